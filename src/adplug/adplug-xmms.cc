@@ -18,6 +18,7 @@
 */
 
 #include <algorithm>
+#include <math.h>
 #include <pthread.h>
 #include <sstream>
 #include <stdlib.h>
@@ -43,7 +44,7 @@ extern "C" {
 #define ADPLUG_NAME	"AdPlug (AdLib Sound Player)"
 
 // Sound buffer size in samples
-#define SNDBUFSIZE	512
+#define SNDBUFSIZE	2048
 
 // AdPlug's 8 and 16 bit audio formats
 #define FORMAT_8	FMT_U8
@@ -121,6 +122,8 @@ bool_t adplug_play(InputPlayback * data, const char * filename, VFSFile * file,
 
 /***** Main player (!! threaded !!) *****/
 
+// May be called from several scanner threads at once: uses only its own
+// player instance and must not touch the playback state in plr.
 extern "C" Tuple * adplug_get_tuple (const char * filename, VFSFile * fd)
 {
   Tuple * ti = NULL;
@@ -145,7 +148,7 @@ extern "C" Tuple * adplug_get_tuple (const char * filename, VFSFile * fd)
 
     tuple_set_str(ti, FIELD_CODEC, NULL, p->gettype().c_str());
     tuple_set_str(ti, FIELD_QUALITY, NULL, _("sequenced"));
-    tuple_set_int(ti, FIELD_LENGTH, NULL, p->songlength (plr.subsong));
+    tuple_set_int(ti, FIELD_LENGTH, NULL, p->songlength (0));
     delete p;
   }
 
@@ -161,7 +164,8 @@ static bool_t play_loop (InputPlayback * playback, const char * filename,
 {
   dbg_printf ("play_loop(\"%s\"): ", filename);
   CEmuopl opl (conf.freq, conf.bit16, conf.stereo);
-  long toadd = 0, i, towrite;
+  long i, towrite;
+  double toadd = 0;             // samples left until the next player tick
   char *sndbuf, *sndbufpos;
   bool playing = true,          // Song self-end indicator.
     bit16 = conf.bit16,          // Duplicate config, so it doesn't affect us if
@@ -222,7 +226,11 @@ static bool_t play_loop (InputPlayback * playback, const char * filename,
     // seek requested ?
     if (plr.seek != -1)
     {
-      int time = playback->output->written_time ();
+      double time = playback->output->written_time ();
+
+      // only the register state at the target matters, so don't run
+      // every intermediate write through the emulator
+      opl.setdeferred (true);
 
       // backward seek ?
       if (plr.seek < time)
@@ -233,30 +241,33 @@ static bool_t play_loop (InputPlayback * playback, const char * filename,
 
       // seek to requested position
       while (time < plr.seek && plr.p->update ())
-        time += (int) (1000 / plr.p->getrefresh ());
+        time += 1000 / plr.p->getrefresh ();
+
+      opl.setdeferred (false);
 
       // Reset output plugin and some values
-      playback->output->flush (time);
+      playback->output->flush ((int) time);
       plr.seek = -1;
+      toadd = 0;
     }
 
     pthread_mutex_unlock (& mutex);
 
-    // fill sound buffer
+    // fill sound buffer, rendering everything up to the next tick at once
     towrite = SNDBUFSIZE;
     sndbufpos = sndbuf;
     while (towrite > 0)
     {
-      while (toadd < 0)
+      while (toadd <= 0)
       {
-        toadd += freq;
         playing = plr.p->update ();
+        toadd += freq / plr.p->getrefresh ();
       }
-      i = MIN (towrite, (long) (toadd / plr.p->getrefresh () + 4) & ~3);
+      i = MIN (towrite, (long) ceil (toadd));
       opl.update ((short *) sndbufpos, i);
       sndbufpos += i * sampsize;
       towrite -= i;
-      toadd -= (long) (plr.p->getrefresh () * i);
+      toadd -= i;
     }
 
     playback->output->write_audio (sndbuf, SNDBUFSIZE * sampsize);
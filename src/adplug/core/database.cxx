@@ -118,45 +118,38 @@ CAdPlugDatabase::save (binostream & f)
   return true;
 }
 
+// Doesn't touch the linear iterator, so concurrent searches are safe
+// as long as nobody modifies the database at the same time.
 CAdPlugDatabase::CRecord * CAdPlugDatabase::search (CKey const &key)
 {
-  if (lookup (key))
-    return get_record ();
-  else
-    return 0;
+  DB_Bucket *bucket = find_bucket (key);
+
+  return bucket ? bucket->record : 0;
 }
 
 bool
 CAdPlugDatabase::lookup (CKey const &key)
 {
-  unsigned long index = make_hash (key);
-  if (!db_hashed[index])
-    return false;
+  DB_Bucket *bucket = find_bucket (key);
 
-  // immediate hit ?
-  DB_Bucket *bucket = db_hashed[index];
+  if (!bucket)
+    return false;
 
-  if (!bucket->deleted && bucket->record->key == key)
-  {
-    linear_index = bucket->index;
-    return true;
-  }
+  linear_index = bucket->index;
+  return true;
+}
 
-  // in-chain hit ?
-  bucket = db_hashed[index]->chain;
+CAdPlugDatabase::DB_Bucket *
+CAdPlugDatabase::find_bucket (CKey const &key)
+{
+  unsigned long index = make_hash (key);
 
-  while (bucket)
-  {
+  // immediate or in-chain hit ?
+  for (DB_Bucket *bucket = db_hashed[index]; bucket; bucket = bucket->chain)
     if (!bucket->deleted && bucket->record->key == key)
-    {
-      linear_index = bucket->index;
-      return true;
-    }
-
-    bucket = bucket->chain;
-  }
+      return bucket;
 
-  return false;
+  return 0;
 }
 
 bool
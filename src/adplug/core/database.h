@@ -121,6 +121,7 @@ private:
   unsigned long	linear_index, linear_logic_length, linear_length;
 
   unsigned long make_hash(CKey const &key);
+  DB_Bucket *find_bucket(CKey const &key);
 };
 
 class CPlainRecord: public CAdPlugDatabase::CRecord
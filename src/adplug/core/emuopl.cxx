@@ -19,10 +19,12 @@
  * emuopl.cpp - Emulated OPL, by Simon Peter <dn.tlp@gmx.net>
  */
 
+#include <string.h>
+
 #include "emuopl.h"
 
 CEmuopl::CEmuopl (int rate, bool bit16, bool usestereo):use16bit (bit16), stereo (usestereo),
-mixbufSamples (0)
+mixbufSamples (0), deferred (false)
 {
   opl[0] = OPLCreate (OPL_TYPE_YM3812, 3579545, rate);
   opl[1] = OPLCreate (OPL_TYPE_YM3812, 3579545, rate);
@@ -111,17 +113,14 @@ CEmuopl::update (short *buf, int samples)
     YM3812UpdateOne (opl[1], tempbuf, samples);
 
     //output stereo:
-    //then we need to interleave the two buffers
+    //then we need to interleave the two buffers,
+    //chip0 on the left channel and chip1 on the right
     if (stereo)
-    {
-      //first, spread tempbuf's samples across left channel
-      //left channel
       for (i = 0; i < samples; i++)
+      {
         outbuf[i * 2] = tempbuf2[i];
-      //next, insert the samples from tempbuf2 into right channel
-      for (i = 0; i < samples; i++)
         outbuf[i * 2 + 1] = tempbuf[i];
-    }
+      }
     else
       //output mono:
       //then we need to mix the two buffers into buf
@@ -143,6 +142,15 @@ CEmuopl::write (int reg, int val)
   {
   case TYPE_OPL2:
   case TYPE_DUAL_OPL2:
+    if (deferred)
+    {
+      //OPLWrite latches only the low byte of the address, so the
+      //shadow copy is indexed the same way
+      regs[currChip][reg & 0xff] = val;
+      dirty[currChip][reg & 0xff] = true;
+      break;
+    }
+
     OPLWrite (opl[currChip], 0, reg);
     OPLWrite (opl[currChip], 1, val);
     break;
@@ -157,6 +165,8 @@ CEmuopl::init ()
   OPLResetChip (opl[0]);
   OPLResetChip (opl[1]);
   currChip = 0;
+
+  memset (dirty, 0, sizeof dirty);
 }
 
 void
@@ -164,3 +174,27 @@ CEmuopl::settype (ChipType type)
 {
   currType = type;
 }
+
+void
+CEmuopl::setdeferred (bool on)
+{
+  if (deferred && !on)
+    flush ();
+
+  deferred = on;
+}
+
+void
+CEmuopl::flush ()
+{
+  //ascending order keeps operator and frequency registers ahead of
+  //the key-on bits in 0xb0-0xbd
+  for (int chip = 0; chip < 2; chip++)
+    for (int reg = 0; reg < 256; reg++)
+      if (dirty[chip][reg])
+      {
+        OPLWrite (opl[chip], 0, reg);
+        OPLWrite (opl[chip], 1, regs[chip][reg]);
+        dirty[chip][reg] = false;
+      }
+}
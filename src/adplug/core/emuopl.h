@@ -39,11 +39,21 @@ class CEmuopl: public Copl
   void init();
   void settype(ChipType type);
 
+  // While deferred, register writes only update a shadow copy; turning
+  // deferral off replays the final register state into the emulator.
+  // Used to skip the intermediate writes while seeking.
+  void setdeferred(bool on);
+
  private:
+  void flush();
+
   bool		use16bit, stereo;
   FM_OPL	*opl[2];				// OPL2 emulator data
   short		*mixbuf0, *mixbuf1;
   int		mixbufSamples;
+  bool		deferred;
+  unsigned char	regs[2][256];			// shadow registers (deferred mode)
+  bool		dirty[2][256];
 };
 
 #endif
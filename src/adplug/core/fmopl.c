@@ -358,6 +358,12 @@ static inline UINT32 OPL_CALC_SLOT( OPL_SLOT *SLOT )
 	return SLOT->TLL+ENV_CURVE[SLOT->evc>>ENV_BITS]+(SLOT->ams ? ams : 0);
 }
 
+/* ---------- slot has finished its release and outputs nothing ---------- */
+static inline int OPL_SLOT_IDLE( const OPL_SLOT *SLOT )
+{
+	return SLOT->evc >= EG_OFF && SLOT->evs == 0;
+}
+
 /* set algorythm connection */
 static void set_algorythm( OPL_CH *CH)
 {
@@ -1040,13 +1046,14 @@ static void OPL_UnLockTable(void)
 /* ---------- update one of chip ----------- */
 void YM3812UpdateOne(FM_OPL *OPL, INT16 *buffer, int length)
 {
-    int i;
+    int i,c,n_act;
 	int data;
 	OPLSAMPLE *buf = buffer;
 	UINT32 amsCnt  = OPL->amsCnt;
 	UINT32 vibCnt  = OPL->vibCnt;
 	UINT8 rythm = OPL->rythm&0x20;
 	OPL_CH *CH,*R_CH;
+	OPL_CH *act_ch[9];
 
 	if( (void *)OPL != cur_chip ){
 		cur_chip = (void *)OPL;
@@ -1065,6 +1072,20 @@ void YM3812UpdateOne(FM_OPL *OPL, INT16 *buffer, int length)
 		vib_table = OPL->vib_table;
 	}
 	R_CH = rythm ? &S_CH[6] : E_CH;
+	/* register writes never happen inside one update, so channels whose */
+	/* envelopes have both run out stay silent for the whole block       */
+	n_act = 0;
+	for(CH=S_CH ; CH < R_CH ; CH++)
+	{
+		if( OPL_SLOT_IDLE(&CH->SLOT[SLOT1]) && OPL_SLOT_IDLE(&CH->SLOT[SLOT2]) )
+		{
+			/* same feedback history the per-sample path would leave */
+			CH->op1_out[1] = (length > 1) ? 0 : CH->op1_out[0];
+			CH->op1_out[0] = 0;
+		}
+		else
+			act_ch[n_act++] = CH;
+	}
     for( i=0; i < length ; i++ )
 	{
 		/*            channel A         channel B         channel C      */
@@ -1073,8 +1094,8 @@ void YM3812UpdateOne(FM_OPL *OPL, INT16 *buffer, int length)
 		vib = vib_table[(vibCnt+=vibIncr)>>VIB_SHIFT];
 		outd[0] = 0;
 		/* FM part */
-		for(CH=S_CH ; CH < R_CH ; CH++)
-			OPL_CALC_CH(CH);
+		for(c=0 ; c < n_act ; c++)
+			OPL_CALC_CH(act_ch[c]);
 		/* Rythn part */
 		if(rythm)
 			OPL_CALC_RH(S_CH);
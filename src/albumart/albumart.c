@@ -23,78 +23,84 @@
 #include <libaudcore/hook.h>
 #include <libaudgui/libaudgui-gtk.h>
 
-static void album_set_unscaled (GtkWidget * widget, GdkPixbuf * unscaled)
-{
-    GdkPixbuf * old;
+#include "../common/art_cache.h"
 
-    if ((old = g_object_get_data ((GObject *) widget, "pixbux-unscaled")))
-        g_object_unref (old);
-    if ((old = g_object_get_data ((GObject *) widget, "pixbux-scaled")))
+static void album_set_pixbuf (GtkWidget * widget, GdkPixbuf * pixbuf)
+{
+    GdkPixbuf * old = g_object_get_data ((GObject *) widget, "pixbuf");
+    if (old)
         g_object_unref (old);
 
-    g_object_set_data ((GObject *) widget, "pixbuf-unscaled", unscaled);
-    g_object_set_data ((GObject *) widget, "pixbuf-scaled", NULL);
-
+    g_object_set_data ((GObject *) widget, "pixbuf", pixbuf);
     gtk_widget_queue_draw (widget);
 }
 
-static GdkPixbuf * album_get_scaled (GtkWidget * widget, int maxwidth, int maxheight)
+static GdkPixbuf * album_request (GtkWidget * widget, bool_t * pending)
 {
-    GdkPixbuf * unscaled = g_object_get_data ((GObject *) widget, "pixbuf-unscaled");
-    if (! unscaled)
-        return NULL;
+    GdkRectangle rect;
+    gtk_widget_get_allocation (widget, & rect);
+
+    GdkPixbuf * pixbuf = art_cache_request_current (MIN (rect.width, rect.height), pending);
+    if (! pixbuf && ! * pending)
+        pixbuf = audgui_pixbuf_fallback ();
 
-    int width = gdk_pixbuf_get_width (unscaled);
-    int height = gdk_pixbuf_get_height (unscaled);
+    return pixbuf;
+}
 
-    if (width > maxwidth || height > maxheight)
+static bool_t album_draw (GtkWidget * widget, cairo_t * cr)
+{
+    GdkPixbuf * pixbuf = g_object_get_data ((GObject *) widget, "pixbuf");
+    if (! pixbuf)
+        return TRUE;
+
+    GdkRectangle rect;
+    gtk_widget_get_allocation (widget, & rect);
+
+    int orig_width = gdk_pixbuf_get_width (pixbuf);
+    int orig_height = gdk_pixbuf_get_height (pixbuf);
+    int width = orig_width;
+    int height = orig_height;
+
+    if (width > rect.width || height > rect.height)
     {
-        if (width * maxheight > height * maxwidth)
+        if (width * rect.height > height * rect.width)
         {
-            height = height * maxwidth / width;
-            width = maxwidth;
+            height = height * rect.width / width;
+            width = rect.width;
         }
         else
         {
-            width = width * maxheight / height;
-            height = maxheight;
+            width = width * rect.height / height;
+            height = rect.height;
         }
     }
 
-    GdkPixbuf * scaled = g_object_get_data ((GObject *) widget, "pixbuf-scaled");
-    if (scaled)
-    {
-        if (gdk_pixbuf_get_width (scaled) == width &&
-         gdk_pixbuf_get_height (scaled) == height)
-            return scaled;
-
-        g_object_unref (scaled);
-    }
+    /* the cached image is only a step larger than the widget, so this is
+     * cheap compared to scaling the original art */
+    cairo_translate (cr, (rect.width - width) / 2, (rect.height - height) / 2);
+    cairo_scale (cr, (double) width / orig_width, (double) height / orig_height);
 
-    scaled = gdk_pixbuf_scale_simple (unscaled, width, height, GDK_INTERP_BILINEAR);
-    g_object_set_data ((GObject *) widget, "pixbuf-scaled", scaled);
-    return scaled;
+    gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
+    cairo_paint (cr);
+    return TRUE;
 }
 
-static bool_t album_draw (GtkWidget * widget, cairo_t * cr)
+/* keeps the image already shown until one of the new size is ready */
+static void album_resize (GtkWidget * widget)
 {
-    GdkRectangle rect;
-    gtk_widget_get_allocation (widget, & rect);
-
-    GdkPixbuf * scaled = album_get_scaled (widget, rect.width, rect.height);
-    if (! scaled)
-        return TRUE;
+    if (! aud_drct_get_playing ())
+        return;
 
-    int x = (rect.width - gdk_pixbuf_get_width (scaled)) / 2;
-    int y = (rect.height - gdk_pixbuf_get_height (scaled)) / 2;
+    bool_t pending;
+    GdkPixbuf * pixbuf = album_request (widget, & pending);
 
-    gdk_cairo_set_source_pixbuf (cr, scaled, x, y);
-    cairo_paint (cr);
-    return TRUE;
+    if (pixbuf)
+        album_set_pixbuf (widget, pixbuf);
 }
 
 static bool_t album_configure (GtkWidget * widget, GdkEventConfigure * event)
 {
+    album_resize (widget);
     gtk_widget_queue_draw (widget);
     return TRUE;
 }
@@ -104,15 +110,13 @@ static void album_update (void * unused, GtkWidget * widget)
     if (! aud_drct_get_playing ())
         return;
 
-    GdkPixbuf * unscaled = audgui_pixbuf_request_current ();
-    album_set_unscaled (widget, unscaled ? unscaled : audgui_pixbuf_fallback ());
-    gtk_widget_queue_draw (widget);
+    bool_t pending;
+    album_set_pixbuf (widget, album_request (widget, & pending));
 }
 
 static void album_clear (void * unused, GtkWidget * widget)
 {
-    album_set_unscaled (widget, NULL);
-    gtk_widget_queue_draw (widget);
+    album_set_pixbuf (widget, NULL);
 }
 
 static void album_cleanup (GtkWidget * widget)
@@ -120,6 +124,9 @@ static void album_cleanup (GtkWidget * widget)
     hook_dissociate_full ("playback begin", (HookFunction) album_update, widget);
     hook_dissociate_full ("current art ready", (HookFunction) album_update, widget);
     hook_dissociate_full ("playback stop", (HookFunction) album_clear, widget);
+
+    art_cache_unwatch ((ArtCacheFunc) album_resize, widget);
+    album_set_pixbuf (widget, NULL);
 }
 
 static void * album_get_widget (void)
@@ -135,6 +142,8 @@ static void * album_get_widget (void)
     hook_associate ("current art ready", (HookFunction) album_update, widget);
     hook_associate ("playback stop", (HookFunction) album_clear, widget);
 
+    art_cache_watch ((ArtCacheFunc) album_resize, widget);
+
     return widget;
 }
 
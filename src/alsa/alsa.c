@@ -32,9 +32,12 @@
  *
  * * After adding more data to the buffer, and after resuming from pause,
  *   signal on alsa_cond to wake the pump.  (There is no need to signal when
- *   entering pause.)
+ *   entering pause.)  To save context switches, the pump is only woken for
+ *   new data once there is at least a period of it, or when draining.
  * * After setting the pump_quit flag, signal on alsa_cond AND the poll_pipe
  *   before joining the thread.
+ * * The pump signals on alsa_cond after writing only if the main thread is
+ *   actually waiting for room in the buffer (writer_waiting).
  */
 
 #include <assert.h>
@@ -78,6 +81,8 @@ static int alsa_channels, alsa_rate;
 static void * alsa_buffer;
 static int alsa_buffer_length, alsa_buffer_data_start, alsa_buffer_data_length;
 static int alsa_period; /* milliseconds */
+static int alsa_period_bytes;
+static char alsa_mmap;
 
 static int64_t alsa_written; /* frames */
 static char alsa_prebuffer, alsa_paused;
@@ -87,7 +92,7 @@ static int poll_pipe[2];
 static int poll_count;
 static struct pollfd * poll_handles;
 
-static char pump_quit;
+static char pump_quit, pump_idle, writer_waiting;
 static pthread_t pump_thread;
 
 static snd_mixer_t * alsa_mixer;
@@ -149,6 +154,15 @@ static void poll_cleanup (void)
     free (poll_handles);
 }
 
+static snd_pcm_sframes_t pcm_write (snd_pcm_t * handle, const void * data,
+ snd_pcm_uframes_t frames)
+{
+    if (alsa_mmap)
+        return snd_pcm_mmap_writei (handle, data, frames);
+    else
+        return snd_pcm_writei (handle, data, frames);
+}
+
 static void * pump (void * unused)
 {
     pthread_mutex_lock (& alsa_mutex);
@@ -163,7 +177,9 @@ static void * pump (void * unused)
         if (alsa_prebuffer || alsa_paused || ! snd_pcm_bytes_to_frames
          (alsa_handle, alsa_buffer_data_length))
         {
+            pump_idle = 1;
             pthread_cond_wait (& alsa_cond, & alsa_mutex);
+            pump_idle = 0;
             continue;
         }
 
@@ -181,7 +197,7 @@ static void * pump (void * unused)
         length = snd_pcm_bytes_to_frames (alsa_handle, length);
 
         int written;
-        CHECK_VAL_RECOVER (written, snd_pcm_writei, alsa_handle, (char *)
+        CHECK_VAL_RECOVER (written, pcm_write, alsa_handle, (char *)
          alsa_buffer + alsa_buffer_data_start, length);
 
         failed = 0;
@@ -190,7 +206,8 @@ static void * pump (void * unused)
         alsa_buffer_data_start += written;
         alsa_buffer_data_length -= written;
 
-        pthread_cond_broadcast (& alsa_cond); /* signal write complete */
+        if (writer_waiting)
+            pthread_cond_broadcast (& alsa_cond); /* signal write complete */
 
         if (alsa_buffer_data_start == alsa_buffer_length)
         {
@@ -340,8 +357,14 @@ int alsa_open_audio (int aud_format, int rate, int channels)
     snd_pcm_hw_params_t * params;
     snd_pcm_hw_params_alloca (& params);
     CHECK_NOISY (snd_pcm_hw_params_any, alsa_handle, params);
-    CHECK_NOISY (snd_pcm_hw_params_set_access, alsa_handle, params,
-     SND_PCM_ACCESS_RW_INTERLEAVED);
+
+    /* Memory-mapped transfer saves a copy inside ALSA, but not every device
+     * (or plugin) supports it, so fall back to read/write access. */
+    alsa_mmap = alsa_config_mmap && snd_pcm_hw_params_test_access (alsa_handle,
+     params, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+
+    CHECK_NOISY (snd_pcm_hw_params_set_access, alsa_handle, params, alsa_mmap ?
+     SND_PCM_ACCESS_MMAP_INTERLEAVED : SND_PCM_ACCESS_RW_INTERLEAVED);
 
     CHECK_NOISY (snd_pcm_hw_params_set_format, alsa_handle, params, format);
     CHECK_NOISY (snd_pcm_hw_params_set_channels, alsa_handle, params, channels);
@@ -366,9 +389,14 @@ int alsa_open_audio (int aud_format, int rate, int channels)
 
     CHECK_NOISY (snd_pcm_hw_params, alsa_handle, params);
 
+    snd_pcm_uframes_t period_frames;
+    CHECK_NOISY (snd_pcm_hw_params_get_period_size, params, & period_frames,
+     NULL);
+    alsa_period_bytes = snd_pcm_frames_to_bytes (alsa_handle, period_frames);
+
     int soft_buffer = MAX (total_buffer / 2, total_buffer - hard_buffer);
-    AUDDBG ("Buffer: hardware %d ms, software %d ms, period %d ms.\n",
-     hard_buffer, soft_buffer, alsa_period);
+    AUDDBG ("Buffer: hardware %d ms, software %d ms, period %d ms%s.\n",
+     hard_buffer, soft_buffer, alsa_period, alsa_mmap ? ", mmap" : "");
 
     alsa_buffer_length = snd_pcm_frames_to_bytes (alsa_handle, (int64_t)
      soft_buffer * rate / 1000);
@@ -449,7 +477,9 @@ void alsa_write_audio (void * data, int length)
     alsa_buffer_data_length += length;
     alsa_written += snd_pcm_bytes_to_frames (alsa_handle, length);
 
-    if (! alsa_paused)
+    /* If the pump is busy, it will find the new data on its own. */
+    if (! alsa_paused && pump_idle && alsa_buffer_data_length >=
+     alsa_period_bytes)
         pthread_cond_broadcast (& alsa_cond);
 
     pthread_mutex_unlock (& alsa_mutex);
@@ -469,7 +499,9 @@ void alsa_period_wait (void)
                 pthread_cond_broadcast (& alsa_cond);
         }
 
+        writer_waiting = 1;
         pthread_cond_wait (& alsa_cond, & alsa_mutex);
+        writer_waiting = 0;
     }
 
     pthread_mutex_unlock (& alsa_mutex);
@@ -484,10 +516,16 @@ void alsa_drain (void)
 
     if (alsa_prebuffer)
         start_playback ();
+    else
+        pthread_cond_broadcast (& alsa_cond); /* flush out a partial period */
+
+    writer_waiting = 1;
 
     while (snd_pcm_bytes_to_frames (alsa_handle, alsa_buffer_data_length))
         pthread_cond_wait (& alsa_cond, & alsa_mutex);
 
+    writer_waiting = 0;
+
     pump_stop ();
 
     if (alsa_config_drain_workaround)
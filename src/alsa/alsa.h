@@ -74,7 +74,7 @@ void alsa_set_volume (int left, int right);
 /* config.c */
 extern char * alsa_config_pcm, * alsa_config_mixer, * alsa_config_mixer_element;
 extern int alsa_config_drop_workaround, alsa_config_drain_workaround,
- alsa_config_delay_workaround;
+ alsa_config_delay_workaround, alsa_config_mmap;
 
 void alsa_config_load (void);
 void alsa_config_save (void);
@@ -29,10 +29,11 @@
 char * alsa_config_pcm = NULL, * alsa_config_mixer = NULL,
  * alsa_config_mixer_element = NULL;
 int alsa_config_drain_workaround = 1;
+int alsa_config_mmap = 0;
 
 static GtkListStore * pcm_list, * mixer_list, * mixer_element_list;
 static GtkWidget * window, * pcm_combo, * mixer_combo, * mixer_element_combo,
- * drain_workaround_check;
+ * drain_workaround_check, * mmap_check;
 
 static GtkTreeIter * list_lookup_member (GtkListStore * list, const char * text)
 {
@@ -314,6 +315,7 @@ static const gchar * const alsa_defaults[] = {
  "pcm", "default",
  "mixer", "default",
  "drain-workaround", "TRUE",
+ "mmap", "FALSE",
  NULL};
 
 void alsa_config_load (void)
@@ -324,6 +326,7 @@ void alsa_config_load (void)
     alsa_config_mixer = aud_get_string ("alsa", "mixer");
     alsa_config_mixer_element = aud_get_string ("alsa", "mixer-element");
     alsa_config_drain_workaround = aud_get_bool ("alsa", "drain-workaround");
+    alsa_config_mmap = aud_get_bool ("alsa", "mmap");
 
     if (! alsa_config_mixer_element[0])
         guess_mixer_element ();
@@ -353,6 +356,7 @@ void alsa_config_save (void)
     aud_set_string ("alsa", "mixer", alsa_config_mixer);
     aud_set_string ("alsa", "mixer-element", alsa_config_mixer_element);
     aud_set_bool ("alsa", "drain-workaround", alsa_config_drain_workaround);
+    aud_set_bool ("alsa", "mmap", alsa_config_mmap);
 
     free (alsa_config_pcm);
     alsa_config_pcm = NULL;
@@ -444,6 +448,12 @@ static void create_window (void)
      alsa_config_drain_workaround);
     gtk_box_pack_start ((GtkBox *) vbox, drain_workaround_check, 0, 0, 0);
 
+    mmap_check = gtk_check_button_new_with_label (_("Use memory-mapped "
+     "transfer if supported"));
+    gtk_toggle_button_set_active ((GtkToggleButton *) mmap_check,
+     alsa_config_mmap);
+    gtk_box_pack_start ((GtkBox *) vbox, mmap_check, 0, 0, 0);
+
     gtk_widget_show_all (window);
 }
 
@@ -510,6 +520,8 @@ static void connect_callbacks (void)
      mixer_element_changed, NULL);
     g_signal_connect ((GObject *) drain_workaround_check, "toggled", (GCallback)
      boolean_toggled, & alsa_config_drain_workaround);
+    g_signal_connect ((GObject *) mmap_check, "toggled", (GCallback)
+     boolean_toggled, & alsa_config_mmap);
     g_signal_connect ((GObject *) window, "response", (GCallback)
      gtk_widget_destroy, window);
     g_signal_connect ((GObject *) window, "destroy", (GCallback)
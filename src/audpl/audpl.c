@@ -17,9 +17,16 @@
  * the use of this software.
  */
 
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <audacious/i18n.h>
 #include <audacious/plugin.h>
@@ -78,7 +85,25 @@ static bool_t read_key (ReadState * state, char * * keyp, char * * valp)
     return TRUE;
 }
 
-static bool_t write_key_raw (VFSFile * file, const char * key, const char * val)
+static uint32_t hash_bytes (uint32_t hash, const void * data, int64_t len)
+{
+    const unsigned char * c = data;
+
+    /* FNV-1a */
+    while (len --)
+        hash = (hash ^ * c ++) * 16777619;
+
+    return hash;
+}
+
+#define HASH_INIT 2166136261u
+
+typedef struct {
+    VFSFile * file;
+    int64_t size;
+} WriteState;
+
+static bool_t write_key_raw (WriteState * state, const char * key, const char * val)
 {
     int keylen = strlen (key);
     int vallen = strlen (val);
@@ -89,22 +114,466 @@ static bool_t write_key_raw (VFSFile * file, const char * key, const char * val)
     memcpy (buf + keylen + 1, val, vallen);
     buf[keylen + vallen + 1] = '\n';
 
-    return (vfs_fwrite (buf, 1, keylen + vallen + 2, file) == keylen + vallen + 2);
+    state->size += keylen + vallen + 2;
+
+    return (vfs_fwrite (buf, 1, keylen + vallen + 2, state->file) == keylen + vallen + 2);
 }
 
-static bool_t write_key (VFSFile * file, const char * key, const char * val)
+static bool_t write_key (WriteState * state, const char * key, const char * val)
 {
     if (! strcmp (key, "uri"))
-        return write_key_raw (file, key, val);
+        return write_key_raw (state, key, val);
 
     char buf[3 * strlen (val) + 1];
     str_encode_percent (val, -1, buf);
-    return write_key_raw (file, key, buf);
+    return write_key_raw (state, key, buf);
+}
+
+/* Binary sidecar
+ * --------------
+ * Next to every local .audpl file, a .audpl.bin file is written holding the
+ * same playlist in a form that can be used straight from an mmap: a header,
+ * a table of string offsets, fixed-size entry and field records, and the
+ * interned strings themselves.  The header records the size, modification
+ * time (to the nanosecond, where the file system keeps it) and inode of the
+ * text file it was written with, so it can be checked with a single stat()
+ * rather than by reading the text file; if those do not match, or the
+ * checksum of the sidecar is wrong, the text file is parsed as before.
+ * Sidecars whose text file is gone are deleted the next time a playlist in
+ * the same folder is saved.
+ *
+ * Fields are stored by name rather than by number, so the sidecar does not
+ * depend on the order of the tuple fields in libaudcore.  Integers are in
+ * native byte order; the magic string rules out files written elsewhere. */
+
+#define BIN_MAGIC "AUDPLBIN"
+#define BIN_VERSION 3
+#define BIN_NONE 0xffffffff
+
+typedef struct {
+    char magic[8];
+    uint32_t version, endian;
+    int64_t text_size, text_mtime, text_mtime_ns;
+    uint64_t text_inode;
+    uint32_t title; /* string id */
+    uint32_t strings, entries, records, string_bytes;
+    uint32_t checksum; /* of everything after the header */
+} BinHeader;
+
+typedef struct {
+    uint32_t uri; /* string id */
+    uint32_t first, count; /* count is BIN_NONE if there is no tuple */
+} BinEntry;
+
+typedef struct {
+    uint32_t name; /* string id */
+    uint32_t type;
+    int32_t value; /* string id for TUPLE_STRING */
+} BinRecord;
+
+typedef struct {
+    Index * strings;
+    uint32_t * buckets; /* string id + 1, or 0 for an empty bucket */
+    int bucket_count;
+    uint32_t string_bytes;
+
+    BinEntry * entries;
+    int entry_count, entries_size;
+    BinRecord * records;
+    int record_count, records_size;
+} BinBuilder;
+
+static void * grow (void * data, int * size, int need, int elem)
+{
+    if (need <= * size)
+        return data;
+
+    * size = (* size > 0) ? * size * 2 : 256;
+    if (* size < need)
+        * size = need;
+
+    return realloc (data, (size_t) * size * elem);
+}
+
+/* the strings are not copied; they must outlive the builder */
+static uint32_t intern (BinBuilder * b, const char * str)
+{
+    if (index_count (b->strings) * 2 >= b->bucket_count)
+    {
+        int count = b->bucket_count ? b->bucket_count * 2 : 1024;
+        uint32_t * buckets = calloc (count, sizeof (uint32_t));
+
+        for (int i = 0; i < index_count (b->strings); i ++)
+        {
+            const char * s = index_get (b->strings, i);
+            int slot = hash_bytes (HASH_INIT, s, strlen (s)) & (count - 1);
+
+            while (buckets[slot])
+                slot = (slot + 1) & (count - 1);
+
+            buckets[slot] = i + 1;
+        }
+
+        free (b->buckets);
+        b->buckets = buckets;
+        b->bucket_count = count;
+    }
+
+    int len = strlen (str);
+    int slot = hash_bytes (HASH_INIT, str, len) & (b->bucket_count - 1);
+
+    while (b->buckets[slot])
+    {
+        uint32_t id = b->buckets[slot] - 1;
+        if (! strcmp (index_get (b->strings, id), str))
+            return id;
+
+        slot = (slot + 1) & (b->bucket_count - 1);
+    }
+
+    uint32_t id = index_count (b->strings);
+    index_append (b->strings, (void *) str);
+    b->buckets[slot] = id + 1;
+    b->string_bytes += len + 1;
+
+    return id;
+}
+
+static void bin_add_entry (BinBuilder * b, const char * uri, bool_t has_tuple)
+{
+    b->entries = grow (b->entries, & b->entries_size, b->entry_count + 1,
+     sizeof (BinEntry));
+
+    BinEntry * entry = & b->entries[b->entry_count ++];
+    entry->uri = intern (b, uri);
+    entry->first = b->record_count;
+    entry->count = has_tuple ? 0 : BIN_NONE;
+}
+
+static void bin_add_record (BinBuilder * b, const char * name, int type, int value)
+{
+    b->records = grow (b->records, & b->records_size, b->record_count + 1,
+     sizeof (BinRecord));
+
+    BinRecord * record = & b->records[b->record_count ++];
+    record->name = intern (b, name);
+    record->type = type;
+    record->value = value;
+
+    b->entries[b->entry_count - 1].count ++;
+}
+
+static char * bin_path (const char * local)
+{
+    int len = strlen (local);
+    char * bin = malloc (len + 5);
+    memcpy (bin, local, len);
+    strcpy (bin + len, ".bin");
+    return bin;
+}
+
+static bool_t bin_write_all (FILE * handle, const void * data, size_t len,
+ uint32_t * checksum)
+{
+    if (checksum)
+        * checksum = hash_bytes (* checksum, data, len);
+
+    return (fwrite (data, 1, len, handle) == len);
+}
+
+static bool_t bin_write_body (BinBuilder * b, FILE * handle, uint32_t * checksum)
+{
+    int strings = index_count (b->strings);
+    uint32_t offset = 0;
+
+    for (int i = 0; i < strings; i ++)
+    {
+        if (! bin_write_all (handle, & offset, sizeof offset, checksum))
+            return FALSE;
+
+        offset += strlen (index_get (b->strings, i)) + 1;
+    }
+
+    if (! bin_write_all (handle, b->entries, sizeof (BinEntry) *
+     b->entry_count, checksum) || ! bin_write_all (handle, b->records, sizeof
+     (BinRecord) * b->record_count, checksum))
+        return FALSE;
+
+    for (int i = 0; i < strings; i ++)
+    {
+        const char * str = index_get (b->strings, i);
+        if (! bin_write_all (handle, str, strlen (str) + 1, checksum))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* deletes the sidecars in a folder whose text files no longer exist, as when
+ * a playlist has been deleted or renamed */
+static void bin_sweep (const char * folder)
+{
+    DIR * dir = opendir (folder);
+    if (! dir)
+        return;
+
+    struct dirent * ent;
+
+    while ((ent = readdir (dir)))
+    {
+        int len = strlen (ent->d_name);
+
+        /* "x.audpl.bin" at the least */
+        if (len < 11 || strcmp (ent->d_name + len - 10, ".audpl.bin"))
+            continue;
+
+        char local[strlen (folder) + len + 2];
+        snprintf (local, sizeof local, "%s/%.*s", folder, len - 4, ent->d_name);
+
+        struct stat info;
+
+        if (stat (local, & info) < 0 && errno == ENOENT)
+        {
+            char * bin = bin_path (local);
+            unlink (bin);
+            free (bin);
+        }
+    }
+
+    closedir (dir);
+}
+
+static void bin_save (const char * path, BinBuilder * b, uint32_t title,
+ WriteState * text)
+{
+    char * local = uri_to_filename (path);
+    if (! local)
+        return;
+
+    /* seeking flushes the text file, so its size and time are now final; if
+     * the transport does not allow this, there is no sidecar */
+    struct stat info;
+    if (vfs_fseek (text->file, 0, SEEK_CUR) || stat (local, & info) ||
+     info.st_size != text->size)
+    {
+        free (local);
+        return;
+    }
+
+    char * bin = bin_path (local);
+
+    char * slash = strrchr (local, '/');
+    if (slash)
+    {
+        * slash = 0;
+        bin_sweep (local[0] ? local : "/");
+    }
+
+    free (local);
+
+    BinHeader header;
+    memset (& header, 0, sizeof header);
+    memcpy (header.magic, BIN_MAGIC, sizeof header.magic);
+    header.version = BIN_VERSION;
+    header.endian = 0x01020304;
+    header.text_size = info.st_size;
+    header.text_mtime = info.st_mtime;
+    header.text_mtime_ns = info.st_mtim.tv_nsec;
+    header.text_inode = info.st_ino;
+    header.title = title;
+    header.strings = index_count (b->strings);
+    header.entries = b->entry_count;
+    header.records = b->record_count;
+    header.string_bytes = b->string_bytes;
+    header.checksum = HASH_INIT;
+
+    /* the checksum is only known after the body is written, so the header is
+     * written twice; the file is renamed into place once complete */
+    int len = strlen (bin);
+    char temp[len + 5];
+    memcpy (temp, bin, len);
+    strcpy (temp + len, ".tmp");
+
+    FILE * handle = fopen (temp, "wb");
+    bool_t success = FALSE;
+
+    if (handle)
+    {
+        success = bin_write_all (handle, & header, sizeof header, NULL) &&
+         bin_write_body (b, handle, & header.checksum) && ! fseek (handle, 0,
+         SEEK_SET) && bin_write_all (handle, & header, sizeof header, NULL);
+
+        if (fclose (handle))
+            success = FALSE;
+    }
+
+    if (! success || rename (temp, bin))
+    {
+        unlink (temp);
+        unlink (bin);
+    }
+
+    free (bin);
+}
+
+static bool_t bin_check (const BinHeader * h, size_t size)
+{
+    if (size < sizeof (BinHeader) || memcmp (h->magic, BIN_MAGIC, sizeof
+     h->magic) || h->version != BIN_VERSION || h->endian != 0x01020304)
+        return FALSE;
+
+    uint64_t need = sizeof (BinHeader) + (uint64_t) h->strings * sizeof
+     (uint32_t) + (uint64_t) h->entries * sizeof (BinEntry) + (uint64_t)
+     h->records * sizeof (BinRecord) + h->string_bytes;
+
+    if (need != size || ! h->strings || h->title >= h->strings)
+        return FALSE;
+
+    if (hash_bytes (HASH_INIT, h + 1, size - sizeof (BinHeader)) != h->checksum)
+        return FALSE;
+
+    const uint32_t * offsets = (const uint32_t *) (h + 1);
+    const BinEntry * entries = (const BinEntry *) (offsets + h->strings);
+    const BinRecord * records = (const BinRecord *) (entries + h->entries);
+    const char * data = (const char *) (records + h->records);
+
+    if (! h->string_bytes || data[h->string_bytes - 1])
+        return FALSE;
+
+    for (uint32_t i = 0; i < h->strings; i ++)
+    {
+        if (offsets[i] >= h->string_bytes)
+            return FALSE;
+    }
+
+    for (uint32_t i = 0; i < h->entries; i ++)
+    {
+        if (entries[i].uri >= h->strings)
+            return FALSE;
+
+        if (entries[i].count != BIN_NONE && (entries[i].first > h->records ||
+         entries[i].count > h->records - entries[i].first))
+            return FALSE;
+    }
+
+    for (uint32_t i = 0; i < h->records; i ++)
+    {
+        if (records[i].name >= h->strings || (records[i].type == TUPLE_STRING &&
+         (uint32_t) records[i].value >= h->strings))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void bin_read (const BinHeader * h, char * * title, Index * filenames,
+ Index * tuples)
+{
+    const uint32_t * offsets = (const uint32_t *) (h + 1);
+    const BinEntry * entries = (const BinEntry *) (offsets + h->strings);
+    const BinRecord * records = (const BinRecord *) (entries + h->entries);
+    const char * data = (const char *) (records + h->records);
+
+    /* field names are looked up once per distinct name */
+    int * fields = malloc (sizeof (int) * h->strings);
+    for (uint32_t i = 0; i < h->strings; i ++)
+        fields[i] = -2;
+
+    * title = str_get (data + offsets[h->title]);
+
+    for (uint32_t i = 0; i < h->entries; i ++)
+    {
+        char * uri = str_get (data + offsets[entries[i].uri]);
+        Tuple * tuple = NULL;
+
+        if (entries[i].count != BIN_NONE)
+        {
+            tuple = tuple_new_from_filename (uri);
+
+            for (uint32_t r = 0; r < entries[i].count; r ++)
+            {
+                const BinRecord * record = & records[entries[i].first + r];
+
+                if (fields[record->name] == -2)
+                    fields[record->name] = tuple_field_by_name (data +
+                     offsets[record->name]);
+
+                int field = fields[record->name];
+
+                if (field < 0 || tuple_field_get_type (field) != record->type)
+                    continue;
+
+                if (record->type == TUPLE_STRING)
+                    tuple_set_str (tuple, field, NULL, data +
+                     offsets[record->value]);
+                else if (record->type == TUPLE_INT)
+                    tuple_set_int (tuple, field, NULL, record->value);
+            }
+        }
+
+        index_append (filenames, uri);
+        index_append (tuples, tuple);
+    }
+
+    free (fields);
+}
+
+/* checks the sidecar against the size, time and inode of the text file */
+static bool_t bin_load (const char * path, char * * title, Index * filenames,
+ Index * tuples)
+{
+    char * local = uri_to_filename (path);
+    if (! local)
+        return FALSE;
+
+    struct stat text;
+    if (stat (local, & text))
+    {
+        free (local);
+        return FALSE;
+    }
+
+    char * bin = bin_path (local);
+    free (local);
+
+    int handle = open (bin, O_RDONLY);
+    free (bin);
+
+    if (handle < 0)
+        return FALSE;
+
+    struct stat info;
+    void * map = MAP_FAILED;
+
+    if (! fstat (handle, & info) && info.st_size >= (off_t) sizeof (BinHeader))
+        map = mmap (NULL, info.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+
+    close (handle);
+
+    if (map == MAP_FAILED)
+        return FALSE;
+
+    const BinHeader * h = map;
+    bool_t success = FALSE;
+
+    if (bin_check (h, info.st_size) && h->text_size == text.st_size &&
+     h->text_mtime == text.st_mtime && h->text_mtime_ns ==
+     text.st_mtim.tv_nsec && h->text_inode == text.st_ino)
+    {
+        bin_read (h, title, filenames, tuples);
+        success = TRUE;
+    }
+
+    munmap (map, info.st_size);
+    return success;
 }
 
 static bool_t audpl_load (const char * path, VFSFile * file, char * * title,
  Index * filenames, Index * tuples)
 {
+    if (bin_load (path, title, filenames, tuples))
+        return TRUE;
+
     ReadState * state = malloc (sizeof (ReadState));
     state->file = file;
     state->cur = state->buf;
@@ -158,18 +627,32 @@ static bool_t audpl_load (const char * path, VFSFile * file, char * * title,
 static bool_t audpl_save (const char * path, VFSFile * file,
  const char * title, Index * filenames, Index * tuples)
 {
-    if (! write_key (file, "title", title))
-        return FALSE;
+    WriteState state = {file, 0};
+    BinBuilder b;
+    memset (& b, 0, sizeof b);
+    b.strings = index_new ();
+
+    /* the builder borrows the strings; keep them alive until it is saved */
+    Index * held = index_new ();
+    bool_t success = FALSE;
 
+    if (! write_key (& state, "title", title))
+        goto DONE;
+
+    uint32_t title_id = intern (& b, title);
     int count = index_count (filenames);
 
     for (int i = 0; i < count; i ++)
     {
-        if (! write_key (file, "uri", index_get (filenames, i)))
-            return FALSE;
+        const char * uri = index_get (filenames, i);
+
+        if (! write_key (& state, "uri", uri))
+            goto DONE;
 
         const Tuple * tuple = tuples ? index_get (tuples, i) : NULL;
 
+        bin_add_entry (& b, uri, tuple != NULL);
+
         if (tuple)
         {
             int keys = 0;
@@ -184,35 +667,49 @@ static bool_t audpl_save (const char * path, VFSFile * file,
                 if (type == TUPLE_STRING)
                 {
                     char * str = tuple_get_str (tuple, f, NULL);
+                    index_append (held, str);
 
-                    if (! write_key (file, tuple_field_get_name (f), str))
-                    {
-                        str_unref (str);
-                        return FALSE;
-                    }
+                    if (! write_key (& state, tuple_field_get_name (f), str))
+                        goto DONE;
 
-                    str_unref (str);
+                    bin_add_record (& b, tuple_field_get_name (f), type,
+                     intern (& b, str));
                     keys ++;
                 }
                 else if (type == TUPLE_INT)
                 {
                     char buf[32];
-                    snprintf (buf, sizeof buf, "%d", tuple_get_int (tuple, f, NULL));
+                    int val = tuple_get_int (tuple, f, NULL);
+                    snprintf (buf, sizeof buf, "%d", val);
 
-                    if (! write_key (file, tuple_field_get_name (f), buf))
-                        return FALSE;
+                    if (! write_key (& state, tuple_field_get_name (f), buf))
+                        goto DONE;
 
+                    bin_add_record (& b, tuple_field_get_name (f), type, val);
                     keys ++;
                 }
             }
 
             /* distinguish between an empty tuple and no tuple at all */
-            if (! keys && ! write_key (file, "empty", "1"))
-                return FALSE;
+            if (! keys && ! write_key (& state, "empty", "1"))
+                goto DONE;
         }
     }
 
-    return TRUE;
+    bin_save (path, & b, title_id, & state);
+    success = TRUE;
+
+DONE:
+    for (int i = 0; i < index_count (held); i ++)
+        str_unref (index_get (held, i));
+
+    index_free (held);
+    index_free (b.strings);
+    free (b.buckets);
+    free (b.entries);
+    free (b.records);
+
+    return success;
 }
 
 static const char * const audpl_exts[] = {"audpl", NULL};
@@ -0,0 +1,197 @@
+/*
+ * pump.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Plays silence through the ALSA output plugin into ALSA's "null" device,
+ * writing blocks the way the output thread of the core does: write what fits,
+ * otherwise wait for a period.  The null device takes data as fast as it is
+ * written, so the time spent is that of the plugin's buffer, its pump thread
+ * and the signalling between the two threads.
+ *
+ * Cases are named after the transfer and the size of a block in frames, e.g.
+ * "rw-256" or "mmap-4096".  For each case, one more line is printed before
+ * the usual one, with the context switches of both threads per second of
+ * audio:
+ *
+ *   {"bench": "alsa", "case": "rw-256", "switches_per_s": 12.5,
+ *    "voluntary_per_s": 12.0, "involuntary_per_s": 0.5}
+ *
+ * Usage: pump [seconds] [case ...] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <audacious/plugin.h>
+
+#include "../bench.h"
+#include "alsa.h"
+
+#define RATE 44100
+#define CHANNELS 2
+
+/* of audio; the null device takes an hour in well under a second */
+static int seconds = 3600;
+
+/* ---- what alsa.c needs from config.c and the audacious program ---- */
+
+char * alsa_config_pcm = "null", * alsa_config_mixer = "default",
+ * alsa_config_mixer_element = "";
+int alsa_config_drain_workaround = 1;
+int alsa_config_mmap = 0;
+
+void alsa_config_load (void)
+{
+}
+
+void alsa_config_save (void)
+{
+}
+
+int aud_get_int (const char * section, const char * name)
+{
+    if (! section && ! strcmp (name, "output_buffer_size"))
+        return 500;
+
+    return 0;
+}
+
+bool_t aud_get_verbose_mode (void)
+{
+    return FALSE;
+}
+
+void aud_interface_show_error (const char * message)
+{
+    fprintf (stderr, "%s\n", message);
+}
+
+/* ---- the benchmark ---- */
+
+typedef struct {
+    const char * name;
+    int mmap;
+    int block; /* frames */
+} Case;
+
+static double run_pump (void * data)
+{
+    const Case * c = data;
+    int block_bytes = c->block * CHANNELS * 2;
+    char * block = calloc (1, block_bytes);
+    int64_t frames = (int64_t) RATE * seconds;
+
+    alsa_config_mmap = c->mmap;
+
+    if (! alsa_open_audio (FMT_S16_NE, RATE, CHANNELS))
+    {
+        free (block);
+        return -1;
+    }
+
+    struct rusage before, after;
+    getrusage (RUSAGE_SELF, & before);
+
+    for (int64_t done = 0; done < frames; done += c->block)
+    {
+        int left = block_bytes;
+
+        while (left > 0)
+        {
+            int ready = alsa_buffer_free ();
+
+            if (! ready)
+            {
+                alsa_period_wait ();
+                continue;
+            }
+
+            int n = (ready < left) ? ready : left;
+            alsa_write_audio (block + block_bytes - left, n);
+            left -= n;
+        }
+    }
+
+    alsa_drain ();
+
+    getrusage (RUSAGE_SELF, & after);
+
+    /* everything written must have been played */
+    int played = alsa_output_time ();
+    int expect = (frames + c->block - 1) / c->block * c->block * 1000 / RATE;
+
+    alsa_close_audio ();
+    free (block);
+
+    if (played < expect - 1)
+    {
+        fprintf (stderr, "Played %d ms of %d.\n", played, expect);
+        return -1;
+    }
+
+    long vol = after.ru_nvcsw - before.ru_nvcsw;
+    long invol = after.ru_nivcsw - before.ru_nivcsw;
+
+    printf ("{\"bench\": \"alsa\", \"case\": \"%s\", \"switches_per_s\": %.2f, "
+     "\"voluntary_per_s\": %.2f, \"involuntary_per_s\": %.2f}\n", c->name,
+     (double) (vol + invol) / seconds, (double) vol / seconds, (double)
+     invol / seconds);
+    fflush (stdout);
+
+    return seconds;
+}
+
+static const Case cases[] = {
+    {"rw-256", 0, 256},
+    {"rw-4096", 0, 4096},
+    {"mmap-256", 1, 256},
+    {"mmap-4096", 1, 4096}
+};
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo info = {"alsa", "realtime_factor", TRUE};
+    int failed = 0;
+
+    if (argc > 1)
+        seconds = atoi (argv[1]);
+
+    if (seconds <= 0)
+    {
+        fprintf (stderr, "Usage: %s [seconds] [case ...]\n", argv[0]);
+        return 1;
+    }
+
+    for (unsigned i = 0; i < sizeof cases / sizeof cases[0]; i ++)
+    {
+        int selected = (argc <= 2);
+
+        for (int a = 2; a < argc; a ++)
+        {
+            if (! strcmp (argv[a], cases[i].name))
+                selected = 1;
+        }
+
+        if (selected && bench_run (& info, cases[i].name, run_pump,
+         (void *) & cases[i]) < 0)
+            failed = 1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,215 @@
+/*
+ * startup.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Loads a generated playlist through the audpl plugin, once from the text
+ * format and once from the binary sidecar, as is done for every playlist at
+ * startup.  The plugin is linked in and called through its header.
+ *
+ * Usage: startup [entries] [case ...] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <audacious/plugin.h>
+
+#include "../bench.h"
+
+#define LOADS 10
+
+PlaylistPlugin * get_plugin_info (AudAPITable * table);
+
+static PlaylistPlugin * plugin;
+static int entries = 20000;
+static char dir[] = "/tmp/audpl-bench-XXXXXX";
+
+static const char * const artists[] = {"Ashra", "Cluster", "Harmonia",
+ "Kraftwerk", "Neu!", "Popol Vuh", "Tangerine Dream"};
+
+/* a playlist as it would be after scanning: most entries have a full tuple,
+ * some have not been scanned yet */
+static void make_playlist (Index * filenames, Index * tuples)
+{
+    for (int i = 0; i < entries; i ++)
+    {
+        char uri[128], title[64];
+        const char * artist = artists[i % (sizeof artists / sizeof artists[0])];
+
+        snprintf (uri, sizeof uri, "file:///home/user/Music/%s/Album %d/"
+         "%02d - Track %d.flac", artist, i / 12, i % 12 + 1, i);
+        snprintf (title, sizeof title, "Track %d", i);
+
+        Tuple * tuple = NULL;
+
+        if (i % 10)
+        {
+            tuple = tuple_new_from_filename (uri);
+            tuple_set_str (tuple, FIELD_TITLE, NULL, title);
+            tuple_set_str (tuple, FIELD_ARTIST, NULL, artist);
+            tuple_set_str (tuple, FIELD_CODEC, NULL, "Free Lossless Audio Codec (FLAC)");
+            tuple_set_str (tuple, FIELD_QUALITY, NULL, "lossless");
+            tuple_set_int (tuple, FIELD_TRACK_NUMBER, NULL, i % 12 + 1);
+            tuple_set_int (tuple, FIELD_LENGTH, NULL, 180000 + i % 97 * 1000);
+            tuple_set_int (tuple, FIELD_YEAR, NULL, 1970 + i % 10);
+            tuple_set_int (tuple, FIELD_BITRATE, NULL, 900 + i % 300);
+        }
+
+        index_append (filenames, str_get (uri));
+        index_append (tuples, tuple);
+    }
+}
+
+static void free_playlist (Index * filenames, Index * tuples)
+{
+    for (int i = 0; i < index_count (filenames); i ++)
+    {
+        str_unref (index_get (filenames, i));
+
+        Tuple * tuple = index_get (tuples, i);
+        if (tuple)
+            tuple_unref (tuple);
+    }
+
+    index_free (filenames);
+    index_free (tuples);
+}
+
+static bool_t save (const char * name, bool_t keep_bin)
+{
+    char uri[128], bin[128];
+    snprintf (uri, sizeof uri, "file://%s/%s", dir, name);
+    snprintf (bin, sizeof bin, "%s/%s.bin", dir, name);
+
+    Index * filenames = index_new ();
+    Index * tuples = index_new ();
+    make_playlist (filenames, tuples);
+
+    VFSFile * file = vfs_fopen (uri, "w");
+    bool_t success = FALSE;
+
+    if (file)
+    {
+        success = plugin->save (uri, file, "Benchmark", filenames, tuples);
+
+        if (vfs_fclose (file))
+            success = FALSE;
+    }
+
+    free_playlist (filenames, tuples);
+
+    if (! success || access (bin, F_OK))
+    {
+        fprintf (stderr, "Failed to write %s.\n", uri);
+        return FALSE;
+    }
+
+    if (! keep_bin)
+        unlink (bin);
+
+    return TRUE;
+}
+
+static double run_load (void * data)
+{
+    char uri[128];
+    snprintf (uri, sizeof uri, "file://%s/%s", dir, (const char *) data);
+
+    for (int i = 0; i < LOADS; i ++)
+    {
+        VFSFile * file = vfs_fopen (uri, "r");
+        if (! file)
+            return -1;
+
+        char * title = NULL;
+        Index * filenames = index_new ();
+        Index * tuples = index_new ();
+
+        bool_t success = plugin->load (uri, file, & title, filenames, tuples) &&
+         index_count (filenames) == entries;
+
+        vfs_fclose (file);
+        str_unref (title);
+        free_playlist (filenames, tuples);
+
+        if (! success)
+            return -1;
+    }
+
+    return (double) entries * LOADS;
+}
+
+static const struct {
+    const char * name;
+    const char * file;
+    bool_t keep_bin;
+} cases[] = {
+    {"text", "text.audpl", FALSE},
+    {"binary", "binary.audpl", TRUE}
+};
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo info = {"audpl", "entries_per_s"};
+    int failed = 0;
+
+    if (argc > 1)
+        entries = atoi (argv[1]);
+
+    if (entries <= 0)
+    {
+        fprintf (stderr, "Usage: %s [entries] [case ...]\n", argv[0]);
+        return 1;
+    }
+
+    plugin = get_plugin_info (NULL);
+
+    if (! mkdtemp (dir))
+    {
+        perror (dir);
+        return 1;
+    }
+
+    for (unsigned i = 0; i < sizeof cases / sizeof cases[0]; i ++)
+    {
+        bool_t selected = (argc <= 2);
+
+        for (int a = 2; a < argc; a ++)
+        {
+            if (! strcmp (argv[a], cases[i].name))
+                selected = TRUE;
+        }
+
+        if (! selected)
+            continue;
+
+        if (! save (cases[i].file, cases[i].keep_bin) || bench_run (& info,
+         cases[i].name, run_load, (void *) cases[i].file) < 0)
+            failed = 1;
+
+        char path[128];
+        snprintf (path, sizeof path, "%s/%s", dir, cases[i].file);
+        unlink (path);
+        snprintf (path, sizeof path, "%s/%s.bin", dir, cases[i].file);
+        unlink (path);
+    }
+
+    rmdir (dir);
+    return failed;
+}
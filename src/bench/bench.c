@@ -0,0 +1,147 @@
+/*
+ * bench.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+static int64_t allocs, alloc_bytes;
+static double start_cpu, start_wall;
+
+#ifdef __GLIBC__
+
+/* Counting is done by wrapping the allocator of the C library.  Some of the
+ * benchmarks run threads, so the counters are updated atomically. */
+
+extern void * __libc_malloc (size_t size);
+extern void * __libc_calloc (size_t count, size_t size);
+extern void * __libc_realloc (void * ptr, size_t size);
+
+void * malloc (size_t size)
+{
+    __atomic_add_fetch (& allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch (& alloc_bytes, size, __ATOMIC_RELAXED);
+    return __libc_malloc (size);
+}
+
+void * calloc (size_t count, size_t size)
+{
+    __atomic_add_fetch (& allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch (& alloc_bytes, count * size, __ATOMIC_RELAXED);
+    return __libc_calloc (count, size);
+}
+
+void * realloc (void * ptr, size_t size)
+{
+    __atomic_add_fetch (& allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch (& alloc_bytes, size, __ATOMIC_RELAXED);
+    return __libc_realloc (ptr, size);
+}
+
+#define HAVE_ALLOC_COUNTS 1
+#else
+#define HAVE_ALLOC_COUNTS 0
+#endif
+
+static double timeval_seconds (const struct timeval * tv)
+{
+    return tv->tv_sec + tv->tv_usec / 1000000.0;
+}
+
+static double get_cpu (void)
+{
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, & usage);
+    return timeval_seconds (& usage.ru_utime) + timeval_seconds (& usage.ru_stime);
+}
+
+static double get_wall (void)
+{
+    struct timeval tv;
+    gettimeofday (& tv, NULL);
+    return timeval_seconds (& tv);
+}
+
+void bench_reset (void)
+{
+    allocs = 0;
+    alloc_bytes = 0;
+    start_cpu = get_cpu ();
+    start_wall = get_wall ();
+}
+
+int bench_run (const BenchInfo * info, const char * name, BenchFunc func,
+ void * data)
+{
+    fflush (stdout);
+
+    pid_t pid = fork ();
+
+    if (pid < 0)
+    {
+        perror ("fork");
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        bench_reset ();
+
+        double work = func (data);
+
+        double cpu = get_cpu () - start_cpu;
+        double wall = get_wall () - start_wall;
+        double per = info->wall_rate ? wall : cpu;
+        int64_t count = allocs, bytes = alloc_bytes;
+
+        if (work < 0)
+        {
+            fprintf (stderr, "%s: %s failed.\n", info->bench, name);
+            _exit (1);
+        }
+
+        struct rusage usage;
+        getrusage (RUSAGE_SELF, & usage);
+
+        printf ("{\"bench\": \"%s\", \"case\": \"%s\", \"work\": %g, "
+         "\"cpu_s\": %.4f, \"wall_s\": %.4f, \"%s\": %.2f, "
+         "\"peak_rss_kb\": %ld, \"allocs\": %lld, \"alloc_bytes\": %lld}\n",
+         info->bench, name, work, cpu, wall, info->rate_name,
+         (per > 0) ? work / per : 0, (long) usage.ru_maxrss,
+         HAVE_ALLOC_COUNTS ? (long long) count : -1LL,
+         HAVE_ALLOC_COUNTS ? (long long) bytes : -1LL);
+
+        fflush (stdout);
+        _exit (0);
+    }
+
+    int status;
+    if (waitpid (pid, & status, 0) < 0 || ! WIFEXITED (status) ||
+     WEXITSTATUS (status))
+        return -1;
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * bench.h
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Shared part of the benchmark programs under src/bench.  Each case is run in
+ * a child process of its own, so that its peak RSS and allocation counts are
+ * not mixed up with those of the other cases.  Results are printed to stdout,
+ * one JSON object per line:
+ *
+ *   {"bench": "render", "case": "gme-vgm", "work": 60, "cpu_s": 0.25,
+ *    "wall_s": 0.25, "realtime_factor": 240.0, "peak_rss_kb": 3480,
+ *    "allocs": 52, "alloc_bytes": 1048576}
+ *
+ * "work" is in whatever unit the benchmark measures (seconds of audio, frames,
+ * playlist entries); the rate is work per CPU second, under the name given by
+ * the benchmark.  Benchmarks that spread work over threads ask for work per
+ * wall-clock second instead.  Allocation counts cover malloc, calloc and
+ * realloc, and are only available with glibc (-1 otherwise). */
+
+#ifndef AUD_BENCH_H
+#define AUD_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const char * bench;      /* name of the program, e.g. "render" */
+    const char * rate_name;  /* e.g. "realtime_factor" */
+    int wall_rate;           /* rate per wall-clock second, not CPU second */
+} BenchInfo;
+
+/* Runs a case in a child process and prints its results.  func returns the
+ * amount of work done, or a negative value on failure.  Returns 0 on
+ * success. */
+typedef double (* BenchFunc) (void * data);
+int bench_run (const BenchInfo * info, const char * name, BenchFunc func,
+ void * data);
+
+/* Restarts the clocks and allocation counters; for work done by func that
+ * should not be measured, such as generating test data. */
+void bench_reset (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
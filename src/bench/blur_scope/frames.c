@@ -0,0 +1,162 @@
+/*
+ * frames.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Blurs frames of the Blur Scope image at a few common window sizes, as the
+ * plugin does at scale 1.  Before timing, one frame is checked against a
+ * plain per-channel version of the filter.
+ *
+ * Usage: frames [frames] [case ...] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "../bench.h"
+#include "blur.h"
+
+#define FADE 6
+
+typedef struct {
+    gint width, height;
+} FrameSize;
+
+static gint frames = 200;
+
+static guint32 reference_pixel (const guint32 * p, gint stride)
+{
+    guint32 out = 0;
+
+    for (gint shift = 0; shift < 24; shift += 8)
+    {
+        gint sum = ((p[- stride] >> shift) & 0xFF) + ((p[-1] >> shift) & 0xFF) +
+         ((p[1] >> shift) & 0xFF) + ((p[stride] >> shift) & 0xFF) - FADE;
+
+        out |= (guint32) (MAX (sum, 0) >> 2) << shift;
+    }
+
+    return out;
+}
+
+static double run_blur (void * data)
+{
+    const FrameSize * size = data;
+    gint width = size->width, height = size->height, stride = width + 2;
+
+    /* one-pixel black border, as in the plugin */
+    guint32 * image = g_new0 (guint32, stride * (height + 2));
+    guint32 * back = g_new0 (guint32, stride * (height + 2));
+    guint32 * corner = image + stride + 1;
+    guint32 * back_corner = back + stride + 1;
+
+    guint32 seed = 1;
+
+    for (gint y = 0; y < height; y ++)
+    {
+        for (gint x = 0; x < width; x ++)
+        {
+            seed = seed * 1103515245 + 12345;
+            corner[stride * y + x] = (seed >> 8) & 0xFFFFFF;
+        }
+    }
+
+    for (gint y = 0; y < height; y ++)
+        blur_row (corner + stride * y, back_corner + stride * y, width, stride,
+         FADE);
+
+    for (gint y = 0; y < height; y ++)
+    {
+        for (gint x = 0; x < width; x ++)
+        {
+            if (back_corner[stride * y + x] != reference_pixel (corner +
+             stride * y + x, stride))
+            {
+                fprintf (stderr, "%dx%d: wrong pixel at %d,%d.\n", width,
+                 height, x, y);
+                g_free (image);
+                g_free (back);
+                return -1;
+            }
+        }
+    }
+
+    bench_reset ();
+
+    for (gint f = 0; f < frames; f ++)
+    {
+        for (gint y = 0; y < height; y ++)
+            blur_row (corner + stride * y, back_corner + stride * y, width,
+             stride, FADE);
+
+        guint32 * swap = corner;
+        corner = back_corner;
+        back_corner = swap;
+    }
+
+    g_free (image);
+    g_free (back);
+
+    return frames;
+}
+
+static FrameSize vga = {640, 480};
+static FrameSize full_hd = {1920, 1080};
+static FrameSize uhd = {3840, 2160};
+
+static const struct {
+    const char * name;
+    FrameSize * size;
+} cases[] = {
+    {"640x480", & vga},
+    {"1920x1080", & full_hd},
+    {"3840x2160", & uhd}
+};
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo info = {"blur_scope", "frames_per_s"};
+    int failed = 0;
+
+    if (argc > 1)
+        frames = atoi (argv[1]);
+
+    if (frames <= 0)
+    {
+        fprintf (stderr, "Usage: %s [frames] [case ...]\n", argv[0]);
+        return 1;
+    }
+
+    for (unsigned i = 0; i < G_N_ELEMENTS (cases); i ++)
+    {
+        gboolean selected = (argc <= 2);
+
+        for (gint a = 2; a < argc; a ++)
+        {
+            if (! strcmp (argv[a], cases[i].name))
+                selected = TRUE;
+        }
+
+        if (selected && bench_run (& info, cases[i].name, run_blur,
+         cases[i].size) < 0)
+            failed = 1;
+    }
+
+    return failed;
+}
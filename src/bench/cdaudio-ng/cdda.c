@@ -0,0 +1,445 @@
+/*
+ * cdda.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Reads a generated audio CD image through the cdaudio-ng plugin, linked in
+ * and called through its header.  The image is a BIN/CUE pair with CD-Text in
+ * the cue sheet; the "device" setting names the cue sheet, so libcdio opens it
+ * with its image driver and no drive is needed.  Every frame of the image
+ * holds its own position on the disc, so each byte played is checked.
+ *
+ *   toc   reads the tuples of all tracks, as the playlist does when the disc
+ *         is added, and checks their lengths and CD-Text (tracks_per_s)
+ *   play  plays every track from start to end (realtime_factor)
+ *   seek  plays the last track, seeking back and forth from the output as the
+ *         user would, and checks that playback resumes at each new position
+ *         (realtime_factor)
+ *
+ * Usage: cdda [case ...] */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <audacious/misc.h>
+#include <audacious/playlist.h>
+#include <audacious/plugin.h>
+
+#include "../bench.h"
+
+#define TRACKS 4
+#define ROUNDS 100 /* the toc case reads every tuple this many times */
+#define SEEK_AFTER 44100 /* frames played before each seek */
+
+static const int track_seconds[TRACKS] = {30, 45, 60, 75};
+static const int seeks[] = {40000, 5000, 70000, 20000}; /* ms */
+
+InputPlugin * get_plugin_info (AudAPITable * table);
+
+static InputPlugin * plugin;
+static InputPlayback playback;
+static char dir[] = "/tmp/cdda-bench-XXXXXX";
+static char bin_path[64], cue_path[64];
+/* in sectors, indexed by track; TRACKS + 1 is the end of the disc */
+static int track_start[TRACKS + 2];
+
+/* ---- the part of the core that the plugin uses ---- */
+
+void aud_config_set_defaults (const char * section, const char * const *
+ entries)
+{
+}
+
+char * aud_get_string (const char * section, const char * name)
+{
+    if (section && ! strcmp (section, "CDDA") && ! strcmp (name, "device"))
+        return strdup (cue_path);
+
+    return strdup ("");
+}
+
+bool_t aud_get_bool (const char * section, const char * name)
+{
+    /* CD-Text only; CDDB would go out to the network */
+    return section && ! strcmp (section, "CDDA") && ! strcmp (name,
+     "use_cdtext");
+}
+
+int aud_get_int (const char * section, const char * name)
+{
+    if (! section && ! strcmp (name, "output_buffer_size"))
+        return 500;
+    if (section && ! strcmp (section, "CDDA") && ! strcmp (name, "disc_speed"))
+        return 2;
+
+    return 0;
+}
+
+void aud_interface_show_error (const char * message)
+{
+    fprintf (stderr, "%s\n", message);
+}
+
+int aud_playlist_count (void)
+{
+    return 0;
+}
+
+int aud_playlist_entry_count (int playlist)
+{
+    return 0;
+}
+
+char * aud_playlist_entry_get_filename (int playlist, int entry)
+{
+    return NULL;
+}
+
+void aud_playlist_entry_delete (int playlist, int at, int number)
+{
+}
+
+/* ---- the output, which checks what is played ---- */
+
+static int play_track;
+static int64_t next_frame; /* the position the next frame should have */
+static int64_t played; /* frames */
+static int since_seek; /* frames */
+static int n_seeks, seeks_done;
+static const char * error;
+
+static void fail (const char * message)
+{
+    if (! error)
+        error = message;
+}
+
+static bool_t output_open_audio (int format, int rate, int channels)
+{
+    if (format != FMT_S16_LE || rate != 44100 || channels != 2)
+        fail ("The plugin opened the output in the wrong format.");
+
+    return TRUE;
+}
+
+static void output_set_replaygain_info (const ReplayGainInfo * info)
+{
+}
+
+static void output_write_audio (void * data, int length)
+{
+    const unsigned char * p = data;
+
+    if (length % 4)
+        fail ("The plugin wrote a partial frame.");
+
+    for (int i = 0; i + 4 <= length; i += 4)
+    {
+        uint32_t f = next_frame ++;
+
+        if (p[i] != (f & 0xff) || p[i + 1] != ((f >> 8) & 0xff) || p[i + 2] !=
+         ((f >> 16) & 0xff) || p[i + 3] != (f >> 24))
+            fail ("The plugin played the wrong data.");
+    }
+
+    played += length / 4;
+    since_seek += length / 4;
+
+    /* called on the play thread, as the core would call it from the main
+     * thread while playback goes on */
+    if (seeks_done < n_seeks && since_seek >= SEEK_AFTER)
+        plugin->mseek (& playback, seeks[seeks_done]);
+}
+
+static void output_abort_write (void)
+{
+}
+
+static void output_pause (bool_t pause)
+{
+}
+
+static int output_written_time (void)
+{
+    return played * 1000 / 44100;
+}
+
+static void output_flush (int time)
+{
+    if (seeks_done >= n_seeks || time != seeks[seeks_done])
+        fail ("The plugin flushed the output to the wrong time.");
+
+    next_frame = (int64_t) (track_start[play_track] + time * 75 / 1000) * 588;
+    since_seek = 0;
+    seeks_done ++;
+}
+
+static struct OutputAPI output = {
+    .open_audio = output_open_audio,
+    .set_replaygain_info = output_set_replaygain_info,
+    .write_audio = output_write_audio,
+    .abort_write = output_abort_write,
+    .pause = output_pause,
+    .written_time = output_written_time,
+    .flush = output_flush
+};
+
+static void playback_set_pb_ready (InputPlayback * p)
+{
+}
+
+static void playback_set_params (InputPlayback * p, int bitrate, int
+ samplerate, int channels)
+{
+}
+
+static InputPlayback playback = {
+    .set_pb_ready = playback_set_pb_ready,
+    .set_params = playback_set_params,
+    .output = & output
+};
+
+/* ---- the benchmark ---- */
+
+static void make_uri (char * uri, int size, int track)
+{
+    snprintf (uri, size, "cdda://?%d", track);
+}
+
+static bool_t check_tuple (int track)
+{
+    char uri[32], title[32], artist[32];
+    make_uri (uri, sizeof uri, track);
+    snprintf (title, sizeof title, "Track %d", track);
+    snprintf (artist, sizeof artist, "Artist %d", track);
+
+    Tuple * tuple = plugin->probe_for_tuple (uri, NULL);
+    if (! tuple)
+    {
+        fprintf (stderr, "Cannot read track %d.\n", track);
+        return FALSE;
+    }
+
+    char * got_title = tuple_get_str (tuple, FIELD_TITLE, NULL);
+    char * got_artist = tuple_get_str (tuple, FIELD_ARTIST, NULL);
+    char * got_album = tuple_get_str (tuple, FIELD_ALBUM, NULL);
+    int length = tuple_get_int (tuple, FIELD_LENGTH, NULL);
+
+    bool_t ok = got_title && ! strcmp (got_title, title) && got_artist &&
+     ! strcmp (got_artist, artist) && got_album && ! strcmp (got_album,
+     "Benchmark") && length == track_seconds[track - 1] * 1000;
+
+    str_unref (got_title);
+    str_unref (got_artist);
+    str_unref (got_album);
+    tuple_unref (tuple);
+
+    if (! ok)
+        fprintf (stderr, "Track %d was not read correctly.\n", track);
+
+    return ok;
+}
+
+static double run_toc (void * unused)
+{
+    bool_t ok = plugin->init ();
+
+    for (int r = 0; ok && r < ROUNDS; r ++)
+    {
+        for (int t = 1; ok && t <= TRACKS; t ++)
+            ok = check_tuple (t);
+    }
+
+    plugin->cleanup ();
+    return ok ? TRACKS * ROUNDS : -1;
+}
+
+static bool_t play (int track, int seek_count)
+{
+    char uri[32];
+    make_uri (uri, sizeof uri, track);
+
+    play_track = track;
+    next_frame = (int64_t) track_start[track] * 588;
+    since_seek = 0;
+    n_seeks = seek_count;
+    seeks_done = 0;
+
+    if (! plugin->play (& playback, uri, NULL, 0, -1, FALSE))
+    {
+        fprintf (stderr, "Cannot play track %d.\n", track);
+        return FALSE;
+    }
+
+    if (! error && seeks_done < n_seeks)
+        fail ("The plugin did not seek.");
+    if (! error && next_frame != (int64_t) track_start[track + 1] * 588)
+        fail ("The plugin did not play to the end of the track.");
+
+    if (error)
+    {
+        fprintf (stderr, "Track %d: %s\n", track, error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static double run_play (void * data)
+{
+    int seek_count = * (int *) data;
+    bool_t ok = plugin->init ();
+
+    /* reading the TOC is measured by the toc case */
+    if (ok)
+        ok = check_tuple (1);
+
+    bench_reset ();
+    played = 0;
+
+    if (seek_count)
+        ok = ok && play (TRACKS, seek_count);
+    else
+    {
+        for (int t = 1; ok && t <= TRACKS; t ++)
+            ok = play (t, 0);
+    }
+
+    plugin->cleanup ();
+    return ok ? (double) played / 44100 : -1;
+}
+
+/* A disc of TRACKS audio tracks in one BIN file.  The position of each frame
+ * on the disc, counted from the start of the first track, is written as a
+ * 32-bit number: the low half in the left channel, the high half in the
+ * right. */
+static bool_t make_image (void)
+{
+    snprintf (bin_path, sizeof bin_path, "%s/disc.bin", dir);
+    snprintf (cue_path, sizeof cue_path, "%s/disc.cue", dir);
+
+    FILE * bin = fopen (bin_path, "w");
+    FILE * cue = fopen (cue_path, "w");
+
+    if (! bin || ! cue)
+    {
+        if (bin)
+            fclose (bin);
+        if (cue)
+            fclose (cue);
+
+        fprintf (stderr, "Cannot write the image in %s.\n", dir);
+        return FALSE;
+    }
+
+    fprintf (cue, "TITLE \"Benchmark\"\nPERFORMER \"Various\"\n"
+     "FILE \"%s\" BINARY\n", bin_path);
+
+    int lsn = 0;
+
+    for (int t = 1; t <= TRACKS; t ++)
+    {
+        track_start[t] = lsn;
+
+        fprintf (cue, "  TRACK %02d AUDIO\n    TITLE \"Track %d\"\n"
+         "    PERFORMER \"Artist %d\"\n    INDEX 01 %02d:%02d:%02d\n", t, t, t,
+         lsn / 75 / 60, lsn / 75 % 60, lsn % 75);
+
+        for (int end = lsn + track_seconds[t - 1] * 75; lsn < end; lsn ++)
+        {
+            unsigned char sector[2352];
+
+            for (int i = 0; i < 588; i ++)
+            {
+                uint32_t f = (uint32_t) lsn * 588 + i;
+                sector[4 * i] = f & 0xff;
+                sector[4 * i + 1] = (f >> 8) & 0xff;
+                sector[4 * i + 2] = (f >> 16) & 0xff;
+                sector[4 * i + 3] = f >> 24;
+            }
+
+            fwrite (sector, 1, sizeof sector, bin);
+        }
+    }
+
+    track_start[TRACKS + 1] = lsn;
+
+    bool_t ok = ! ferror (bin) && ! ferror (cue);
+
+    if (fclose (bin))
+        ok = FALSE;
+    if (fclose (cue))
+        ok = FALSE;
+
+    if (! ok)
+        fprintf (stderr, "Failed to write the image in %s.\n", dir);
+
+    return ok;
+}
+
+static bool_t selected (int argc, char * * argv, const char * name)
+{
+    if (argc <= 1)
+        return TRUE;
+
+    for (int a = 1; a < argc; a ++)
+    {
+        if (! strcmp (argv[a], name))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo toc_info = {"cdaudio", "tracks_per_s", TRUE};
+    static const BenchInfo play_info = {"cdaudio", "realtime_factor", TRUE};
+    static int no_seeks = 0, all_seeks = sizeof seeks / sizeof seeks[0];
+    int failed = 0;
+
+    plugin = get_plugin_info (NULL);
+
+    if (! mkdtemp (dir))
+    {
+        perror (dir);
+        return 1;
+    }
+
+    if (! make_image ())
+        failed = 1;
+    else
+    {
+        if (selected (argc, argv, "toc") && bench_run (& toc_info, "toc",
+         run_toc, NULL) < 0)
+            failed = 1;
+        if (selected (argc, argv, "play") && bench_run (& play_info, "play",
+         run_play, & no_seeks) < 0)
+            failed = 1;
+        if (selected (argc, argv, "seek") && bench_run (& play_info, "seek",
+         run_play, & all_seeks) < 0)
+            failed = 1;
+    }
+
+    unlink (bin_path);
+    unlink (cue_path);
+    rmdir (dir);
+    return failed;
+}
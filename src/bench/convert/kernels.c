@@ -0,0 +1,451 @@
+/*
+ * kernels.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Times each function of src/common/sample_convert.c at each of the versions
+ * the CPU supports, in GB per second of samples read and written.  Before
+ * timing, each version is checked bit for bit, over many lengths, offsets and
+ * channel counts, against the plain C code the plugins used before:
+ *
+ *   from_s16, from_s24  jackout's sample_move_short_float and
+ *                       sample_move_int24_float
+ *   gain                jackout's float_volume_effect
+ *   gain_s16            sdlout's fixed-point volume
+ *
+ * The conversions to integers have no earlier plain version with the same
+ * rounding, so they are checked against the plain version in
+ * sample_convert.c.  The dithered ones are also checked for ending with the
+ * same dither state, with the input split into odd-sized pieces.
+ *
+ * Usage: kernels [gigabytes] [case ...]
+ *
+ * Cases are named after the function and version, e.g. "to_s16-avx2". */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "../bench.h"
+#include "sample_convert.h"
+
+#define BLOCK 8192 /* samples per call while timing; stays in the cache */
+#define CHECK_SAMPLES 4099
+#define MAX_CHANNELS 9
+#define SEED 0x12345678
+
+static double gigabytes = 4;
+static int channels;
+static float gains[MAX_CHANNELS];
+static int factors[MAX_CHANNELS];
+
+/* ---- the earlier plain versions ---- */
+
+static void old_from_s16 (const void * in, void * out, int samples)
+{
+    const short * src = in;
+    float * dst = out;
+
+    for (int i = 0; i < samples; i ++)
+        dst[i] = (float) (src[i]) / 32768.0f;
+}
+
+static void old_from_s24 (const void * in, void * out, int samples)
+{
+    const int32_t * src = in;
+    float * dst = out;
+
+    for (int i = 0; i < samples; i ++)
+        dst[i] = (float) (src[i]) / 8388608.0f;
+}
+
+static void old_gain (const void * in, void * out, int samples)
+{
+    memcpy (out, in, sizeof (float) * samples);
+
+    for (int c = 0; c < channels; c ++)
+    {
+        float * buf = (float *) out + c;
+        float volume = gains[c];
+
+        for (int n = (samples - c + channels - 1) / channels; n --; )
+        {
+            * buf = (* buf) * volume;
+            buf += channels;
+        }
+    }
+}
+
+static void old_gain_s16 (const void * in, void * out, int samples)
+{
+    memcpy (out, in, sizeof (int16_t) * samples);
+
+    int16_t * i = out;
+
+    for (int s = 0; s < samples; s ++)
+        i[s] = ((int) i[s] * factors[s % channels]) >> 16;
+}
+
+/* ---- the functions under test, with a common signature ---- */
+
+static SampleDither dither;
+
+static void run_from_s16 (const void * in, void * out, int samples)
+{
+    sample_from_s16 (in, out, samples);
+}
+
+static void run_from_s24 (const void * in, void * out, int samples)
+{
+    sample_from_s24 (in, out, samples);
+}
+
+static void run_to_s16 (const void * in, void * out, int samples)
+{
+    sample_to_s16 (in, out, samples);
+}
+
+static void run_to_s24 (const void * in, void * out, int samples)
+{
+    sample_to_s24 (in, out, samples);
+}
+
+static void run_to_s16_dither (const void * in, void * out, int samples)
+{
+    sample_to_s16_dither (in, out, samples, & dither);
+}
+
+static void run_to_s24_dither (const void * in, void * out, int samples)
+{
+    sample_to_s24_dither (in, out, samples, & dither);
+}
+
+static void run_gain (const void * in, void * out, int samples)
+{
+    if (in != out)
+        memcpy (out, in, sizeof (float) * samples);
+
+    sample_gain (out, channels, samples / channels, gains);
+}
+
+static void run_gain_s16 (const void * in, void * out, int samples)
+{
+    if (in != out)
+        memcpy (out, in, sizeof (int16_t) * samples);
+
+    sample_gain_s16 (out, channels, samples / channels, factors);
+}
+
+typedef enum {
+    INPUT_S16,
+    INPUT_S24,
+    INPUT_FLOAT
+} InputType;
+
+typedef struct {
+    const char * name;
+    InputType input;
+    int in_size, out_size;
+    void (* run) (const void * in, void * out, int samples);
+    void (* old) (const void * in, void * out, int samples); /* or NULL */
+    gboolean in_place, dithered;
+} Kernel;
+
+static const Kernel kernels[] = {
+    {"from_s16", INPUT_S16, 2, 4, run_from_s16, old_from_s16},
+    {"from_s24", INPUT_S24, 4, 4, run_from_s24, old_from_s24},
+    {"to_s16", INPUT_FLOAT, 4, 2, run_to_s16, NULL},
+    {"to_s24", INPUT_FLOAT, 4, 4, run_to_s24, NULL},
+    {"to_s16_dither", INPUT_FLOAT, 4, 2, run_to_s16_dither, NULL, FALSE, TRUE},
+    {"to_s24_dither", INPUT_FLOAT, 4, 4, run_to_s24_dither, NULL, FALSE, TRUE},
+    {"gain", INPUT_FLOAT, 4, 4, run_gain, old_gain, TRUE},
+    {"gain_s16", INPUT_S16, 2, 2, run_gain_s16, old_gain_s16, TRUE}
+};
+
+static const char * const level_names[] = {"scalar", "sse2", "avx2"};
+
+/* ---- test data ---- */
+
+static guint32 seed = 1;
+
+static guint32 next_random (void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) | (seed << 16);
+}
+
+/* Mostly ordinary samples, with the edge cases mixed in: values exactly half
+ * way between two steps, full scale, clipping, NaN, infinities, denormals and
+ * negative zero. */
+static void fill_input (InputType type, void * buf, int samples)
+{
+    static const float specials[] = {0.0f, -0.0f, 1.0f, -1.0f, 1.5f, -3.0f,
+     0.5f / 32768, 1.5f / 32768, -2.5f / 32768, 32767.5f / 32768, 0.5f /
+     8388608, -8388607.5f / 8388608, 1e-40f, -1e-40f, 1e30f, -1e30f};
+
+    for (int i = 0; i < samples; i ++)
+    {
+        guint32 r = next_random ();
+
+        if (type == INPUT_S16)
+            ((int16_t *) buf)[i] = (int16_t) r;
+        else if (type == INPUT_S24)
+        {
+            /* sign-extended 24-bit, and now and then other high bits */
+            int32_t x = (int32_t) (r << 8) >> 8;
+            ((int32_t *) buf)[i] = (i % 97) ? x : (int32_t) (r * 2654435761u);
+        }
+        else
+        {
+            float x = ((float) (r & 0xffffff) / 0x800000 - 1) * 1.2f;
+
+            if (! (i % 13))
+                x = specials[(r >> 24) % G_N_ELEMENTS (specials)];
+            else if (! (i % 211))
+                x = (r & 1) ? NAN : ((r & 2) ? INFINITY : - INFINITY);
+
+            ((float *) buf)[i] = x;
+        }
+    }
+}
+
+static void pick_gains (int round)
+{
+    static const int special_factors[] = {0, 1, 32767, 32768, 32769, 40000,
+     65535, 65536};
+
+    for (int c = 0; c < MAX_CHANNELS; c ++)
+    {
+        guint32 r = next_random ();
+
+        if (round & 1)
+            factors[c] = special_factors[(r >> 8) % G_N_ELEMENTS
+             (special_factors)];
+        else
+            factors[c] = r % 65537;
+
+        gains[c] = (float) factors[c] / 65536 * ((r & 1) ? -1 : 1);
+    }
+}
+
+/* ---- checking ---- */
+
+/* the plain version in sample_convert.c, or the old one */
+static void reference (const Kernel * k, const void * in, void * out,
+ int samples)
+{
+    if (k->old)
+        k->old (in, out, samples);
+    else
+    {
+        int level = sample_convert_level ();
+        sample_convert_set_level (SAMPLE_SCALAR);
+        k->run (in, out, samples);
+        sample_convert_set_level (level);
+    }
+}
+
+static int check_one (const Kernel * k, const char * in, int samples,
+ int pieces)
+{
+    char * expect = g_malloc (k->out_size * samples + 1);
+    char * got = g_malloc (k->out_size * samples + 1);
+    SampleDither dither_expect;
+    int failed = 0;
+
+    /* the output is written one byte off alignment */
+    memset (expect, 0x55, k->out_size * samples + 1);
+    memset (got, 0x55, k->out_size * samples + 1);
+
+    sample_dither_init (& dither, SEED);
+    reference (k, in, expect + 1, samples);
+    dither_expect = dither;
+
+    sample_dither_init (& dither, SEED);
+
+    /* in pieces of odd length, to start and stop part way through a vector
+     * and through the dither sequence */
+    for (int done = 0, part = 0; done < samples; part ++)
+    {
+        int length = (pieces > 1) ? MIN (samples - done, 1 + 7 * part) :
+         samples - done;
+        length -= length % channels;
+        if (! length)
+            length = samples - done;
+
+        k->run (in + k->in_size * done, got + 1 + k->out_size * done, length);
+        done += length;
+    }
+
+    if (memcmp (got, expect, k->out_size * samples + 1))
+    {
+        for (int i = 0; i < samples; i ++)
+        {
+            if (memcmp (got + 1 + k->out_size * i, expect + 1 + k->out_size *
+             i, k->out_size))
+            {
+                fprintf (stderr, "%s-%s: sample %d of %d differs (%d "
+                 "channels).\n", k->name, level_names[sample_convert_level
+                 ()], i, samples, channels);
+                break;
+            }
+        }
+
+        failed = 1;
+    }
+    else if (k->dithered && memcmp (& dither, & dither_expect, sizeof dither))
+    {
+        fprintf (stderr, "%s-%s: dither state differs after %d samples.\n",
+         k->name, level_names[sample_convert_level ()], samples);
+        failed = 1;
+    }
+
+    g_free (expect);
+    g_free (got);
+
+    return failed ? -1 : 0;
+}
+
+static int check (const Kernel * k)
+{
+    /* one spare sample so that the input can start off alignment */
+    char * in = g_malloc (k->in_size * (CHECK_SAMPLES + 1));
+    int failed = 0;
+
+    fill_input (k->input, in, CHECK_SAMPLES + 1);
+
+    for (int round = 0; round < 4 && ! failed; round ++)
+    {
+        pick_gains (round);
+
+        for (channels = 1; channels <= MAX_CHANNELS && ! failed; channels ++)
+        {
+            for (int length = channels; length < 80 && ! failed; length +=
+             channels)
+            {
+                for (int skip = 0; skip < 2 && ! failed; skip ++)
+                {
+                    if (check_one (k, in + k->in_size * skip, length, 1) < 0)
+                        failed = 1;
+                }
+            }
+
+            int length = CHECK_SAMPLES - CHECK_SAMPLES % channels;
+
+            if (! failed && (check_one (k, in, length, 1) < 0 || check_one (k,
+             in + k->in_size, length, 2) < 0))
+                failed = 1;
+        }
+    }
+
+    g_free (in);
+    return failed ? -1 : 0;
+}
+
+/* ---- timing ---- */
+
+typedef struct {
+    const Kernel * kernel;
+    int level;
+} KernelCase;
+
+static double run_case (void * data)
+{
+    const KernelCase * c = data;
+    const Kernel * k = c->kernel;
+
+    sample_convert_set_level (c->level);
+
+    if (check (k) < 0)
+        return -1;
+
+    /* stereo, with gains that keep the samples from decaying to denormals */
+    channels = 2;
+    gains[0] = 1.0f;
+    gains[1] = -1.0f;
+    factors[0] = 65535;
+    factors[1] = 40000;
+
+    void * in = g_malloc (k->in_size * BLOCK);
+    void * out = g_malloc (k->out_size * BLOCK);
+
+    fill_input (k->input, in, BLOCK);
+    if (k->in_place)
+        memcpy (out, in, k->in_size * BLOCK);
+
+    sample_dither_init (& dither, SEED);
+    bench_reset ();
+
+    double bytes_per_call = (double) (k->in_size + k->out_size) * BLOCK;
+    long calls = gigabytes * 1e9 / bytes_per_call;
+
+    for (long i = 0; i < calls; i ++)
+        k->run (k->in_place ? out : in, out, BLOCK);
+
+    g_free (in);
+    g_free (out);
+
+    return calls * bytes_per_call / 1e9;
+}
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo info = {"convert", "gb_per_s"};
+    int failed = 0;
+
+    if (argc > 1)
+        gigabytes = atof (argv[1]);
+
+    if (gigabytes <= 0)
+    {
+        fprintf (stderr, "Usage: %s [gigabytes] [case ...]\n", argv[0]);
+        return 1;
+    }
+
+    int max_level = sample_convert_level ();
+
+    if (max_level < SAMPLE_AVX2)
+        fprintf (stderr, "The CPU does not support %s; those cases are "
+         "skipped.\n", (max_level < SAMPLE_SSE2) ? "SSE2 or AVX2" : "AVX2");
+
+    for (unsigned i = 0; i < G_N_ELEMENTS (kernels); i ++)
+    {
+        for (int level = SAMPLE_SCALAR; level <= max_level; level ++)
+        {
+            KernelCase c = {& kernels[i], level};
+            char * name = g_strdup_printf ("%s-%s", kernels[i].name,
+             level_names[level]);
+            gboolean selected = (argc <= 2);
+
+            for (int a = 2; a < argc; a ++)
+            {
+                if (! strcmp (argv[a], name))
+                    selected = TRUE;
+            }
+
+            if (selected && bench_run (& info, name, run_case, & c) < 0)
+                failed = 1;
+
+            g_free (name);
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,332 @@
+/*
+ * pixels.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Draws the bars of the OpenGL Spectrum Analyzer into an offscreen EGL
+ * pbuffer, both with the plugin's vertex arrays and with the immediate mode
+ * calls it used before, and compares the two images pixel for pixel before
+ * timing them.  No window system is needed; with Mesa, run with
+ * EGL_PLATFORM=surfaceless to use llvmpipe.
+ *
+ * Usage: pixels [frames] [case ...] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <EGL/egl.h>
+#include <GL/gl.h>
+
+#include "../bench.h"
+#include "bars.h"
+
+#define WIDTH 640
+#define HEIGHT 480
+#define COMPARE_FRAMES 64
+
+#define BAR_SPACING (3.2f / NUM_BANDS)
+#define BAR_WIDTH (0.8f * BAR_SPACING)
+
+static int frames = 200;
+
+static float heights[NUM_BANDS][NUM_BANDS];
+static int pos;
+static float angle;
+static unsigned seed = 1;
+
+/* a new row of pseudo-random heights, as the plugin gets from render_freq */
+static void next_row (void)
+{
+    for (int j = 0; j < NUM_BANDS; j ++)
+    {
+        seed = seed * 1103515245 + 12345;
+        heights[pos][j] = (float) ((seed >> 8) & 0xFFFF) / 0xFFFF;
+    }
+
+    pos = (pos + 1) % NUM_BANDS;
+    angle += 0.5f;
+}
+
+/* the drawing code as it was before the vertex arrays */
+static void reference_rectangle (float x1, float y1, float z1, float x2,
+ float y2, float z2, float r, float g, float b)
+{
+    glColor3f (r, g, b);
+
+    glBegin (GL_POLYGON);
+    glVertex3f (x1, y2, z1);
+    glVertex3f (x2, y2, z1);
+    glVertex3f (x2, y2, z2);
+    glVertex3f (x1, y2, z2);
+    glEnd ();
+
+    glColor3f (0.65f * r, 0.65f * g, 0.65f * b);
+
+    glBegin (GL_POLYGON);
+    glVertex3f (x1, y1, z1);
+    glVertex3f (x1, y2, z1);
+    glVertex3f (x1, y2, z2);
+    glVertex3f (x1, y1, z2);
+    glEnd ();
+
+    glBegin (GL_POLYGON);
+    glVertex3f (x2, y2, z1);
+    glVertex3f (x2, y1, z1);
+    glVertex3f (x2, y1, z2);
+    glVertex3f (x2, y2, z2);
+    glEnd ();
+
+    glColor3f (0.8f * r, 0.8f * g, 0.8f * b);
+
+    glBegin (GL_POLYGON);
+    glVertex3f (x1, y1, z1);
+    glVertex3f (x2, y1, z1);
+    glVertex3f (x2, y2, z1);
+    glVertex3f (x1, y2, z1);
+    glEnd ();
+}
+
+static void reference_draw (void)
+{
+    glPushMatrix ();
+    glTranslatef (0.0f, -0.5f, -5.0f);
+    glRotatef (38.0f, 1.0f, 0.0f, 0.0f);
+    glRotatef (angle + 180.0f, 0.0f, 1.0f, 0.0f);
+    glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
+
+    for (int i = 0; i < NUM_BANDS; i ++)
+    {
+        float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+
+        for (int j = 0; j < NUM_BANDS; j ++)
+        {
+            float x = 1.6f - BAR_SPACING * j;
+            float h = heights[(pos + i) % NUM_BANDS][j] * 1.6f;
+            float bright = 0.2f + 0.8f * h;
+            float xf = (float) i / (NUM_BANDS - 1);
+            float yf = (float) j / (NUM_BANDS - 1);
+
+            reference_rectangle (x, 0, z, x + BAR_WIDTH, h, z + BAR_WIDTH,
+             (1 - xf) * (1 - yf) * bright, xf * bright, yf * bright);
+        }
+    }
+
+    glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
+    glPopMatrix ();
+}
+
+static int open_context (void)
+{
+    static const EGLint config_attribs[] = {
+     EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+     EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+     EGL_RED_SIZE, 8,
+     EGL_GREEN_SIZE, 8,
+     EGL_BLUE_SIZE, 8,
+     EGL_DEPTH_SIZE, 16,
+     EGL_NONE
+    };
+
+    static const EGLint surface_attribs[] = {
+     EGL_WIDTH, WIDTH,
+     EGL_HEIGHT, HEIGHT,
+     EGL_NONE
+    };
+
+    EGLDisplay display = eglGetDisplay (EGL_DEFAULT_DISPLAY);
+    EGLConfig config;
+    EGLint configs;
+
+    if (! eglInitialize (display, NULL, NULL) || ! eglChooseConfig (display,
+     config_attribs, & config, 1, & configs) || ! configs ||
+     ! eglBindAPI (EGL_OPENGL_API))
+    {
+        fprintf (stderr, "No EGL display with desktop OpenGL.\n");
+        return -1;
+    }
+
+    EGLSurface surface = eglCreatePbufferSurface (display, config,
+     surface_attribs);
+    EGLContext context = eglCreateContext (display, config, EGL_NO_CONTEXT,
+     NULL);
+
+    if (surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT ||
+     ! eglMakeCurrent (display, surface, surface, context))
+    {
+        fprintf (stderr, "Cannot create an EGL pbuffer context.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* the same state that the plugin sets up around bars_draw () */
+static void draw_frame (void (* draw) (void))
+{
+    glViewport (0, 0, WIDTH, HEIGHT);
+
+    glDisable (GL_BLEND);
+    glMatrixMode (GL_PROJECTION);
+    glPushMatrix ();
+    glLoadIdentity ();
+    glFrustum (-1.1f, 1, -1.5f, 1, 2, 10);
+    glMatrixMode (GL_MODELVIEW);
+    glPushMatrix ();
+    glLoadIdentity ();
+    glEnable (GL_DEPTH_TEST);
+    glDepthFunc (GL_LESS);
+    glPolygonMode (GL_FRONT, GL_FILL);
+    glEnable (GL_BLEND);
+    glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glClearColor (0, 0, 0, 1);
+    glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    draw ();
+
+    glPopMatrix ();
+    glMatrixMode (GL_PROJECTION);
+    glPopMatrix ();
+    glDisable (GL_DEPTH_TEST);
+    glDisable (GL_BLEND);
+    glDepthMask (GL_TRUE);
+
+    glFinish ();
+}
+
+static void vertex_array_draw (void)
+{
+    bars_draw (angle);
+}
+
+/* Draws a few frames both ways and compares them.  GL_POLYGON and GL_QUADS
+ * may be split into triangles along different diagonals, which changes the
+ * rounding of depth and color along the edges of the faces; up to 1 in 1000
+ * of the lit pixels is allowed to differ. */
+static int compare (void)
+{
+    static unsigned char expect[WIDTH * HEIGHT * 4];
+    static unsigned char got[WIDTH * HEIGHT * 4];
+    int total = 0;
+
+    for (int f = 0; f < COMPARE_FRAMES; f ++)
+    {
+        next_row ();
+        bars_update (heights, pos);
+
+        draw_frame (reference_draw);
+        glReadPixels (0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, expect);
+        draw_frame (vertex_array_draw);
+        glReadPixels (0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, got);
+
+        int different = 0, lit = 0;
+
+        for (int i = 0; i < WIDTH * HEIGHT * 4; i += 4)
+        {
+            if (memcmp (got + i, expect + i, 4))
+                different ++;
+            if (expect[i] || expect[i + 1] || expect[i + 2])
+                lit ++;
+        }
+
+        if (! lit || different > lit / 1000)
+        {
+            fprintf (stderr, "Frame %d: %d of %d lit pixels differ.\n", f,
+             different, lit);
+            return -1;
+        }
+
+        total += different;
+    }
+
+    return total;
+}
+
+static double run_draw (void * data)
+{
+    int vertex_arrays = (data != NULL);
+
+    if (open_context () < 0)
+        return -1;
+
+    bars_init ();
+
+    int different = compare ();
+    if (different < 0)
+        return -1;
+
+    fprintf (stderr, "%s: %d pixels differ in %d frames.\n", (const char *)
+     glGetString (GL_RENDERER), different, COMPARE_FRAMES);
+
+    bench_reset ();
+
+    for (int f = 0; f < frames; f ++)
+    {
+        next_row ();
+
+        if (vertex_arrays)
+        {
+            bars_update (heights, pos);
+            draw_frame (vertex_array_draw);
+        }
+        else
+            draw_frame (reference_draw);
+    }
+
+    return frames;
+}
+
+static const struct {
+    const char * name;
+    void * data;
+} cases[] = {
+    {"immediate", NULL},
+    {"vertex-arrays", (void *) 1}
+};
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo info = {"gl-spectrum", "frames_per_s"};
+    int failed = 0;
+
+    if (argc > 1)
+        frames = atoi (argv[1]);
+
+    if (frames <= 0)
+    {
+        fprintf (stderr, "Usage: %s [frames] [case ...]\n", argv[0]);
+        return 1;
+    }
+
+    for (unsigned i = 0; i < sizeof cases / sizeof cases[0]; i ++)
+    {
+        int selected = (argc <= 2);
+
+        for (int a = 2; a < argc; a ++)
+        {
+            if (! strcmp (argv[a], cases[i].name))
+                selected = 1;
+        }
+
+        if (selected && bench_run (& info, cases[i].name, run_draw,
+         cases[i].data) < 0)
+            failed = 1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,344 @@
+/*
+ * scroll.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Scrolls the playlist widget of the GTK interface through a generated
+ * playlist with all columns shown, in an offscreen window.  The playlist
+ * functions of the core are replaced by ones that read from an array of
+ * tuples and count how often the widget asks for a tuple.
+ *
+ *   wheel  three rows or so per frame, as a mouse wheel does
+ *   page   one page per frame, as Page Down does
+ *   jump   to random places, as dragging the scroll bar far does
+ *
+ * A frame is timed from setting the scroll position to the end of the redraw.
+ * Idle work, such as the widget's prefetching, runs between frames and is not
+ * part of the frame time, as it would be done while waiting for the next
+ * scroll event; it does count as CPU time.  For each case, one more line is
+ * printed before the usual one:
+ *
+ *   {"bench": "gtkui", "case": "wheel", "frame_ms_median": 1.2,
+ *    "frame_ms_p95": 2.5, "frame_ms_max": 9.8, "lookups_per_frame": 0.5}
+ *
+ * It needs a display; without one, run it under Xvfb.
+ *
+ * Usage: scroll [entries] [case ...] */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtk/gtk.h>
+
+#include <audacious/playlist.h>
+#include <libaudcore/audstrings.h>
+
+#include "../bench.h"
+#include "gtkui.h"
+#include "playlist_util.h"
+#include "ui_playlist_widget.h"
+
+#define FRAMES 1000
+#define WIDTH 1000
+#define HEIGHT 700
+
+static gint entries = 200000;
+static Tuple * * tuples;
+static gint lookups;
+
+static const gchar * const artists[] = {"Ashra", "Cluster", "Harmonia",
+ "Kraftwerk", "Neu!", "Popol Vuh", "Tangerine Dream"};
+static const gchar * const genres[] = {"Ambient", "Electronic", "Krautrock",
+ "Rock"};
+
+/* ---- the part of the core that the widget uses ---- */
+
+const gchar * const pw_col_names[PW_COLS] = {"Entry number", "Title",
+ "Artist", "Year", "Album", "Track", "Genre", "Queue position", "Length",
+ "File path", "File name", "Custom title", "Bitrate"};
+
+gint pw_num_cols;
+gint pw_cols[PW_COLS];
+
+gint aud_playlist_entry_count (gint list)
+{
+    return entries;
+}
+
+Tuple * aud_playlist_entry_get_tuple (gint list, gint entry, gboolean fast)
+{
+    lookups ++;
+    return tuple_ref (tuples[entry]);
+}
+
+void aud_playlist_entry_describe (gint list, gint entry, gchar * * title,
+ gchar * * artist, gchar * * album, gboolean fast)
+{
+    lookups ++;
+    * title = tuple_get_str (tuples[entry], FIELD_TITLE, NULL);
+    * artist = tuple_get_str (tuples[entry], FIELD_ARTIST, NULL);
+    * album = tuple_get_str (tuples[entry], FIELD_ALBUM, NULL);
+}
+
+gchar * aud_playlist_entry_get_title (gint list, gint entry, gboolean fast)
+{
+    lookups ++;
+
+    gchar * title = tuple_get_str (tuples[entry], FIELD_TITLE, NULL);
+    gchar * artist = tuple_get_str (tuples[entry], FIELD_ARTIST, NULL);
+    gchar * custom = str_printf ("%s - %s", artist, title);
+
+    str_unref (title);
+    str_unref (artist);
+    return custom;
+}
+
+gint aud_playlist_entry_get_length (gint list, gint entry, gboolean fast)
+{
+    return tuple_get_int (tuples[entry], FIELD_LENGTH, NULL);
+}
+
+gboolean aud_playlist_entry_get_selected (gint list, gint entry)
+{
+    return FALSE;
+}
+
+void aud_playlist_entry_set_selected (gint list, gint entry,
+ gboolean selected)
+{
+}
+
+void aud_playlist_select_all (gint list, gboolean selected)
+{
+}
+
+gint aud_playlist_get_focus (gint list)
+{
+    return -1;
+}
+
+void aud_playlist_set_focus (gint list, gint entry)
+{
+}
+
+void aud_playlist_set_position (gint list, gint entry)
+{
+}
+
+void aud_playlist_shift (gint list, gint entry, gint distance)
+{
+}
+
+gint aud_playlist_queue_count (gint list)
+{
+    return 0;
+}
+
+gint aud_playlist_queue_get_entry (gint list, gint at)
+{
+    return -1;
+}
+
+gint aud_playlist_queue_find_entry (gint list, gint entry)
+{
+    return -1;
+}
+
+void aud_drct_play_playlist (gint list)
+{
+}
+
+gboolean aud_get_bool (const gchar * section, const gchar * name)
+{
+    return FALSE;
+}
+
+gint aud_get_int (const gchar * section, const gchar * name)
+{
+    return 0;
+}
+
+void popup_menu_rclick (guint button, guint32 time)
+{
+}
+
+gint playlist_count_selected_in_range (gint list, gint top, gint length)
+{
+    return 0;
+}
+
+/* ---- the benchmark ---- */
+
+static void make_playlist (void)
+{
+    tuples = g_malloc (sizeof (Tuple *) * entries);
+
+    for (gint i = 0; i < entries; i ++)
+    {
+        gchar uri[128], title[64], album[64];
+        const gchar * artist = artists[i % G_N_ELEMENTS (artists)];
+
+        snprintf (uri, sizeof uri, "file:///home/user/Music/%s/Album%%20%d/"
+         "%02d%%20-%%20Track%%20%d.flac", artist, i / 12, i % 12 + 1, i);
+        snprintf (title, sizeof title, "Track %d", i);
+        snprintf (album, sizeof album, "Album %d", i / 12);
+
+        Tuple * tuple = tuple_new_from_filename (uri);
+        tuple_set_str (tuple, FIELD_TITLE, NULL, title);
+        tuple_set_str (tuple, FIELD_ARTIST, NULL, artist);
+        tuple_set_str (tuple, FIELD_ALBUM, NULL, album);
+        tuple_set_str (tuple, FIELD_GENRE, NULL, genres[i / 12 % G_N_ELEMENTS
+         (genres)]);
+        tuple_set_int (tuple, FIELD_TRACK_NUMBER, NULL, i % 12 + 1);
+        tuple_set_int (tuple, FIELD_LENGTH, NULL, 180000 + i % 97 * 1000);
+        tuple_set_int (tuple, FIELD_YEAR, NULL, 1970 + i % 10);
+        tuple_set_int (tuple, FIELD_BITRATE, NULL, 900 + i % 300);
+
+        tuples[i] = tuple;
+    }
+}
+
+static void run_idle (void)
+{
+    while (gtk_events_pending ())
+        gtk_main_iteration ();
+}
+
+static gint compare_times (const void * a, const void * b)
+{
+    gint64 x = * (const gint64 *) a, y = * (const gint64 *) b;
+    return (x > y) - (x < y);
+}
+
+static double next_value (const gchar * mode, GtkAdjustment * vadj,
+ double value, double * step)
+{
+    double page = gtk_adjustment_get_page_size (vadj);
+    double top = gtk_adjustment_get_upper (vadj) - page;
+
+    if (! strcmp (mode, "jump"))
+        return top * g_random_double ();
+
+    /* GTK scrolls by page^(2/3) pixels per wheel click */
+    double size = ! strcmp (mode, "page") ? page : pow (page, 2.0 / 3.0);
+
+    /* turn around at the ends */
+    if (value + * step * size > top || value + * step * size < 0)
+        * step = - * step;
+
+    return value + * step * size;
+}
+
+static double run_scroll (void * data)
+{
+    const gchar * mode = data;
+
+    if (! gtk_init_check (NULL, NULL))
+    {
+        fprintf (stderr, "Cannot open a display.\n");
+        return -1;
+    }
+
+    g_random_set_seed (1);
+    make_playlist ();
+
+    pw_num_cols = PW_COLS;
+    for (gint i = 0; i < PW_COLS; i ++)
+        pw_cols[i] = i;
+
+    GtkWidget * window = gtk_offscreen_window_new ();
+    GtkWidget * scroll = gtk_scrolled_window_new (NULL, NULL);
+    GtkWidget * list = ui_playlist_widget_new (0);
+
+    gtk_widget_set_size_request (scroll, WIDTH, HEIGHT);
+    gtk_container_add ((GtkContainer *) scroll, list);
+    gtk_container_add ((GtkContainer *) window, scroll);
+    gtk_widget_show_all (window);
+
+    GtkAdjustment * vadj = gtk_scrollable_get_vadjustment ((GtkScrollable *)
+     list);
+
+    run_idle ();
+    gdk_window_process_all_updates ();
+    run_idle ();
+
+    bench_reset ();
+    lookups = 0;
+
+    gint64 times[FRAMES];
+    double value = 0, step = 1;
+
+    for (gint f = 0; f < FRAMES; f ++)
+    {
+        gint64 start = g_get_monotonic_time ();
+
+        value = next_value (mode, vadj, value, & step);
+        gtk_adjustment_set_value (vadj, value);
+        gdk_window_process_all_updates ();
+
+        times[f] = g_get_monotonic_time () - start;
+
+        run_idle ();
+    }
+
+    qsort (times, FRAMES, sizeof times[0], compare_times);
+
+    printf ("{\"bench\": \"gtkui\", \"case\": \"%s\", \"frame_ms_median\": "
+     "%.3f, \"frame_ms_p95\": %.3f, \"frame_ms_max\": %.3f, "
+     "\"lookups_per_frame\": %.2f}\n", mode, times[FRAMES / 2] / 1000.0,
+     times[FRAMES * 95 / 100] / 1000.0, times[FRAMES - 1] / 1000.0,
+     (double) lookups / FRAMES);
+
+    gtk_widget_destroy (window);
+
+    return FRAMES;
+}
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo info = {"gtkui", "frames_per_s", TRUE};
+    static const gchar * const modes[] = {"wheel", "page", "jump"};
+    gint failed = 0;
+
+    if (argc > 1)
+        entries = atoi (argv[1]);
+
+    if (entries <= 0)
+    {
+        fprintf (stderr, "Usage: %s [entries] [case ...]\n", argv[0]);
+        return 1;
+    }
+
+    for (gint m = 0; m < G_N_ELEMENTS (modes); m ++)
+    {
+        gboolean selected = (argc <= 2);
+
+        for (gint a = 2; a < argc; a ++)
+        {
+            if (! strcmp (argv[a], modes[m]))
+                selected = TRUE;
+        }
+
+        if (selected && bench_run (& info, modes[m], run_scroll, (void *)
+         modes[m]) < 0)
+            failed = 1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,308 @@
+/*
+ * chain.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Runs stereo audio through the effect chain of the LADSPA host, linked in
+ * without its user interface.  The plugins are built into the program: a
+ * passthrough, a gain, and the same gain marked LADSPA_PROPERTY_INPLACE_BROKEN
+ * so that it gets output buffers of its own.  The output of each chain is
+ * checked before timing.
+ *
+ * Usage: chain [seconds] [case ...] */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../bench.h"
+#include "ladspa.h"
+#include "plugin.h"
+
+#define CHANNELS 2
+#define RATE 44100
+#define BLOCK 2048 /* frames passed to ladspa_process at once */
+#define GAIN 0.9f
+
+/* used by effect.c; normally defined in plugin.c */
+pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+Index * loadeds;
+
+static int song_seconds = 600;
+
+/* ---- bundled plugins ---- */
+
+enum {PORT_IN, PORT_OUT, PORT_GAIN, PORTS};
+
+typedef struct {
+    LADSPA_Data * ports[PORTS];
+} Instance;
+
+static const LADSPA_PortDescriptor port_descs[PORTS] = {
+ LADSPA_PORT_INPUT | LADSPA_PORT_AUDIO,
+ LADSPA_PORT_OUTPUT | LADSPA_PORT_AUDIO,
+ LADSPA_PORT_INPUT | LADSPA_PORT_CONTROL};
+
+static const char * const port_names[PORTS] = {"Input", "Output", "Gain"};
+
+static const LADSPA_PortRangeHint port_hints[PORTS] = {
+ {0, 0, 0}, {0, 0, 0},
+ {LADSPA_HINT_BOUNDED_BELOW | LADSPA_HINT_BOUNDED_ABOVE |
+  LADSPA_HINT_DEFAULT_1, 0, 2}};
+
+static LADSPA_Handle instantiate (const LADSPA_Descriptor * desc,
+ unsigned long rate)
+{
+    return calloc (1, sizeof (Instance));
+}
+
+static void connect_port (LADSPA_Handle handle, unsigned long port,
+ LADSPA_Data * data)
+{
+    ((Instance *) handle)->ports[port] = data;
+}
+
+static void run_passthrough (LADSPA_Handle handle, unsigned long frames)
+{
+    Instance * inst = handle;
+
+    if (inst->ports[PORT_OUT] != inst->ports[PORT_IN])
+        memcpy (inst->ports[PORT_OUT], inst->ports[PORT_IN], sizeof
+         (LADSPA_Data) * frames);
+}
+
+static void run_gain (LADSPA_Handle handle, unsigned long frames)
+{
+    Instance * inst = handle;
+    const LADSPA_Data * in = inst->ports[PORT_IN];
+    LADSPA_Data * out = inst->ports[PORT_OUT];
+    LADSPA_Data gain = * inst->ports[PORT_GAIN];
+
+    for (unsigned long i = 0; i < frames; i ++)
+        out[i] = in[i] * gain;
+}
+
+static void cleanup (LADSPA_Handle handle)
+{
+    free (handle);
+}
+
+static const LADSPA_Descriptor passthrough_desc = {
+    .Label = "passthrough",
+    .Name = "Passthrough",
+    .PortCount = 2,
+    .PortDescriptors = port_descs,
+    .PortNames = port_names,
+    .PortRangeHints = port_hints,
+    .instantiate = instantiate,
+    .connect_port = connect_port,
+    .run = run_passthrough,
+    .cleanup = cleanup
+};
+
+static const LADSPA_Descriptor gain_desc = {
+    .Label = "gain",
+    .Name = "Gain",
+    .PortCount = PORTS,
+    .PortDescriptors = port_descs,
+    .PortNames = port_names,
+    .PortRangeHints = port_hints,
+    .instantiate = instantiate,
+    .connect_port = connect_port,
+    .run = run_gain,
+    .cleanup = cleanup
+};
+
+static const LADSPA_Descriptor gain_copy_desc = {
+    .Label = "gain_copy",
+    .Name = "Gain (not in place)",
+    .Properties = LADSPA_PROPERTY_INPLACE_BROKEN,
+    .PortCount = PORTS,
+    .PortDescriptors = port_descs,
+    .PortNames = port_names,
+    .PortRangeHints = port_hints,
+    .instantiate = instantiate,
+    .connect_port = connect_port,
+    .run = run_gain,
+    .cleanup = cleanup
+};
+
+/* ---- the chain ---- */
+
+/* what plugin.c would have found out from the descriptor */
+static PluginData * make_plugin (const LADSPA_Descriptor * desc)
+{
+    PluginData * plugin = g_new0 (PluginData, 1);
+    plugin->desc = desc;
+    plugin->controls = index_new ();
+    plugin->in_ports = g_array_new (0, 0, sizeof (int));
+    plugin->out_ports = g_array_new (0, 0, sizeof (int));
+
+    for (int i = 0; i < (int) desc->PortCount; i ++)
+    {
+        if (LADSPA_IS_PORT_CONTROL (desc->PortDescriptors[i]))
+        {
+            ControlData * control = g_new0 (ControlData, 1);
+            control->port = i;
+            control->def = GAIN;
+            index_append (plugin->controls, control);
+        }
+        else if (LADSPA_IS_PORT_INPUT (desc->PortDescriptors[i]))
+            g_array_append_val (plugin->in_ports, i);
+        else
+            g_array_append_val (plugin->out_ports, i);
+    }
+
+    return plugin;
+}
+
+static void load_chain (const LADSPA_Descriptor * desc, int length)
+{
+    PluginData * plugin = make_plugin (desc);
+    loadeds = index_new ();
+
+    for (int i = 0; i < length; i ++)
+    {
+        LoadedPlugin * loaded = g_new0 (LoadedPlugin, 1);
+        loaded->plugin = plugin;
+        loaded->values = g_new (float, index_count (plugin->controls));
+
+        for (int c = 0; c < index_count (plugin->controls); c ++)
+            loaded->values[c] = ((ControlData *) index_get (plugin->controls,
+             c))->def;
+
+        index_append (loadeds, loaded);
+    }
+}
+
+/* a sine on each channel, at different pitches */
+static void fill_block (float * data)
+{
+    for (int f = 0; f < BLOCK; f ++)
+    {
+        for (int c = 0; c < CHANNELS; c ++)
+            data[CHANNELS * f + c] = 0.5f * sinf (f * (c + 1) * (float) (2 *
+             M_PI * 440 / RATE));
+    }
+}
+
+typedef struct {
+    const LADSPA_Descriptor * desc;
+    int length;
+} ChainCase;
+
+static double run_case (void * data)
+{
+    const ChainCase * chain = data;
+    int channels = CHANNELS, rate = RATE;
+
+    load_chain (chain->desc, chain->length);
+    ladspa_start (& channels, & rate);
+
+    float * block = g_new (float, CHANNELS * BLOCK);
+    float * expect = g_new (float, CHANNELS * BLOCK);
+    float gain = (chain->desc == & passthrough_desc) ? 1 : powf (GAIN,
+     chain->length);
+
+    fill_block (block);
+    for (int i = 0; i < CHANNELS * BLOCK; i ++)
+        expect[i] = block[i] * gain;
+
+    float * out = block;
+    int samples = CHANNELS * BLOCK;
+    ladspa_process (& out, & samples);
+
+    for (int i = 0; i < CHANNELS * BLOCK; i ++)
+    {
+        if (fabsf (out[i] - expect[i]) > 1e-5f)
+        {
+            fprintf (stderr, "Sample %d is %f, should be %f.\n", i, out[i],
+             expect[i]);
+            return -1;
+        }
+    }
+
+    /* the chain works in place, so each block starts from a fresh copy of the
+     * input; otherwise the gain would soon leave only denormals */
+    fill_block (expect);
+    bench_reset ();
+
+    long total = (long) RATE * song_seconds;
+
+    for (long done = 0; done < total; done += BLOCK)
+    {
+        memcpy (block, expect, sizeof (float) * CHANNELS * BLOCK);
+        out = block;
+        samples = CHANNELS * BLOCK;
+        ladspa_process (& out, & samples);
+    }
+
+    out = block;
+    samples = 0;
+    ladspa_finish (& out, & samples);
+
+    g_free (block);
+    g_free (expect);
+
+    return song_seconds;
+}
+
+static ChainCase passthrough_1 = {& passthrough_desc, 1};
+static ChainCase gain_5 = {& gain_desc, 5};
+static ChainCase gain_copy_5 = {& gain_copy_desc, 5};
+
+static const struct {
+    const char * name;
+    ChainCase * chain;
+} cases[] = {
+    {"passthrough-x1", & passthrough_1},
+    {"gain-x5", & gain_5},
+    {"gain-not-in-place-x5", & gain_copy_5}
+};
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo info = {"ladspa", "realtime_factor"};
+    int failed = 0;
+
+    if (argc > 1)
+        song_seconds = atoi (argv[1]);
+
+    if (song_seconds <= 0)
+    {
+        fprintf (stderr, "Usage: %s [seconds] [case ...]\n", argv[0]);
+        return 1;
+    }
+
+    for (unsigned i = 0; i < G_N_ELEMENTS (cases); i ++)
+    {
+        gboolean selected = (argc <= 2);
+
+        for (int a = 2; a < argc; a ++)
+        {
+            if (! strcmp (argv[a], cases[i].name))
+                selected = TRUE;
+        }
+
+        if (selected && bench_run (& info, cases[i].name, run_case,
+         cases[i].chain) < 0)
+            failed = 1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,518 @@
+/*
+ * render.cxx
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Renders generated tunes with the emulator engines of the console, vtx and
+ * adplug plugins, linked in without their plugin glue, into a null sink.
+ *
+ * Usage: render [seconds] [case ...] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gme.h"
+#include "ayemu.h"
+#include "emuopl.h"
+
+extern "C" {
+#include "../bench.h"
+}
+
+#define RATE 44100
+#define BUF_FRAMES 1024
+
+/* the "tunes" are pseudo-random pentatonic melodies, a note every 1/8 s */
+#define STEPS_PER_SECOND 8
+#define SONG_STEPS 128
+
+static int song_seconds = 60;
+
+static double note_freq (int note)
+{
+    /* note 0 is A 110 Hz */
+    static const double semitone = 1.0594630943592953;
+    double f = 110;
+
+    while (note -- > 0)
+        f *= semitone;
+
+    return f;
+}
+
+static int next_note (unsigned * seed)
+{
+    static const int scale[5] = {0, 3, 5, 7, 10};
+
+    * seed = * seed * 1103515245 + 12345;
+    unsigned r = (* seed >> 16) & 0x7fff;
+
+    return scale[r % 5] + 12 * (r / 5 % 3);
+}
+
+class Writer
+{
+public:
+    Writer () : data (NULL), len (0), size (0) {}
+    ~Writer () { free (data); }
+
+    void byte (int b)
+    {
+        if (len == size)
+        {
+            size = size ? size * 2 : 4096;
+            data = (unsigned char *) realloc (data, size);
+        }
+
+        data[len ++] = b;
+    }
+
+    void le16 (int v) { byte (v & 0xff); byte ((v >> 8) & 0xff); }
+    void le32 (long v) { le16 (v & 0xffff); le16 ((v >> 16) & 0xffff); }
+
+    void put_le32 (long pos, long v)
+    {
+        for (int i = 0; i < 4; i ++)
+            data[pos + i] = (v >> (8 * i)) & 0xff;
+    }
+
+    unsigned char * data;
+    long len, size;
+};
+
+/* VGM: YM2612 and SN76489 */
+
+static void vgm_ym (Writer & w, int ch, int reg, int val)
+{
+    w.byte ((ch < 3) ? 0x52 : 0x53);
+    w.byte (reg + ch % 3);
+    w.byte (val);
+}
+
+static void make_vgm (Writer & w)
+{
+    static const int fm_clock = 7670453, psg_clock = 3579545;
+    static const int slots[4] = {0, 8, 4, 12};   /* operators 1-4 */
+
+    for (int i = 0; i < 0x40; i ++)
+        w.byte (0);
+
+    memcpy (w.data, "Vgm ", 4);
+    w.put_le32 (0x08, 0x150);
+    w.put_le32 (0x0c, psg_clock);
+    w.put_le32 (0x24, 60);
+    w.data[0x28] = 0x09;
+    w.data[0x2a] = 16;
+    w.put_le32 (0x2c, fm_clock);
+
+    /* algorithm 4: two modulator-carrier pairs */
+    for (int ch = 0; ch < 6; ch ++)
+    {
+        for (int op = 0; op < 4; op ++)
+        {
+            vgm_ym (w, ch, 0x30 + slots[op], 0x01 + op);
+            vgm_ym (w, ch, 0x40 + slots[op], (op & 1) ? 0x08 : 0x20);
+            vgm_ym (w, ch, 0x50 + slots[op], 0x1f);
+            vgm_ym (w, ch, 0x60 + slots[op], 0x06);
+            vgm_ym (w, ch, 0x70 + slots[op], 0x02);
+            vgm_ym (w, ch, 0x80 + slots[op], 0x27);
+        }
+
+        vgm_ym (w, ch, 0xb0, 0x34);
+        vgm_ym (w, ch, 0xb4, 0xc0);
+    }
+
+    long loop = w.len;
+    unsigned seed = 1;
+
+    for (int step = 0; step < SONG_STEPS; step ++)
+    {
+        for (int ch = 0; ch < 6; ch ++)
+        {
+            int keys = (ch < 3) ? ch : ch + 1;
+
+            if ((step + ch) % 2)
+                continue;
+
+            double f = note_freq (next_note (& seed) + 12 * (ch % 3));
+            int fnum = (int) (144 * f * (1 << 20) / fm_clock / 8);
+
+            w.byte (0x52); w.byte (0x28); w.byte (keys);
+            vgm_ym (w, ch, 0xa4, (4 << 3) | (fnum >> 8));
+            vgm_ym (w, ch, 0xa0, fnum & 0xff);
+            w.byte (0x52); w.byte (0x28); w.byte (0xf0 | keys);
+        }
+
+        for (int ch = 0; ch < 3; ch ++)
+        {
+            int period = (int) (psg_clock / (32 * note_freq (next_note (& seed)
+             + 24)));
+
+            w.byte (0x50); w.byte (0x80 | (ch << 5) | (period & 0x0f));
+            w.byte (0x50); w.byte ((period >> 4) & 0x3f);
+            w.byte (0x50); w.byte (0x90 | (ch << 5) | (step + ch) % 8);
+        }
+
+        w.byte (0x61);
+        w.le16 (RATE / STEPS_PER_SECOND);
+    }
+
+    w.byte (0x66);
+
+    w.put_le32 (0x04, w.len - 0x04);
+    w.put_le32 (0x18, (long) SONG_STEPS * (RATE / STEPS_PER_SECOND));
+    w.put_le32 (0x1c, loop - 0x1c);
+    w.put_le32 (0x20, (long) SONG_STEPS * (RATE / STEPS_PER_SECOND));
+}
+
+/* SPC: eight voices looping a BRR sample, with echo */
+
+static void make_spc (Writer & w)
+{
+    static const unsigned char code[] = {
+        0x8f, 0x4c, 0xf2,   /* mov $f2, #$4c */
+        0x8f, 0xff, 0xf3,   /* mov $f3, #$ff (key on all voices) */
+        0x2f, 0xfe          /* bra * */
+    };
+
+    for (long i = 0; i < 0x10200; i ++)
+        w.byte (0);
+
+    memcpy (w.data, "SNES-SPC700 Sound File Data v0.30", 33);
+    w.data[0x21] = 26;
+    w.data[0x22] = 26;
+    w.data[0x23] = 27;
+    w.data[0x24] = 30;
+    w.data[0x25] = 0x00;   /* pc = $0200 */
+    w.data[0x26] = 0x02;
+    w.data[0x2b] = 0xef;   /* sp */
+
+    unsigned char * ram = w.data + 0x100;
+    unsigned char * dsp = w.data + 0x10100;
+
+    memcpy (ram + 0x200, code, sizeof code);
+
+    /* sample directory at $0800, one entry */
+    ram[0x800] = 0x00; ram[0x801] = 0x10;
+    ram[0x802] = 0x00; ram[0x803] = 0x10;
+
+    /* 32 BRR blocks of a rough sawtooth at $1000, looping */
+    for (int b = 0; b < 32; b ++)
+    {
+        unsigned char * block = ram + 0x1000 + 9 * b;
+
+        block[0] = (11 << 4) | ((b == 31) ? 0x03 : 0x02);
+
+        for (int i = 0; i < 8; i ++)
+            block[1 + i] = (((2 * i) & 0xf) << 4) | ((2 * i + 1) & 0xf);
+    }
+
+    for (int v = 0; v < 8; v ++)
+    {
+        unsigned char * regs = dsp + 0x10 * v;
+        int pitch = (int) (0x1000 * note_freq (v * 5) / 440);
+
+        regs[0] = 0x30;            /* volume */
+        regs[1] = 0x30;
+        regs[2] = pitch & 0xff;
+        regs[3] = (pitch >> 8) & 0x3f;
+        regs[4] = 0;               /* sample */
+        regs[5] = 0x8f;            /* ADSR */
+        regs[6] = 0xe8;
+    }
+
+    dsp[0x0c] = 0x7f;   /* main volume */
+    dsp[0x1c] = 0x7f;
+    dsp[0x2c] = 0x30;   /* echo volume */
+    dsp[0x3c] = 0x30;
+    dsp[0x0d] = 0x40;   /* echo feedback */
+    dsp[0x0f] = 0x7f;   /* echo FIR */
+    dsp[0x4d] = 0xff;   /* echo on all voices */
+    dsp[0x5d] = 0x08;   /* sample directory */
+    dsp[0x6d] = 0x60;   /* echo buffer at $6000 */
+    dsp[0x7d] = 0x04;   /* echo delay, 8 KB */
+}
+
+/* GME */
+
+struct GmeCase {
+    void (* make) (Writer & w);
+};
+
+static double run_gme (void * data)
+{
+    GmeCase * c = (GmeCase *) data;
+    Writer w;
+    Music_Emu * emu;
+
+    c->make (w);
+
+    if (gme_open_data (w.data, w.len, & emu, RATE))
+        return -1;
+
+    gme_ignore_silence (emu, 1);
+
+    if (gme_start_track (emu, 0))
+    {
+        gme_delete (emu);
+        return -1;
+    }
+
+    short buf[2 * BUF_FRAMES];
+    long frames = (long) RATE * song_seconds;
+
+    for (long done = 0; done < frames; done += BUF_FRAMES)
+    {
+        if (gme_play (emu, 2 * BUF_FRAMES, buf))
+        {
+            gme_delete (emu);
+            return -1;
+        }
+    }
+
+    gme_delete (emu);
+    return song_seconds;
+}
+
+/* vtx: the AY emulator, fed 50 register frames per second as a VTX file
+ * would.  ayemu_gen_sound() renders in runs between the edges of the audible
+ * generators, so the tunes differ in how many edges there are: a plain tune
+ * with one channel on the envelope, a fast envelope on every channel, noise
+ * only, and the plain tune at a higher chip clock. */
+
+typedef struct {
+    ayemu_chip_t chip;
+    int freq;
+    unsigned char mixer;       /* R7 */
+    unsigned char volumes[3];  /* R8-R10, 0x10 for the envelope */
+    int env_period;            /* R11-R12 */
+    unsigned char env_shape;   /* R13 */
+    unsigned char noise;       /* R6 */
+} AyCase;
+
+static double run_ay (void * data)
+{
+    const AyCase * c = (const AyCase *) data;
+    ayemu_ay_t ay;
+    unsigned char regs[14];
+    short buf[2 * (RATE / 50)];
+    unsigned seed = 1;
+
+    memset (& ay, 0, sizeof ay);
+    ayemu_init (& ay);
+    ayemu_set_chip_type (& ay, c->chip, NULL);
+    ayemu_set_chip_freq (& ay, c->freq);
+    ayemu_set_stereo (& ay, AYEMU_ABC, NULL);
+    ayemu_set_sound_format (& ay, RATE, 2, 16);
+
+    for (long frame = 0; frame < 50L * song_seconds; frame ++)
+    {
+        if (frame % (50 / STEPS_PER_SECOND) == 0)
+        {
+            for (int ch = 0; ch < 3; ch ++)
+            {
+                int period = (int) (c->freq / (16 * note_freq (next_note
+                 (& seed) + 12 * ch)));
+
+                regs[2 * ch] = period & 0xff;
+                regs[2 * ch + 1] = (period >> 8) & 0x0f;
+            }
+
+            regs[6] = c->noise;
+            regs[7] = c->mixer;
+            regs[8] = c->volumes[0];
+            regs[9] = c->volumes[1];
+            regs[10] = c->volumes[2];
+            regs[11] = c->env_period & 0xff;
+            regs[12] = c->env_period >> 8;
+            regs[13] = c->env_shape;
+        }
+        else
+            regs[13] = 0xff;          /* keep the envelope running */
+
+        ayemu_set_regs (& ay, regs);
+        ayemu_gen_sound (& ay, buf, sizeof buf);
+    }
+
+    return song_seconds;
+}
+
+/* adplug: the OPL2 emulator, with register writes as a player would make */
+
+static const int opl_ops[9] = {0, 1, 2, 8, 9, 10, 16, 17, 18};
+
+static void opl_setup (CEmuopl & opl)
+{
+    opl.init ();
+    opl.write (0x01, 0x20);
+
+    for (int ch = 0; ch < 9; ch ++)
+    {
+        for (int op = opl_ops[ch]; op <= opl_ops[ch] + 3; op += 3)
+        {
+            opl.write (0x20 + op, 0x01);
+            opl.write (0x40 + op, (op == opl_ops[ch]) ? 0x10 : 0x00);
+            opl.write (0x60 + op, 0xf4);
+            opl.write (0x80 + op, 0x55);
+            opl.write (0xe0 + op, ch % 3);
+        }
+
+        opl.write (0xc0 + ch, 0x0e);
+    }
+}
+
+static void opl_notes (CEmuopl & opl, long step, unsigned * seed)
+{
+    for (int ch = 0; ch < 9; ch ++)
+    {
+        if ((step + ch) % 3)
+            continue;
+
+        int fnum = (int) (note_freq (next_note (seed) + 12 * (ch % 3)) *
+         (1 << 16) / 49716);
+
+        opl.write (0xb0 + ch, 0);
+        opl.write (0xa0 + ch, fnum & 0xff);
+        opl.write (0xb0 + ch, 0x20 | (4 << 2) | ((fnum >> 8) & 3));
+    }
+}
+
+static double run_opl (void * data)
+{
+    static const int step_frames = RATE / STEPS_PER_SECOND;
+
+    CEmuopl opl (RATE, true, true);
+    short buf[2 * BUF_FRAMES];
+    unsigned seed = 1;
+
+    opl_setup (opl);
+
+    for (long step = 0; step < (long) STEPS_PER_SECOND * song_seconds; step ++)
+    {
+        opl_notes (opl, step, & seed);
+
+        for (int left = step_frames; left > 0; left -= BUF_FRAMES)
+            opl.update (buf, (left < BUF_FRAMES) ? left : BUF_FRAMES);
+    }
+
+    return song_seconds;
+}
+
+/* adplug: seeking through the same tune, as the plugin does, by running the
+ * player without rendering.  The player ticks 70 times a second and slides
+ * the volume of every carrier on each tick.  With "deferred" set the writes
+ * go to the shadow registers of CEmuopl and only the final state reaches the
+ * emulator; otherwise every write does. */
+
+#define OPL_TICKS_PER_SECOND 70
+
+static double run_opl_seek (void * data)
+{
+    bool deferred = * (const bool *) data;
+    CEmuopl opl (RATE, true, true);
+    short buf[2 * BUF_FRAMES];
+    unsigned seed = 1;
+
+    opl_setup (opl);
+    opl.setdeferred (deferred);
+
+    long ticks = (long) OPL_TICKS_PER_SECOND * song_seconds;
+
+    for (long tick = 0; tick < ticks; tick ++)
+    {
+        if (tick * STEPS_PER_SECOND % OPL_TICKS_PER_SECOND < STEPS_PER_SECOND)
+            opl_notes (opl, tick * STEPS_PER_SECOND / OPL_TICKS_PER_SECOND,
+             & seed);
+
+        for (int ch = 0; ch < 9; ch ++)
+            opl.write (0x43 + opl_ops[ch], tick % 32);
+    }
+
+    opl.setdeferred (false);
+
+    /* the first block after the seek */
+    opl.update (buf, BUF_FRAMES);
+
+    return song_seconds;
+}
+
+static const bool opl_deferred = true, opl_direct = false;
+
+static GmeCase vgm_case = {make_vgm};
+static GmeCase spc_case = {make_spc};
+
+/* tones on A-C and noise on C; C follows a slow envelope */
+static AyCase ay_case = {AYEMU_AY, 1773400, 0x18, {0x0f, 0x0c, 0x10}, 0x0800,
+ 0x0e, 0x08};
+/* a buzzing sawtooth envelope on every channel, tone on A */
+static AyCase ym_buzz_case = {AYEMU_YM, 2000000, 0x3e, {0x10, 0x10, 0x10},
+ 0x0010, 0x08, 0x08};
+/* the fastest noise on every channel, all tones masked */
+static AyCase ay_noise_case = {AYEMU_AY, 1773400, 0x07, {0x0f, 0x0d, 0x0b},
+ 0x0800, 0x0e, 0x01};
+/* the plain tune at twice the clock, with twice the tacts per sample */
+static AyCase ay_fast_case = {AYEMU_AY, 3546900, 0x18, {0x0f, 0x0c, 0x10},
+ 0x0800, 0x0e, 0x08};
+
+static const struct {
+    const char * name;
+    BenchFunc func;
+    void * data;
+} cases[] = {
+    {"gme-vgm", run_gme, & vgm_case},
+    {"gme-spc", run_gme, & spc_case},
+    {"vtx-ay", run_ay, & ay_case},
+    {"vtx-ym-buzz", run_ay, & ym_buzz_case},
+    {"vtx-ay-noise", run_ay, & ay_noise_case},
+    {"vtx-ay-3mhz", run_ay, & ay_fast_case},
+    {"adplug-opl2", run_opl, NULL},
+    {"adplug-seek", run_opl_seek, (void *) & opl_deferred},
+    {"adplug-seek-direct", run_opl_seek, (void *) & opl_direct}
+};
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo info = {"render", "realtime_factor"};
+    int failed = 0;
+
+    if (argc > 1)
+        song_seconds = atoi (argv[1]);
+
+    if (song_seconds <= 0)
+    {
+        fprintf (stderr, "Usage: %s [seconds] [case ...]\n", argv[0]);
+        return 1;
+    }
+
+    for (unsigned i = 0; i < sizeof cases / sizeof cases[0]; i ++)
+    {
+        bool selected = (argc <= 2);
+
+        for (int a = 2; a < argc; a ++)
+        {
+            if (! strcmp (argv[a], cases[i].name))
+                selected = true;
+        }
+
+        if (selected && bench_run (& info, cases[i].name, cases[i].func,
+         cases[i].data) < 0)
+            failed = 1;
+    }
+
+    return failed;
+}
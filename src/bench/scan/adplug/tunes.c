@@ -0,0 +1,73 @@
+/*
+ * tunes.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Tunes for the AdPlug plugin in the RAW format (Rdos raw OPL capture): a
+ * melody on one channel, a few minutes long.  The plugin plays the whole tune
+ * on a silent OPL to find its length, which is most of the work of reading
+ * the tuple. */
+
+#include "../scan.h"
+
+#define CLOCK 0x4000 /* timer divisor; 1193180 / 0x4000 = about 73 Hz */
+
+static void put (FILE * file, int reg, int value)
+{
+    /* value first, then register; register 0 means a delay of value ticks */
+    fputc (value, file);
+    fputc (reg, file);
+}
+
+static bool_t make_raw (FILE * file, int number)
+{
+    unsigned seed = number + 1;
+    int notes = 1000 + number % 200;
+
+    fwrite ("RAWADATA", 1, 8, file);
+    fputc (CLOCK & 0xff, file);
+    fputc (CLOCK >> 8, file);
+
+    /* a plain instrument on channel 0 */
+    put (file, 0x20, 0x01);
+    put (file, 0x23, 0x01);
+    put (file, 0x40, 0x10);
+    put (file, 0x43, 0x00);
+    put (file, 0x60, 0xf0);
+    put (file, 0x63, 0xf0);
+    put (file, 0x80, 0x77);
+    put (file, 0x83, 0x77);
+
+    for (int i = 0; i < notes; i ++)
+    {
+        seed = seed * 1103515245 + 12345;
+
+        int fnum = 0x158 + (seed >> 16) % 0x100;
+        int block = 3 + (seed >> 24) % 3;
+
+        put (file, 0xb0, 0); /* key off */
+        put (file, 0xa0, fnum & 0xff);
+        put (file, 0xb0, 0x20 | block << 2 | fnum >> 8);
+        put (file, 0, 8 + (seed >> 8) % 8);
+    }
+
+    put (file, 0xff, 0xff); /* end of song */
+
+    return ! ferror (file);
+}
+
+const ScanFormat scan_format = {"scan-adplug", "raw", NULL, make_raw};
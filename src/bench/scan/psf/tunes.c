@@ -0,0 +1,85 @@
+/*
+ * tunes.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Tunes for the PSF plugin: PSF1 files with a compressed program and a tag
+ * block.  The tuple comes from the tags, but the plugin decompresses the
+ * program too. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zlib.h>
+
+#include "../scan.h"
+
+#define PROGRAM_SIZE 0x10800 /* a PS-X EXE header and 64 KiB of code */
+
+static void put32 (unsigned char * p, uint32_t x)
+{
+    p[0] = x;
+    p[1] = x >> 8;
+    p[2] = x >> 16;
+    p[3] = x >> 24;
+}
+
+static bool_t make_psf (FILE * file, int number)
+{
+    static unsigned char program[PROGRAM_SIZE];
+    unsigned char header[16];
+    unsigned seed = number + 1;
+
+    memset (program, 0, sizeof program);
+    memcpy (program, "PS-X EXE", 8);
+
+    /* code that compresses about as well as the real thing */
+    for (int i = 0x800; i < PROGRAM_SIZE; i += 4)
+    {
+        seed = seed * 1103515245 + 12345;
+        put32 (program + i, (seed & 0x80000000) ? 0x24080000 | (seed >> 20 &
+         0xffff) : 0);
+    }
+
+    uLongf packed_size = compressBound (sizeof program);
+    unsigned char * packed = malloc (packed_size);
+
+    if (! packed || compress2 (packed, & packed_size, program, sizeof program,
+     9) != Z_OK)
+    {
+        free (packed);
+        return FALSE;
+    }
+
+    memcpy (header, "PSF\x01", 4);
+    put32 (header + 4, 0); /* no reserved area */
+    put32 (header + 8, packed_size);
+    put32 (header + 12, crc32 (0, packed, packed_size));
+
+    fwrite (header, 1, sizeof header, file);
+    fwrite (packed, 1, packed_size, file);
+    free (packed);
+
+    fprintf (file, "[TAG]title=Song %d\nartist=Composer %d\ngame=Game %d\n"
+     "length=%d:%02d\nfade=10\n", number, number % 17, number / 20, 1 +
+     number % 4, number % 60);
+
+    return ! ferror (file);
+}
+
+const ScanFormat scan_format = {"scan-psf", "psf", NULL, make_psf};
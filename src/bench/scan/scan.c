@@ -0,0 +1,258 @@
+/*
+ * scan.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Reads the tuples of generated tunes through the probe_for_tuple function of
+ * an input plugin, as the playlist scanner does, on 1, 2, 4 ... threads up to
+ * the number of CPUs.  The plugin is linked in and called through its header.
+ *
+ * Each file is first read once on a single thread.  Every tuple read while
+ * timing is compared with that one, so a reader that is not safe to run
+ * concurrently shows up as a failed case rather than only as a crash.  The
+ * rate is files per wall-clock second; with safe readers it grows with the
+ * number of threads.
+ *
+ * Usage: scan [files] [case ...]
+ *
+ * Cases are named after the number of threads, e.g. "threads-4". */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <audacious/plugin.h>
+
+#include "../bench.h"
+#include "scan.h"
+
+#define ROUNDS 4 /* each case reads every file this many times */
+
+InputPlugin * get_plugin_info (AudAPITable * table);
+
+static InputPlugin * plugin;
+static int files = 200;
+static char dir[] = "/tmp/scan-bench-XXXXXX";
+static char * * uris;
+static char * * expect;
+
+static int next_file;
+static int mismatches;
+
+/* the fields that the playlist shows */
+static char * describe (Tuple * tuple)
+{
+    if (! tuple)
+        return strdup ("(none)");
+
+    char * title = tuple_get_str (tuple, FIELD_TITLE, NULL);
+    char * artist = tuple_get_str (tuple, FIELD_ARTIST, NULL);
+    char * codec = tuple_get_str (tuple, FIELD_CODEC, NULL);
+    char * desc = NULL;
+
+    if (asprintf (& desc, "%s|%s|%s|%d|%d", title ? title : "", artist ?
+     artist : "", codec ? codec : "", tuple_get_int (tuple, FIELD_LENGTH,
+     NULL), tuple_get_n_subtunes (tuple)) < 0)
+        desc = NULL;
+
+    str_unref (title);
+    str_unref (artist);
+    str_unref (codec);
+
+    return desc;
+}
+
+static char * read_tuple (int i)
+{
+    VFSFile * file = vfs_fopen (uris[i], "r");
+    if (! file)
+        return NULL;
+
+    Tuple * tuple = plugin->probe_for_tuple (uris[i], file);
+    vfs_fclose (file);
+
+    char * desc = describe (tuple);
+
+    if (tuple)
+        tuple_unref (tuple);
+
+    return desc;
+}
+
+static void * scan_thread (void * unused)
+{
+    int i;
+
+    while ((i = __atomic_fetch_add (& next_file, 1, __ATOMIC_RELAXED)) <
+     files * ROUNDS)
+    {
+        char * desc = read_tuple (i % files);
+
+        if (! desc || strcmp (desc, expect[i % files]))
+        {
+            if (! __atomic_fetch_add (& mismatches, 1, __ATOMIC_RELAXED))
+                fprintf (stderr, "%s: read \"%s\", should be \"%s\".\n",
+                 uris[i % files], desc ? desc : "(error)", expect[i % files]);
+        }
+
+        free (desc);
+    }
+
+    return NULL;
+}
+
+static double run_threads (void * data)
+{
+    int threads = * (int *) data;
+    pthread_t thread[threads];
+
+    next_file = 0;
+    mismatches = 0;
+
+    for (int t = 0; t < threads; t ++)
+    {
+        if (pthread_create (& thread[t], NULL, scan_thread, NULL))
+        {
+            fprintf (stderr, "Cannot start thread %d.\n", t);
+            return -1;
+        }
+    }
+
+    for (int t = 0; t < threads; t ++)
+        pthread_join (thread[t], NULL);
+
+    if (mismatches)
+    {
+        fprintf (stderr, "%d of %d tuples differ with %d threads.\n",
+         mismatches, files * ROUNDS, threads);
+        return -1;
+    }
+
+    return (double) files * ROUNDS;
+}
+
+static bool_t make_files (void)
+{
+    uris = calloc (files, sizeof (char *));
+    expect = calloc (files, sizeof (char *));
+
+    for (int i = 0; i < files; i ++)
+    {
+        char path[256];
+        snprintf (path, sizeof path, "%s/%04d.%s", dir, i,
+         scan_format.extension);
+
+        FILE * file = fopen (path, "w");
+
+        if (! file || ! scan_format.make (file, i) || fclose (file))
+        {
+            fprintf (stderr, "Failed to write %s.\n", path);
+            return FALSE;
+        }
+
+        if (asprintf (& uris[i], "file://%s", path) < 0)
+            return FALSE;
+    }
+
+    /* the single-threaded reading that the others are compared with */
+    for (int i = 0; i < files; i ++)
+    {
+        if (! (expect[i] = read_tuple (i)) || ! strcmp (expect[i], "(none)"))
+        {
+            fprintf (stderr, "The plugin does not read %s.\n", uris[i]);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static void delete_files (void)
+{
+    for (int i = 0; i < files; i ++)
+    {
+        if (uris && uris[i])
+            unlink (uris[i] + 7);
+        if (expect)
+            free (expect[i]);
+        if (uris)
+            free (uris[i]);
+    }
+
+    free (uris);
+    free (expect);
+    rmdir (dir);
+}
+
+int main (int argc, char * * argv)
+{
+    BenchInfo info = {scan_format.bench, "files_per_s", TRUE};
+    int failed = 0;
+
+    if (argc > 1)
+        files = atoi (argv[1]);
+
+    if (files <= 0)
+    {
+        fprintf (stderr, "Usage: %s [files] [case ...]\n", argv[0]);
+        return 1;
+    }
+
+    plugin = get_plugin_info (NULL);
+
+    if (scan_format.setup)
+        scan_format.setup ();
+
+    if (! mkdtemp (dir))
+    {
+        perror (dir);
+        return 1;
+    }
+
+    if (! make_files ())
+    {
+        delete_files ();
+        return 1;
+    }
+
+    int cpus = sysconf (_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+        cpus = 1;
+
+    for (int threads = 1; threads <= cpus; threads = (threads * 2 > cpus &&
+     threads < cpus) ? cpus : threads * 2)
+    {
+        char name[32];
+        snprintf (name, sizeof name, "threads-%d", threads);
+
+        bool_t selected = (argc <= 2);
+
+        for (int a = 2; a < argc; a ++)
+        {
+            if (! strcmp (argv[a], name))
+                selected = TRUE;
+        }
+
+        if (selected && bench_run (& info, name, run_threads, & threads) < 0)
+            failed = 1;
+    }
+
+    delete_files ();
+    return failed;
+}
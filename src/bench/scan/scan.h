@@ -0,0 +1,40 @@
+/*
+ * scan.h
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Shared part of the tuple scanning benchmarks.  Each program links one input
+ * plugin and provides a ScanFormat that writes tunes for it; scan.c does the
+ * rest (see there). */
+
+#ifndef AUD_BENCH_SCAN_H
+#define AUD_BENCH_SCAN_H
+
+#include <stdio.h>
+
+#include <audacious/plugin.h>
+
+typedef struct {
+    const char * bench;      /* e.g. "scan-adplug" */
+    const char * extension;  /* of the generated files */
+    void (* setup) (void);   /* settings the plugin would get from init, or NULL */
+    bool_t (* make) (FILE * file, int number); /* writes tune <number> */
+} ScanFormat;
+
+extern const ScanFormat scan_format;
+
+#endif
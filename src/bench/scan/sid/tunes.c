@@ -0,0 +1,78 @@
+/*
+ * tunes.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Tunes for the SID plugin: PSID v2 files with up to eight subtunes, whose
+ * init and play routines only return.  Automatic subtunes are turned on, as
+ * the plugin's default settings have them. */
+
+#include <string.h>
+
+#include "../scan.h"
+#include "xs_config.h"
+
+#define LOAD_ADDR 0x1000
+#define CODE_SIZE 1024
+
+static void put16 (unsigned char * p, int x)
+{
+    p[0] = x >> 8;
+    p[1] = x;
+}
+
+static void setup (void)
+{
+    xs_cfg.subAutoEnable = TRUE;
+    xs_cfg.subAutoMinOnly = FALSE;
+    xs_cfg.subAutoMinTime = 15;
+}
+
+static bool_t make_sid (FILE * file, int number)
+{
+    unsigned char header[0x7c];
+    unsigned char data[2 + CODE_SIZE];
+
+    memset (header, 0, sizeof header);
+    memcpy (header, "PSID", 4);
+    put16 (header + 0x04, 2); /* version */
+    put16 (header + 0x06, sizeof header); /* data offset */
+    put16 (header + 0x08, 0); /* load address in the data */
+    put16 (header + 0x0a, LOAD_ADDR); /* init */
+    put16 (header + 0x0c, LOAD_ADDR + 1); /* play */
+    put16 (header + 0x0e, 1 + number % 8); /* songs */
+    put16 (header + 0x10, 1); /* start song */
+
+    snprintf ((char *) header + 0x16, 32, "Tune %d", number);
+    snprintf ((char *) header + 0x36, 32, "Composer %d", number % 13);
+    snprintf ((char *) header + 0x56, 32, "%d Benchmark", 1982 + number % 12);
+
+    header[0x77] = 0x14; /* PAL, 6581 */
+
+    /* RTS; RTS; then NOPs */
+    data[0] = LOAD_ADDR & 0xff;
+    data[1] = LOAD_ADDR >> 8;
+    memset (data + 2, 0xea, CODE_SIZE);
+    data[2] = data[3] = 0x60;
+
+    fwrite (header, 1, sizeof header, file);
+    fwrite (data, 1, sizeof data, file);
+
+    return ! ferror (file);
+}
+
+const ScanFormat scan_format = {"scan-sid", "sid", setup, make_sid};
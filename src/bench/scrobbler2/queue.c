@@ -0,0 +1,470 @@
+/*
+ * queue.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Sends a queue of scrobbles through the scrobbling thread of the scrobbler2
+ * plugin to a stand-in for the Last.fm API on a local port, which the plugin
+ * is pointed at with the scrobbler/api_url setting.  The queue is written to
+ * scrobbler.log in a temporary directory that stands in for the user's
+ * config directory.
+ *
+ *   clean  every request is answered with success
+ *   retry  the third request is answered with "service offline" (error 11);
+ *          the plugin keeps the rest of the queue and is woken again, as it
+ *          would be by the next track played
+ *
+ * The plugin's globals, which are normally in scrobbler.c, are defined here.
+ *
+ * The stand-in checks on each request that the committed offset in
+ * scrobbler.log.offset already covers exactly the tracks it has accepted, so
+ * that a crash would only send the request in flight again.  At the end every
+ * track must have been accepted exactly once, in batches of at most 50, and
+ * the log must be empty.  The rate is tracks per wall-clock second.
+ *
+ * Usage: queue [tracks] [case ...] */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../bench.h"
+#include "scrobbler.h"
+
+#define FIRST_TIMESTAMP 1300000000
+#define MAX_BATCH 50
+#define TIMEOUT 30 /* seconds */
+
+static int tracks = 1000;
+static char dir[] = "/tmp/scrobbler-bench-XXXXXX";
+static char * queuepath, * offsetpath;
+static char api_url[64];
+
+/* state of the stand-in, only touched by its thread until the case ends */
+static char * accepted; /* per track */
+static volatile int n_accepted, n_requests, n_failed;
+static int fail_request = -1;
+static const char * error;
+
+/* ---- the part of scrobbler.c and config_window.c that the thread uses ---- */
+
+bool_t scrobbler_running = TRUE;
+bool_t migrate_config_requested = FALSE;
+bool_t now_playing_requested = FALSE;
+bool_t permission_check_requested = FALSE;
+bool_t invalidate_session_requested = FALSE;
+enum permission perm_result = PERMISSION_UNKNOWN;
+Tuple * now_playing_track = NULL;
+
+pthread_mutex_t communication_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t communication_signal = PTHREAD_COND_INITIALIZER;
+pthread_mutex_t log_access_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+gchar * session_key = NULL;
+gchar * request_token = NULL;
+gchar * username = "";
+
+gchar * remove_tabs (const char * string)
+{
+    return g_strdup (string);
+}
+
+/* ---- the part of the core that the plugin uses ---- */
+
+const gchar * aud_get_path (gint id)
+{
+    return dir;
+}
+
+gchar * aud_get_string (const gchar * section, const gchar * name)
+{
+    if (! strcmp (section, "scrobbler") && ! strcmp (name, "api_url"))
+        return g_strdup (api_url);
+
+    return g_strdup ("");
+}
+
+void aud_set_string (const gchar * section, const gchar * name,
+ const gchar * value)
+{
+}
+
+void aud_interface_show_error (const gchar * message)
+{
+    fprintf (stderr, "%s\n", message);
+}
+
+/* ---- the stand-in server ---- */
+
+static void fail (const char * message)
+{
+    if (! error)
+        error = message;
+}
+
+/* the committed offset must be just past the last accepted track in the log,
+ * with only accepted tracks before it */
+static void check_offset (void)
+{
+    gchar * log = NULL, * marker = NULL;
+    gint64 offset = 0;
+
+    pthread_mutex_lock (& log_access_mutex);
+
+    g_file_get_contents (queuepath, & log, NULL, NULL);
+    if (g_file_get_contents (offsetpath, & marker, NULL, NULL))
+    {
+        char * end;
+        g_ascii_strtoull (marker, & end, 10);
+        offset = g_ascii_strtoll (end, NULL, 10);
+    }
+
+    pthread_mutex_unlock (& log_access_mutex);
+
+    int before = 0, after = 0;
+
+    for (char * line = log; line && * line; )
+    {
+        char * newline = strchr (line, '\n');
+        if (newline)
+            * newline = 0;
+
+        char * stamp = strrchr (line, '\t');
+        int track = stamp ? atoi (stamp + 1) - FIRST_TIMESTAMP : -1;
+
+        if (track < 0 || track >= tracks)
+            fail ("The log has a line that was not written to it.");
+        else if (line - log < offset)
+            before += accepted[track] ? 0 : 1;
+        else
+            after += accepted[track] ? 1 : 0;
+
+        line = newline ? newline + 1 : line + strlen (line);
+    }
+
+    if (before)
+        fail ("The committed offset covers tracks that were not accepted.");
+    if (after)
+        fail ("Accepted tracks were not committed before the next request.");
+
+    g_free (log);
+    g_free (marker);
+}
+
+/* accepts the tracks of a track.scrobble request; returns how many there were */
+static int read_request (const char * body)
+{
+    int n = 0;
+
+    for (const char * p = body; (p = strstr (p, "timestamp[")); p ++)
+    {
+        const char * equals = strchr (p, '=');
+        int track = equals ? atoi (equals + 1) - FIRST_TIMESTAMP : -1;
+
+        if (track < 0 || track >= tracks)
+            fail ("A track was sent that is not in the log.");
+        else if (accepted[track] ++)
+            fail ("A track was sent again after it had been accepted.");
+
+        n ++;
+    }
+
+    return n;
+}
+
+static char * answer (const char * body)
+{
+    if (! strstr (body, "method=track.scrobble"))
+        return g_strdup ("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+         "<lfm status=\"failed\"><error code=\"3\">Invalid Method</error></lfm>");
+
+    check_offset ();
+
+    if (n_requests ++ == fail_request)
+    {
+        n_failed ++;
+        return g_strdup ("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+         "<lfm status=\"failed\"><error code=\"11\">Service Offline</error>"
+         "</lfm>");
+    }
+
+    int n = read_request (body);
+
+    if (n < 1 || n > MAX_BATCH)
+        fail ("A request had no tracks or too many.");
+
+    n_accepted += n;
+
+    return g_strdup_printf ("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+     "<lfm status=\"ok\"><scrobbles accepted=\"%d\" ignored=\"0\"></scrobbles>"
+     "</lfm>", n);
+}
+
+static void send_all (int fd, const char * data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t sent = send (fd, data, len, MSG_NOSIGNAL);
+        if (sent <= 0)
+            return;
+
+        data += sent;
+        len -= sent;
+    }
+}
+
+/* serves one connection, which curl keeps open for all its requests */
+static void serve (int fd)
+{
+    GString * in = g_string_new (NULL);
+    char buf[4096];
+
+    while (1)
+    {
+        char * head_end = strstr (in->str, "\r\n\r\n");
+
+        if (! head_end)
+        {
+            ssize_t got = recv (fd, buf, sizeof buf, 0);
+            if (got <= 0)
+                break;
+
+            g_string_append_len (in, buf, got);
+            continue;
+        }
+
+        size_t head_len = head_end + 4 - in->str;
+        char * length = strstr (in->str, "\r\nContent-Length:");
+        size_t body_len = (length && length < head_end) ? atol (length + 17) : 0;
+
+        /* curl waits for this before sending a larger body */
+        char * expect = strstr (in->str, "\r\nExpect: 100-continue");
+        if (expect && expect < head_end && in->len == head_len)
+            send_all (fd, "HTTP/1.1 100 Continue\r\n\r\n", 25);
+
+        while (in->len < head_len + body_len)
+        {
+            ssize_t got = recv (fd, buf, sizeof buf, 0);
+            if (got <= 0)
+                goto out;
+
+            g_string_append_len (in, buf, got);
+        }
+
+        gchar * body = g_strndup (in->str + head_len, body_len);
+        gchar * reply = answer (body);
+        gchar * out = g_strdup_printf ("HTTP/1.1 200 OK\r\nContent-Type: "
+         "text/xml; charset=utf-8\r\nContent-Length: %d\r\n\r\n%s", (int)
+         strlen (reply), reply);
+
+        send_all (fd, out, strlen (out));
+
+        g_free (body);
+        g_free (reply);
+        g_free (out);
+
+        g_string_erase (in, 0, head_len + body_len);
+    }
+
+out:
+    g_string_free (in, TRUE);
+    close (fd);
+}
+
+static void * server_thread (void * data)
+{
+    int listener = GPOINTER_TO_INT (data);
+    int fd;
+
+    while ((fd = accept (listener, NULL, NULL)) >= 0)
+        serve (fd);
+
+    return NULL;
+}
+
+static bool_t start_server (void)
+{
+    struct sockaddr_in addr = {.sin_family = AF_INET};
+    socklen_t len = sizeof addr;
+    int listener = socket (AF_INET, SOCK_STREAM, 0);
+    pthread_t thread;
+
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+    if (listener < 0 || bind (listener, (struct sockaddr *) & addr, len) < 0 ||
+     listen (listener, 4) < 0 || getsockname (listener, (struct sockaddr *)
+     & addr, & len) < 0 || pthread_create (& thread, NULL, server_thread,
+     GINT_TO_POINTER (listener)))
+    {
+        perror ("stand-in server");
+        return FALSE;
+    }
+
+    snprintf (api_url, sizeof api_url, "http://127.0.0.1:%d/2.0/", ntohs
+     (addr.sin_port));
+    return TRUE;
+}
+
+/* ---- the benchmark ---- */
+
+static bool_t write_log (void)
+{
+    FILE * file = fopen (queuepath, "w");
+    if (! file)
+        return FALSE;
+
+    for (int i = 0; i < tracks; i ++)
+        fprintf (file, "Artist %d\tAlbum %d\tTrack %d\t%d\t%d\tL\t%d\n", i % 7,
+         i / 12, i, i % 12 + 1, 180 + i % 97, FIRST_TIMESTAMP + i);
+
+    return ! fclose (file);
+}
+
+static volatile bool_t thread_done;
+
+static void * run_thread (void * data)
+{
+    scrobbling_thread (NULL);
+    thread_done = TRUE;
+    return NULL;
+}
+
+/* wakes the scrobbling thread as scrobbler.c does when a track is queued */
+static void wake_thread (void)
+{
+    pthread_mutex_lock (& communication_mutex);
+    pthread_cond_signal (& communication_signal);
+    pthread_mutex_unlock (& communication_mutex);
+}
+
+static double run_queue (void * data)
+{
+    pthread_t thread;
+
+    fail_request = * (int *) data;
+    accepted = g_malloc0 (tracks);
+
+    if (! write_log () || ! start_server () || ! scrobbler_communication_init ())
+    {
+        fprintf (stderr, "Cannot set up the test.\n");
+        return -1;
+    }
+
+    session_key = g_strdup ("bench");
+    scrobbler_running = TRUE;
+    scrobbling_enabled = TRUE;
+
+    bench_reset ();
+    pthread_create (& thread, NULL, run_thread, NULL);
+
+    /* the thread sends the queue when it starts; after a failure it waits
+     * for the next track */
+    for (int i = 0; i < TIMEOUT * 100 && n_accepted < tracks && ! error; i ++)
+    {
+        if (n_failed)
+            wake_thread ();
+
+        g_usleep (10000);
+    }
+
+    scrobbler_running = FALSE;
+
+    while (! thread_done)
+    {
+        wake_thread ();
+        g_usleep (1000);
+    }
+
+    pthread_join (thread, NULL);
+
+    struct stat st;
+    if (! error && n_accepted < tracks)
+        error = "Not all tracks were sent.";
+    if (! error && (stat (queuepath, & st) < 0 || st.st_size))
+        error = "The log was not emptied.";
+    if (! error && fail_request >= 0 && ! n_failed)
+        error = "The failed request was never made.";
+
+    unlink (queuepath);
+    unlink (offsetpath);
+
+    if (error)
+    {
+        fprintf (stderr, "%s\n", error);
+        return -1;
+    }
+
+    return tracks;
+}
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo info = {"scrobbler2", "tracks_per_s", TRUE};
+    static int fail_none = -1, fail_third = 2;
+    static const struct {
+        const char * name;
+        int * fail_request;
+    } cases[] = {
+        {"clean", & fail_none},
+        {"retry", & fail_third}
+    };
+
+    int failed = 0;
+
+    if (argc > 1)
+        tracks = atoi (argv[1]);
+
+    if (tracks <= 0)
+    {
+        fprintf (stderr, "Usage: %s [tracks] [case ...]\n", argv[0]);
+        return 1;
+    }
+
+    if (! mkdtemp (dir))
+    {
+        perror (dir);
+        return 1;
+    }
+
+    queuepath = g_build_filename (dir, "scrobbler.log", NULL);
+    offsetpath = g_strconcat (queuepath, ".offset", NULL);
+
+    for (unsigned i = 0; i < sizeof cases / sizeof cases[0]; i ++)
+    {
+        bool_t selected = (argc <= 2);
+
+        for (int a = 2; a < argc; a ++)
+        {
+            if (! strcmp (argv[a], cases[i].name))
+                selected = TRUE;
+        }
+
+        if (selected && bench_run (& info, cases[i].name, run_queue,
+         cases[i].fail_request) < 0)
+            failed = 1;
+    }
+
+    rmdir (dir);
+    g_free (queuepath);
+    g_free (offsetpath);
+    return failed;
+}
@@ -0,0 +1,303 @@
+/*
+ * playlists.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Saves and loads generated playlists of 10k, 100k and 1M tracks through the
+ * XSPF plugin, linked in and called through its header.  For each size there
+ * are three cases:
+ *
+ *   generate  only builds the playlist in memory, as the core holds it
+ *   save      builds it and writes it to a file
+ *   load      reads that file back and checks the tracks
+ *
+ * The peak RSS of "generate" is the playlist itself; what "save" and "load"
+ * use beyond it is the memory of the plugin.  Selecting a load case also runs
+ * the save case of the same size, which writes its file.
+ *
+ * Usage: playlists [case ...] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <audacious/plugin.h>
+
+#include "../bench.h"
+
+PlaylistPlugin * get_plugin_info (AudAPITable * table);
+
+static PlaylistPlugin * plugin;
+static char dir[] = "/tmp/xspf-bench-XXXXXX";
+
+static const char * const artists[] = {"Ashra", "Cluster", "Harmonia",
+ "Kraftwerk", "Neu!", "Popol Vuh", "Tangerine Dream"};
+
+static void make_uri (char * uri, int size, int i)
+{
+    const char * artist = artists[i % (sizeof artists / sizeof artists[0])];
+
+    snprintf (uri, size, "file:///home/user/Music/%s/Album%%20%d/"
+     "%02d%%20-%%20Track%%20%d.flac", artist, i / 12, i % 12 + 1, i);
+}
+
+/* a playlist as it would be after scanning: most entries have a full tuple,
+ * some have not been scanned yet */
+static void make_playlist (int entries, Index * filenames, Index * tuples)
+{
+    for (int i = 0; i < entries; i ++)
+    {
+        char uri[128], title[64], album[64];
+        const char * artist = artists[i % (sizeof artists / sizeof artists[0])];
+
+        make_uri (uri, sizeof uri, i);
+        snprintf (title, sizeof title, "Track %d", i);
+        snprintf (album, sizeof album, "Album %d", i / 12);
+
+        Tuple * tuple = NULL;
+
+        if (i % 10)
+        {
+            tuple = tuple_new_from_filename (uri);
+            tuple_set_str (tuple, FIELD_TITLE, NULL, title);
+            tuple_set_str (tuple, FIELD_ARTIST, NULL, artist);
+            tuple_set_str (tuple, FIELD_ALBUM, NULL, album);
+            tuple_set_str (tuple, FIELD_CODEC, NULL, "Free Lossless Audio Codec (FLAC)");
+            tuple_set_str (tuple, FIELD_QUALITY, NULL, "lossless");
+            tuple_set_int (tuple, FIELD_TRACK_NUMBER, NULL, i % 12 + 1);
+            tuple_set_int (tuple, FIELD_LENGTH, NULL, 180000 + i % 97 * 1000);
+            tuple_set_int (tuple, FIELD_YEAR, NULL, 1970 + i % 10);
+            tuple_set_int (tuple, FIELD_BITRATE, NULL, 900 + i % 300);
+        }
+
+        index_append (filenames, str_get (uri));
+        index_append (tuples, tuple);
+    }
+}
+
+static void free_playlist (Index * filenames, Index * tuples)
+{
+    for (int i = 0; i < index_count (filenames); i ++)
+    {
+        str_unref (index_get (filenames, i));
+
+        Tuple * tuple = index_get (tuples, i);
+        if (tuple)
+            tuple_unref (tuple);
+    }
+
+    index_free (filenames);
+    index_free (tuples);
+}
+
+/* nine entries spread evenly from the first to the last */
+static bool_t check_playlist (int entries, Index * filenames, Index * tuples)
+{
+    if (index_count (filenames) != entries)
+    {
+        fprintf (stderr, "Loaded %d entries, should be %d.\n", index_count
+         (filenames), entries);
+        return FALSE;
+    }
+
+    for (int n = 0; n <= 8; n ++)
+    {
+        int i = (int64_t) (entries - 1) * n / 8;
+        char uri[128], title[64];
+        make_uri (uri, sizeof uri, i);
+        snprintf (title, sizeof title, "Track %d", i);
+
+        Tuple * tuple = index_get (tuples, i);
+        char * got = tuple ? tuple_get_str (tuple, FIELD_TITLE, NULL) : NULL;
+
+        bool_t ok = ! strcmp (index_get (filenames, i), uri) && ((i % 10) ?
+         got && ! strcmp (got, title) && tuple_get_int (tuple, FIELD_LENGTH,
+         NULL) == 180000 + i % 97 * 1000 : ! got);
+
+        str_unref (got);
+
+        if (! ok)
+        {
+            fprintf (stderr, "Entry %d was not loaded correctly.\n", i);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+typedef struct {
+    const char * name;
+    int entries;
+    char uri[128];
+} Size;
+
+static double run_generate (void * data)
+{
+    const Size * size = data;
+    Index * filenames = index_new ();
+    Index * tuples = index_new ();
+
+    make_playlist (size->entries, filenames, tuples);
+    free_playlist (filenames, tuples);
+
+    return size->entries;
+}
+
+static double run_save (void * data)
+{
+    const Size * size = data;
+    Index * filenames = index_new ();
+    Index * tuples = index_new ();
+
+    make_playlist (size->entries, filenames, tuples);
+    bench_reset ();
+
+    VFSFile * file = vfs_fopen (size->uri, "w");
+    bool_t success = FALSE;
+
+    if (file)
+    {
+        success = plugin->save (size->uri, file, "Benchmark", filenames,
+         tuples);
+
+        if (vfs_fclose (file))
+            success = FALSE;
+    }
+
+    free_playlist (filenames, tuples);
+
+    if (! success)
+    {
+        fprintf (stderr, "Failed to write %s.\n", size->uri);
+        return -1;
+    }
+
+    return size->entries;
+}
+
+static double run_load (void * data)
+{
+    const Size * size = data;
+    VFSFile * file = vfs_fopen (size->uri, "r");
+
+    if (! file)
+    {
+        fprintf (stderr, "Cannot open %s.\n", size->uri);
+        return -1;
+    }
+
+    char * title = NULL;
+    Index * filenames = index_new ();
+    Index * tuples = index_new ();
+
+    bool_t success = plugin->load (size->uri, file, & title, filenames,
+     tuples);
+
+    vfs_fclose (file);
+
+    /* the check is timed too, but it is short next to the loading */
+    if (success && (! title || strcmp (title, "Benchmark") ||
+     ! check_playlist (size->entries, filenames, tuples)))
+        success = FALSE;
+
+    str_unref (title);
+    free_playlist (filenames, tuples);
+
+    return success ? size->entries : -1;
+}
+
+static Size sizes[] = {
+    {"10k", 10000},
+    {"100k", 100000},
+    {"1m", 1000000}
+};
+
+static const struct {
+    const char * name;
+    BenchFunc func;
+} steps[] = {
+    {"generate", run_generate},
+    {"save", run_save},
+    {"load", run_load}
+};
+
+static bool_t selected (int argc, char * * argv, const char * name)
+{
+    if (argc <= 1)
+        return TRUE;
+
+    for (int a = 1; a < argc; a ++)
+    {
+        if (! strcmp (argv[a], name))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+int main (int argc, char * * argv)
+{
+    static const BenchInfo info = {"xspf", "tracks_per_s"};
+    int failed = 0;
+
+    plugin = get_plugin_info (NULL);
+
+    if (! mkdtemp (dir))
+    {
+        perror (dir);
+        return 1;
+    }
+
+    for (unsigned s = 0; s < sizeof sizes / sizeof sizes[0]; s ++)
+    {
+        Size * size = & sizes[s];
+        snprintf (size->uri, sizeof size->uri, "file://%s/%s.xspf", dir,
+         size->name);
+
+        char names[3][32];
+        bool_t run[3];
+
+        for (int i = 0; i < 3; i ++)
+        {
+            snprintf (names[i], sizeof names[i], "%s-%s", steps[i].name,
+             size->name);
+            run[i] = selected (argc, argv, names[i]);
+        }
+
+        /* load reads the file that save writes */
+        if (run[2])
+            run[1] = TRUE;
+
+        for (int i = 0; i < 3; i ++)
+        {
+            if (run[i] && bench_run (& info, names[i], steps[i].func, size) < 0)
+            {
+                failed = 1;
+
+                if (i == 1)
+                    break;
+            }
+        }
+
+        unlink (size->uri + 7);
+    }
+
+    rmdir (dir);
+    return failed;
+}
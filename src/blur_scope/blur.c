@@ -0,0 +1,86 @@
+/*
+ *  Blur Scope plugin for Audacious
+ *  Copyright (C) 2010-2012 John Lindgren
+ *
+ *  Based on BMP - Cross-platform multimedia player:
+ *  Copyright (C) 2003-2004  BMP development team.
+ *
+ *  Based on XMMS:
+ *  Copyright (C) 1998-2003  XMMS development team.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <glib.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "blur.h"
+
+/* Each pixel becomes the average of its four neighbors, less a small amount
+ * so that the image fades out over a number of frames. */
+void blur_row (const guint32 * p, guint32 * q, gint width, gint stride,
+ gint fade)
+{
+    gint x = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i sub = _mm_set1_epi16 (fade);
+
+    /* four pixels at a time, with each color channel widened to 16 bits */
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i up = _mm_loadu_si128 ((const __m128i *) (p + x - stride));
+        __m128i left = _mm_loadu_si128 ((const __m128i *) (p + x - 1));
+        __m128i right = _mm_loadu_si128 ((const __m128i *) (p + x + 1));
+        __m128i down = _mm_loadu_si128 ((const __m128i *) (p + x + stride));
+
+        __m128i lo = _mm_add_epi16 (_mm_add_epi16 (_mm_unpacklo_epi8 (up,
+         zero), _mm_unpacklo_epi8 (left, zero)), _mm_add_epi16
+         (_mm_unpacklo_epi8 (right, zero), _mm_unpacklo_epi8 (down, zero)));
+        __m128i hi = _mm_add_epi16 (_mm_add_epi16 (_mm_unpackhi_epi8 (up,
+         zero), _mm_unpackhi_epi8 (left, zero)), _mm_add_epi16
+         (_mm_unpackhi_epi8 (right, zero), _mm_unpackhi_epi8 (down, zero)));
+
+        lo = _mm_srli_epi16 (_mm_subs_epu16 (lo, sub), 2);
+        hi = _mm_srli_epi16 (_mm_subs_epu16 (hi, sub), 2);
+
+        _mm_storeu_si128 ((__m128i *) (q + x), _mm_packus_epi16 (lo, hi));
+    }
+#endif
+
+    /* one pixel at a time; red and blue are summed side by side in 16-bit
+     * halves, with the high bit of each half set beforehand so that the
+     * subtraction cannot borrow across */
+    const guint32 rb_bias = 0x80008000 - fade * 0x10001;
+
+    for (; x < width; x ++)
+    {
+        guint32 a = p[x - stride], b = p[x - 1], c = p[x + 1], d = p[x + stride];
+
+        guint32 rb = (a & 0xFF00FF) + (b & 0xFF00FF) + (c & 0xFF00FF) + (d &
+         0xFF00FF) + rb_bias;
+        gint g = ((a >> 8) & 0xFF) + ((b >> 8) & 0xFF) + ((c >> 8) & 0xFF) +
+         ((d >> 8) & 0xFF) - fade;
+
+        /* halves that went below zero have lost their high bit */
+        rb &= ((rb >> 15) & 0x10001) * 0x7FFF;
+
+        q[x] = ((rb >> 2) & 0xFF00FF) | ((MAX (g, 0) >> 2) << 8);
+    }
+}
@@ -0,0 +1,37 @@
+/*
+ *  Blur Scope plugin for Audacious
+ *  Copyright (C) 2010-2012 John Lindgren
+ *
+ *  Based on BMP - Cross-platform multimedia player:
+ *  Copyright (C) 2003-2004  BMP development team.
+ *
+ *  Based on XMMS:
+ *  Copyright (C) 1998-2003  XMMS development team.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef BLUR_SCOPE_BLUR_H
+#define BLUR_SCOPE_BLUR_H
+
+#include <glib.h>
+
+/* Blurs one row of width pixels from p into q.  The rows above and below p
+ * (stride pixels away) and the pixels to either side of it must be readable;
+ * the image keeps a one-pixel black border for this. */
+void blur_row (const guint32 * p, guint32 * q, gint width, gint stride,
+ gint fade);
+
+#endif
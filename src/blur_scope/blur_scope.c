@@ -33,6 +33,8 @@
 #include <audacious/plugin.h>
 #include <audacious/preferences.h>
 
+#include "blur.h"
+
 #define D_WIDTH 64
 #define D_HEIGHT 32
 
@@ -42,10 +44,25 @@ static void bscope_clear (void);
 static void bscope_render (const gfloat * data);
 static void /* GtkWidget */ * bscope_get_widget (void);
 static void /* GtkWidget */ * bscope_get_color_chooser (void);
+static void bscope_reconfigure (void);
+
+static const ComboBoxElements bscope_scales[] = {
+ {"1", N_("Full")},
+ {"2", N_("Half")},
+ {"4", N_("Quarter")}};
 
 static const PreferencesWidget bscope_widgets[] = {
  {WIDGET_LABEL, N_("<b>Color</b>")},
- {WIDGET_CUSTOM, .data = {.populate = bscope_get_color_chooser}}};
+ {WIDGET_CUSTOM, .data = {.populate = bscope_get_color_chooser}},
+ {WIDGET_LABEL, N_("<b>Rendering</b>")},
+ {WIDGET_COMBO_BOX, N_("Resolution:"),
+  .cfg_type = VALUE_STRING, .csect = "BlurScope", .cname = "scale",
+  .callback = bscope_reconfigure,
+  .data = {.combo = {bscope_scales, G_N_ELEMENTS (bscope_scales)}}},
+ {WIDGET_SPIN_BTN, N_("Fade speed:"),
+  .cfg_type = VALUE_INT, .csect = "BlurScope", .cname = "fade",
+  .callback = bscope_reconfigure,
+  .data = {.spin_btn = {0, 32, 1}}}};
 
 static const PluginPreferences bscope_prefs = {
  .widgets = bscope_widgets,
@@ -64,19 +81,40 @@ AUD_VIS_PLUGIN
 )
 
 static GtkWidget * area = NULL;
+static gint area_width, area_height;
 static gint width, height, stride, image_size;
+
+/* The scope is rendered at 1/scale of the size of the widget and scaled up
+ * when drawn.  Each frame is blurred from image into back, and then the two
+ * are swapped. */
 static guint32 * image = NULL, * corner = NULL;
+static guint32 * back = NULL, * back_corner = NULL;
 
 static const gchar * const bscope_defaults[] = {
  "color", "16727935", /* 0xFF3F7F */
+ "scale", "1",
+ "fade", "6",
  NULL};
 
 static gint color;
+static gint scale, fade;
+
+static void bscope_resize (gint w, gint h);
+
+static void bscope_reconfigure (void)
+{
+    scale = CLAMP (aud_get_int ("BlurScope", "scale"), 1, 4);
+    fade = CLAMP (aud_get_int ("BlurScope", "fade"), 0, 32);
+
+    if (area)
+        bscope_resize (area_width, area_height);
+}
 
 static gboolean bscope_init (void)
 {
     aud_config_set_defaults ("BlurScope", bscope_defaults);
     color = aud_get_int ("BlurScope", "color");
+    bscope_reconfigure ();
 
     return TRUE;
 }
@@ -86,25 +124,44 @@ static void bscope_cleanup (void)
     aud_set_int ("BlurScope", "color", color);
 
     g_free (image);
-    image = NULL;
+    g_free (back);
+    image = back = NULL;
 }
 
 static void bscope_resize (gint w, gint h)
 {
-    width = w;
-    height = h;
+    area_width = w;
+    area_height = h;
+
+    width = MAX (w / scale, 1);
+    height = MAX (h / scale, 1);
     stride = width + 2;
     image_size = (stride << 2) * (height + 2);
+
+    /* the one-pixel border around each image must stay black */
     image = g_realloc (image, image_size);
+    back = g_realloc (back, image_size);
     memset (image, 0, image_size);
+    memset (back, 0, image_size);
     corner = image + stride + 1;
+    back_corner = back + stride + 1;
 }
 
 static void bscope_draw_to_cairo (cairo_t * cr)
 {
     cairo_surface_t * surf = cairo_image_surface_create_for_data ((guchar *)
-     image, CAIRO_FORMAT_RGB24, width, height, stride << 2);
-    cairo_set_source_surface (cr, surf, 0, 0);
+     corner, CAIRO_FORMAT_RGB24, width, height, stride << 2);
+
+    if (width != area_width || height != area_height)
+    {
+        cairo_scale (cr, (gdouble) area_width / width, (gdouble) area_height /
+         height);
+        cairo_set_source_surface (cr, surf, 0, 0);
+        cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_BILINEAR);
+    }
+    else
+        cairo_set_source_surface (cr, surf, 0, 0);
+
     cairo_paint (cr);
     cairo_surface_destroy (surf);
 }
@@ -151,26 +208,23 @@ static void bscope_clear (void)
 {
     g_return_if_fail (image != NULL);
     memset (image, 0, image_size);
+    memset (back, 0, image_size);
     bscope_draw ();
 }
 
 static void bscope_blur (void)
 {
     for (gint y = 0; y < height; y ++)
-    {
-        guint32 * p = corner + stride * y;
-        guint32 * end = p + width;
-        guint32 * plast = p - stride;
-        guint32 * pnext = p + stride;
-
-        /* We do a quick and dirty average of four color values, first masking
-         * off the lowest two bits.  Over a large area, this masking has the net
-         * effect of subtracting 1.5 from each value, which by a happy chance
-         * is just right for a gradual fade effect. */
-        for (; p < end; p ++)
-            * p = ((* plast ++ & 0xFCFCFC) + (p[-1] & 0xFCFCFC) + (p[1] &
-             0xFCFCFC) + (* pnext ++ & 0xFCFCFC)) >> 2;
-    }
+        blur_row (corner + stride * y, back_corner + stride * y, width, stride,
+         fade);
+
+    guint32 * swap = image;
+    image = back;
+    back = swap;
+
+    swap = corner;
+    corner = back_corner;
+    back_corner = swap;
 }
 
 static inline void draw_vert_line (gint x, guint y1, gint y2)
@@ -18,7 +18,6 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <math.h>
 #include <gtk/gtk.h>
 
 #include <audacious/debug.h>
@@ -31,21 +30,14 @@
 #include <libaudgui/libaudgui.h>
 #include <libaudgui/libaudgui-gtk.h>
 
+#include "../common/vis_bands.h"
+
 #define MAX_BANDS   (256)
-#define VIS_DELAY 2 /* delay before falloff in frames */
-#define VIS_FALLOFF 2 /* falloff in pixels per frame */
 
 static GtkWidget * spect_widget = NULL;
-static gfloat xscale[MAX_BANDS + 1];
 static gint width, height, bands;
-static gint bars[MAX_BANDS + 1];
-static gint delay[MAX_BANDS + 1];
-
-static void calculate_xscale (void)
-{
-    for (gint i = 0; i <= bands; i ++)
-        xscale[i] = powf (256, (gfloat) i / bands) - 0.5f;
-}
+static VisBands layout;
+static VisPeaks peaks;
 
 static void render_cb (gfloat * freq)
 {
@@ -54,43 +46,11 @@ static void render_cb (gfloat * freq)
     if (! bands)
         return;
 
-    for (gint i = 0; i < bands; i ++)
-    {
-        gint a = ceilf (xscale[i]);
-        gint b = floorf (xscale[i + 1]);
-        gfloat n = 0;
-
-        if (b < a)
-            n += freq[b] * (xscale[i + 1] - xscale[i]);
-        else
-        {
-            if (a > 0)
-                n += freq[a - 1] * (a - xscale[i]);
-            for (; a < b; a ++)
-                n += freq[a];
-            if (b < 256)
-                n += freq[b] * (xscale[i + 1] - b);
-        }
-
-        /* fudge factor to make the graph have the same overall height as a
-           12-band one no matter how many bands there are */
-        n *= (gfloat) bands / 12;
-
-        /* 40 dB range */
-        gint x = 40 + 20 * log10f (n);
-        x = CLAMP (x, 0, 40);
-
-        bars[i] -= MAX (0, VIS_FALLOFF - delay[i]);
-
-        if (delay[i])
-            delay[i]--;
-
-        if (x > bars[i])
-        {
-            bars[i] = x;
-            delay[i] = VIS_DELAY;
-        }
-    }
+    gfloat levels[bands];
+
+    /* 40 dB range */
+    vis_bands_compute (& layout, freq, 40, levels);
+    vis_peaks_update (& peaks, levels, 40);
 
     gtk_widget_queue_draw (spect_widget);
 }
@@ -231,14 +191,14 @@ static void draw_visualizer (GtkWidget *widget, cairo_t *cr)
 {
     gfloat base_s = (height / 40);
 
-    for (gint i = 0; i <= bands; i++)
+    for (gint i = 0; i < bands; i++)
     {
         gint x = ((width / bands) * i) + 2;
         gfloat r, g, b;
 
         get_color (i, & r, & g, & b);
         cairo_set_source_rgb (cr, r, g, b);
-        cairo_rectangle (cr, x + 1, height - (bars[i] * base_s), (width / bands) - 1, (bars[i] * base_s));
+        cairo_rectangle (cr, x + 1, height - (peaks.bars[i] * base_s), (width / bands) - 1, (peaks.bars[i] * base_s));
         cairo_fill (cr);
     }
 }
@@ -249,9 +209,18 @@ static gboolean configure_event (GtkWidget * widget, GdkEventConfigure * event)
     height = event->height;
     gtk_widget_queue_draw(widget);
 
-    bands = width / 10;
-    bands = CLAMP(bands, 12, MAX_BANDS);
-    calculate_xscale ();
+    gint new_bands = width / 10;
+    new_bands = CLAMP (new_bands, 12, MAX_BANDS);
+
+    if (new_bands != bands)
+    {
+        vis_bands_cleanup (& layout);
+        vis_peaks_cleanup (& peaks);
+
+        bands = new_bands;
+        vis_bands_init (& layout, bands);
+        vis_peaks_init (& peaks, bands);
+    }
 
     return TRUE;
 }
@@ -272,6 +241,10 @@ static gboolean destroy_event (void)
 {
     aud_vis_func_remove ((VisFunc) render_cb);
     spect_widget = NULL;
+
+    vis_bands_cleanup (& layout);
+    vis_peaks_cleanup (& peaks);
+    bands = 0;
     return TRUE;
 }
 
@@ -62,6 +62,9 @@
 #define MAX_RETRIES 10
 #define MAX_SKIPS 10
 
+/* how far the reader thread may get ahead of playback */
+#define READ_AHEAD_MS 2000
+
 #define warn(...) fprintf(stderr, "cdaudio-ng: " __VA_ARGS__)
 
 typedef struct
@@ -74,10 +77,25 @@ typedef struct
 }
 trackinfo_t;
 
+typedef struct
+{
+    unsigned char * data;
+    int sectors;
+}
+chunk_t;
+
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
 static int seek_time;
 static bool_t playing;
 
+/* read-ahead queue, shared between the play thread and the reader thread;
+ * lock mutex to read / set these variables */
+static chunk_t * chunks;
+static int n_chunks, chunk_head, chunk_count;
+static int read_lsn, read_end, read_sectors, read_generation;
+static bool_t reader_running, reader_quit, reader_done, reader_failed;
+
 /* lock mutex to read / set these variables */
 static int firsttrackno = -1;
 static int lasttrackno = -1;
@@ -86,6 +104,13 @@ static cdrom_drive_t *pcdrom_drive = NULL;
 static trackinfo_t *trackinfo = NULL;
 static int monitor_source = 0;
 
+/* CD-Text and CDDB results for discs seen before, keyed by their TOC; saves
+ * reading CD-Text and querying the server again when a disc is reinserted
+ * (libcddb only caches successful matches) */
+static GHashTable * disc_cache = NULL;
+
+#define DISC_CACHE_SIZE 16
+
 static bool_t cdaudio_init (void);
 static int cdaudio_is_our_file (const char * filename, VFSFile * file);
 static bool_t cdaudio_play (InputPlayback * p, const char * name, VFSFile *
@@ -211,7 +236,7 @@ static bool_t monitor (gpointer unused)
     pthread_mutex_lock (& mutex);
 
     /* make sure not to close drive handle while playing */
-    if (playing)
+    if (playing || reader_running)
     {
         pthread_mutex_unlock (& mutex);
         return true;
@@ -283,6 +308,95 @@ static void cdaudio_set_fullinfo (trackinfo_t * t,
     cdaudio_set_strinfo (t, performer, name, genre);
 }
 
+/* reader thread only; reads ahead into the chunk queue so that seeking and
+ * spinning up the drive overlap with playback */
+static void * reader_thread (void * unused)
+{
+    pthread_mutex_lock (& mutex);
+
+    int sectors = read_sectors;
+    int generation = read_generation;
+    int retry_count = 0, skip_count = 0;
+
+    while (! reader_quit)
+    {
+        if (generation != read_generation)
+        {
+            sectors = read_sectors;
+            generation = read_generation;
+            retry_count = 0;
+            skip_count = 0;
+        }
+
+        if (reader_done || chunk_count == n_chunks)
+        {
+            pthread_cond_wait (& cond, & mutex);
+            continue;
+        }
+
+        sectors = MIN (sectors, read_end + 1 - read_lsn);
+        if (sectors < 1)
+        {
+            reader_done = TRUE;
+            pthread_cond_broadcast (& cond);
+            continue;
+        }
+
+        chunk_t * chunk = & chunks[(chunk_head + chunk_count) % n_chunks];
+        int lsn = read_lsn;
+
+        /* unlock mutex here to avoid blocking
+         * other threads must be careful not to close drive handle */
+        pthread_mutex_unlock (& mutex);
+
+        int ret = cdio_read_audio_sectors (pcdrom_drive->p_cdio, chunk->data,
+         lsn, sectors);
+
+        pthread_mutex_lock (& mutex);
+
+        /* seeked while reading; the data is no longer wanted */
+        if (generation != read_generation)
+            continue;
+
+        if (ret == DRIVER_OP_SUCCESS)
+        {
+            chunk->sectors = sectors;
+            chunk_count ++;
+            read_lsn += sectors;
+            retry_count = 0;
+            skip_count = 0;
+
+            pthread_cond_broadcast (& cond);
+        }
+        else if (sectors > 16)
+        {
+            /* maybe a smaller read size will help */
+            sectors /= 2;
+        }
+        else if (retry_count < MAX_RETRIES)
+        {
+            /* still failed; retry a few times */
+            retry_count ++;
+        }
+        else if (skip_count < MAX_SKIPS)
+        {
+            /* maybe the disk is scratched; try skipping ahead */
+            read_lsn = MIN (read_lsn + 75, read_end + 1);
+            skip_count ++;
+        }
+        else
+        {
+            /* still failed; give it up */
+            reader_failed = TRUE;
+            reader_done = TRUE;
+            pthread_cond_broadcast (& cond);
+        }
+    }
+
+    pthread_mutex_unlock (& mutex);
+    return NULL;
+}
+
 /* play thread only */
 static bool_t cdaudio_play (InputPlayback * p, const char * name, VFSFile *
  file, int start, int stop, bool_t pause)
@@ -339,65 +453,93 @@ static bool_t cdaudio_play (InputPlayback * p, const char * name, VFSFile *
     int speed = aud_get_int ("CDDA", "disc_speed");
     speed = CLAMP (speed, MIN_DISC_SPEED, MAX_DISC_SPEED);
     int sectors = CLAMP (buffer_size / 2, 50, 250) * speed * 75 / 1000;
-    unsigned char buffer[2352 * sectors];
-    int currlsn = startlsn;
-    int retry_count = 0, skip_count = 0;
+
+    n_chunks = MAX (2, (READ_AHEAD_MS * 75 / 1000 + sectors - 1) / sectors);
+    chunks = g_new (chunk_t, n_chunks);
+
+    for (int i = 0; i < n_chunks; i ++)
+        chunks[i].data = g_malloc (2352 * sectors);
+
+    chunk_head = chunk_count = 0;
+    read_lsn = startlsn;
+    read_end = endlsn;
+    read_sectors = sectors;
+    read_generation = 0;
+    reader_quit = reader_done = reader_failed = FALSE;
+
+    if (seek_time >= 0)
+    {
+        p->output->flush (seek_time);
+        read_lsn = startlsn + (seek_time * 75 / 1000);
+        seek_time = -1;
+    }
+
+    pthread_t reader;
+    reader_running = TRUE;
+    pthread_create (& reader, NULL, reader_thread, NULL);
 
     while (playing)
     {
         if (seek_time >= 0)
         {
             p->output->flush (seek_time);
-            currlsn = startlsn + (seek_time * 75 / 1000);
+
+            /* drop whatever was read ahead, including a read in progress */
+            read_lsn = startlsn + (seek_time * 75 / 1000);
+            read_generation ++;
+            chunk_count = 0;
+            reader_done = FALSE;
             seek_time = -1;
+
+            pthread_cond_broadcast (& cond);
+            continue;
         }
 
-        sectors = MIN (sectors, endlsn + 1 - currlsn);
-        if (sectors < 1)
-            break;
+        if (! chunk_count)
+        {
+            if (reader_done)
+            {
+                if (reader_failed)
+                    cdaudio_error (_("Error reading audio CD."));
 
-        /* unlock mutex here to avoid blocking
-         * other threads must be careful not to close drive handle */
-        pthread_mutex_unlock (& mutex);
+                break;
+            }
 
-        int ret = cdio_read_audio_sectors (pcdrom_drive->p_cdio, buffer,
-         currlsn, sectors);
+            pthread_cond_wait (& cond, & mutex);
+            continue;
+        }
 
-        if (ret == DRIVER_OP_SUCCESS)
-            p->output->write_audio (buffer, 2352 * sectors);
+        /* the reader does not touch a chunk until it is released below */
+        chunk_t * chunk = & chunks[chunk_head];
 
+        pthread_mutex_unlock (& mutex);
+        p->output->write_audio (chunk->data, 2352 * chunk->sectors);
         pthread_mutex_lock (& mutex);
 
-        if (ret == DRIVER_OP_SUCCESS)
-        {
-            currlsn += sectors;
-            retry_count = 0;
-            skip_count = 0;
-        }
-        else if (sectors > 16)
-        {
-            /* maybe a smaller read size will help */
-            sectors /= 2;
-        }
-        else if (retry_count < MAX_RETRIES)
-        {
-            /* still failed; retry a few times */
-            retry_count ++;
-        }
-        else if (skip_count < MAX_SKIPS)
-        {
-            /* maybe the disk is scratched; try skipping ahead */
-            currlsn = MIN (currlsn + 75, endlsn + 1);
-            skip_count ++;
-        }
-        else
+        if (chunk_count)
         {
-            /* still failed; give it up */
-            cdaudio_error (_("Error reading audio CD."));
-            break;
+            chunk_head = (chunk_head + 1) % n_chunks;
+            chunk_count --;
+            pthread_cond_broadcast (& cond);
         }
     }
 
+    reader_quit = TRUE;
+    pthread_cond_broadcast (& cond);
+
+    pthread_mutex_unlock (& mutex);
+    pthread_join (reader, NULL);
+    pthread_mutex_lock (& mutex);
+
+    reader_running = FALSE;
+
+    for (int i = 0; i < n_chunks; i ++)
+        g_free (chunks[i].data);
+
+    g_free (chunks);
+    chunks = NULL;
+    n_chunks = 0;
+
     playing = FALSE;
 
     pthread_mutex_unlock (& mutex);
@@ -410,6 +552,7 @@ static void cdaudio_stop (InputPlayback * p)
     pthread_mutex_lock (& mutex);
     playing = FALSE;
     p->output->abort_write();
+    pthread_cond_broadcast (& cond);
     pthread_mutex_unlock (& mutex);
 }
 
@@ -427,6 +570,7 @@ static void cdaudio_mseek (InputPlayback * p, int time)
     pthread_mutex_lock (& mutex);
     seek_time = time;
     p->output->abort_write();
+    pthread_cond_broadcast (& cond);
     pthread_mutex_unlock (& mutex);
 }
 
@@ -453,6 +597,12 @@ static void cdaudio_cleanup (void)
         trackinfo = NULL;
     }
 
+    if (disc_cache != NULL)
+    {
+        g_hash_table_destroy (disc_cache);
+        disc_cache = NULL;
+    }
+
     libcddb_shutdown ();
 
     pthread_mutex_unlock (& mutex);
@@ -560,6 +710,22 @@ static void open_cd (void)
     free (device);
 }
 
+/* mutex must be locked */
+static char * make_disc_key (void)
+{
+    GString * key = g_string_new (NULL);
+
+    g_string_append_printf (key, "%d %d %d", aud_get_bool ("CDDA",
+     "use_cdtext"), aud_get_bool ("CDDA", "use_cddb"), firsttrackno);
+
+    for (int trackno = firsttrackno; trackno <= lasttrackno; trackno ++)
+        g_string_append_printf (key, " %d", trackinfo[trackno].startlsn);
+
+    g_string_append_printf (key, " %d", trackinfo[0].endlsn);
+
+    return g_string_free (key, FALSE);
+}
+
 /* mutex must be locked */
 static void scan_cd (void)
 {
@@ -625,6 +791,20 @@ static void scan_cd (void)
             n_audio_tracks++;
     }
 
+    char * disc_key = make_disc_key ();
+    bool_t cacheable = TRUE;
+
+    trackinfo_t * cached = disc_cache ? g_hash_table_lookup (disc_cache,
+     disc_key) : NULL;
+
+    if (cached)
+    {
+        AUDDBG ("using cached metadata for disc\n");
+        memcpy (trackinfo, cached, sizeof (trackinfo_t) * (lasttrackno + 1));
+        g_free (disc_key);
+        return;
+    }
+
     /* get trackinfo[0] cdtext information (the disc) */
     cdtext_t *pcdtext = NULL;
     if (aud_get_bool ("CDDA", "use_cdtext"))
@@ -700,7 +880,10 @@ static void scan_cd (void)
         {
             pcddb_conn = cddb_new ();
             if (pcddb_conn == NULL)
+            {
                 cdaudio_error (_("Failed to create the cddb connection."));
+                cacheable = FALSE;
+            }
             else
             {
                 AUDDBG ("getting CDDB info\n");
@@ -783,6 +966,7 @@ static void scan_cd (void)
 
                     cddb_disc_destroy (pcddb_disc);
                     pcddb_disc = NULL;
+                    cacheable = FALSE;
                 }
                 else
                 {
@@ -806,6 +990,7 @@ static void scan_cd (void)
                                                            (pcddb_conn)));
                             cddb_disc_destroy (pcddb_disc);
                             pcddb_disc = NULL;
+                            cacheable = FALSE;
                         }
                         else
                         {
@@ -845,6 +1030,21 @@ static void scan_cd (void)
             cddb_destroy (pcddb_conn);
     }
 
+    /* don't remember failed lookups; the server may be reachable next time */
+    if (cacheable)
+    {
+        if (! disc_cache)
+            disc_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+             g_free, g_free);
+        else if (g_hash_table_size (disc_cache) >= DISC_CACHE_SIZE)
+            g_hash_table_remove_all (disc_cache);
+
+        g_hash_table_insert (disc_cache, disc_key, g_memdup (trackinfo,
+         sizeof (trackinfo_t) * (lasttrackno + 1)));
+    }
+    else
+        g_free (disc_key);
+
     return;
 
   ERR:
@@ -0,0 +1,473 @@
+/*
+ * art_cache.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <glib/gstdio.h>
+
+#include <audacious/debug.h>
+#include <audacious/misc.h>
+#include <audacious/playlist.h>
+
+#include "art_cache.h"
+
+#define MAX_CACHED 32
+
+/* larger images are cheap to decode again compared to their size on disk */
+#define MAX_STORED_SIZE 256
+#define MAX_STORED_BYTES (16 << 20)
+
+/* requested sizes are rounded up to one of these */
+static const int sizes[] = {32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048};
+
+typedef struct {
+    char * key;          /* "<hash>-<size>" */
+    int size;
+    void * data;         /* encoded art */
+    int64_t len;
+    GdkPixbuf * pixbuf;  /* result, NULL if the art could not be decoded */
+} ArtJob;
+
+typedef struct {
+    ArtCacheFunc func;
+    void * user;
+} ArtWatcher;
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static pthread_t worker;
+static bool_t worker_quit;
+static GQueue queued = G_QUEUE_INIT;    /* jobs waiting for the worker */
+static GQueue finished = G_QUEUE_INIT;  /* jobs waiting for finish_jobs() */
+static int finish_source;
+
+/* main thread only */
+static GList * watchers;
+static GHashTable * cache;              /* key -> GdkPixbuf (or NULL) */
+static GQueue cache_order = G_QUEUE_INIT;  /* keys, oldest first */
+static GHashTable * in_progress;        /* keys */
+static char * store_dir;
+
+/* hash of the art of the last file looked up */
+static char * last_file;                /* pooled */
+static char * last_hash;
+
+static void free_job (ArtJob * job)
+{
+    if (job->pixbuf)
+        g_object_unref (job->pixbuf);
+
+    g_free (job->key);
+    g_free (job->data);
+    g_slice_free (ArtJob, job);
+}
+
+static void unref_pixbuf (GdkPixbuf * pixbuf)
+{
+    if (pixbuf)
+        g_object_unref (pixbuf);
+}
+
+static void size_prepared (GdkPixbufLoader * loader, int width, int height,
+ void * size_ptr)
+{
+    int size = GPOINTER_TO_INT (size_ptr);
+
+    if (width <= size && height <= size)
+        return;
+
+    /* scaling while decoding lets the JPEG loader skip most of the work */
+    if (width > height)
+    {
+        height = height * size / width;
+        width = size;
+    }
+    else
+    {
+        width = width * size / height;
+        height = size;
+    }
+
+    gdk_pixbuf_loader_set_size (loader, MAX (width, 1), MAX (height, 1));
+}
+
+static GdkPixbuf * decode_scaled (const void * data, int64_t len, int size)
+{
+    GdkPixbufLoader * loader = gdk_pixbuf_loader_new ();
+    g_signal_connect (loader, "size-prepared", (GCallback) size_prepared,
+     GINT_TO_POINTER (size));
+
+    bool_t success = gdk_pixbuf_loader_write (loader, data, len, NULL);
+    success = gdk_pixbuf_loader_close (loader, NULL) && success;
+
+    GdkPixbuf * pixbuf = success ? gdk_pixbuf_loader_get_pixbuf (loader) : NULL;
+    if (pixbuf)
+        g_object_ref (pixbuf);
+
+    g_object_unref (loader);
+    return pixbuf;
+}
+
+static void process_job (ArtJob * job)
+{
+    if (job->size > MAX_STORED_SIZE)
+    {
+        if (! (job->pixbuf = decode_scaled (job->data, job->len, job->size)))
+            AUDDBG ("Failed to decode album art for %s.\n", job->key);
+
+        return;
+    }
+
+    char * name = g_strconcat (job->key, ".png", NULL);
+    char * path = g_build_filename (store_dir, name, NULL);
+    g_free (name);
+
+    if ((job->pixbuf = gdk_pixbuf_new_from_file (path, NULL)))
+    {
+        AUDDBG ("Loaded %s.\n", path);
+
+        /* the store is pruned by the time of last use */
+        g_utime (path, NULL);
+        g_free (path);
+        return;
+    }
+
+    if (! (job->pixbuf = decode_scaled (job->data, job->len, job->size)))
+    {
+        AUDDBG ("Failed to decode album art for %s.\n", job->key);
+        g_free (path);
+        return;
+    }
+
+    char * buf;
+    gsize buf_len;
+
+    if (gdk_pixbuf_save_to_buffer (job->pixbuf, & buf, & buf_len, "png", NULL, NULL))
+    {
+        if (! g_file_set_contents (path, buf, buf_len, NULL))
+            AUDDBG ("Failed to write %s.\n", path);
+
+        g_free (buf);
+    }
+
+    g_free (path);
+}
+
+typedef struct {
+    char * path;
+    time_t time;
+    int64_t size;
+} StoredFile;
+
+static int compare_stored (const void * a, const void * b)
+{
+    time_t ta = ((const StoredFile *) a)->time;
+    time_t tb = ((const StoredFile *) b)->time;
+    return (ta < tb) ? 1 : (ta > tb) ? -1 : 0;
+}
+
+/* deletes the least recently used images once the store grows too large */
+static void prune_store (void)
+{
+    GDir * dir = g_dir_open (store_dir, 0, NULL);
+    if (! dir)
+        return;
+
+    GArray * files = g_array_new (FALSE, FALSE, sizeof (StoredFile));
+    const char * name;
+
+    while ((name = g_dir_read_name (dir)))
+    {
+        struct stat info;
+        char * path = g_build_filename (store_dir, name, NULL);
+
+        if (g_str_has_suffix (name, ".png") && ! g_stat (path, & info))
+        {
+            StoredFile file = {path, info.st_mtime, info.st_size};
+            g_array_append_val (files, file);
+        }
+        else
+            g_free (path);
+    }
+
+    g_dir_close (dir);
+
+    qsort (files->data, files->len, sizeof (StoredFile), compare_stored);
+
+    int64_t total = 0;
+
+    for (int i = 0; i < files->len; i ++)
+    {
+        StoredFile * file = & g_array_index (files, StoredFile, i);
+
+        total += file->size;
+        if (total > MAX_STORED_BYTES)
+        {
+            AUDDBG ("Pruning %s.\n", file->path);
+            g_unlink (file->path);
+        }
+
+        g_free (file->path);
+    }
+
+    g_array_free (files, TRUE);
+}
+
+static void cache_add (char * key, GdkPixbuf * pixbuf)
+{
+    g_hash_table_insert (cache, key, pixbuf);
+    g_queue_push_tail (& cache_order, key);
+
+    while (cache_order.length > MAX_CACHED)
+        g_hash_table_remove (cache, g_queue_pop_head (& cache_order));
+}
+
+static bool_t finish_jobs (void)
+{
+    pthread_mutex_lock (& mutex);
+
+    GList * jobs = finished.head;
+    g_queue_init (& finished);
+    finish_source = 0;
+
+    pthread_mutex_unlock (& mutex);
+
+    for (GList * node = jobs; node; node = node->next)
+    {
+        ArtJob * job = node->data;
+
+        g_hash_table_remove (in_progress, job->key);
+        cache_add (job->key, job->pixbuf);
+
+        job->key = NULL;
+        job->pixbuf = NULL;
+        free_job (job);
+    }
+
+    g_list_free (jobs);
+
+    for (GList * node = watchers; node; )
+    {
+        ArtWatcher * watcher = node->data;
+        node = node->next;
+        watcher->func (watcher->user);
+    }
+
+    return FALSE;
+}
+
+static void * worker_thread (void * unused)
+{
+    prune_store ();
+
+    pthread_mutex_lock (& mutex);
+
+    while (! worker_quit)
+    {
+        ArtJob * job = g_queue_pop_head (& queued);
+
+        if (! job)
+        {
+            pthread_cond_wait (& cond, & mutex);
+            continue;
+        }
+
+        pthread_mutex_unlock (& mutex);
+        process_job (job);
+        pthread_mutex_lock (& mutex);
+
+        g_queue_push_tail (& finished, job);
+
+        if (! finish_source)
+            finish_source = g_idle_add ((GSourceFunc) finish_jobs, NULL);
+    }
+
+    pthread_mutex_unlock (& mutex);
+    return NULL;
+}
+
+static void start (void)
+{
+    cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+     (GDestroyNotify) unref_pixbuf);
+    in_progress = g_hash_table_new (g_str_hash, g_str_equal);
+
+    store_dir = g_build_filename (g_get_user_cache_dir (), "audacious",
+     "album-art", NULL);
+    if (g_mkdir_with_parents (store_dir, 0755) < 0)
+        AUDDBG ("Failed to create %s.\n", store_dir);
+
+    worker_quit = FALSE;
+    pthread_create (& worker, NULL, worker_thread, NULL);
+}
+
+static void stop (void)
+{
+    pthread_mutex_lock (& mutex);
+    worker_quit = TRUE;
+    pthread_cond_broadcast (& cond);
+    pthread_mutex_unlock (& mutex);
+
+    pthread_join (worker, NULL);
+
+    if (finish_source)
+    {
+        g_source_remove (finish_source);
+        finish_source = 0;
+    }
+
+    ArtJob * job;
+    while ((job = g_queue_pop_head (& queued)))
+        free_job (job);
+    while ((job = g_queue_pop_head (& finished)))
+        free_job (job);
+
+    g_queue_clear (& cache_order);
+    g_hash_table_destroy (cache);
+    g_hash_table_destroy (in_progress);
+    cache = NULL;
+    in_progress = NULL;
+
+    str_unref (last_file);
+    g_free (last_hash);
+    g_free (store_dir);
+    last_file = NULL;
+    last_hash = NULL;
+    store_dir = NULL;
+}
+
+void art_cache_watch (ArtCacheFunc func, void * user)
+{
+    if (! watchers)
+        start ();
+
+    ArtWatcher * watcher = g_slice_new (ArtWatcher);
+    watcher->func = func;
+    watcher->user = user;
+
+    watchers = g_list_prepend (watchers, watcher);
+}
+
+void art_cache_unwatch (ArtCacheFunc func, void * user)
+{
+    for (GList * node = watchers; node; node = node->next)
+    {
+        ArtWatcher * watcher = node->data;
+
+        if (watcher->func == func && watcher->user == user)
+        {
+            g_slice_free (ArtWatcher, watcher);
+            watchers = g_list_delete_link (watchers, node);
+            break;
+        }
+    }
+
+    if (! watchers && cache)
+        stop ();
+}
+
+static int round_size (int size)
+{
+    for (int i = 0; i < G_N_ELEMENTS (sizes); i ++)
+    {
+        if (sizes[i] >= size)
+            return sizes[i];
+    }
+
+    return sizes[G_N_ELEMENTS (sizes) - 1];
+}
+
+GdkPixbuf * art_cache_request_current (int size, bool_t * pending)
+{
+    * pending = FALSE;
+    g_return_val_if_fail (cache, NULL);
+
+    int playlist = aud_playlist_get_playing ();
+    int entry = (playlist >= 0) ? aud_playlist_get_position (playlist) : -1;
+    char * file = (entry >= 0) ? aud_playlist_entry_get_filename (playlist, entry) : NULL;
+
+    if (! file)
+        return NULL;
+
+    const void * data = NULL;
+    int64_t len = 0;
+
+    /* pointer comparison works for pooled strings; only art that was found
+     * is remembered, since it may be found later */
+    if (file != last_file)
+    {
+        aud_art_request_data (file, & data, & len);
+
+        if (! data)
+        {
+            str_unref (file);
+            return NULL;
+        }
+
+        str_unref (last_file);
+        g_free (last_hash);
+        last_file = str_ref (file);
+        last_hash = g_compute_checksum_for_data (G_CHECKSUM_MD5, data, len);
+    }
+
+    char * key = g_strdup_printf ("%s-%d", last_hash, round_size (size));
+    GdkPixbuf * pixbuf = NULL;
+    void * found;
+
+    if (g_hash_table_lookup_extended (cache, key, NULL, & found))
+    {
+        if (found)
+            pixbuf = g_object_ref (found);
+    }
+    else if (g_hash_table_lookup (in_progress, key))
+        * pending = TRUE;
+    else
+    {
+        if (! data)
+            aud_art_request_data (file, & data, & len);
+
+        if (data)
+        {
+            ArtJob * job = g_slice_new0 (ArtJob);
+            job->key = key;
+            job->size = round_size (size);
+            job->data = g_memdup (data, len);
+            job->len = len;
+
+            g_hash_table_insert (in_progress, job->key, job->key);
+
+            pthread_mutex_lock (& mutex);
+            g_queue_push_tail (& queued, job);
+            pthread_cond_signal (& cond);
+            pthread_mutex_unlock (& mutex);
+
+            key = NULL;
+            * pending = TRUE;
+        }
+    }
+
+    if (data)
+        aud_art_unref (file);
+
+    g_free (key);
+    str_unref (file);
+    return pixbuf;
+}
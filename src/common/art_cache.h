@@ -0,0 +1,48 @@
+/*
+ * art_cache.h
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Album art, decoded and scaled down in a background thread.  Images are
+ * keyed by a hash of the encoded art, so tracks sharing a cover share the
+ * result.  Small scaled copies are also saved in the user cache directory,
+ * so that they need not be decoded again in a later session.
+ *
+ * This file is compiled into each plugin that uses it.  All functions must be
+ * called from the main thread. */
+
+#ifndef AUD_ART_CACHE_H
+#define AUD_ART_CACHE_H
+
+#include <gtk/gtk.h>
+#include <libaudcore/core.h>
+
+typedef void (* ArtCacheFunc) (void * user);
+
+/* Starts the cache; func is called whenever a newly scaled image is ready. */
+void art_cache_watch (ArtCacheFunc func, void * user);
+
+/* The cache is shut down once the last watcher is removed. */
+void art_cache_unwatch (ArtCacheFunc func, void * user);
+
+/* Returns the current song's album art, scaled to fit within a square of the
+ * given size (rounded up to one of a few fixed sizes) and referenced.  Returns
+ * NULL if there is no art; in that case, *pending is set if the art is still
+ * being scaled, in which case watchers will be called once it is ready. */
+GdkPixbuf * art_cache_request_current (int size, bool_t * pending);
+
+#endif
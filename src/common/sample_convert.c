@@ -0,0 +1,713 @@
+/*
+ * sample_convert.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+#include <pthread.h>
+
+#include "sample_convert.h"
+
+/* The vector versions are built with per-function target attributes, so the
+ * rest of the plugin is still built for the baseline CPU.  That needs GCC 4.9
+ * or clang. */
+#if (defined (__i386__) || defined (__x86_64__)) && (defined (__clang__) || \
+ __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define SAMPLE_X86 1
+#include <immintrin.h>
+#define SSE2 __attribute__ ((target ("sse2")))
+#define AVX2 __attribute__ ((target ("avx2")))
+#endif
+
+typedef struct {
+    void (* from_s16) (const int16_t * in, float * out, int samples);
+    void (* from_s24) (const int32_t * in, float * out, int samples);
+    void (* to_s16) (const float * in, int16_t * out, int samples);
+    void (* to_s24) (const float * in, int32_t * out, int samples);
+    void (* to_s16_dither) (const float * in, int16_t * out, int samples,
+     SampleDither * dither);
+    void (* to_s24_dither) (const float * in, int32_t * out, int samples,
+     SampleDither * dither);
+    void (* gain) (float * data, int channels, int frames, const float * gains);
+    void (* gain_s16) (int16_t * data, int channels, int frames,
+     const int * factors);
+} SampleFuncs;
+
+void sample_dither_init (SampleDither * dither, uint32_t seed)
+{
+    for (int i = 0; i < 8; i ++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        dither->lanes[i] = seed ? seed : 1; /* xorshift never leaves zero */
+    }
+
+    dither->next = 0;
+}
+
+/* ---- plain versions ---- */
+
+/* in the same order as minps and maxps, so that NaN gives hi */
+static inline float clip (float x, float lo, float hi)
+{
+    x = (x < hi) ? x : hi;
+    return (x > lo) ? x : lo;
+}
+
+/* between -1 and 1 step, in steps of 1 / 65536 */
+static inline float dither_noise (SampleDither * dither)
+{
+    uint32_t x = dither->lanes[dither->next];
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    dither->lanes[dither->next] = x;
+    dither->next = (dither->next + 1) & 7;
+
+    return (float) ((int32_t) (x >> 16) - (int32_t) (x & 0xffff)) * (1.0f /
+     65536);
+}
+
+static void from_s16_c (const int16_t * in, float * out, int samples)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = (float) in[i] / 32768.0f;
+}
+
+static void from_s24_c (const int32_t * in, float * out, int samples)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = (float) in[i] / 8388608.0f;
+}
+
+static void to_s16_c (const float * in, int16_t * out, int samples)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = lrintf (clip (in[i] * 32768.0f, -32768.0f, 32767.0f));
+}
+
+static void to_s24_c (const float * in, int32_t * out, int samples)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = lrintf (clip (in[i] * 8388608.0f, -8388608.0f, 8388607.0f));
+}
+
+static void to_s16_dither_c (const float * in, int16_t * out, int samples,
+ SampleDither * dither)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = lrintf (clip (in[i] * 32768.0f + dither_noise (dither),
+         -32768.0f, 32767.0f));
+}
+
+static void to_s24_dither_c (const float * in, int32_t * out, int samples,
+ SampleDither * dither)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = lrintf (clip (in[i] * 8388608.0f + dither_noise (dither),
+         -8388608.0f, 8388607.0f));
+}
+
+static void gain_c (float * data, int channels, int frames, const float * gains)
+{
+    for (int f = 0; f < frames; f ++)
+    {
+        for (int c = 0; c < channels; c ++)
+            data[c] *= gains[c];
+
+        data += channels;
+    }
+}
+
+static void gain_s16_c (int16_t * data, int channels, int frames,
+ const int * factors)
+{
+    for (int f = 0; f < frames; f ++)
+    {
+        for (int c = 0; c < channels; c ++)
+            data[c] = ((int) data[c] * factors[c]) >> 16;
+
+        data += channels;
+    }
+}
+
+static const SampleFuncs funcs_c = {
+    from_s16_c,
+    from_s24_c,
+    to_s16_c,
+    to_s24_c,
+    to_s16_dither_c,
+    to_s24_dither_c,
+    gain_c,
+    gain_s16_c
+};
+
+/* The vector gain works on blocks of samples that hold a whole number of
+ * frames, with the gains laid out to match. */
+static int pattern_fits (int channels, int block)
+{
+    return channels > 0 && channels <= block && ! (block % channels);
+}
+
+/* The fixed-point gain is done as a signed 16 x 16 bit multiply, keeping the
+ * high half.  A factor of 32768 or more does not fit in 16 signed bits, so it
+ * is used as (factor - 65536) and x is added back to the result; that also
+ * covers 65536 itself.  The result is never larger than x, so the 16-bit
+ * arithmetic gives exactly (x * factor) >> 16. */
+static int split_factors (const int * factors, int channels, int block,
+ int16_t * mul, int16_t * add)
+{
+    for (int c = 0; c < channels; c ++)
+    {
+        if (factors[c] < 0 || factors[c] > 65536)
+            return 0;
+    }
+
+    for (int i = 0; i < block; i ++)
+    {
+        int factor = factors[i % channels];
+        mul[i] = (int16_t) (uint16_t) factor;
+        add[i] = (factor >= 32768) ? -1 : 0;
+    }
+
+    return 1;
+}
+
+/* the plain version up to a multiple of 8 samples in the dither sequence */
+static int dither_head (SampleDither * dither, int samples)
+{
+    int head = (8 - dither->next) & 7;
+    return (head < samples) ? head : samples;
+}
+
+#ifdef SAMPLE_X86
+
+/* ---- SSE2 ---- */
+
+SSE2 static inline __m128i xorshift_sse2 (__m128i x)
+{
+    x = _mm_xor_si128 (x, _mm_slli_epi32 (x, 13));
+    x = _mm_xor_si128 (x, _mm_srli_epi32 (x, 17));
+    return _mm_xor_si128 (x, _mm_slli_epi32 (x, 5));
+}
+
+SSE2 static inline __m128 noise_sse2 (__m128i x)
+{
+    __m128i r = _mm_sub_epi32 (_mm_srli_epi32 (x, 16), _mm_and_si128 (x,
+     _mm_set1_epi32 (0xffff)));
+    return _mm_mul_ps (_mm_cvtepi32_ps (r), _mm_set1_ps (1.0f / 65536));
+}
+
+SSE2 static inline __m128i round_sse2 (__m128 x, __m128 lo, __m128 hi)
+{
+    return _mm_cvtps_epi32 (_mm_max_ps (_mm_min_ps (x, hi), lo));
+}
+
+SSE2 static void from_s16_sse2 (const int16_t * in, float * out, int samples)
+{
+    const __m128 scale = _mm_set1_ps (1.0f / 32768);
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i x = _mm_loadu_si128 ((const __m128i *) (in + i));
+        __m128i a = _mm_srai_epi32 (_mm_unpacklo_epi16 (x, x), 16);
+        __m128i b = _mm_srai_epi32 (_mm_unpackhi_epi16 (x, x), 16);
+
+        _mm_storeu_ps (out + i, _mm_mul_ps (_mm_cvtepi32_ps (a), scale));
+        _mm_storeu_ps (out + i + 4, _mm_mul_ps (_mm_cvtepi32_ps (b), scale));
+    }
+
+    from_s16_c (in + i, out + i, samples - i);
+}
+
+SSE2 static void from_s24_sse2 (const int32_t * in, float * out, int samples)
+{
+    const __m128 scale = _mm_set1_ps (1.0f / 8388608);
+    int i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128i x = _mm_loadu_si128 ((const __m128i *) (in + i));
+        _mm_storeu_ps (out + i, _mm_mul_ps (_mm_cvtepi32_ps (x), scale));
+    }
+
+    from_s24_c (in + i, out + i, samples - i);
+}
+
+SSE2 static void to_s16_sse2 (const float * in, int16_t * out, int samples)
+{
+    const __m128 scale = _mm_set1_ps (32768.0f);
+    const __m128 lo = _mm_set1_ps (-32768.0f), hi = _mm_set1_ps (32767.0f);
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i a = round_sse2 (_mm_mul_ps (_mm_loadu_ps (in + i), scale), lo, hi);
+        __m128i b = round_sse2 (_mm_mul_ps (_mm_loadu_ps (in + i + 4), scale),
+         lo, hi);
+
+        _mm_storeu_si128 ((__m128i *) (out + i), _mm_packs_epi32 (a, b));
+    }
+
+    to_s16_c (in + i, out + i, samples - i);
+}
+
+SSE2 static void to_s24_sse2 (const float * in, int32_t * out, int samples)
+{
+    const __m128 scale = _mm_set1_ps (8388608.0f);
+    const __m128 lo = _mm_set1_ps (-8388608.0f), hi = _mm_set1_ps (8388607.0f);
+    int i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+        _mm_storeu_si128 ((__m128i *) (out + i), round_sse2 (_mm_mul_ps
+         (_mm_loadu_ps (in + i), scale), lo, hi));
+
+    to_s24_c (in + i, out + i, samples - i);
+}
+
+SSE2 static void to_s16_dither_sse2 (const float * in, int16_t * out,
+ int samples, SampleDither * dither)
+{
+    const __m128 scale = _mm_set1_ps (32768.0f);
+    const __m128 lo = _mm_set1_ps (-32768.0f), hi = _mm_set1_ps (32767.0f);
+    int i = dither_head (dither, samples);
+
+    to_s16_dither_c (in, out, i, dither);
+
+    __m128i x0 = _mm_loadu_si128 ((const __m128i *) dither->lanes);
+    __m128i x1 = _mm_loadu_si128 ((const __m128i *) (dither->lanes + 4));
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        x0 = xorshift_sse2 (x0);
+        x1 = xorshift_sse2 (x1);
+
+        __m128i a = round_sse2 (_mm_add_ps (_mm_mul_ps (_mm_loadu_ps (in + i),
+         scale), noise_sse2 (x0)), lo, hi);
+        __m128i b = round_sse2 (_mm_add_ps (_mm_mul_ps (_mm_loadu_ps (in + i +
+         4), scale), noise_sse2 (x1)), lo, hi);
+
+        _mm_storeu_si128 ((__m128i *) (out + i), _mm_packs_epi32 (a, b));
+    }
+
+    _mm_storeu_si128 ((__m128i *) dither->lanes, x0);
+    _mm_storeu_si128 ((__m128i *) (dither->lanes + 4), x1);
+
+    to_s16_dither_c (in + i, out + i, samples - i, dither);
+}
+
+SSE2 static void to_s24_dither_sse2 (const float * in, int32_t * out,
+ int samples, SampleDither * dither)
+{
+    const __m128 scale = _mm_set1_ps (8388608.0f);
+    const __m128 lo = _mm_set1_ps (-8388608.0f), hi = _mm_set1_ps (8388607.0f);
+    int i = dither_head (dither, samples);
+
+    to_s24_dither_c (in, out, i, dither);
+
+    __m128i x0 = _mm_loadu_si128 ((const __m128i *) dither->lanes);
+    __m128i x1 = _mm_loadu_si128 ((const __m128i *) (dither->lanes + 4));
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        x0 = xorshift_sse2 (x0);
+        x1 = xorshift_sse2 (x1);
+
+        _mm_storeu_si128 ((__m128i *) (out + i), round_sse2 (_mm_add_ps
+         (_mm_mul_ps (_mm_loadu_ps (in + i), scale), noise_sse2 (x0)), lo, hi));
+        _mm_storeu_si128 ((__m128i *) (out + i + 4), round_sse2 (_mm_add_ps
+         (_mm_mul_ps (_mm_loadu_ps (in + i + 4), scale), noise_sse2 (x1)), lo,
+         hi));
+    }
+
+    _mm_storeu_si128 ((__m128i *) dither->lanes, x0);
+    _mm_storeu_si128 ((__m128i *) (dither->lanes + 4), x1);
+
+    to_s24_dither_c (in + i, out + i, samples - i, dither);
+}
+
+SSE2 static void gain_sse2 (float * data, int channels, int frames,
+ const float * gains)
+{
+    if (! pattern_fits (channels, 8))
+    {
+        gain_c (data, channels, frames, gains);
+        return;
+    }
+
+    float pattern[8];
+    for (int i = 0; i < 8; i ++)
+        pattern[i] = gains[i % channels];
+
+    __m128 g0 = _mm_loadu_ps (pattern), g1 = _mm_loadu_ps (pattern + 4);
+    int samples = channels * frames, i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        _mm_storeu_ps (data + i, _mm_mul_ps (_mm_loadu_ps (data + i), g0));
+        _mm_storeu_ps (data + i + 4, _mm_mul_ps (_mm_loadu_ps (data + i + 4),
+         g1));
+    }
+
+    gain_c (data + i, channels, (samples - i) / channels, gains);
+}
+
+SSE2 static void gain_s16_sse2 (int16_t * data, int channels, int frames,
+ const int * factors)
+{
+    int16_t mul[8], add[8];
+
+    if (! pattern_fits (channels, 8) || ! split_factors (factors, channels, 8,
+     mul, add))
+    {
+        gain_s16_c (data, channels, frames, factors);
+        return;
+    }
+
+    __m128i m = _mm_loadu_si128 ((const __m128i *) mul);
+    __m128i a = _mm_loadu_si128 ((const __m128i *) add);
+    int samples = channels * frames, i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i x = _mm_loadu_si128 ((const __m128i *) (data + i));
+        x = _mm_add_epi16 (_mm_mulhi_epi16 (x, m), _mm_and_si128 (x, a));
+        _mm_storeu_si128 ((__m128i *) (data + i), x);
+    }
+
+    gain_s16_c (data + i, channels, (samples - i) / channels, factors);
+}
+
+static const SampleFuncs funcs_sse2 = {
+    from_s16_sse2,
+    from_s24_sse2,
+    to_s16_sse2,
+    to_s24_sse2,
+    to_s16_dither_sse2,
+    to_s24_dither_sse2,
+    gain_sse2,
+    gain_s16_sse2
+};
+
+/* ---- AVX2 ---- */
+
+AVX2 static inline __m256i xorshift_avx2 (__m256i x)
+{
+    x = _mm256_xor_si256 (x, _mm256_slli_epi32 (x, 13));
+    x = _mm256_xor_si256 (x, _mm256_srli_epi32 (x, 17));
+    return _mm256_xor_si256 (x, _mm256_slli_epi32 (x, 5));
+}
+
+AVX2 static inline __m256 noise_avx2 (__m256i x)
+{
+    __m256i r = _mm256_sub_epi32 (_mm256_srli_epi32 (x, 16), _mm256_and_si256
+     (x, _mm256_set1_epi32 (0xffff)));
+    return _mm256_mul_ps (_mm256_cvtepi32_ps (r), _mm256_set1_ps (1.0f / 65536));
+}
+
+AVX2 static inline __m256i round_avx2 (__m256 x, __m256 lo, __m256 hi)
+{
+    return _mm256_cvtps_epi32 (_mm256_max_ps (_mm256_min_ps (x, hi), lo));
+}
+
+/* packs_epi32 works within each 128-bit half; put the quarters in order */
+AVX2 static inline __m256i pack_avx2 (__m256i a, __m256i b)
+{
+    return _mm256_permute4x64_epi64 (_mm256_packs_epi32 (a, b), 0xd8);
+}
+
+AVX2 static void from_s16_avx2 (const int16_t * in, float * out, int samples)
+{
+    const __m256 scale = _mm256_set1_ps (1.0f / 32768);
+    int i = 0;
+
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i a = _mm256_cvtepi16_epi32 (_mm_loadu_si128 ((const __m128i *)
+         (in + i)));
+        __m256i b = _mm256_cvtepi16_epi32 (_mm_loadu_si128 ((const __m128i *)
+         (in + i + 8)));
+
+        _mm256_storeu_ps (out + i, _mm256_mul_ps (_mm256_cvtepi32_ps (a), scale));
+        _mm256_storeu_ps (out + i + 8, _mm256_mul_ps (_mm256_cvtepi32_ps (b),
+         scale));
+    }
+
+    from_s16_c (in + i, out + i, samples - i);
+}
+
+AVX2 static void from_s24_avx2 (const int32_t * in, float * out, int samples)
+{
+    const __m256 scale = _mm256_set1_ps (1.0f / 8388608);
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256 ((const __m256i *) (in + i));
+        _mm256_storeu_ps (out + i, _mm256_mul_ps (_mm256_cvtepi32_ps (x), scale));
+    }
+
+    from_s24_c (in + i, out + i, samples - i);
+}
+
+AVX2 static void to_s16_avx2 (const float * in, int16_t * out, int samples)
+{
+    const __m256 scale = _mm256_set1_ps (32768.0f);
+    const __m256 lo = _mm256_set1_ps (-32768.0f), hi = _mm256_set1_ps (32767.0f);
+    int i = 0;
+
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i a = round_avx2 (_mm256_mul_ps (_mm256_loadu_ps (in + i), scale),
+         lo, hi);
+        __m256i b = round_avx2 (_mm256_mul_ps (_mm256_loadu_ps (in + i + 8),
+         scale), lo, hi);
+
+        _mm256_storeu_si256 ((__m256i *) (out + i), pack_avx2 (a, b));
+    }
+
+    to_s16_c (in + i, out + i, samples - i);
+}
+
+AVX2 static void to_s24_avx2 (const float * in, int32_t * out, int samples)
+{
+    const __m256 scale = _mm256_set1_ps (8388608.0f);
+    const __m256 lo = _mm256_set1_ps (-8388608.0f);
+    const __m256 hi = _mm256_set1_ps (8388607.0f);
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+        _mm256_storeu_si256 ((__m256i *) (out + i), round_avx2 (_mm256_mul_ps
+         (_mm256_loadu_ps (in + i), scale), lo, hi));
+
+    to_s24_c (in + i, out + i, samples - i);
+}
+
+AVX2 static void to_s16_dither_avx2 (const float * in, int16_t * out,
+ int samples, SampleDither * dither)
+{
+    const __m256 scale = _mm256_set1_ps (32768.0f);
+    const __m256 lo = _mm256_set1_ps (-32768.0f), hi = _mm256_set1_ps (32767.0f);
+    int i = dither_head (dither, samples);
+
+    to_s16_dither_c (in, out, i, dither);
+
+    __m256i x = _mm256_loadu_si256 ((const __m256i *) dither->lanes);
+
+    for (; i + 16 <= samples; i += 16)
+    {
+        x = xorshift_avx2 (x);
+        __m256i a = round_avx2 (_mm256_add_ps (_mm256_mul_ps (_mm256_loadu_ps
+         (in + i), scale), noise_avx2 (x)), lo, hi);
+        x = xorshift_avx2 (x);
+        __m256i b = round_avx2 (_mm256_add_ps (_mm256_mul_ps (_mm256_loadu_ps
+         (in + i + 8), scale), noise_avx2 (x)), lo, hi);
+
+        _mm256_storeu_si256 ((__m256i *) (out + i), pack_avx2 (a, b));
+    }
+
+    _mm256_storeu_si256 ((__m256i *) dither->lanes, x);
+
+    to_s16_dither_c (in + i, out + i, samples - i, dither);
+}
+
+AVX2 static void to_s24_dither_avx2 (const float * in, int32_t * out,
+ int samples, SampleDither * dither)
+{
+    const __m256 scale = _mm256_set1_ps (8388608.0f);
+    const __m256 lo = _mm256_set1_ps (-8388608.0f);
+    const __m256 hi = _mm256_set1_ps (8388607.0f);
+    int i = dither_head (dither, samples);
+
+    to_s24_dither_c (in, out, i, dither);
+
+    __m256i x = _mm256_loadu_si256 ((const __m256i *) dither->lanes);
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        x = xorshift_avx2 (x);
+        _mm256_storeu_si256 ((__m256i *) (out + i), round_avx2 (_mm256_add_ps
+         (_mm256_mul_ps (_mm256_loadu_ps (in + i), scale), noise_avx2 (x)), lo,
+         hi));
+    }
+
+    _mm256_storeu_si256 ((__m256i *) dither->lanes, x);
+
+    to_s24_dither_c (in + i, out + i, samples - i, dither);
+}
+
+AVX2 static void gain_avx2 (float * data, int channels, int frames,
+ const float * gains)
+{
+    if (! pattern_fits (channels, 8))
+    {
+        gain_c (data, channels, frames, gains);
+        return;
+    }
+
+    float pattern[8];
+    for (int i = 0; i < 8; i ++)
+        pattern[i] = gains[i % channels];
+
+    __m256 g = _mm256_loadu_ps (pattern);
+    int samples = channels * frames, i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+        _mm256_storeu_ps (data + i, _mm256_mul_ps (_mm256_loadu_ps (data + i),
+         g));
+
+    gain_c (data + i, channels, (samples - i) / channels, gains);
+}
+
+AVX2 static void gain_s16_avx2 (int16_t * data, int channels, int frames,
+ const int * factors)
+{
+    int16_t mul[16], add[16];
+
+    if (! pattern_fits (channels, 16) || ! split_factors (factors, channels,
+     16, mul, add))
+    {
+        gain_s16_c (data, channels, frames, factors);
+        return;
+    }
+
+    __m256i m = _mm256_loadu_si256 ((const __m256i *) mul);
+    __m256i a = _mm256_loadu_si256 ((const __m256i *) add);
+    int samples = channels * frames, i = 0;
+
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i x = _mm256_loadu_si256 ((const __m256i *) (data + i));
+        x = _mm256_add_epi16 (_mm256_mulhi_epi16 (x, m), _mm256_and_si256 (x,
+         a));
+        _mm256_storeu_si256 ((__m256i *) (data + i), x);
+    }
+
+    gain_s16_c (data + i, channels, (samples - i) / channels, factors);
+}
+
+static const SampleFuncs funcs_avx2 = {
+    from_s16_avx2,
+    from_s24_avx2,
+    to_s16_avx2,
+    to_s24_avx2,
+    to_s16_dither_avx2,
+    to_s24_dither_avx2,
+    gain_avx2,
+    gain_s16_avx2
+};
+
+#endif /* SAMPLE_X86 */
+
+/* ---- dispatch ---- */
+
+static pthread_once_t detect_once = PTHREAD_ONCE_INIT;
+static int max_level = SAMPLE_SCALAR;
+static int level = SAMPLE_SCALAR;
+static const SampleFuncs * funcs = & funcs_c;
+
+static void select_level (int want)
+{
+    level = (want < max_level) ? want : max_level;
+
+#ifdef SAMPLE_X86
+    if (level == SAMPLE_AVX2)
+        funcs = & funcs_avx2;
+    else if (level == SAMPLE_SSE2)
+        funcs = & funcs_sse2;
+    else
+#endif
+        funcs = & funcs_c;
+}
+
+static void detect (void)
+{
+#ifdef SAMPLE_X86
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx2"))
+        max_level = SAMPLE_AVX2;
+    else if (__builtin_cpu_supports ("sse2"))
+        max_level = SAMPLE_SSE2;
+#endif
+
+    select_level (max_level);
+}
+
+static const SampleFuncs * get_funcs (void)
+{
+    pthread_once (& detect_once, detect);
+    return funcs;
+}
+
+int sample_convert_level (void)
+{
+    get_funcs ();
+    return level;
+}
+
+int sample_convert_set_level (int want)
+{
+    get_funcs ();
+    select_level (want);
+    return level;
+}
+
+void sample_from_s16 (const int16_t * in, float * out, int samples)
+{
+    get_funcs ()->from_s16 (in, out, samples);
+}
+
+void sample_from_s24 (const int32_t * in, float * out, int samples)
+{
+    get_funcs ()->from_s24 (in, out, samples);
+}
+
+void sample_to_s16 (const float * in, int16_t * out, int samples)
+{
+    get_funcs ()->to_s16 (in, out, samples);
+}
+
+void sample_to_s24 (const float * in, int32_t * out, int samples)
+{
+    get_funcs ()->to_s24 (in, out, samples);
+}
+
+void sample_to_s16_dither (const float * in, int16_t * out, int samples,
+ SampleDither * dither)
+{
+    get_funcs ()->to_s16_dither (in, out, samples, dither);
+}
+
+void sample_to_s24_dither (const float * in, int32_t * out, int samples,
+ SampleDither * dither)
+{
+    get_funcs ()->to_s24_dither (in, out, samples, dither);
+}
+
+void sample_gain (float * data, int channels, int frames, const float * gains)
+{
+    get_funcs ()->gain (data, channels, frames, gains);
+}
+
+void sample_gain_s16 (int16_t * data, int channels, int frames,
+ const int * factors)
+{
+    get_funcs ()->gain_s16 (data, channels, frames, factors);
+}
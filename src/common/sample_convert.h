@@ -0,0 +1,80 @@
+/*
+ * sample_convert.h
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Sample conversion and gain for the output plugins.  Each function has a
+ * plain C version and, on x86, SSE2 and AVX2 versions; the best one the CPU
+ * supports is picked the first time any of them is called.  The vector
+ * versions give exactly the same output as the plain ones, including for
+ * out-of-range and NaN input and for dither, so the choice never changes what
+ * is played.
+ *
+ * Samples are interleaved.  S24 means 24-bit samples in the low bits of an
+ * int32_t, as FMT_S24_NE.
+ *
+ * This file is compiled into each plugin that uses it. */
+
+#ifndef AUD_SAMPLE_CONVERT_H
+#define AUD_SAMPLE_CONVERT_H
+
+#include <stdint.h>
+
+enum {
+    SAMPLE_SCALAR,
+    SAMPLE_SSE2,
+    SAMPLE_AVX2
+};
+
+/* State of the triangular (TPDF) dither of up to one step either way.  The
+ * noise comes from eight xorshift generators used in turn, so that a vector
+ * of eight samples takes one number from each. */
+typedef struct {
+    uint32_t lanes[8];
+    int next; /* the generator for the next sample */
+} SampleDither;
+
+void sample_dither_init (SampleDither * dither, uint32_t seed);
+
+/* x / 32768 and x / 8388608 */
+void sample_from_s16 (const int16_t * in, float * out, int samples);
+void sample_from_s24 (const int32_t * in, float * out, int samples);
+
+/* Rounded to the nearest step and clipped; NaN gives the highest value. */
+void sample_to_s16 (const float * in, int16_t * out, int samples);
+void sample_to_s24 (const float * in, int32_t * out, int samples);
+void sample_to_s16_dither (const float * in, int16_t * out, int samples,
+ SampleDither * dither);
+void sample_to_s24_dither (const float * in, int32_t * out, int samples,
+ SampleDither * dither);
+
+/* Multiplies each channel by its own gain, in place.  The vector versions
+ * handle 1, 2, 4 or 8 channels; other layouts use the plain version. */
+void sample_gain (float * data, int channels, int frames, const float * gains);
+
+/* The same for 16-bit samples with 16.16 fixed-point factors from 0 to 65536:
+ * x = (x * factor) >> 16. */
+void sample_gain_s16 (int16_t * data, int channels, int frames,
+ const int * factors);
+
+/* The version in use, and a way to force a lower one for testing.  Returns
+ * the version actually selected, which is never higher than the CPU
+ * supports.  Not to be called while other threads are converting. */
+int sample_convert_level (void);
+int sample_convert_set_level (int level);
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * vis_bands.c
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "vis_bands.h"
+
+#define VIS_DELAY 2 /* delay before falloff in frames */
+#define VIS_FALLOFF 2 /* falloff in units of range per frame */
+
+void vis_bands_init (VisBands * vb, int bands)
+{
+    float xscale[bands + 1];
+
+    /* conversion table for the x-axis */
+    for (int i = 0; i <= bands; i ++)
+        xscale[i] = powf (256, (float) i / bands) - 0.5f;
+
+    /* fudge factor to make the graph have the same overall height as a
+       12-band one no matter how many bands there are */
+    float fudge = (float) bands / 12;
+
+    /* each band spans at most two partial bins more than its width */
+    int max = 2 * bands + 256;
+
+    vb->bands = bands;
+    vb->first = g_new (int, bands + 1);
+    vb->bins = g_new (int, max);
+    vb->weights = g_new (float, max);
+
+    int n = 0;
+
+    for (int i = 0; i < bands; i ++)
+    {
+        /* sum up values in freq array between xscale[i] and xscale[i + 1],
+           including fractional parts */
+        int a = ceilf (xscale[i]);
+        int b = floorf (xscale[i + 1]);
+
+        vb->first[i] = n;
+
+        if (b < a)
+        {
+            vb->bins[n] = b;
+            vb->weights[n ++] = fudge * (xscale[i + 1] - xscale[i]);
+        }
+        else
+        {
+            if (a > 0)
+            {
+                vb->bins[n] = a - 1;
+                vb->weights[n ++] = fudge * (a - xscale[i]);
+            }
+
+            for (; a < b; a ++)
+            {
+                vb->bins[n] = a;
+                vb->weights[n ++] = fudge;
+            }
+
+            if (b < 256)
+            {
+                vb->bins[n] = b;
+                vb->weights[n ++] = fudge * (xscale[i + 1] - b);
+            }
+        }
+    }
+
+    vb->first[bands] = n;
+}
+
+void vis_bands_cleanup (VisBands * vb)
+{
+    g_free (vb->first);
+    g_free (vb->bins);
+    g_free (vb->weights);
+    memset (vb, 0, sizeof (VisBands));
+}
+
+/* log2 (x) to within 0.001 dB, without the overhead of a library call; the
+ * loop in vis_bands_compute() can then be vectorized by the compiler */
+static inline float fast_log2 (float x)
+{
+    union {
+        float f;
+        uint32_t i;
+    } u = {x};
+
+    /* split x into 2^e * m, with m in [1, 2) */
+    float e = (int) (u.i >> 23) - 127;
+    u.i = (u.i & 0x7fffff) | 0x3f800000;
+
+    /* series for log2 (m) = 2 / ln (2) * atanh ((m - 1) / (m + 1)) */
+    float t = (u.f - 1) / (u.f + 1);
+    float t2 = t * t;
+
+    return e + t * (2.8853901f + t2 * (0.9617967f + t2 * 0.5770780f));
+}
+
+void vis_bands_compute (const VisBands * vb, const float * freq, float
+ db_range, float * levels)
+{
+    for (int i = 0; i < vb->bands; i ++)
+    {
+        float sum = 0;
+
+        for (int j = vb->first[i]; j < vb->first[i + 1]; j ++)
+            sum += freq[vb->bins[j]] * vb->weights[j];
+
+        levels[i] = sum;
+    }
+
+    /* convert to dB and scale (-db_range, 0.0) to (0.0, 1.0);
+       20 * log10 (x) = 20 * log10 (2) * log2 (x) */
+    float scale = 6.0205999f / db_range;
+
+    for (int i = 0; i < vb->bands; i ++)
+    {
+        float val = 1 + scale * fast_log2 (levels[i]);
+        levels[i] = CLAMP (val, 0, 1);
+    }
+}
+
+void vis_peaks_init (VisPeaks * peaks, int bands)
+{
+    peaks->bands = bands;
+    peaks->bars = g_new0 (int, bands);
+    peaks->delay = g_new0 (int, bands);
+}
+
+void vis_peaks_cleanup (VisPeaks * peaks)
+{
+    g_free (peaks->bars);
+    g_free (peaks->delay);
+    memset (peaks, 0, sizeof (VisPeaks));
+}
+
+void vis_peaks_clear (VisPeaks * peaks)
+{
+    memset (peaks->bars, 0, sizeof (int) * peaks->bands);
+    memset (peaks->delay, 0, sizeof (int) * peaks->bands);
+}
+
+void vis_peaks_update (VisPeaks * peaks, const float * levels, int range)
+{
+    for (int i = 0; i < peaks->bands; i ++)
+    {
+        int x = levels[i] * range;
+
+        peaks->bars[i] -= MAX (0, VIS_FALLOFF - peaks->delay[i]);
+
+        if (peaks->delay[i])
+            peaks->delay[i] --;
+
+        if (x > peaks->bars[i])
+        {
+            peaks->bars[i] = x;
+            peaks->delay[i] = VIS_DELAY;
+        }
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * vis_bands.h
+ * Copyright 2013 Audacious development team
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Conversion of the 256-bin frequency data passed to visualizations into a
+ * smaller number of logarithmically spaced bands, measured in decibels.  The
+ * fractional bin weights for a given number of bands are worked out once, so
+ * that each frame is only a weighted sum and a logarithm per band.
+ *
+ * This file is compiled into each plugin that uses it. */
+
+#ifndef AUD_VIS_BANDS_H
+#define AUD_VIS_BANDS_H
+
+typedef struct {
+    int bands;
+    int * first; /* band i uses entries first[i] through first[i + 1] - 1 */
+    int * bins;
+    float * weights;
+} VisBands;
+
+typedef struct {
+    int bands;
+    int * bars;
+    int * delay;
+} VisPeaks;
+
+void vis_bands_init (VisBands * vb, int bands);
+void vis_bands_cleanup (VisBands * vb);
+
+/* Fills levels[0 .. vb->bands - 1], scaling (-db_range, 0) dB to (0, 1).  The
+ * overall height of the graph is the same no matter how many bands there
+ * are. */
+void vis_bands_compute (const VisBands * vb, const float * freq, float
+ db_range, float * levels);
+
+void vis_peaks_init (VisPeaks * peaks, int bands);
+void vis_peaks_cleanup (VisPeaks * peaks);
+void vis_peaks_clear (VisPeaks * peaks);
+
+/* Scales levels to (0, range) and updates the bars, which are held for a short
+ * time before falling back. */
+void vis_peaks_update (VisPeaks * peaks, const float * levels, int range);
+
+#endif
@@ -27,6 +27,26 @@ static gboolean stop_flag = FALSE;
 static const gint fade_threshold = 10 * 1000;
 static const gint fade_length    = 8 * 1000;
 
+/* The emulator runs in a separate render thread, which stays up to
+ * audcfg.render_ahead seconds ahead of the output in a ring buffer.  The ring
+ * state below is protected by seek_mutex.  Sizes and positions are counted in
+ * samples (two per stereo frame). */
+static const gint block_size = 16384;   // most samples rendered or written at once
+
+static pthread_cond_t render_cond = PTHREAD_COND_INITIALIZER;
+static Music_Emu::sample_t *ring;
+static gint ring_size, ring_read, ring_fill;
+static gint64 ring_time;                // track position of ring[ring_read]
+static gint ring_generation;            // bumped whenever the ring is emptied
+static gint64 render_target = -1;       // position the renderer must seek to
+static gboolean render_done;            // track ended and its tail is queued
+
+struct RenderParams {
+    Music_Emu *emu;
+    gint track;
+    gint fade_start;
+};
+
 static blargg_err_t log_err(blargg_err_t err)
 {
     if (err) g_critical("console: %s\n", err);
@@ -212,10 +232,128 @@ extern "C" Tuple * console_probe_for_tuple(const gchar *filename, VFSFile *fd)
     return NULL;
 }
 
+static gint64 ms_to_samples(gint ms, gint sample_rate)
+{
+    return (gint64) ms * sample_rate / 1000 * 2;
+}
+
+/* Seeks in steps of a second, so that a stop or a newer seek request does not
+ * have to wait for a long skip.  Returns the position reached, or -1 if the
+ * track could not be restarted. */
+static gint64 render_seek(const RenderParams *params, gint64 now, gint64 target, gint generation)
+{
+    Music_Emu *emu = params->emu;
+
+    if (target < now)
+    {
+        if (log_err(emu->start_track(params->track)))
+            return -1;
+
+        // start_track() resets the fade as well
+        emu->set_fade(params->fade_start, fade_length);
+        now = 0;
+    }
+
+    const gint64 step = emu->sample_rate() * 2;
+
+    while (now < target)
+    {
+        gint64 count = MIN(target - now, step);
+        emu->skip(count);
+        now += count;
+
+        pthread_mutex_lock(&seek_mutex);
+        gboolean interrupted = stop_flag || generation != ring_generation;
+        pthread_mutex_unlock(&seek_mutex);
+
+        if (interrupted)
+            break;
+    }
+
+    return now;
+}
+
+static void *render_thread(void *data)
+{
+    const RenderParams *params = (const RenderParams *) data;
+    Music_Emu *emu = params->emu;
+    gint64 emu_time = 0;        // position of the emulator in the track
+    gint64 silence = -1;        // samples of silence left after the end of the track
+
+    pthread_mutex_lock(&seek_mutex);
+
+    while (!stop_flag)
+    {
+        if (render_target >= 0)
+        {
+            gint64 target = render_target;
+            gint generation = ring_generation;
+            render_target = -1;
+            pthread_mutex_unlock(&seek_mutex);
+
+            emu_time = render_seek(params, emu_time, target, generation);
+            silence = -1;
+
+            pthread_mutex_lock(&seek_mutex);
+
+            if (emu_time < 0)
+            {
+                emu_time = 0;
+                render_done = TRUE;
+                pthread_cond_broadcast(&seek_cond);
+            }
+
+            continue;
+        }
+
+        gint space = ring_size - ring_fill;
+        if (render_done || space < block_size)
+        {
+            pthread_cond_wait(&render_cond, &seek_mutex);
+            continue;
+        }
+
+        gint write = (ring_read + ring_fill) % ring_size;
+        gint count = MIN(MIN(space, ring_size - write), block_size);
+        gint generation = ring_generation;
+        pthread_mutex_unlock(&seek_mutex);
+
+        // the region past the buffered data is only touched by this thread
+        if (silence >= 0)
+        {
+            // TODO: remove delay once host doesn't cut the end of track off
+            count = MIN(count, silence);
+            memset(ring + write, 0, sizeof(Music_Emu::sample_t) * count);
+            silence -= count;
+        }
+        else
+        {
+            // the emulator has moved on even if a seek makes us throw the
+            // block away, so its position is kept apart from the ring's
+            emu->play(count, ring + write);
+            emu_time += count;
+            if (emu->track_ended())
+                silence = emu->sample_rate() * 3 * 2;
+        }
+
+        pthread_mutex_lock(&seek_mutex);
+
+        if (generation == ring_generation)
+        {
+            ring_fill += count;
+            render_done = (silence == 0);
+            pthread_cond_broadcast(&seek_cond);
+        }
+    }
+
+    pthread_mutex_unlock(&seek_mutex);
+    return NULL;
+}
+
 extern "C" gboolean console_play(InputPlayback *playback, const gchar *filename,
     VFSFile *file, gint start_time, gint stop_time, gboolean pause)
 {
-    gint length, end_delay, sample_rate;
+    gint length, sample_rate;
     track_info_t info;
     gboolean error = FALSE;
 
@@ -294,47 +432,85 @@ extern "C" gboolean console_play(InputPlayback *playback, const gchar *filename,
         length -= fade_length / 2;
     fh.m_emu->set_fade(length, fade_length);
 
+    RenderParams params = {fh.m_emu, fh.m_track, length};
+    pthread_t render;
+
+    ring_size = MAX(audcfg.render_ahead * sample_rate * 2, block_size * 2);
+    ring = g_new(Music_Emu::sample_t, ring_size);
+    ring_read = ring_fill = 0;
+    ring_time = 0;
+    render_target = -1;
+    render_done = FALSE;
+
     stop_flag = FALSE;
-    end_delay = 0;
     playback->set_pb_ready(playback);
 
+    pthread_create(&render, NULL, render_thread, &params);
+    pthread_mutex_lock(&seek_mutex);
+
     while (!stop_flag)
     {
         /* Perform seek, if requested */
-        pthread_mutex_lock(&seek_mutex);
         if (seek_value >= 0)
         {
             playback->output->flush(seek_value);
-            fh.m_emu->seek(seek_value);
+
+            gint64 target = ms_to_samples(seek_value, sample_rate);
+
+            if (render_target < 0 && target >= ring_time && target < ring_time + ring_fill)
+            {
+                // already rendered: just drop what lies before
+                gint drop = target - ring_time;
+                ring_read = (ring_read + drop) % ring_size;
+                ring_fill -= drop;
+            }
+            else
+            {
+                render_target = target;
+                ring_read = ring_fill = 0;
+                render_done = FALSE;
+                ring_generation ++;
+            }
+
+            ring_time = target;
             seek_value = -1;
-            pthread_cond_signal(&seek_cond);
+            pthread_cond_broadcast(&seek_cond);
+            pthread_cond_signal(&render_cond);
+            continue;
         }
-        pthread_mutex_unlock(&seek_mutex);
 
-        /* Fill and play buffer of audio */
-        gint const buf_size = 1024;
-        Music_Emu::sample_t buf[buf_size];
-        if (end_delay)
+        if (!ring_fill)
         {
-            // TODO: remove delay once host doesn't cut the end of track off
-            if (!--end_delay)
-                stop_flag = TRUE;
-            memset(buf, 0, sizeof(buf));
-        }
-        else
-        {
-            fh.m_emu->play(buf_size, buf);
-            if (fh.m_emu->track_ended())
-            {
-                end_delay = (fh.m_emu->sample_rate() * 3 * 2) / buf_size;
-            }
+            if (render_done)
+                break;
+
+            pthread_cond_wait(&seek_cond, &seek_mutex);
+            continue;
         }
 
-        playback->output->write_audio(buf, sizeof(buf));
+        /* Play buffered audio; the renderer does not touch it meanwhile */
+        gint count = MIN(MIN(ring_fill, ring_size - ring_read), block_size);
+        Music_Emu::sample_t *buf = ring + ring_read;
+
+        pthread_mutex_unlock(&seek_mutex);
+        playback->output->write_audio(buf, sizeof(Music_Emu::sample_t) * count);
+        pthread_mutex_lock(&seek_mutex);
+
+        ring_read = (ring_read + count) % ring_size;
+        ring_fill -= count;
+        ring_time += count;
+        pthread_cond_signal(&render_cond);
     }
 
     // stop playing
     stop_flag = TRUE;
+    pthread_cond_signal(&render_cond);
+    pthread_mutex_unlock(&seek_mutex);
+
+    pthread_join(render, NULL);
+
+    g_free(ring);
+    ring = NULL;
 
     return !error;
 }
@@ -347,8 +523,10 @@ extern "C" void console_seek(InputPlayback *playback, gint time)
     {
         seek_value = time;
         playback->output->abort_write();
-        pthread_cond_signal(&seek_cond);
-        pthread_cond_wait(&seek_cond, &seek_mutex);
+        pthread_cond_broadcast(&seek_cond);
+
+        while (seek_value >= 0 && !stop_flag)
+            pthread_cond_wait(&seek_cond, &seek_mutex);
     }
 
     pthread_mutex_unlock(&seek_mutex);
@@ -362,7 +540,7 @@ extern "C" void console_stop(InputPlayback *playback)
     {
         stop_flag = TRUE;
         playback->output->abort_write();
-        pthread_cond_signal(&seek_cond);
+        pthread_cond_broadcast(&seek_cond);
     }
 
     pthread_mutex_unlock (&seek_mutex);
@@ -29,6 +29,7 @@ static const gchar * const console_defaults[] = {
  "ignore_spc_length", "FALSE",
  "echo", "0",
  "inc_spc_reverb", "FALSE",
+ "render_ahead", "5",
  NULL};
 
 // TODO: add UI for echo
@@ -44,6 +45,7 @@ void console_cfg_load (void)
     audcfg.ignore_spc_length = aud_get_bool (CON_CFGID, "ignore_spc_length");
     audcfg.echo = aud_get_int (CON_CFGID, "echo");
     audcfg.inc_spc_reverb = aud_get_bool (CON_CFGID, "inc_spc_reverb");
+    audcfg.render_ahead = aud_get_int (CON_CFGID, "render_ahead");
 }
 
 void console_cfg_save (void)
@@ -56,6 +58,7 @@ void console_cfg_save (void)
     aud_set_bool (CON_CFGID, "ignore_spc_length", audcfg.ignore_spc_length);
     aud_set_int (CON_CFGID, "echo", audcfg.echo);
     aud_set_bool (CON_CFGID, "inc_spc_reverb", audcfg.inc_spc_reverb);
+    aud_set_int (CON_CFGID, "render_ahead", audcfg.render_ahead);
 }
 
 
@@ -86,6 +89,11 @@ static void i_cfg_ev_deflen_value_commit( gpointer spbt )
     audcfg.loop_length = (gint)gtk_spin_button_get_value( GTK_SPIN_BUTTON(spbt) );
 }
 
+static void i_cfg_ev_renderahead_value_commit( gpointer spbt )
+{
+    audcfg.render_ahead = (gint)gtk_spin_button_get_value( GTK_SPIN_BUTTON(spbt) );
+}
+
 static void i_cfg_ev_ignorespclen_enable_commit( gpointer cbt )
 {
     audcfg.ignore_spc_length = gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON(cbt) );
@@ -122,6 +130,7 @@ void console_cfg_ui(void)
     GtkWidget *configwin_gen_playback_tb_bass_hbox, *configwin_gen_playback_tb_bass_spbt;
     GtkWidget *configwin_gen_playback_tb_treble_hbox, *configwin_gen_playback_tb_treble_spbt;
     GtkWidget *configwin_gen_playback_deflen_hbox, *configwin_gen_playback_deflen_spbt;
+    GtkWidget *configwin_gen_playback_renderahead_hbox, *configwin_gen_playback_renderahead_spbt;
     GtkWidget *configwin_spc_ignorespclen_cbt, *configwin_spc_increverb_cbt;
     GtkWidget /* *hseparator, */ *hbuttonbox, *button_ok, *button_cancel;
     GtkWidget *configwin_notebook;
@@ -202,6 +211,19 @@ void console_cfg_ui(void)
                         configwin_gen_playback_deflen_spbt , FALSE , FALSE , 0 );
     gtk_box_pack_start( GTK_BOX(configwin_gen_playback_deflen_hbox) ,
                         gtk_label_new(_("secs")) , FALSE , FALSE , 0 );
+    configwin_gen_playback_renderahead_hbox = gtk_box_new( GTK_ORIENTATION_HORIZONTAL , 4 );
+    gtk_box_pack_start( GTK_BOX(configwin_gen_playback_vbox) ,
+                        configwin_gen_playback_renderahead_hbox , FALSE , FALSE , 0 );
+    configwin_gen_playback_renderahead_spbt = gtk_spin_button_new_with_range( 1 , 60 , 1 );
+    gtk_spin_button_set_value( GTK_SPIN_BUTTON(configwin_gen_playback_renderahead_spbt) , audcfg.render_ahead );
+    g_signal_connect_swapped( G_OBJECT(button_ok) , "clicked" ,
+                              G_CALLBACK(i_cfg_ev_renderahead_value_commit) , configwin_gen_playback_renderahead_spbt );
+    gtk_box_pack_start( GTK_BOX(configwin_gen_playback_renderahead_hbox) ,
+                        gtk_label_new(_("Render ahead:")) , FALSE , FALSE , 0 );
+    gtk_box_pack_start( GTK_BOX(configwin_gen_playback_renderahead_hbox) ,
+                        configwin_gen_playback_renderahead_spbt , FALSE , FALSE , 0 );
+    gtk_box_pack_start( GTK_BOX(configwin_gen_playback_renderahead_hbox) ,
+                        gtk_label_new(_("secs")) , FALSE , FALSE , 0 );
     // GENERAL PAGE - RESAMPLING FRAME
     configwin_gen_resample_frame = gtk_frame_new( _("Resampling") );
     gtk_box_pack_start( GTK_BOX(configwin_gen_vbox) ,
@@ -268,6 +290,9 @@ void console_cfg_ui(void)
     gtk_widget_set_tooltip_text( configwin_gen_playback_deflen_spbt ,
                                  _("The default song length, expressed in seconds, is used for songs "
                                  "that do not provide length information (i.e. looping tracks)."));
+    gtk_widget_set_tooltip_text( configwin_gen_playback_renderahead_spbt ,
+                                 _("How much audio is emulated ahead of playback. Seeking within "
+                                 "this range is immediate."));
 
     gtk_widget_show_all( configwin );
 }
@@ -20,6 +20,7 @@ typedef struct {
 	gboolean ignore_spc_length; /* if true, ignore length from SPC tags */
 	gint echo;                  /* 0 to +100 */
 	gboolean inc_spc_reverb;    /* if true, increases the default reverb */
+	gint render_ahead;          /* seconds rendered ahead of the output */
 } AudaciousConsoleConfig;
 
 extern AudaciousConsoleConfig audcfg;
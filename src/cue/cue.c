@@ -17,8 +17,10 @@
  * the use of this software.
  */
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include <libcue/libcue.h>
 
@@ -54,6 +56,112 @@ tuple_attach_cdtext(Tuple *tuple, Track *track, int tuple_type, int pti)
     tuple_set_str(tuple, tuple_type, NULL, text);
 }
 
+/* Base tuples of the referenced audio files, shared between all cue sheets and
+ * loading threads so that each image is probed once as long as it is not
+ * modified.  Only local files are cached, since only those can be stat'ed. */
+
+#define CACHE_SIZE 32
+
+typedef struct {
+    char * filename;
+    time_t mtime;
+    off_t size;
+    Tuple * tuple; /* NULL if no decoder accepted the file */
+    unsigned stamp;
+} CachedTuple;
+
+static CachedTuple cache[CACHE_SIZE];
+static unsigned cache_clock;
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static Tuple * probe_tuple (const char * filename)
+{
+    PluginHandle * decoder = aud_file_find_decoder (filename, FALSE);
+    return decoder ? aud_file_read_tuple (filename, decoder) : NULL;
+}
+
+static bool_t stat_uri (const char * filename, struct stat * info)
+{
+    char * local = uri_to_filename (filename);
+    if (! local)
+        return FALSE;
+
+    bool_t success = ! stat (local, info);
+    free (local);
+    return success;
+}
+
+static Tuple * get_base_tuple (const char * filename)
+{
+    struct stat info;
+    if (! stat_uri (filename, & info))
+        return probe_tuple (filename);
+
+    pthread_mutex_lock (& cache_mutex);
+
+    for (int i = 0; i < CACHE_SIZE; i ++)
+    {
+        CachedTuple * item = & cache[i];
+
+        if (item->filename && ! strcmp (item->filename, filename) &&
+         item->mtime == info.st_mtime && item->size == info.st_size)
+        {
+            Tuple * tuple = item->tuple ? tuple_ref (item->tuple) : NULL;
+            item->stamp = ++ cache_clock;
+            pthread_mutex_unlock (& cache_mutex);
+            return tuple;
+        }
+    }
+
+    pthread_mutex_unlock (& cache_mutex);
+
+    /* probe without holding the lock; other sheets may load meanwhile */
+    Tuple * tuple = probe_tuple (filename);
+
+    pthread_mutex_lock (& cache_mutex);
+
+    CachedTuple * slot = & cache[0];
+
+    for (int i = 0; i < CACHE_SIZE; i ++)
+    {
+        CachedTuple * item = & cache[i];
+
+        if (item->filename && ! strcmp (item->filename, filename))
+        {
+            slot = item;
+            break;
+        }
+
+        if (! item->filename || item->stamp < slot->stamp)
+            slot = item;
+    }
+
+    str_unref (slot->filename);
+    if (slot->tuple)
+        tuple_unref (slot->tuple);
+
+    slot->filename = str_get (filename);
+    slot->mtime = info.st_mtime;
+    slot->size = info.st_size;
+    slot->tuple = tuple ? tuple_ref (tuple) : NULL;
+    slot->stamp = ++ cache_clock;
+
+    pthread_mutex_unlock (& cache_mutex);
+    return tuple;
+}
+
+static void cue_cleanup (void)
+{
+    for (int i = 0; i < CACHE_SIZE; i ++)
+    {
+        str_unref (cache[i].filename);
+        if (cache[i].tuple)
+            tuple_unref (cache[i].tuple);
+    }
+
+    memset (cache, 0, sizeof cache);
+}
+
 static bool_t playlist_load_cue (const char * cue_filename, VFSFile * file,
  char * * title, Index * filenames, Index * tuples)
 {
@@ -75,33 +183,31 @@ static bool_t playlist_load_cue (const char * cue_filename, VFSFile * file,
         return FALSE;
 
     int tracks = cd_get_ntrack (cd);
-    if (tracks == 0)
-        return FALSE;
-
-    Track * current = cd_get_track (cd, 1);
-    if (current == NULL)
-        return FALSE;
+    Track * current = (tracks > 0) ? cd_get_track (cd, 1) : NULL;
+    char * track_filename = (current != NULL) ? track_get_filename (current) : NULL;
 
-    char * track_filename = track_get_filename (current);
     if (track_filename == NULL)
+    {
+        cd_delete (cd);
         return FALSE;
+    }
 
     char * filename = aud_construct_uri (track_filename, cue_filename);
 
+    /* each FILE gets its own base tuple, so that the last track of every
+     * file is given the right length */
     Tuple * base_tuple = NULL;
     bool_t base_tuple_scanned = FALSE;
 
     for (int track = 1; track <= tracks; track ++)
     {
         if (current == NULL || filename == NULL)
-            return FALSE;
+            break;
 
-        if (base_tuple == NULL && ! base_tuple_scanned)
+        if (! base_tuple_scanned)
         {
             base_tuple_scanned = TRUE;
-            PluginHandle * decoder = aud_file_find_decoder (filename, FALSE);
-            if (decoder != NULL)
-                base_tuple = aud_file_read_tuple (filename, decoder);
+            base_tuple = get_base_tuple (filename);
         }
 
         Track * next = (track + 1 <= tracks) ? cd_get_track (cd, track + 1) : NULL;
@@ -140,15 +246,23 @@ static bool_t playlist_load_cue (const char * cue_filename, VFSFile * file,
         free (filename);
         filename = next_filename;
 
-        if (last_track && base_tuple != NULL)
+        if (last_track)
         {
-            tuple_unref (base_tuple);
+            if (base_tuple != NULL)
+                tuple_unref (base_tuple);
+
             base_tuple = NULL;
             base_tuple_scanned = FALSE;
         }
     }
 
-    return TRUE;
+    if (base_tuple != NULL)
+        tuple_unref (base_tuple);
+
+    free (filename);
+    cd_delete (cd);
+
+    return (index_count (tuples) > 0);
 }
 
 static const char * const cue_exts[] = {"cue", NULL};
@@ -157,6 +271,7 @@ AUD_PLAYLIST_PLUGIN
 (
  .name = N_("Cue Sheet Plugin"),
  .domain = PACKAGE,
+ .cleanup = cue_cleanup,
  .extensions = cue_exts,
  .load = playlist_load_cue
 )
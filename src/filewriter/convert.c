@@ -1,9 +1,14 @@
+#include "../common/sample_convert.h"
 #include "convert.h"
 
 gpointer convert_output = NULL;
+static gsize output_size;
+static gfloat * convert_temp = NULL;
+static gsize temp_size;
 static gint nch;
 static gint in_fmt;
 static gint out_fmt;
+static SampleDither dither;
 
 gboolean convert_init(gint input_fmt, gint output_fmt, gint channels)
 {
@@ -11,28 +16,63 @@ gboolean convert_init(gint input_fmt, gint output_fmt, gint channels)
     out_fmt = output_fmt;
     nch = channels;
 
+    /* the same seed each time, so that a song is always written the same */
+    sample_dither_init (& dither, 1);
+
     return TRUE;
 }
 
+/* 16 and 24 bit use the shared converters, and are dithered when the bit
+ * depth is reduced; libaudcore does the other formats. */
+
+static void to_float (gconstpointer in, gfloat * out, gint samples)
+{
+    if (in_fmt == FMT_S16_NE)
+        sample_from_s16 (in, out, samples);
+    else if (in_fmt == FMT_S24_NE)
+        sample_from_s24 (in, out, samples);
+    else
+        audio_from_int (in, in_fmt, out, samples);
+}
+
+static void from_float (const gfloat * in, gpointer out, gint samples)
+{
+    if (out_fmt == FMT_S16_NE)
+        sample_to_s16_dither (in, out, samples, & dither);
+    else if (out_fmt == FMT_S24_NE)
+        sample_to_s24_dither (in, out, samples, & dither);
+    else
+        audio_to_int (in, out, out_fmt, samples);
+}
+
 gint convert_process(gpointer ptr, gint length)
 {
     gint samples = length / FMT_SIZEOF (in_fmt);
-    gfloat * temp;
 
-    convert_output = g_realloc (convert_output, FMT_SIZEOF (out_fmt) * samples);
+    /* The buffers are only ever grown, so that after the first few blocks no
+     * allocation is done here at all. */
+    if (output_size < FMT_SIZEOF (out_fmt) * samples)
+    {
+        output_size = FMT_SIZEOF (out_fmt) * samples;
+        convert_output = g_realloc (convert_output, output_size);
+    }
 
     if (in_fmt == out_fmt)
         memcpy (convert_output, ptr, FMT_SIZEOF (in_fmt) * samples);
     else if (in_fmt == FMT_FLOAT)
-        audio_to_int (ptr, convert_output, out_fmt, samples);
+        from_float (ptr, convert_output, samples);
     else if (out_fmt == FMT_FLOAT)
-        audio_from_int (ptr, in_fmt, convert_output, samples);
+        to_float (ptr, convert_output, samples);
     else
     {
-        temp = g_malloc (sizeof (gfloat) * samples);
-        audio_from_int (ptr, in_fmt, temp, samples);
-        audio_to_int (temp, convert_output, out_fmt, samples);
-        g_free (temp);
+        if (temp_size < samples)
+        {
+            temp_size = samples;
+            convert_temp = g_renew (gfloat, convert_temp, temp_size);
+        }
+
+        to_float (ptr, convert_temp, samples);
+        from_float (convert_temp, convert_output, samples);
     }
 
     return FMT_SIZEOF (out_fmt) * samples;
@@ -42,4 +82,9 @@ void convert_free(void)
 {
     g_free (convert_output);
     convert_output = NULL;
+    output_size = 0;
+
+    g_free (convert_temp);
+    convert_temp = NULL;
+    temp_size = 0;
 }
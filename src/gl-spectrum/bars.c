@@ -0,0 +1,133 @@
+/*
+ * OpenGL Spectrum Analyzer for Audacious
+ * Copyright 2013 Christophe Budé and John Lindgren
+ *
+ * Based on the XMMS plugin:
+ * Copyright 1998-2000 Peter Alm, Mikael Alm, Olle Hallnas, Thomas Nilsson, and
+ *                     4Front Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <GL/gl.h>
+
+#include "bars.h"
+
+#define BAR_SPACING (3.2f / NUM_BANDS)
+#define BAR_WIDTH (0.8f * BAR_SPACING)
+
+/* each bar is drawn as four quads: top, left, right, and front */
+#define BAR_VERTICES 16
+
+static float colors[NUM_BANDS][NUM_BANDS][3];
+
+/* The bars are drawn from vertex arrays in a single call.  The x and z
+ * coordinates never change; the heights and colors are filled in whenever new
+ * data arrives. */
+static float s_vertices[NUM_BANDS][NUM_BANDS][BAR_VERTICES][3];
+static float s_colors[NUM_BANDS][NUM_BANDS][BAR_VERTICES][3];
+
+static const struct {
+    GLboolean right, top, back;
+    float shade;
+} bar_corners[BAR_VERTICES] = {
+ {GL_FALSE, GL_TRUE, GL_FALSE, 1}, {GL_TRUE, GL_TRUE, GL_FALSE, 1},
+ {GL_TRUE, GL_TRUE, GL_TRUE, 1}, {GL_FALSE, GL_TRUE, GL_TRUE, 1},
+ {GL_FALSE, GL_FALSE, GL_FALSE, 0.65f}, {GL_FALSE, GL_TRUE, GL_FALSE, 0.65f},
+ {GL_FALSE, GL_TRUE, GL_TRUE, 0.65f}, {GL_FALSE, GL_FALSE, GL_TRUE, 0.65f},
+ {GL_TRUE, GL_TRUE, GL_FALSE, 0.65f}, {GL_TRUE, GL_FALSE, GL_FALSE, 0.65f},
+ {GL_TRUE, GL_FALSE, GL_TRUE, 0.65f}, {GL_TRUE, GL_TRUE, GL_TRUE, 0.65f},
+ {GL_FALSE, GL_FALSE, GL_FALSE, 0.8f}, {GL_TRUE, GL_FALSE, GL_FALSE, 0.8f},
+ {GL_TRUE, GL_TRUE, GL_FALSE, 0.8f}, {GL_FALSE, GL_TRUE, GL_FALSE, 0.8f}};
+
+void bars_init (void)
+{
+    for (int y = 0; y < NUM_BANDS; y ++)
+    {
+        float yf = (float) y / (NUM_BANDS - 1);
+
+        for (int x = 0; x < NUM_BANDS; x ++)
+        {
+            float xf = (float) x / (NUM_BANDS - 1);
+
+            colors[x][y][0] = (1 - xf) * (1 - yf);
+            colors[x][y][1] = xf;
+            colors[x][y][2] = yf;
+        }
+    }
+
+    for (int i = 0; i < NUM_BANDS; i ++)
+    {
+        float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+
+        for (int j = 0; j < NUM_BANDS; j ++)
+        {
+            float x = 1.6f - BAR_SPACING * j;
+
+            for (int k = 0; k < BAR_VERTICES; k ++)
+            {
+                float * v = s_vertices[i][j][k];
+
+                v[0] = bar_corners[k].right ? x + BAR_WIDTH : x;
+                v[1] = 0;
+                v[2] = bar_corners[k].back ? z + BAR_WIDTH : z;
+            }
+        }
+    }
+}
+
+void bars_update (float heights[][NUM_BANDS], int pos)
+{
+    for (int i = 0; i < NUM_BANDS; i ++)
+    {
+        for (int j = 0; j < NUM_BANDS; j ++)
+        {
+            float h = heights[(pos + i) % NUM_BANDS][j] * 1.6f;
+            float bright = 0.2f + 0.8f * h;
+
+            for (int k = 0; k < BAR_VERTICES; k ++)
+            {
+                if (bar_corners[k].top)
+                    s_vertices[i][j][k][1] = h;
+
+                for (int c = 0; c < 3; c ++)
+                    s_colors[i][j][k][c] = colors[i][j][c] * bright *
+                     bar_corners[k].shade;
+            }
+        }
+    }
+}
+
+void bars_draw (float angle)
+{
+    glPushMatrix ();
+    glTranslatef (0.0f, -0.5f, -5.0f);
+    glRotatef (38.0f, 1.0f, 0.0f, 0.0f);
+    glRotatef (angle + 180.0f, 0.0f, 1.0f, 0.0f);
+    glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
+
+    glEnableClientState (GL_VERTEX_ARRAY);
+    glEnableClientState (GL_COLOR_ARRAY);
+    glVertexPointer (3, GL_FLOAT, 0, s_vertices);
+    glColorPointer (3, GL_FLOAT, 0, s_colors);
+
+    glDrawArrays (GL_QUADS, 0, NUM_BANDS * NUM_BANDS * BAR_VERTICES);
+
+    glDisableClientState (GL_COLOR_ARRAY);
+    glDisableClientState (GL_VERTEX_ARRAY);
+
+    glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
+    glPopMatrix ();
+}
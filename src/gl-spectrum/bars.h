@@ -0,0 +1,40 @@
+/*
+ * OpenGL Spectrum Analyzer for Audacious
+ * Copyright 2013 Christophe Budé and John Lindgren
+ *
+ * Based on the XMMS plugin:
+ * Copyright 1998-2000 Peter Alm, Mikael Alm, Olle Hallnas, Thomas Nilsson, and
+ *                     4Front Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef GL_SPECTRUM_BARS_H
+#define GL_SPECTRUM_BARS_H
+
+#define NUM_BANDS 32
+
+/* Sets up the parts of the bars that never change. */
+void bars_init (void);
+
+/* Fills in the bars from heights between 0 and 1.  Row pos of heights holds
+ * the oldest data, which is drawn at the back. */
+void bars_update (float heights[][NUM_BANDS], int pos);
+
+/* Draws the bars into the current context, which must already have its
+ * projection set up, turned to the given angle. */
+void bars_draw (float angle);
+
+#endif
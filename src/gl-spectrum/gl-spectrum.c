@@ -21,7 +21,6 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
-#include <math.h>
 #include <string.h>
 
 #include <audacious/i18n.h>
@@ -33,14 +32,12 @@
 #include <GL/gl.h>
 #include <GL/glx.h>
 
-#define NUM_BANDS 32
-#define DB_RANGE 40
+#include "../common/vis_bands.h"
+#include "bars.h"
 
-#define BAR_SPACING (3.2f / NUM_BANDS)
-#define BAR_WIDTH (0.8f * BAR_SPACING)
+#define DB_RANGE 40
 
-static float logscale[NUM_BANDS + 1];
-static float colors[NUM_BANDS][NUM_BANDS][3];
+static VisBands s_layout;
 
 static GLXContext s_context;
 static GtkWidget * s_widget = NULL;
@@ -51,68 +48,23 @@ static float s_bars[NUM_BANDS][NUM_BANDS];
 
 static bool_t init (void)
 {
-    for (int i = 0; i <= NUM_BANDS; i ++)
-        logscale[i] = powf (256, (float) i / NUM_BANDS) - 0.5f;
-
-    for (int y = 0; y < NUM_BANDS; y ++)
-    {
-        float yf = (float) y / (NUM_BANDS - 1);
-
-        for (int x = 0; x < NUM_BANDS; x ++)
-        {
-            float xf = (float) x / (NUM_BANDS - 1);
-
-            colors[x][y][0] = (1 - xf) * (1 - yf);
-            colors[x][y][1] = xf;
-            colors[x][y][2] = yf;
-        }
-    }
+    vis_bands_init (& s_layout, NUM_BANDS);
+    bars_init ();
+    bars_update (s_bars, s_pos);
 
     return TRUE;
 }
 
-/* stolen from the skins plugin */
-/* convert linear frequency graph to logarithmic one */
-static void make_log_graph (const float * freq, float * graph)
+static void cleanup (void)
 {
-    for (int i = 0; i < NUM_BANDS; i ++)
-    {
-        /* sum up values in freq array between logscale[i] and logscale[i + 1],
-           including fractional parts */
-        int a = ceilf (logscale[i]);
-        int b = floorf (logscale[i + 1]);
-        float sum = 0;
-
-        if (b < a)
-            sum += freq[b] * (logscale[i + 1] - logscale[i]);
-        else
-        {
-            if (a > 0)
-                sum += freq[a - 1] * (a - logscale[i]);
-            for (; a < b; a ++)
-                sum += freq[a];
-            if (b < 256)
-                sum += freq[b] * (logscale[i + 1] - b);
-        }
-
-        /* fudge factor to make the graph have the same overall height as a
-           12-band one no matter how many bands there are */
-        sum *= (float) NUM_BANDS / 12;
-
-        /* convert to dB */
-        float val = 20 * log10f (sum);
-
-        /* scale (-DB_RANGE, 0.0) to (0.0, 1.0) */
-        val = 1 + val / DB_RANGE;
-
-        graph[i] = CLAMP (val, 0, 1);
-    }
+    vis_bands_cleanup (& s_layout);
 }
 
 static void render_freq (const float * freq)
 {
-    make_log_graph (freq, s_bars[s_pos]);
+    vis_bands_compute (& s_layout, freq, DB_RANGE, s_bars[s_pos]);
     s_pos = (s_pos + 1) % NUM_BANDS;
+    bars_update (s_bars, s_pos);
 
     s_angle += s_anglespeed;
     if (s_angle > 45 || s_angle < -45)
@@ -125,79 +77,12 @@ static void render_freq (const float * freq)
 static void clear (void)
 {
     memset (s_bars, 0, sizeof s_bars);
+    bars_update (s_bars, s_pos);
 
     if (s_widget)
         gtk_widget_queue_draw (s_widget);
 }
 
-static void draw_rectangle (float x1, float y1, float z1, float x2, float y2,
- float z2, float r, float g, float b)
-{
-    glColor3f (r, g, b);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y2, z1);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x2, y2, z2);
-    glVertex3f (x1, y2, z2);
-    glEnd ();
-
-    glColor3f (0.65f * r, 0.65f * g, 0.65f * b);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y1, z1);
-    glVertex3f (x1, y2, z1);
-    glVertex3f (x1, y2, z2);
-    glVertex3f (x1, y1, z2);
-    glEnd ();
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x2, y1, z1);
-    glVertex3f (x2, y1, z2);
-    glVertex3f (x2, y2, z2);
-    glEnd ();
-
-    glColor3f (0.8f * r, 0.8f * g, 0.8f * b);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y1, z1);
-    glVertex3f (x2, y1, z1);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x1, y2, z1);
-    glEnd ();
-}
-
-static void draw_bar (float x, float z, float h, float r, float g, float b)
-{
-    draw_rectangle (x, 0, z, x + BAR_WIDTH, h, z + BAR_WIDTH,
-     r * (0.2f + 0.8f * h), g * (0.2f + 0.8f * h), b * (0.2f + 0.8f * h));
-}
-
-static void draw_bars (void)
-{
-    glPushMatrix ();
-    glTranslatef (0.0f, -0.5f, -5.0f);
-    glRotatef (38.0f, 1.0f, 0.0f, 0.0f);
-    glRotatef (s_angle + 180.0f, 0.0f, 1.0f, 0.0f);
-    glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
-
-    for (int i = 0; i < NUM_BANDS; i ++)
-    {
-        float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
-
-        for (int j = 0; j < NUM_BANDS; j ++)
-        {
-            draw_bar (1.6f - BAR_SPACING * j, z,
-             s_bars[(s_pos + i) % NUM_BANDS][j] * 1.6,
-             colors[i][j][0], colors[i][j][1], colors[i][j][2]);
-        }
-    }
-
-    glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
-    glPopMatrix ();
-}
-
 static bool_t draw_cb (GtkWidget * widget, cairo_t * cr)
 {
     Display * xdisplay = GDK_SCREEN_XDISPLAY (gdk_screen_get_default ());
@@ -226,7 +111,7 @@ static bool_t draw_cb (GtkWidget * widget, cairo_t * cr)
     glClearColor (0, 0, 0, 1);
     glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    draw_bars ();
+    bars_draw (s_angle);
 
     glPopMatrix ();
     glMatrixMode (GL_PROJECTION);
@@ -293,6 +178,7 @@ AUD_VIS_PLUGIN
     .domain = PACKAGE,
     .about_text = about_text,
     .init = init,
+    .cleanup = cleanup,
     .render_freq = render_freq,
     .clear = clear,
     .get_widget = get_widget,
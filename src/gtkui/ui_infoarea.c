@@ -17,7 +17,6 @@
  * the use of this software.
  */
 
-#include <math.h>
 #include <string.h>
 
 #include <gtk/gtk.h>
@@ -28,6 +27,8 @@
 #include <libaudcore/hook.h>
 #include <libaudgui/libaudgui-gtk.h>
 
+#include "../common/art_cache.h"
+#include "../common/vis_bands.h"
 #include "ui_infoarea.h"
 
 #define SPACING 8
@@ -37,8 +38,6 @@
 #define VIS_BANDS 12
 #define VIS_WIDTH (8 * VIS_BANDS - 2)
 #define VIS_CENTER (ICON_SIZE * 5 / 8 + SPACING)
-#define VIS_DELAY 2 /* delay before falloff in frames */
-#define VIS_FALLOFF 2 /* falloff in pixels per frame */
 
 typedef struct {
     GtkWidget * box, * main;
@@ -55,8 +54,8 @@ typedef struct {
 
 static struct {
     GtkWidget * widget;
-    gchar bars[VIS_BANDS];
-    gchar delay[VIS_BANDS];
+    VisBands layout;
+    VisPeaks peaks;
 } vis;
 
 /****************************************************************************/
@@ -65,43 +64,11 @@ static UIInfoArea * area = NULL;
 
 static void vis_render_cb (const gfloat * freq)
 {
-    /* xscale[i] = pow (256, i / VIS_BANDS) - 0.5; */
-    const gfloat xscale[VIS_BANDS + 1] = {0.5, 1.09, 2.02, 3.5, 5.85, 9.58,
-     15.5, 24.9, 39.82, 63.5, 101.09, 160.77, 255.5};
+    gfloat levels[VIS_BANDS];
 
-    for (gint i = 0; i < VIS_BANDS; i ++)
-    {
-        gint a = ceilf (xscale[i]);
-        gint b = floorf (xscale[i + 1]);
-        gfloat n = 0;
-
-        if (b < a)
-            n += freq[b] * (xscale[i + 1] - xscale[i]);
-        else
-        {
-            if (a > 0)
-                n += freq[a - 1] * (a - xscale[i]);
-            for (; a < b; a ++)
-                n += freq[a];
-            if (b < 256)
-                n += freq[b] * (xscale[i + 1] - b);
-        }
-
-        /* 40 dB range */
-        gint x = 40 + 20 * log10f (n);
-        x = CLAMP (x, 0, 40);
-
-        vis.bars[i] -= MAX (0, VIS_FALLOFF - vis.delay[i]);
-
-        if (vis.delay[i])
-            vis.delay[i] --;
-
-        if (x > vis.bars[i])
-        {
-            vis.bars[i] = x;
-            vis.delay[i] = VIS_DELAY;
-        }
-    }
+    /* 40 dB range */
+    vis_bands_compute (& vis.layout, freq, 40, levels);
+    vis_peaks_update (& vis.peaks, levels, 40);
 
     if (vis.widget)
         gtk_widget_queue_draw (vis.widget);
@@ -109,8 +76,7 @@ static void vis_render_cb (const gfloat * freq)
 
 static void vis_clear_cb (void)
 {
-    memset (vis.bars, 0, sizeof vis.bars);
-    memset (vis.delay, 0, sizeof vis.delay);
+    vis_peaks_clear (& vis.peaks);
 
     if (vis.widget)
         gtk_widget_queue_draw (vis.widget);
@@ -265,8 +231,8 @@ static gboolean draw_vis_cb (GtkWidget * widget, cairo_t * cr)
     for (gint i = 0; i < VIS_BANDS; i++)
     {
         gint x = SPACING + 8 * i;
-        gint t = VIS_CENTER - vis.bars[i];
-        gint m = MIN (VIS_CENTER + vis.bars[i], HEIGHT);
+        gint t = VIS_CENTER - vis.peaks.bars[i];
+        gint m = MIN (VIS_CENTER + vis.peaks.bars[i], HEIGHT);
 
         gfloat r, g, b;
         get_color (i, & r, & g, & b);
@@ -406,11 +372,15 @@ static void set_album_art (void)
     if (area->pb)
         g_object_unref (area->pb);
 
-    area->pb = audgui_pixbuf_request_current ();
-    if (! area->pb)
+    bool_t pending;
+    area->pb = art_cache_request_current (ICON_SIZE, & pending);
+
+    if (! area->pb && ! pending)
+    {
         area->pb = audgui_pixbuf_fallback ();
-    if (area->pb)
-        audgui_pixbuf_scale_within (& area->pb, ICON_SIZE);
+        if (area->pb)
+            audgui_pixbuf_scale_within (& area->pb, ICON_SIZE);
+    }
 }
 
 static void album_art_ready (void)
@@ -496,6 +466,9 @@ void ui_infoarea_show_vis (gboolean show)
         g_signal_connect (vis.widget, "draw", (GCallback) draw_vis_cb, NULL);
         gtk_widget_show (vis.widget);
 
+        vis_bands_init (& vis.layout, VIS_BANDS);
+        vis_peaks_init (& vis.peaks, VIS_BANDS);
+
         aud_vis_func_add (AUD_VIS_TYPE_CLEAR, (VisFunc) vis_clear_cb);
         aud_vis_func_add (AUD_VIS_TYPE_FREQ, (VisFunc) vis_render_cb);
     }
@@ -509,6 +482,8 @@ void ui_infoarea_show_vis (gboolean show)
 
         gtk_widget_destroy (vis.widget);
 
+        vis_bands_cleanup (& vis.layout);
+        vis_peaks_cleanup (& vis.peaks);
         memset (& vis, 0, sizeof vis);
     }
 }
@@ -523,6 +498,7 @@ static void destroy_cb (GtkWidget * widget)
     hook_dissociate ("playback begin", (HookFunction) ui_infoarea_playback_start);
     hook_dissociate ("playback stop", (HookFunction) ui_infoarea_playback_stop);
     hook_dissociate ("current art ready", (HookFunction) album_art_ready);
+    art_cache_unwatch ((ArtCacheFunc) album_art_ready, NULL);
 
     if (area->fade_timeout)
     {
@@ -563,6 +539,7 @@ GtkWidget * ui_infoarea_new (void)
     hook_associate ("playback begin", (HookFunction) ui_infoarea_playback_start, NULL);
     hook_associate ("playback stop", (HookFunction) ui_infoarea_playback_stop, NULL);
     hook_associate ("current art ready", (HookFunction) album_art_ready, NULL);
+    art_cache_watch ((ArtCacheFunc) album_art_ready, NULL);
 
     g_signal_connect (area->box, "destroy", (GCallback) destroy_cb, NULL);
 
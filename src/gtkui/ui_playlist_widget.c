@@ -43,28 +43,262 @@ static const gboolean pw_col_widths[PW_COLS] = {7, -1, -1, 4, -1, 2, -1, 3, 7,
 static const gboolean pw_col_label[PW_COLS] = {FALSE, TRUE, TRUE, TRUE, TRUE,
  FALSE, TRUE, FALSE, FALSE, TRUE, TRUE, TRUE, FALSE};
 
+/* The text of the columns that need the entry's tuple is kept in a small
+ * direct-mapped cache, so that redrawing or scrolling doesn't look up the tuple
+ * again for every cell.  Rows are invalidated by ui_playlist_widget_update().
+ *
+ * When the view scrolls, the visible rows and up to PREFETCH_MARGIN rows on
+ * either side are filled in from an idle callback, so that the next scroll
+ * step mostly finds its rows ready.  Rows are only prefetched as far as they
+ * fit in the cache without pushing out visible ones. */
+#define CACHE_ROWS 256
+#define PREFETCH_MARGIN 64
+
+typedef struct {
+    gint row; /* -1 if unused */
+    gint valid; /* bit mask of columns filled in */
+    gchar * text[PW_COLS];
+} CachedRow;
+
 typedef struct {
+    GtkWidget * widget;
     gint list;
     GList * queue;
     gint popup_source, popup_pos;
     gboolean popup_shown;
+    CachedRow cache[CACHE_ROWS];
+    GtkAdjustment * vadj; /* watched for scrolling */
+    gint prefetch_source;
+    GPtrArray * search_keys; /* lower-cased "title\nartist\nalbum", per row */
+    gchar * search_text; /* the last search string ... */
+    gchar * * search_words; /* ... and its lower-cased, non-blank words */
 } PlaylistWidgetData;
 
-static void set_int_from_tuple (GValue * value, const Tuple * tuple, gint field)
+static gchar * int_from_tuple (const Tuple * tuple, gint field)
 {
     gint i = tuple ? tuple_get_int (tuple, field, NULL) : 0;
-    if (i > 0)
-        g_value_take_string (value, g_strdup_printf ("%d", i));
-    else
-        g_value_set_string (value, "");
+    return (i > 0) ? g_strdup_printf ("%d", i) : g_strdup ("");
+}
+
+static gchar * string_from_tuple (const Tuple * tuple, gint field)
+{
+    gchar * str = tuple ? tuple_get_str (tuple, field, NULL) : NULL;
+    gchar * copy = g_strdup (str);
+    str_unref (str);
+    return copy;
+}
+
+static gboolean col_needs_describe (gint column)
+{
+    return (column == PW_COL_TITLE || column == PW_COL_ARTIST || column ==
+     PW_COL_ALBUM);
+}
+
+static gboolean col_needs_tuple (gint column)
+{
+    return (column == PW_COL_YEAR || column == PW_COL_TRACK || column ==
+     PW_COL_GENRE || column == PW_COL_FILENAME || column == PW_COL_PATH ||
+     column == PW_COL_BITRATE);
+}
+
+static gboolean col_is_cached (gint column)
+{
+    return (col_needs_describe (column) || col_needs_tuple (column) || column
+     == PW_COL_CUSTOM);
+}
+
+static void cache_clear_row (CachedRow * c)
+{
+    for (gint i = 0; i < PW_COLS; i ++)
+    {
+        g_free (c->text[i]);
+        c->text[i] = NULL;
+    }
+
+    c->row = -1;
+    c->valid = 0;
 }
 
-static void set_string_from_tuple (GValue * value, const Tuple * tuple,
- gint field)
+/* forgets rows from <at> onward, or only <count> of them if count >= 0 */
+static void cache_invalidate (PlaylistWidgetData * data, gint at, gint count)
 {
-    gchar *str = tuple ? tuple_get_str (tuple, field, NULL) : NULL;
-    g_value_set_string (value, str);
-    str_unref(str);
+    for (gint i = 0; i < CACHE_ROWS; i ++)
+    {
+        CachedRow * c = & data->cache[i];
+        if (c->row >= at && (count < 0 || c->row < at + count))
+            cache_clear_row (c);
+    }
+}
+
+/* Fills in <column> and all the other cached columns that are shown, so that
+ * the rest of the row is already there when GTK asks for it.  The tuple is
+ * fetched at most once per row. */
+static void cache_fill_row (PlaylistWidgetData * data, CachedRow * c, gint row,
+ gint column)
+{
+    gchar * title = NULL, * artist = NULL, * album = NULL;
+    Tuple * tuple = NULL;
+    gboolean need_describe = FALSE, need_tuple = FALSE;
+
+    for (gint i = -1; i < pw_num_cols; i ++)
+    {
+        gint col = (i < 0) ? column : pw_cols[i];
+        if (c->valid & (1 << col))
+            continue;
+
+        need_describe |= col_needs_describe (col);
+        need_tuple |= col_needs_tuple (col);
+    }
+
+    if (need_describe)
+        aud_playlist_entry_describe (data->list, row, & title, & artist,
+         & album, TRUE);
+    if (need_tuple)
+        tuple = aud_playlist_entry_get_tuple (data->list, row, TRUE);
+
+    for (gint i = -1; i < pw_num_cols; i ++)
+    {
+        gint col = (i < 0) ? column : pw_cols[i];
+        if ((c->valid & (1 << col)) || ! col_is_cached (col))
+            continue;
+
+        gchar * text = NULL;
+
+        switch (col)
+        {
+        case PW_COL_TITLE:
+            text = g_strdup (title);
+            break;
+        case PW_COL_ARTIST:
+            text = g_strdup (artist);
+            break;
+        case PW_COL_YEAR:
+            text = int_from_tuple (tuple, FIELD_YEAR);
+            break;
+        case PW_COL_ALBUM:
+            text = g_strdup (album);
+            break;
+        case PW_COL_TRACK:
+            text = int_from_tuple (tuple, FIELD_TRACK_NUMBER);
+            break;
+        case PW_COL_GENRE:
+            text = string_from_tuple (tuple, FIELD_GENRE);
+            break;
+        case PW_COL_FILENAME:
+            text = string_from_tuple (tuple, FIELD_FILE_NAME);
+            break;
+        case PW_COL_PATH:
+            text = string_from_tuple (tuple, FIELD_FILE_PATH);
+            break;
+        case PW_COL_CUSTOM:;
+            gchar * custom = aud_playlist_entry_get_title (data->list, row, TRUE);
+            text = g_strdup (custom);
+            str_unref (custom);
+            break;
+        case PW_COL_BITRATE:
+            text = int_from_tuple (tuple, FIELD_BITRATE);
+            break;
+        }
+
+        c->text[col] = text;
+        c->valid |= 1 << col;
+    }
+
+    str_unref (title);
+    str_unref (artist);
+    str_unref (album);
+    if (tuple)
+        tuple_unref (tuple);
+}
+
+static const gchar * cache_get (PlaylistWidgetData * data, gint row,
+ gint column)
+{
+    CachedRow * c = & data->cache[row % CACHE_ROWS];
+
+    if (c->row != row)
+    {
+        cache_clear_row (c);
+        c->row = row;
+    }
+
+    if (! (c->valid & (1 << column)))
+        cache_fill_row (data, c, row, column);
+
+    return c->text[column];
+}
+
+static gboolean prefetch_cb (PlaylistWidgetData * data)
+{
+    data->prefetch_source = 0;
+
+    /* a row is filled in by asking for any one of its cached columns */
+    gint column = -1;
+    for (gint i = 0; i < pw_num_cols && column < 0; i ++)
+    {
+        if (col_is_cached (pw_cols[i]))
+            column = pw_cols[i];
+    }
+
+    GtkTreePath * start, * end;
+    if (column < 0 || ! gtk_tree_view_get_visible_range ((GtkTreeView *)
+     data->widget, & start, & end))
+        return FALSE;
+
+    gint top = gtk_tree_path_get_indices (start)[0];
+    gint bottom = gtk_tree_path_get_indices (end)[0];
+    gtk_tree_path_free (start);
+    gtk_tree_path_free (end);
+
+    gint margin = CLAMP ((CACHE_ROWS - (bottom - top + 1)) / 2, 0,
+     PREFETCH_MARGIN);
+    gint entries = aud_playlist_entry_count (data->list);
+
+    top = MAX (top - margin, 0);
+    bottom = MIN (bottom + margin, entries - 1);
+
+    for (gint row = top; row <= bottom; row ++)
+        cache_get (data, row, column);
+
+    return FALSE;
+}
+
+static void prefetch_trigger (PlaylistWidgetData * data)
+{
+    /* after GTK has redrawn the rows it needs right away */
+    if (! data->prefetch_source)
+        data->prefetch_source = g_idle_add_full (G_PRIORITY_LOW, (GSourceFunc)
+         prefetch_cb, data, NULL);
+}
+
+static void prefetch_watch (PlaylistWidgetData * data, GtkAdjustment * vadj)
+{
+    if (data->vadj)
+    {
+        g_signal_handlers_disconnect_by_func (data->vadj, (GCallback)
+         prefetch_trigger, data);
+        g_object_unref (data->vadj);
+    }
+
+    data->vadj = vadj;
+
+    if (vadj)
+    {
+        g_object_ref (vadj);
+        g_signal_connect_swapped (vadj, "value-changed", (GCallback)
+         prefetch_trigger, data);
+        g_signal_connect_swapped (vadj, "changed", (GCallback)
+         prefetch_trigger, data);
+    }
+}
+
+/* the adjustment is set when the list is put into a scrolled window */
+static void vadj_notify_cb (GtkWidget * widget, GParamSpec * pspec,
+ PlaylistWidgetData * data)
+{
+    prefetch_watch (data, gtk_scrollable_get_vadjustment ((GtkScrollable *)
+     widget));
+    prefetch_trigger (data);
 }
 
 static void set_queued (GValue * value, gint list, gint row)
@@ -105,68 +339,21 @@ static void get_value (void * user, gint row, gint column, GValue * value)
 
     column = pw_cols[column];
 
-    gchar * title = NULL, * artist = NULL, * album = NULL;
-    Tuple * tuple = NULL;
-
-    if (column == PW_COL_TITLE || column == PW_COL_ARTIST || column ==
-     PW_COL_ALBUM)
-        aud_playlist_entry_describe (data->list, row, & title, & artist,
-         & album, TRUE);
-    else if (column == PW_COL_YEAR || column == PW_COL_TRACK || column ==
-     PW_COL_GENRE || column == PW_COL_FILENAME || column == PW_COL_PATH ||
-     column == PW_COL_BITRATE)
-        tuple = aud_playlist_entry_get_tuple (data->list, row, TRUE);
-
     switch (column)
     {
     case PW_COL_NUMBER:
         g_value_set_int (value, 1 + row);
         break;
-    case PW_COL_TITLE:
-        g_value_set_string (value, title);
-        break;
-    case PW_COL_ARTIST:
-        g_value_set_string (value, artist);
-        break;
-    case PW_COL_YEAR:
-        set_int_from_tuple (value, tuple, FIELD_YEAR);
-        break;
-    case PW_COL_ALBUM:
-        g_value_set_string (value, album);
-        break;
-    case PW_COL_TRACK:
-        set_int_from_tuple (value, tuple, FIELD_TRACK_NUMBER);
-        break;
-    case PW_COL_GENRE:
-        set_string_from_tuple (value, tuple, FIELD_GENRE);
-        break;
     case PW_COL_QUEUED:
         set_queued (value, data->list, row);
         break;
     case PW_COL_LENGTH:
         set_length (value, data->list, row);
         break;
-    case PW_COL_FILENAME:
-        set_string_from_tuple (value, tuple, FIELD_FILE_NAME);
-        break;
-    case PW_COL_PATH:
-        set_string_from_tuple (value, tuple, FIELD_FILE_PATH);
-        break;
-    case PW_COL_CUSTOM:;
-        gchar * custom = aud_playlist_entry_get_title (data->list, row, TRUE);
-        g_value_set_string (value, custom);
-        str_unref (custom);
-        break;
-    case PW_COL_BITRATE:
-        set_int_from_tuple (value, tuple, FIELD_BITRATE);
+    default:
+        g_value_set_string (value, cache_get (data, row, column));
         break;
     }
-
-    str_unref (title);
-    str_unref (artist);
-    str_unref (album);
-    if (tuple)
-        tuple_unref (tuple);
 }
 
 static gboolean get_selected (void * user, gint row)
@@ -305,61 +492,130 @@ static const AudguiListCallbacks callbacks = {
  .get_data = get_data,
  .receive_data = receive_data};
 
+/* The search keys are built the first time a row is searched and kept until
+ * the row changes, so that searching again doesn't need to look at the
+ * playlist at all.  The array always has one element per row. */
+static void search_keys_reset (PlaylistWidgetData * data)
+{
+    if (data->search_keys)
+        g_ptr_array_free (data->search_keys, TRUE);
+
+    data->search_keys = g_ptr_array_new_with_free_func (g_free);
+    g_ptr_array_set_size (data->search_keys, aud_playlist_entry_count
+     (data->list));
+}
+
+static void search_keys_clear (PlaylistWidgetData * data, gint at, gint count)
+{
+    for (gint i = at; i < at + count; i ++)
+    {
+        g_free (g_ptr_array_index (data->search_keys, i));
+        g_ptr_array_index (data->search_keys, i) = NULL;
+    }
+}
+
+static void search_keys_insert (PlaylistWidgetData * data, gint at, gint count)
+{
+    GPtrArray * keys = data->search_keys;
+    gint old_len = keys->len;
+
+    /* g_ptr_array_set_size() fills the new elements with NULL */
+    g_ptr_array_set_size (keys, old_len + count);
+    memmove (keys->pdata + at + count, keys->pdata + at, sizeof (void *) *
+     (old_len - at));
+    memset (keys->pdata + at, 0, sizeof (void *) * count);
+}
+
+static const gchar * search_key (PlaylistWidgetData * data, gint row)
+{
+    gchar * key = g_ptr_array_index (data->search_keys, row);
+    if (key)
+        return key;
+
+    gchar * s[3] = {NULL, NULL, NULL};
+    aud_playlist_entry_describe (data->list, row, & s[0], & s[1], & s[2],
+     FALSE);
+
+    gchar * temp = g_strjoin ("\n", s[0] ? s[0] : "", s[1] ? s[1] : "",
+     s[2] ? s[2] : "", NULL);
+    key = g_utf8_strdown (temp, -1);
+    g_free (temp);
+
+    for (gint i = 0; i < G_N_ELEMENTS (s); i ++)
+        str_unref (s[i]);
+
+    g_ptr_array_index (data->search_keys, row) = key;
+    return key;
+}
+
+/* splits the search string into words, but only when it has changed */
+static gchar * * search_words (PlaylistWidgetData * data, const gchar * text)
+{
+    if (data->search_text && ! strcmp (data->search_text, text))
+        return data->search_words;
+
+    g_free (data->search_text);
+    g_strfreev (data->search_words);
+
+    data->search_text = g_strdup (text);
+
+    gchar * temp = g_utf8_strdown (text, -1);
+    gchar * * words = g_strsplit (temp, " ", 0);
+    g_free (temp);
+
+    /* drop the blank words left by repeated spaces */
+    gint n = 0;
+    for (gint j = 0; words[j]; j ++)
+    {
+        if (words[j][0])
+            words[n ++] = words[j];
+        else
+            g_free (words[j]);
+    }
+    words[n] = NULL;
+
+    data->search_words = words;
+    return words;
+}
+
 static gboolean search_cb (GtkTreeModel * model, gint column, const gchar * key,
  GtkTreeIter * iter, void * user)
 {
+    PlaylistWidgetData * data = user;
+
     GtkTreePath * path = gtk_tree_model_get_path (model, iter);
     g_return_val_if_fail (path, TRUE);
     gint row = gtk_tree_path_get_indices (path)[0];
-    g_return_val_if_fail (row >= 0, TRUE);
-    gchar * s[3] = {NULL, NULL, NULL};
-    aud_playlist_entry_describe (((PlaylistWidgetData *) user)->list, row,
-     & s[0], & s[1], & s[2], FALSE);
     gtk_tree_path_free (path);
+    g_return_val_if_fail (row >= 0 && row < data->search_keys->len, TRUE);
 
-    gchar * temp = g_utf8_strdown (key, -1);
-    gchar * * keys = g_strsplit (temp, " ", 0);
-    g_free (temp);
+    gchar * * words = search_words (data, key);
+    if (! words[0])
+        return TRUE; /* force non-match if there are no non-blank words */
 
-    gint remain = 0; /* number of keys remaining to be matched */
-    for (gint j = 0; keys[j]; j ++)
-    {
-        if (keys[j][0])
-            remain ++;
-    }
-    if (! remain)
-        remain ++; /* force non-match if there are no non-blank keys */
+    /* the fields are separated by newlines, which can't be part of a word, so
+     * a word is never matched across two fields */
+    const gchar * text = search_key (data, row);
 
-    for (gint i = 0; i < G_N_ELEMENTS (s); i ++)
+    for (gint j = 0; words[j]; j ++)
     {
-        if (! s[i])
-            continue;
-
-        if (remain)
-        {
-            temp = g_utf8_strdown (s[i], -1);
-
-            for (gint j = 0; keys[j] && remain; j ++)
-            {
-                if (keys[j][0] && strstr (temp, keys[j]))
-                {
-                    keys[j][0] = 0; /* don't look for this one again */
-                    remain --;
-                }
-            }
-
-            g_free (temp);
-        }
-
-        str_unref (s[i]);
+        if (! strstr (text, words[j]))
+            return TRUE; /* TRUE == not matched */
     }
 
-    g_strfreev (keys);
-    return remain ? TRUE : FALSE; /* TRUE == not matched, FALSE == matched */
+    return FALSE; /* FALSE == matched */
 }
 
 static void destroy_cb (PlaylistWidgetData * data)
 {
+    if (data->prefetch_source)
+        g_source_remove (data->prefetch_source);
+
+    prefetch_watch (data, NULL);
+    cache_invalidate (data, 0, -1);
+    g_ptr_array_free (data->search_keys, TRUE);
+    g_free (data->search_text);
+    g_strfreev (data->search_words);
     g_list_free (data->queue);
     g_free (data);
 }
@@ -373,6 +629,11 @@ GtkWidget * ui_playlist_widget_new (gint playlist)
     data->popup_pos = -1;
     data->popup_shown = FALSE;
 
+    for (gint i = 0; i < CACHE_ROWS; i ++)
+        data->cache[i].row = -1;
+
+    search_keys_reset (data);
+
     GtkWidget * list = audgui_list_new (& callbacks, data,
      aud_playlist_entry_count (playlist));
 
@@ -381,6 +642,10 @@ GtkWidget * ui_playlist_widget_new (gint playlist)
     gtk_tree_view_set_search_equal_func ((GtkTreeView *) list, search_cb, data,
      NULL);
     g_signal_connect_swapped (list, "destroy", (GCallback) destroy_cb, data);
+    g_signal_connect (list, "notify::vadjustment", (GCallback) vadj_notify_cb,
+     data);
+
+    data->widget = list;
 
     /* Disable type-to-search because it blocks CTRL-V, causing URI's to be
      * pasted into the search box rather than added to the playlist.  The search
@@ -409,6 +674,9 @@ void ui_playlist_widget_set_playlist (GtkWidget * widget, gint list)
     PlaylistWidgetData * data = audgui_list_get_user (widget);
     g_return_if_fail (data);
     data->list = list;
+    cache_invalidate (data, 0, -1);
+    search_keys_reset (data);
+    prefetch_trigger (data);
 }
 
 static void update_queue (GtkWidget * widget, PlaylistWidgetData * data)
@@ -435,10 +703,23 @@ void ui_playlist_widget_update (GtkWidget * widget, gint type, gint at,
 
     if (type == PLAYLIST_UPDATE_STRUCTURE)
     {
+        /* everything from <at> onward may have moved */
+        cache_invalidate (data, at, -1);
+        prefetch_trigger (data);
+
         gint old_entries = audgui_list_row_count (widget);
         gint entries = aud_playlist_entry_count (data->list);
+        gint removed = old_entries - (entries - count);
+
+        if (data->search_keys->len == old_entries)
+        {
+            g_ptr_array_remove_range (data->search_keys, at, removed);
+            search_keys_insert (data, at, count);
+        }
+        else
+            search_keys_reset (data);
 
-        audgui_list_delete_rows (widget, at, old_entries - (entries - count));
+        audgui_list_delete_rows (widget, at, removed);
         audgui_list_insert_rows (widget, at, count);
 
         /* scroll to end of playlist if entries were added there
@@ -450,7 +731,11 @@ void ui_playlist_widget_update (GtkWidget * widget, gint type, gint at,
         ui_playlist_widget_scroll (widget);
     }
     else if (type == PLAYLIST_UPDATE_METADATA)
+    {
+        cache_invalidate (data, at, count);
+        search_keys_clear (data, at, count);
         audgui_list_update_rows (widget, at, count);
+    }
 
     audgui_list_update_selection (widget, at, count);
     audgui_list_set_focus (widget, aud_playlist_get_focus (data->list));
@@ -33,6 +33,7 @@
 #include <sys/time.h>
 #include <samplerate.h>
 
+#include "../common/sample_convert.h"
 #include "bio2jack.h"
 
 /* enable/disable TRACING through the JACK_Callback() function */
@@ -148,8 +149,10 @@ typedef struct jack_driver_s
 
   unsigned long rw_buffer1_size;        /* number of bytes in the buffer allocated for processing data in JACK_(Read|Write) */
   char *rw_buffer1;
+  unsigned long rw_buffer2_size;        /* number of bytes in the buffer JACK_Write() resamples into */
+  char *rw_buffer2;
 
-  struct timeval previousTime;  /* time of last JACK_Callback() write to jack, allows for MS accurate bytes played  */
+  double client_frames_remainder;       /* fraction of a client frame left over from the last JACK_Callback(), when resampling */
 
   unsigned long written_client_bytes;   /* input bytes we wrote to jack, not necessarily actual bytes we wrote to jack due to channel and other conversion */
   unsigned long played_client_bytes;    /* input bytes that jack has played */
@@ -176,6 +179,8 @@ typedef struct jack_driver_s
   enum status_enum state;       /* one of PLAYING, PAUSED, STOPPED, CLOSED, RESET etc */
 
   unsigned int volume[MAX_OUTPUT_PORTS];        /* percentage of sample value to preserve, 100 would be no attenuation */
+  float gain[MAX_OUTPUT_PORTS];         /* volume[] converted to a multiplier, set outside of JACK_Callback() */
+  float callback_gain[MAX_OUTPUT_PORTS];        /* gain JACK_Callback() last applied, it ramps from this to gain[] */
   enum JACK_VOLUME_TYPE volumeEffectType;       /* linear or dbAttenuation, if dbAttenuation volume is the number of dBs of
                                                    attenuation to apply, 0 volume being no attenuation, full volume */
 
@@ -184,6 +189,9 @@ typedef struct jack_driver_s
 
   bool in_use;                  /* true if this device is currently in use */
 
+  unsigned long xrun_count;     /* number of xruns jack has reported since the device was opened */
+  unsigned long max_callback_usecs;     /* longest time spent in JACK_Callback() since the device was opened */
+
   pthread_mutex_t mutex;        /* mutex to lock this specific device */
 
   /* variables used for trying to restart the connection to jack */
@@ -378,20 +386,15 @@ DEBUGSTATE(enum status_enum state)
 
 /* floating point volume routine */
 /* volume should be a value between 0.0 and 1.0 */
-static void
-float_volume_effect(sample_t * buf, unsigned long nsamples, float volume,
-                    int skip)
+static float
+clip_volume(float volume)
 {
   if(volume < 0)
     volume = 0;
   if(volume > 1.0)
     volume = 1.0;
 
-  while(nsamples--)
-  {
-    *buf = (*buf) * volume;
-    buf += skip;
-  }
+  return volume;
 }
 
 /* place one channel into a multi-channel stream */
@@ -408,18 +411,73 @@ mux(sample_t * dst, sample_t * src, unsigned long nsamples,
   }
 }
 
-/* pull one channel out of a multi-channel stream */
+/* pull nframes of interleaved samples out of the playback ringbuffer and
+   into the per-port buffers, without copying them anywhere in between.
+   the ringbuffer size is a power of two so a sample is never split across
+   the wrap, but a frame may be, so we keep track of the channel as we go */
 static void
-demux(sample_t * dst, sample_t * src, unsigned long nsamples,
-      unsigned long src_skip)
+demux_ringbuffer(jack_driver_t * drv, sample_t ** out, unsigned long nframes)
 {
-  /* ALERT: signed sign-extension portability !!! */
-  while(nsamples--)
+  jack_ringbuffer_data_t vec[2];
+  unsigned long nsamples = nframes * drv->num_output_channels;
+  unsigned long chan = 0, frame = 0;
+  int v;
+
+  jack_ringbuffer_get_read_vector(drv->pPlayPtr, vec);
+
+  for(v = 0; v < 2 && nsamples; v++)
   {
-    *dst = *src;
-    dst++;
-    src += src_skip;
+    sample_t *src = (sample_t *) vec[v].buf;
+    unsigned long n = min(vec[v].len / sizeof(sample_t), nsamples);
+
+    nsamples -= n;
+
+    if(drv->num_output_channels == 1)
+    {
+      memcpy(out[0] + frame, src, n * sizeof(sample_t));
+      frame += n;
+      continue;
+    }
+
+    while(n--)
+    {
+      out[chan][frame] = *src++;
+      if(++chan == drv->num_output_channels)
+      {
+        chan = 0;
+        frame++;
+      }
+    }
+  }
+
+  jack_ringbuffer_read_advance(drv->pPlayPtr,
+                               nframes * drv->bytes_per_jack_output_frame);
+}
+
+/* scale one port's buffer, ramping linearly from the gain we used last
+   time to the current one so that volume changes don't click */
+static void
+gain_ramp(sample_t * buf, unsigned long nframes, float *current, float target)
+{
+  unsigned long i;
+
+  if(*current == target)
+  {
+    if(target != 1.0f)
+      sample_gain(buf, 1, nframes, &target);
+    return;
   }
+
+  float step = (target - *current) / nframes;
+  float gain = *current;
+
+  for(i = 0; i < nframes; i++)
+  {
+    gain += step;
+    buf[i] *= gain;
+  }
+
+  *current = target;
 }
 
 /* copy floating point samples */
@@ -444,19 +502,14 @@ sample_move_int32_float(sample_t * dst, int32_t * src, unsigned long nsamples)
 static inline void
 sample_move_int24_float(sample_t * dst, int32_t * src, unsigned long nsamples)
 {
-  unsigned long i;
-  for(i = 0; i < nsamples; i++)
-    dst[i] = (sample_t) (src[i]) / SAMPLE_MAX_24BIT;
+  sample_from_s24(src, dst, nsamples);
 }
 
 /* convert from 16 bit to floating point */
 static inline void
 sample_move_short_float(sample_t * dst, short *src, unsigned long nsamples)
 {
-  /* ALERT: signed sign-extension portability !!! */
-  unsigned long i;
-  for(i = 0; i < nsamples; i++)
-    dst[i] = (sample_t) (src[i]) / SAMPLE_MAX_16BIT;
+  sample_from_s16(src, dst, nsamples);
 }
 
 /* convert from floating point to 16 bit */
@@ -534,16 +587,13 @@ JACK_callback(nframes_t nframes, void *arg)
 
   unsigned int i;
   int src_error = 0;
+  jack_time_t start_time = jack_get_time();
 
   TIMER("start\n");
-  gettimeofday(&drv->previousTime, 0);  /* record the current time */
 
   CALLBACK_TRACE("nframes %ld, sizeof(sample_t) == %d\n", (long) nframes,
                  sizeof(sample_t));
 
-  if(!drv->client)
-    ERR("client is closed, this is weird...\n");
-
   sample_t *out_buffer[MAX_OUTPUT_PORTS];
   /* retrieve the buffers for the output ports */
   for(i = 0; i < drv->num_output_channels; i++)
@@ -558,20 +608,17 @@ JACK_callback(nframes_t nframes, void *arg)
   if(drv->state == PLAYING)
   {
     /* handle playback data, if any */
+    /* NOTE: JACK_Write() has already done any sample rate conversion, so */
+    /* all we do here is copy the frames out to the ports and apply the gain */
     if(drv->num_output_channels > 0)
     {
-      unsigned long jackFramesAvailable = nframes;      /* frames we have left to write to jack */
-      unsigned long numFramesToWrite;   /* num frames we are writing */
-      size_t inputBytesAvailable = jack_ringbuffer_read_space(drv->pPlayPtr);
-      unsigned long inputFramesAvailable;       /* frames we have available */
-
-      inputFramesAvailable = inputBytesAvailable / drv->bytes_per_jack_output_frame;
-      size_t jackBytesAvailable = jackFramesAvailable * drv->bytes_per_jack_output_frame;
+      unsigned long inputFramesAvailable =
+        jack_ringbuffer_read_space(drv->pPlayPtr) / drv->bytes_per_jack_output_frame;
+      unsigned long numFramesToWrite = min(nframes, inputFramesAvailable);
+      long read;
 
-      long read = 0;
-
-      CALLBACK_TRACE("playing... jackFramesAvailable = %ld inputFramesAvailable = %ld\n",
-         jackFramesAvailable, inputFramesAvailable);
+      CALLBACK_TRACE("playing... nframes = %ld inputFramesAvailable = %ld\n",
+         (long) nframes, inputFramesAvailable);
 
 #if JACK_CLOSE_HACK
       if(drv->in_use == FALSE)
@@ -584,146 +631,41 @@ JACK_callback(nframes_t nframes, void *arg)
       }
 #endif
 
-      /* make sure our buffer is large enough for the data we are writing */
-      /* ie. callback_buffer2_size < (bytes we already wrote + bytes we are going to write in this loop) */
-      if(!ensure_buffer_size
-         (&drv->callback_buffer2, &drv->callback_buffer2_size,
-          jackBytesAvailable))
+      if(numFramesToWrite)
+        demux_ringbuffer(drv, out_buffer, numFramesToWrite);
+
+      /* see if we still have frames left here, if we do that means that we
+         ran out of wave data to play and had a buffer underrun, fill in
+         the rest of the space with zero bytes so at least there is silence */
+      if(numFramesToWrite < nframes)
       {
-        ERR("allocated %lu bytes, need %lu bytes\n",
-            drv->callback_buffer2_size, (unsigned long)jackBytesAvailable);
-        return -1;
+        for(i = 0; i < drv->num_output_channels; i++)
+          sample_silence_float(out_buffer[i] + numFramesToWrite,
+                               nframes - numFramesToWrite);
       }
 
-      /* do sample rate conversion if needed & requested */
+      for(i = 0; i < drv->num_output_channels; i++)
+        gain_ramp(out_buffer[i], numFramesToWrite, &drv->callback_gain[i],
+                  drv->gain[i]);
+
+      /* work out how many of the client's bytes those frames were */
       if(drv->output_src && drv->output_sample_rate_ratio != 1.0)
       {
-        long bytes_needed_write = nframes * drv->bytes_per_jack_output_frame;
-
-        /* make a very good guess at how many raw bytes we'll need to satisfy jack's request after conversion */
-        long bytes_needed_read = min(inputBytesAvailable,
-                                     (double) (bytes_needed_write +
-                                               drv->
-                                               output_sample_rate_ratio
-                                               *
-                                               drv->
-                                               bytes_per_jack_output_frame)
-                                     / drv->output_sample_rate_ratio);
-        DEBUG("guessing that we need %ld bytes in and %ld out for rate conversion ratio = %f\n",
-           bytes_needed_read, bytes_needed_write,
-           drv->output_sample_rate_ratio);
-
-        if(!ensure_buffer_size(&drv->callback_buffer1,
-                               &drv->callback_buffer1_size,
-                               bytes_needed_read))
-        {
-          ERR("could not realloc callback_buffer2!\n");
-          return 1;
-        }
-        if(!ensure_buffer_size(&drv->callback_buffer2,
-                               &drv->callback_buffer2_size,
-                               bytes_needed_write))
-        {
-          ERR("could not realloc callback_buffer2!\n");
-          return 1;
-        }
+        double client_frames = numFramesToWrite / drv->output_sample_rate_ratio +
+          drv->client_frames_remainder;
+        long whole = (long) client_frames;
 
-        if(jackFramesAvailable && inputBytesAvailable > 0)
-        {
-          /* read in the data, but don't move the read pointer until we know how much SRC used */
-          jack_ringbuffer_peek(drv->pPlayPtr, drv->callback_buffer1,
-                               bytes_needed_read);
-
-          SRC_DATA srcdata;
-          srcdata.data_in = (sample_t *) drv->callback_buffer1;
-          srcdata.input_frames = bytes_needed_read / drv->bytes_per_jack_output_frame;
-          srcdata.src_ratio = drv->output_sample_rate_ratio;
-          srcdata.data_out = (sample_t *) drv->callback_buffer2;
-          srcdata.output_frames = nframes;
-          srcdata.end_of_input = 0;     // it's a stream, it never ends
-          DEBUG("input_frames = %ld, output_frames = %ld\n",
-                srcdata.input_frames, srcdata.output_frames);
-          /* convert the sample rate */
-          src_error = src_process(drv->output_src, &srcdata);
-          DEBUG("used = %ld, generated = %ld, error = %d: %s.\n",
-                srcdata.input_frames_used, srcdata.output_frames_gen,
-                src_error, src_strerror(src_error));
-
-          if(src_error == 0)
-          {
-            /* now we can move the read pointer */
-            jack_ringbuffer_read_advance(drv->pPlayPtr,
-                                         srcdata.
-                                         input_frames_used *
-                                         drv->bytes_per_jack_output_frame);
-            /* add on what we wrote */
-            read = srcdata.input_frames_used * drv->bytes_per_output_frame;
-            jackFramesAvailable -= srcdata.output_frames_gen;   /* take away what was used */
-          }
-        }
+        drv->client_frames_remainder = client_frames - whole;
+        read = whole * drv->bytes_per_output_frame;
       }
-      else                      /* no resampling needed or requested */
+      else
       {
-        /* read as much data from the buffer as is available */
-        if(jackFramesAvailable && inputBytesAvailable > 0)
-        {
-          /* write as many bytes as we have space remaining, or as much as we have data to write */
-          numFramesToWrite = min(jackFramesAvailable, inputFramesAvailable);
-          jack_ringbuffer_read(drv->pPlayPtr, drv->callback_buffer2,
-                               jackBytesAvailable);
-          /* add on what we wrote */
-          read = numFramesToWrite * drv->bytes_per_output_frame;
-          jackFramesAvailable -= numFramesToWrite;      /* take away what was written */
-        }
+        read = numFramesToWrite * drv->bytes_per_output_frame;
       }
 
       drv->written_client_bytes += read;
       drv->played_client_bytes += drv->clientBytesInJack;       /* move forward by the previous bytes we wrote since those must have finished by now */
       drv->clientBytesInJack = read;    /* record the input bytes we wrote to jack */
-
-      /* see if we still have jackBytesLeft here, if we do that means that we
-         ran out of wave data to play and had a buffer underrun, fill in
-         the rest of the space with zero bytes so at least there is silence */
-      if(jackFramesAvailable)
-      {
-        WARN("buffer underrun of %ld frames\n", jackFramesAvailable);
-        for(i = 0; i < drv->num_output_channels; i++)
-          sample_silence_float(out_buffer[i] +
-                               (nframes - jackFramesAvailable),
-                               jackFramesAvailable);
-      }
-
-      /* if we aren't converting or we are converting and src_error == 0 then we should */
-      /* apply volume and demux */
-      if(!(drv->output_src && drv->output_sample_rate_ratio != 1.0) || (src_error == 0))
-      {
-          /* apply volume */
-          for(i = 0; i < drv->num_output_channels; i++)
-          {
-              if(drv->volumeEffectType == dbAttenuation)
-              {
-                  /* assume the volume setting is dB of attenuation, a volume of 0 */
-                  /* is 0dB attenuation */
-                  float volume = powf(10.0, -((float) drv->volume[i]) / 20.0);
-                  float_volume_effect((sample_t *) drv->callback_buffer2 + i,
-                                      (nframes - jackFramesAvailable), volume, drv->num_output_channels);
-              } else
-              {
-                  float_volume_effect((sample_t *) drv->callback_buffer2 + i, (nframes - jackFramesAvailable),
-                                      ((float) drv->volume[i] / 100.0),
-                                      drv->num_output_channels);
-              }
-          }
-
-          /* demux the stream: we skip over the number of samples we have output channels as the channel data */
-          /* is encoded like chan1,chan2,chan3,chan1,chan2,chan3... */
-          for(i = 0; i < drv->num_output_channels; i++)
-          {
-              demux(out_buffer[i],
-                    (sample_t *) drv->callback_buffer2 + i,
-                    (nframes - jackFramesAvailable), drv->num_output_channels);
-          }
-      }
     }
 
     /* handle record data, if any */
@@ -862,6 +804,7 @@ JACK_callback(nframes_t nframes, void *arg)
       drv->client_bytes = 0;    /* bytes that the client wrote to use */
 
       drv->clientBytesInJack = 0;       /* number of input bytes in jack(not necessary the number of bytes written to jack) */
+      drv->client_frames_remainder = 0;
 
       drv->position_byte_offset = 0;
 
@@ -875,12 +818,31 @@ JACK_callback(nframes_t nframes, void *arg)
     }
   }
 
+  /* jack_get_time() is safe to call from the process thread, unlike */
+  /* gettimeofday() on some systems */
+  unsigned long elapsed = (unsigned long) (jack_get_time() - start_time);
+  if(elapsed > drv->max_callback_usecs)
+    drv->max_callback_usecs = elapsed;
+
   CALLBACK_TRACE("done\n");
   TIMER("finish\n");
 
   return 0;
 }
 
+/******************************************************************
+ *             JACK_xrun
+ *
+ * called by the jack server whenever it detects an xrun
+ */
+static int
+JACK_xrun(void *arg)
+{
+  jack_driver_t *drv = (jack_driver_t *) arg;
+  drv->xrun_count++;
+  return 0;
+}
+
 
 /******************************************************************
  *             JACK_bufsize
@@ -1033,6 +995,9 @@ JACK_OpenDevice(jack_driver_t * drv)
   /* setup a buffer size callback */
   jack_set_buffer_size_callback(drv->client, JACK_bufsize, drv);
 
+  /* count xruns so that clients can find out about them */
+  jack_set_xrun_callback(drv->client, JACK_xrun, drv);
+
   /* tell the JACK server to call `srate()' whenever
      the sample rate of the system changes. */
   jack_set_sample_rate_callback(drv->client, JACK_srate, drv);
@@ -1434,6 +1399,10 @@ JACK_ResetFromDriver(jack_driver_t * drv)
   /* variables that the callback modifies while the callback is running */
   /* we set the state to RESET and the callback clears the variables out for us */
   drv->state = RESET;           /* tell the callback that we are to reset, the callback will transition this to STOPPED */
+
+  /* the output SRC object belongs to JACK_Write(), so we clear it here */
+  if(drv->output_src)
+    src_reset(drv->output_src);
 }
 
 /* Clear out any buffered data, stop playing, zero out some variables */
@@ -1738,6 +1707,10 @@ JACK_Close(int deviceID)
   if(drv->rw_buffer1) free(drv->rw_buffer1);
   drv->rw_buffer1 = 0;
 
+  drv->rw_buffer2_size = 0;
+  if(drv->rw_buffer2) free(drv->rw_buffer2);
+  drv->rw_buffer2 = 0;
+
   if(drv->pPlayPtr) jack_ringbuffer_free(drv->pPlayPtr);
   drv->pPlayPtr = 0;
 
@@ -1803,7 +1776,21 @@ JACK_Write(int deviceID, unsigned char *data, unsigned long bytes)
     return 0;                   /* indicate that we couldn't write any bytes */
   }
 
-  frames = min(frames, frames_free);
+  bool resample = (drv->output_src && drv->output_sample_rate_ratio != 1.0);
+
+  /* when resampling, frames_free is in jack frames but frames is in ours */
+  if(resample)
+    frames = min(frames, (long) (frames_free / drv->output_sample_rate_ratio));
+  else
+    frames = min(frames, frames_free);
+
+  if(frames < 1)
+  {
+    TRACE("no room left\n");
+    releaseDriver(drv);
+    return 0;
+  }
+
   long jack_bytes = frames * drv->bytes_per_jack_output_frame;
   if(!ensure_buffer_size(&drv->rw_buffer1, &drv->rw_buffer1_size, jack_bytes))
   {
@@ -1843,7 +1830,48 @@ JACK_Write(int deviceID, unsigned char *data, unsigned long bytes)
         jack_ringbuffer_read_space(drv->pPlayPtr),
         jack_ringbuffer_write_space(drv->pPlayPtr));
 
-  jack_ringbuffer_write(drv->pPlayPtr, drv->rw_buffer1, jack_bytes);
+  /* do sample rate conversion here rather than in JACK_Callback(), so that */
+  /* the callback never has to run the resampler in jack's realtime thread */
+  if(resample)
+  {
+    long out_bytes = frames_free * drv->bytes_per_jack_output_frame;
+    if(!ensure_buffer_size(&drv->rw_buffer2, &drv->rw_buffer2_size, out_bytes))
+    {
+      ERR("couldn't allocate enough space for the buffer\n");
+      releaseDriver(drv);
+      return 0;
+    }
+
+    SRC_DATA srcdata;
+    srcdata.data_in = (sample_t *) drv->rw_buffer1;
+    srcdata.input_frames = frames;
+    srcdata.src_ratio = drv->output_sample_rate_ratio;
+    srcdata.data_out = (sample_t *) drv->rw_buffer2;
+    srcdata.output_frames = frames_free;
+    srcdata.end_of_input = 0;   // it's a stream, it never ends
+
+    int src_error = src_process(drv->output_src, &srcdata);
+    DEBUG("used = %ld, generated = %ld, error = %d: %s.\n",
+          srcdata.input_frames_used, srcdata.output_frames_gen,
+          src_error, src_strerror(src_error));
+
+    if(src_error != 0)
+    {
+      ERR("sample rate conversion failed: %s\n", src_strerror(src_error));
+      releaseDriver(drv);
+      return 0;
+    }
+
+    /* the resampler may not have taken all of the input if it ran out of */
+    /* room for the output, so only report what it actually used */
+    bytes = srcdata.input_frames_used * drv->bytes_per_output_frame;
+    jack_bytes = srcdata.output_frames_gen * drv->bytes_per_jack_output_frame;
+    jack_ringbuffer_write(drv->pPlayPtr, drv->rw_buffer2, jack_bytes);
+  }
+  else
+  {
+    jack_ringbuffer_write(drv->pPlayPtr, drv->rw_buffer1, jack_bytes);
+  }
   DEBUG("wrote %lu bytes, %lu jack_bytes\n", bytes, jack_bytes);
 
   DEBUG("ringbuffer read space = %d, write space = %d\n",
@@ -1916,6 +1944,7 @@ JACK_Read(int deviceID, unsigned char *data, unsigned long bytes)
         jack_ringbuffer_read_space(drv->pRecPtr),
         jack_ringbuffer_write_space(drv->pRecPtr));
 
+  float gains[MAX_OUTPUT_PORTS];
   int i;
   for(i = 0; i < drv->num_output_channels; i++)
   {
@@ -1924,17 +1953,16 @@ JACK_Read(int deviceID, unsigned char *data, unsigned long bytes)
     {
       /* assume the volume setting is dB of attenuation, a volume of 0 */
       /* is 0dB attenuation */
-      float volume = powf(10.0, -((float) drv->volume[i]) / 20.0);
-      float_volume_effect((sample_t *) drv->rw_buffer1 + i,
-                          frames, volume, drv->num_output_channels);
+      gains[i] = clip_volume(powf(10.0, -((float) drv->volume[i]) / 20.0));
     } else
     {
-      float_volume_effect((sample_t *) drv->rw_buffer1 + i, frames,
-                          ((float) drv->volume[i] / 100.0),
-                          drv->num_output_channels);
+      gains[i] = clip_volume((float) drv->volume[i] / 100.0);
     }
   }
 
+  sample_gain((sample_t *) drv->rw_buffer1, drv->num_output_channels, frames,
+              gains);
+
   /* convert from jack samples to client samples
      we have to tell it how many samples there are, which is frames * channels */
   switch (drv->bits_per_channel)
@@ -1959,6 +1987,31 @@ JACK_Read(int deviceID, unsigned char *data, unsigned long bytes)
   return read_bytes;
 }
 
+/* convert a channel's volume setting to the multiplier JACK_Callback() */
+/* applies, so that the callback doesn't need to call powf() itself */
+static void
+JACK_UpdateGainFromDriver(jack_driver_t * drv, unsigned int channel)
+{
+  float gain;
+
+  if(drv->volumeEffectType == dbAttenuation)
+  {
+    /* assume the volume setting is dB of attenuation, a volume of 0 */
+    /* is 0dB attenuation */
+    gain = powf(10.0, -((float) drv->volume[channel]) / 20.0);
+  } else
+  {
+    gain = (float) drv->volume[channel] / 100.0;
+  }
+
+  if(gain < 0)
+    gain = 0;
+  if(gain > 1.0)
+    gain = 1.0;
+
+  drv->gain[channel] = gain;
+}
+
 /* return ERR_SUCCESS for success */
 static int
 JACK_SetVolumeForChannelFromDriver(jack_driver_t * drv,
@@ -1973,6 +2026,7 @@ JACK_SetVolumeForChannelFromDriver(jack_driver_t * drv,
     volume = 100;               /* check for values in excess of max */
 
   drv->volume[channel] = volume;
+  JACK_UpdateGainFromDriver(drv, channel);
   return ERR_SUCCESS;
 }
 
@@ -2061,6 +2115,10 @@ JACK_SetVolumeEffectType(int deviceID, enum JACK_VOLUME_TYPE type)
   retval = drv->volumeEffectType;
   drv->volumeEffectType = type;
 
+  unsigned int i;
+  for(i = 0; i < MAX_OUTPUT_PORTS; i++)
+    JACK_UpdateGainFromDriver(drv, i);
+
   releaseDriver(drv);
   return retval;
 }
@@ -2167,6 +2225,19 @@ JACK_GetInputBytesPerSecond(int deviceID)
   return return_val;
 }
 
+/* convert a number of bytes in the playback ringbuffer into the number */
+/* of client bytes they came from, allowing for sample rate conversion */
+static long
+JACK_ClientBytesFromDriver(jack_driver_t * drv, long jack_bytes)
+{
+  long frames = jack_bytes / drv->bytes_per_jack_output_frame;
+
+  if(drv->output_src && drv->output_sample_rate_ratio != 1.0)
+    frames = (long) (frames / drv->output_sample_rate_ratio);
+
+  return frames * drv->bytes_per_output_frame;
+}
+
 /* Return the number of bytes we have buffered thus far for output */
 /* NOTE: convert from output bytes to input bytes in here */
 static long
@@ -2184,9 +2255,7 @@ JACK_GetBytesStoredFromDriver(jack_driver_t * drv)
   } else
   {
     /* adjust from jack bytes to client bytes */
-    return_val =
-      return_val / drv->bytes_per_jack_output_frame *
-      drv->bytes_per_output_frame;
+    return_val = JACK_ClientBytesFromDriver(drv, return_val);
   }
 
   return return_val;
@@ -2221,9 +2290,7 @@ JACK_GetBytesFreeSpaceFromDriver(jack_driver_t * drv)
   } else
   {
     /* adjust from jack bytes to client bytes */
-    return_val =
-      return_val / drv->bytes_per_jack_output_frame *
-      drv->bytes_per_output_frame;
+    return_val = JACK_ClientBytesFromDriver(drv, return_val);
   }
 
   return return_val;
@@ -2280,7 +2347,6 @@ JACK_GetPositionFromDriver(jack_driver_t * drv, enum pos_enum position,
                            int type)
 {
   long return_val = 0;
-  struct timeval now;
   long elapsedMS;
   double sec2msFactor = 1000;
 
@@ -2313,9 +2379,13 @@ JACK_GetPositionFromDriver(jack_driver_t * drv, enum pos_enum position,
     type_str = "PLAYED";
 #endif
     return_val = drv->played_client_bytes;
-    gettimeofday(&now, 0);
 
-    elapsedMS = TimeValDifference(&drv->previousTime, &now);    /* find the elapsed milliseconds since last JACK_Callback() */
+    /* find the elapsed milliseconds since the start of the last JACK_Callback() */
+    if(drv->client && drv->jack_sample_rate)
+      elapsedMS = (long) jack_frames_since(drv->client) * sec2msFactor /
+        drv->jack_sample_rate;
+    else
+      elapsedMS = 0;
 
     TRACE("elapsedMS since last callback is '%ld'\n", elapsedMS);
 
@@ -2448,10 +2518,9 @@ JACK_GetMaxOutputBufferedBytes(int deviceID)
   if(drv->pPlayPtr == 0 || drv->bytes_per_jack_output_frame == 0) return_val = 0;
 
   /* adjust from jack bytes to client bytes */
-  return_val =
-    (jack_ringbuffer_read_space(drv->pPlayPtr) +
-     jack_ringbuffer_write_space(drv->pPlayPtr)) /
-    drv->bytes_per_jack_output_frame * drv->bytes_per_output_frame;
+  return_val = JACK_ClientBytesFromDriver(drv,
+    jack_ringbuffer_read_space(drv->pPlayPtr) +
+    jack_ringbuffer_write_space(drv->pPlayPtr));
 
   releaseDriver(drv);
 
@@ -2515,6 +2584,26 @@ JACK_GetSampleRate(int deviceID)
   return return_val;
 }
 
+/* number of xruns jack has reported since the device was opened */
+unsigned long
+JACK_GetXrunCount(int deviceID)
+{
+  jack_driver_t *drv = getDriver(deviceID);
+  unsigned long return_val = drv->xrun_count;
+  releaseDriver(drv);
+  return return_val;
+}
+
+/* longest time spent in the process callback, in microseconds */
+unsigned long
+JACK_GetMaxCallbackTime(int deviceID)
+{
+  jack_driver_t *drv = getDriver(deviceID);
+  unsigned long return_val = drv->max_callback_usecs;
+  releaseDriver(drv);
+  return return_val;
+}
+
 void
 JACK_CleanupDriver(jack_driver_t * drv)
 {
@@ -2527,7 +2616,8 @@ JACK_CleanupDriver(jack_driver_t * drv)
   drv->output_sample_rate_ratio = 1.0;
   drv->input_sample_rate_ratio = 1.0;
   drv->jackd_died = FALSE;
-  gettimeofday(&drv->previousTime, 0);  /* record the current time */
+  drv->xrun_count = 0;
+  drv->max_callback_usecs = 0;
   gettimeofday(&drv->last_reconnect_attempt, 0);
 }
 
@@ -2564,7 +2654,11 @@ JACK_Init(void)
     drv->deviceID = x;
 
     for(y = 0; y < MAX_OUTPUT_PORTS; y++)       /* make all volume 25% as a default */
+    {
       drv->volume[y] = 25;
+      JACK_UpdateGainFromDriver(drv, y);
+      drv->callback_gain[y] = drv->gain[y];
+    }
 
     JACK_CleanupDriver(drv);
     JACK_ResetFromDriver(drv);
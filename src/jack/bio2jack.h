@@ -120,6 +120,9 @@ int  JACK_GetNumOutputChannels(int deviceID);
 
 long JACK_GetSampleRate(int deviceID); /* samples per second */
 
+unsigned long JACK_GetXrunCount(int deviceID);       /* xruns reported by jack since the device was opened */
+unsigned long JACK_GetMaxCallbackTime(int deviceID); /* longest process callback so far, in microseconds */
+
 void JACK_SetClientName(char *name); /* sets the name that bio2jack will use when
                                         creating a new jack client.  name_%pid%_%deviceID%%counter%
                                         will be used
@@ -250,6 +250,9 @@ static void jack_close(void)
   aud_set_int ("jack", "volume_left", jack_cfg.volume_left);
   aud_set_int ("jack", "volume_right", jack_cfg.volume_right);
 
+  TRACE("%lu xruns, longest callback %lu usecs\n", JACK_GetXrunCount(driver),
+    JACK_GetMaxCallbackTime(driver));
+
   JACK_Reset(driver); /* flush buffers, reset position and set state to STOPPED */
   TRACE("resetting driver, not closing now, destructor will close for us\n");
 }
@@ -19,12 +19,21 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "ladspa.h"
 #include "plugin.h"
 
 static int ladspa_channels, ladspa_rate;
 
+/* The chain works on planar buffers: the interleaved input is split into one
+ * buffer per channel once per block, every plugin runs on those buffers, and
+ * the result is interleaved once at the end.  Plugins that can work in place
+ * have both ports of a channel connected to the same buffer; the others write
+ * into their own output buffers, which are copied back after each run. */
+static float * chain_data;
+static float * * chain_bufs; /* (float *) */
+
 static void start_plugin (LoadedPlugin * loaded)
 {
     if (loaded->active)
@@ -51,10 +60,12 @@ static void start_plugin (LoadedPlugin * loaded)
     }
 
     int instances = ladspa_channels / ports;
+    char in_place = ! LADSPA_IS_INPLACE_BROKEN (desc->Properties);
 
     loaded->instances = index_new ();
-    loaded->in_bufs = g_malloc (sizeof (float *) * ladspa_channels);
-    loaded->out_bufs = g_malloc (sizeof (float *) * ladspa_channels);
+
+    if (! in_place)
+        loaded->out_bufs = g_malloc0 (sizeof (float *) * ladspa_channels);
 
     for (int i = 0; i < instances; i ++)
     {
@@ -71,14 +82,17 @@ static void start_plugin (LoadedPlugin * loaded)
         for (int p = 0; p < ports; p ++)
         {
             int channel = ports * i + p;
+            float * out = chain_bufs[channel];
+
+            if (! in_place)
+            {
+                out = g_malloc (sizeof (float) * LADSPA_BUFLEN);
+                loaded->out_bufs[channel] = out;
+            }
 
-            float * in = g_malloc (sizeof (float) * LADSPA_BUFLEN);
-            loaded->in_bufs[channel] = in;
             int in_port = g_array_index (plugin->in_ports, int, p);
-            desc->connect_port (handle, in_port, in);
+            desc->connect_port (handle, in_port, chain_bufs[channel]);
 
-            float * out = g_malloc (sizeof (float) * LADSPA_BUFLEN);
-            loaded->out_bufs[channel] = out;
             int out_port = g_array_index (plugin->out_ports, int, p);
             desc->connect_port (handle, out_port, out);
         }
@@ -88,7 +102,7 @@ static void start_plugin (LoadedPlugin * loaded)
     }
 }
 
-static void run_plugin (LoadedPlugin * loaded, float * data, int samples)
+static void run_plugin (LoadedPlugin * loaded, int frames)
 {
     if (! loaded->instances)
         return;
@@ -100,48 +114,69 @@ static void run_plugin (LoadedPlugin * loaded, float * data, int samples)
     int instances = index_count (loaded->instances);
     assert (ports * instances == ladspa_channels);
 
+    for (int i = 0; i < instances; i ++)
+    {
+        LADSPA_Handle * handle = index_get (loaded->instances, i);
+        desc->run (handle, frames);
+    }
+
+    if (loaded->out_bufs)
+    {
+        for (int channel = 0; channel < ladspa_channels; channel ++)
+            memcpy (chain_bufs[channel], loaded->out_bufs[channel],
+             sizeof (float) * frames);
+    }
+}
+
+static void run_chain (float * data, int samples, char finish)
+{
+    int count = index_count (loadeds);
+
+    for (int i = 0; i < count; i ++)
+        start_plugin (index_get (loadeds, i));
+
     while (samples / ladspa_channels > 0)
     {
         int frames = MIN (samples / ladspa_channels, LADSPA_BUFLEN);
 
-        for (int i = 0; i < instances; i ++)
+        for (int channel = 0; channel < ladspa_channels; channel ++)
         {
-            LADSPA_Handle * handle = index_get (loaded->instances, i);
+            float * get = data + channel;
+            float * in = chain_bufs[channel];
+            float * in_end = in + frames;
 
-            for (int p = 0; p < ports; p ++)
+            while (in < in_end)
             {
-                int channel = ports * i + p;
-                float * get = data + channel;
-                float * in = loaded->in_bufs[channel];
-                float * in_end = in + frames;
-
-                while (in < in_end)
-                {
-                    * in ++ = * get;
-                    get += ladspa_channels;
-                }
+                * in ++ = * get;
+                get += ladspa_channels;
             }
+        }
 
-            desc->run (handle, frames);
+        for (int i = 0; i < count; i ++)
+            run_plugin (index_get (loadeds, i), frames);
+
+        for (int channel = 0; channel < ladspa_channels; channel ++)
+        {
+            float * set = data + channel;
+            float * out = chain_bufs[channel];
+            float * out_end = out + frames;
 
-            for (int p = 0; p < ports; p ++)
+            while (out < out_end)
             {
-                int channel = ports * i + p;
-                float * set = data + channel;
-                float * out = loaded->out_bufs[channel];
-                float * out_end = out + frames;
-
-                while (out < out_end)
-                {
-                    * set = * out ++;
-                    set += ladspa_channels;
-                }
+                * set = * out ++;
+                set += ladspa_channels;
             }
         }
 
         data += ladspa_channels * frames;
         samples -= ladspa_channels * frames;
     }
+
+    if (finish)
+    {
+        for (int i = 0; i < count; i ++)
+            shutdown_plugin_locked (index_get (loadeds, i));
+    }
 }
 
 static void flush_plugin (LoadedPlugin * loaded)
@@ -185,16 +220,14 @@ void shutdown_plugin_locked (LoadedPlugin * loaded)
         desc->cleanup (handle);
     }
 
-    for (int channel = 0; channel < ladspa_channels; channel ++)
+    if (loaded->out_bufs)
     {
-        g_free (loaded->in_bufs[channel]);
-        g_free (loaded->out_bufs[channel]);
+        for (int channel = 0; channel < ladspa_channels; channel ++)
+            g_free (loaded->out_bufs[channel]);
     }
 
     index_free (loaded->instances);
     loaded->instances = NULL;
-    g_free (loaded->in_bufs);
-    loaded->in_bufs = NULL;
     g_free (loaded->out_bufs);
     loaded->out_bufs = NULL;
 }
@@ -213,21 +246,21 @@ void ladspa_start (int * channels, int * rate)
     ladspa_channels = * channels;
     ladspa_rate = * rate;
 
+    g_free (chain_data);
+    g_free (chain_bufs);
+    chain_data = g_malloc (sizeof (float) * LADSPA_BUFLEN * ladspa_channels);
+    chain_bufs = g_malloc (sizeof (float *) * ladspa_channels);
+
+    for (int channel = 0; channel < ladspa_channels; channel ++)
+        chain_bufs[channel] = chain_data + LADSPA_BUFLEN * channel;
+
     pthread_mutex_unlock (& mutex);
 }
 
 void ladspa_process (float * * data, int * samples)
 {
     pthread_mutex_lock (& mutex);
-
-    int count = index_count (loadeds);
-    for (int i = 0; i < count; i ++)
-    {
-        LoadedPlugin * loaded = index_get (loadeds, i);
-        start_plugin (loaded);
-        run_plugin (loaded, * data, * samples);
-    }
-
+    run_chain (* data, * samples, 0);
     pthread_mutex_unlock (& mutex);
 }
 
@@ -248,15 +281,6 @@ void ladspa_flush (void)
 void ladspa_finish (float * * data, int * samples)
 {
     pthread_mutex_lock (& mutex);
-
-    int count = index_count (loadeds);
-    for (int i = 0; i < count; i ++)
-    {
-        LoadedPlugin * loaded = index_get (loadeds, i);
-        start_plugin (loaded);
-        run_plugin (loaded, * data, * samples);
-        shutdown_plugin_locked (loaded);
-    }
-
+    run_chain (* data, * samples, 1);
     pthread_mutex_unlock (& mutex);
 }
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include <gmodule.h>
 #include <gtk/gtk.h>
@@ -41,7 +42,7 @@ static const gchar * const ladspa_defaults[] = {
 
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 char * module_path;
-Index * modules; /* (void *) */
+Index * modules; /* (GModule *) */
 Index * plugins; /* (PluginData *) */
 Index * loadeds; /* (LoadedPlugin *) */
 
@@ -107,7 +108,10 @@ static ControlData * parse_control (const LADSPA_Descriptor * desc, int port)
     return control;
 }
 
-static PluginData * open_plugin (const char * path, const LADSPA_Descriptor * desc)
+/* <desc> may be the real descriptor or one rebuilt from the cache; only the
+ * label, name and port information are read from it here. */
+static PluginData * open_plugin (const char * path, int index,
+ const LADSPA_Descriptor * desc)
 {
     const char * slash = strrchr (path, G_DIR_SEPARATOR);
     g_return_val_if_fail (slash && slash[1], NULL);
@@ -115,7 +119,11 @@ static PluginData * open_plugin (const char * path, const LADSPA_Descriptor * de
 
     PluginData * plugin = g_slice_new (PluginData);
     plugin->path = g_strdup (slash + 1);
-    plugin->desc = desc;
+    plugin->module = g_strdup (path);
+    plugin->index = index;
+    plugin->label = g_strdup (desc->Label);
+    plugin->name = g_strdup (desc->Name);
+    plugin->desc = NULL;
     plugin->controls = index_new ();
     plugin->in_ports = g_array_new (0, 0, sizeof (int));
     plugin->out_ports = g_array_new (0, 0, sizeof (int));
@@ -151,13 +159,244 @@ static void close_plugin (PluginData * plugin)
     }
 
     g_free (plugin->path);
+    g_free (plugin->module);
+    g_free (plugin->label);
+    g_free (plugin->name);
     index_free (plugin->controls);
     g_array_free (plugin->in_ports, 1);
     g_array_free (plugin->out_ports, 1);
     g_slice_free (PluginData, plugin);
 }
 
-static void * open_module (const char * path)
+/* Descriptor cache
+ * ----------------
+ * Opening every module in the search paths at startup is slow with a large
+ * LADSPA collection, so the labels, names and port layouts of all plugins are
+ * kept in a key file, one group per module, together with the mtime and size
+ * of the module.  Modules whose entry is still current are not opened until
+ * one of their plugins is enabled. */
+
+static GKeyFile * old_cache, * new_cache;
+static char cache_dirty;
+
+static char * cache_filename (void)
+{
+    return g_build_filename (aud_get_path (AUD_PATH_USER_DIR), "ladspa-cache", NULL);
+}
+
+static void cache_store (const char * path, int index, const LADSPA_Descriptor * desc)
+{
+    char key[32];
+    int ports = desc->PortCount;
+
+    g_key_file_set_integer (new_cache, path, "plugins", index + 1);
+
+    /* broken descriptors are remembered as such, so that the module is not
+     * scanned again because of them */
+    if (! desc->Label || ! desc->Name)
+        return;
+
+    snprintf (key, sizeof key, "%d_label", index);
+    g_key_file_set_string (new_cache, path, key, desc->Label);
+    snprintf (key, sizeof key, "%d_name", index);
+    g_key_file_set_string (new_cache, path, key, desc->Name);
+    snprintf (key, sizeof key, "%d_ports", index);
+    g_key_file_set_integer (new_cache, path, key, ports);
+
+    if (! ports)
+        return;
+
+    int port_types[ports], hint_types[ports];
+    double lower[ports], upper[ports];
+    const char * names[ports];
+
+    for (int i = 0; i < ports; i ++)
+    {
+        port_types[i] = desc->PortDescriptors[i];
+        names[i] = desc->PortNames[i] ? desc->PortNames[i] : "";
+        hint_types[i] = desc->PortRangeHints[i].HintDescriptor;
+        lower[i] = desc->PortRangeHints[i].LowerBound;
+        upper[i] = desc->PortRangeHints[i].UpperBound;
+    }
+
+    snprintf (key, sizeof key, "%d_port_types", index);
+    g_key_file_set_integer_list (new_cache, path, key, port_types, ports);
+    snprintf (key, sizeof key, "%d_port_names", index);
+    g_key_file_set_string_list (new_cache, path, key, names, ports);
+    snprintf (key, sizeof key, "%d_hint_types", index);
+    g_key_file_set_integer_list (new_cache, path, key, hint_types, ports);
+    snprintf (key, sizeof key, "%d_lower", index);
+    g_key_file_set_double_list (new_cache, path, key, lower, ports);
+    snprintf (key, sizeof key, "%d_upper", index);
+    g_key_file_set_double_list (new_cache, path, key, upper, ports);
+}
+
+static PluginData * cache_load_plugin (const char * path, int index)
+{
+    char key[32];
+    PluginData * plugin = NULL;
+
+    snprintf (key, sizeof key, "%d_label", index);
+    char * label = g_key_file_get_string (old_cache, path, key, NULL);
+    snprintf (key, sizeof key, "%d_name", index);
+    char * name = g_key_file_get_string (old_cache, path, key, NULL);
+    snprintf (key, sizeof key, "%d_ports", index);
+    int ports = g_key_file_get_integer (old_cache, path, key, NULL);
+
+    gsize counts[5] = {0, 0, 0, 0, 0};
+    int * port_types = NULL, * hint_types = NULL;
+    double * lower = NULL, * upper = NULL;
+    char * * names = NULL;
+
+    if (ports > 0)
+    {
+        snprintf (key, sizeof key, "%d_port_types", index);
+        port_types = g_key_file_get_integer_list (old_cache, path, key, & counts[0], NULL);
+        snprintf (key, sizeof key, "%d_port_names", index);
+        names = g_key_file_get_string_list (old_cache, path, key, & counts[1], NULL);
+        snprintf (key, sizeof key, "%d_hint_types", index);
+        hint_types = g_key_file_get_integer_list (old_cache, path, key, & counts[2], NULL);
+        snprintf (key, sizeof key, "%d_lower", index);
+        lower = g_key_file_get_double_list (old_cache, path, key, & counts[3], NULL);
+        snprintf (key, sizeof key, "%d_upper", index);
+        upper = g_key_file_get_double_list (old_cache, path, key, & counts[4], NULL);
+    }
+
+    if (! label || ! name || ports < 0)
+        goto DONE;
+
+    for (int i = 0; i < 5; i ++)
+    {
+        if (ports > 0 && counts[i] != ports)
+            goto DONE;
+    }
+
+    {
+        LADSPA_PortDescriptor port_descs[MAX (ports, 1)];
+        LADSPA_PortRangeHint hints[MAX (ports, 1)];
+
+        for (int i = 0; i < ports; i ++)
+        {
+            port_descs[i] = port_types[i];
+            hints[i].HintDescriptor = hint_types[i];
+            hints[i].LowerBound = lower[i];
+            hints[i].UpperBound = upper[i];
+        }
+
+        LADSPA_Descriptor desc;
+        memset (& desc, 0, sizeof desc);
+        desc.Label = label;
+        desc.Name = name;
+        desc.PortCount = ports;
+        desc.PortDescriptors = port_descs;
+        desc.PortNames = (const char * const *) names;
+        desc.PortRangeHints = hints;
+
+        plugin = open_plugin (path, index, & desc);
+    }
+
+DONE:
+    g_free (label);
+    g_free (name);
+    g_free (port_types);
+    g_strfreev (names);
+    g_free (hint_types);
+    g_free (lower);
+    g_free (upper);
+
+    return plugin;
+}
+
+/* returns FALSE if the module has to be scanned */
+static gboolean cache_load_module (const char * path, const struct stat * info)
+{
+    if (! old_cache || ! g_key_file_has_group (old_cache, path) ||
+     g_key_file_get_int64 (old_cache, path, "mtime", NULL) != info->st_mtime ||
+     g_key_file_get_int64 (old_cache, path, "size", NULL) != info->st_size)
+        return FALSE;
+
+    int count = g_key_file_get_integer (old_cache, path, "plugins", NULL);
+
+    for (int i = 0; i < count; i ++)
+    {
+        PluginData * plugin = cache_load_plugin (path, i);
+        if (plugin)
+            index_append (plugins, plugin);
+    }
+
+    /* carry the entry over unchanged */
+    char * * keys = g_key_file_get_keys (old_cache, path, NULL, NULL);
+
+    for (int i = 0; keys && keys[i]; i ++)
+    {
+        char * value = g_key_file_get_value (old_cache, path, keys[i], NULL);
+        g_key_file_set_value (new_cache, path, keys[i], value);
+        g_free (value);
+    }
+
+    g_strfreev (keys);
+    return TRUE;
+}
+
+static void cache_open (void)
+{
+    old_cache = g_key_file_new ();
+    new_cache = g_key_file_new ();
+    cache_dirty = 0;
+
+    char * filename = cache_filename ();
+
+    if (! g_key_file_load_from_file (old_cache, filename, G_KEY_FILE_NONE, NULL))
+    {
+        g_key_file_free (old_cache);
+        old_cache = NULL;
+    }
+
+    g_free (filename);
+}
+
+static void cache_close (void)
+{
+    /* entries of modules that were not found again are dropped as well */
+    if (old_cache)
+    {
+        char * * groups = g_key_file_get_groups (old_cache, NULL);
+
+        for (int i = 0; groups[i]; i ++)
+        {
+            if (! g_key_file_has_group (new_cache, groups[i]))
+                cache_dirty = 1;
+        }
+
+        g_strfreev (groups);
+        g_key_file_free (old_cache);
+        old_cache = NULL;
+    }
+    else
+        cache_dirty = 1;
+
+    if (cache_dirty)
+    {
+        gsize len;
+        char * data = g_key_file_to_data (new_cache, & len, NULL);
+        char * filename = cache_filename ();
+
+        GError * error = NULL;
+        if (! g_file_set_contents (filename, data, len, & error))
+        {
+            fprintf (stderr, "ladspa: Failed to write %s: %s\n", filename, error->message);
+            g_error_free (error);
+        }
+
+        g_free (filename);
+        g_free (data);
+    }
+
+    g_key_file_free (new_cache);
+    new_cache = NULL;
+}
+
+static LADSPA_Descriptor_Function open_module (const char * path)
 {
     GModule * handle = g_module_open (path, G_MODULE_BIND_LOCAL);
     if (! handle)
@@ -174,17 +413,101 @@ static void * open_module (const char * path)
         return NULL;
     }
 
-    LADSPA_Descriptor_Function descfun = (LADSPA_Descriptor_Function) sym;
+    index_append (modules, handle);
+    return (LADSPA_Descriptor_Function) sym;
+}
+
+static void scan_module (const char * path, const struct stat * info)
+{
+    /* modules that fail to open are cached too, as having no plugins */
+    cache_dirty = 1;
+
+    g_key_file_set_int64 (new_cache, path, "mtime", info->st_mtime);
+    g_key_file_set_int64 (new_cache, path, "size", info->st_size);
+    g_key_file_set_integer (new_cache, path, "plugins", 0);
+
+    LADSPA_Descriptor_Function descfun = open_module (path);
+    if (! descfun)
+        return;
 
     const LADSPA_Descriptor * desc;
     for (int i = 0; (desc = descfun (i)); i ++)
     {
-        PluginData * plugin = open_plugin (path, desc);
+        PluginData * plugin = open_plugin (path, i, desc);
         if (plugin)
+        {
+            plugin->desc = desc;
             index_append (plugins, plugin);
+        }
+
+        cache_store (path, i, desc);
     }
+}
+
+/* checks that the ports read from the cache are still where they were */
+static gboolean descriptor_matches (PluginData * plugin, const LADSPA_Descriptor * desc)
+{
+    if (! desc || ! desc->Label || strcmp (desc->Label, plugin->label))
+        return FALSE;
 
-    return handle;
+    int count = index_count (plugin->controls);
+    for (int i = 0; i < count; i ++)
+    {
+        ControlData * control = index_get (plugin->controls, i);
+        if (control->port >= desc->PortCount || ! LADSPA_IS_PORT_CONTROL
+         (desc->PortDescriptors[control->port]))
+            return FALSE;
+    }
+
+    for (int i = 0; i < plugin->in_ports->len; i ++)
+    {
+        int port = g_array_index (plugin->in_ports, int, i);
+        if (port >= desc->PortCount || ! LADSPA_IS_PORT_AUDIO
+         (desc->PortDescriptors[port]) || ! LADSPA_IS_PORT_INPUT
+         (desc->PortDescriptors[port]))
+            return FALSE;
+    }
+
+    for (int i = 0; i < plugin->out_ports->len; i ++)
+    {
+        int port = g_array_index (plugin->out_ports, int, i);
+        if (port >= desc->PortCount || ! LADSPA_IS_PORT_AUDIO
+         (desc->PortDescriptors[port]) || ! LADSPA_IS_PORT_OUTPUT
+         (desc->PortDescriptors[port]))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* opens the module of <plugin> if it has not been opened yet */
+static const LADSPA_Descriptor * get_descriptor (PluginData * plugin)
+{
+    if (plugin->desc)
+        return plugin->desc;
+
+    LADSPA_Descriptor_Function descfun = open_module (plugin->module);
+    if (! descfun)
+        return NULL;
+
+    /* resolve every plugin from the same module at once */
+    int count = index_count (plugins);
+    for (int i = 0; i < count; i ++)
+    {
+        PluginData * other = index_get (plugins, i);
+        if (other->desc || strcmp (other->module, plugin->module))
+            continue;
+
+        const LADSPA_Descriptor * desc = descfun (other->index);
+
+        if (descriptor_matches (other, desc))
+            other->desc = desc;
+        else
+            fprintf (stderr, "ladspa: Plugin %s has changed in %s; rescan the "
+             "module path to use it.\n", other->label, other->module);
+    }
+
+    return plugin->desc;
 }
 
 static void open_modules_for_path (const char * path)
@@ -205,9 +528,12 @@ static void open_modules_for_path (const char * path)
         char filename[strlen (path) + strlen (entry->d_name) + 2];
         snprintf (filename, sizeof filename, "%s" G_DIR_SEPARATOR_S "%s", path, entry->d_name);
 
-        void * handle = open_module (filename);
-        if (handle)
-            index_append (modules, handle);
+        struct stat info;
+        if (stat (filename, & info) < 0)
+            continue;
+
+        if (! cache_load_module (filename, & info))
+            scan_module (filename, & info);
     }
 
     closedir (folder);
@@ -228,8 +554,10 @@ static void open_modules_for_paths (const char * paths)
 
 static void open_modules (void)
 {
+    cache_open ();
     open_modules_for_paths (getenv ("LADSPA_PATH"));
     open_modules_for_paths (module_path);
+    cache_close ();
 }
 
 static void close_modules (void)
@@ -249,6 +577,9 @@ static void close_modules (void)
 
 LoadedPlugin * enable_plugin_locked (PluginData * plugin)
 {
+    if (! get_descriptor (plugin))
+        return NULL;
+
     LoadedPlugin * loaded = g_slice_new (LoadedPlugin);
     loaded->plugin = plugin;
     loaded->selected = 0;
@@ -264,7 +595,6 @@ LoadedPlugin * enable_plugin_locked (PluginData * plugin)
 
     loaded->active = 0;
     loaded->instances = NULL;
-    loaded->in_bufs = NULL;
     loaded->out_bufs = NULL;
 
     loaded->settings_win = NULL;
@@ -294,7 +624,7 @@ static PluginData * find_plugin (const char * path, const char * label)
     for (int i = 0; i < count; i ++)
     {
         PluginData * plugin = index_get (plugins, i);
-        if (! strcmp (plugin->path, path) && ! strcmp (plugin->desc->Label, label))
+        if (! strcmp (plugin->path, path) && ! strcmp (plugin->label, label))
             return plugin;
     }
 
@@ -315,7 +645,7 @@ static void save_enabled_to_config (void)
         aud_set_string ("ladspa", key, loaded->plugin->path);
 
         snprintf (key, sizeof key, "plugin%d_label", i);
-        aud_set_string ("ladspa", key, loaded->plugin->desc->Label);
+        aud_set_string ("ladspa", key, loaded->plugin->label);
 
         int ccount = index_count (loaded->plugin->controls);
         for (int ci = 0; ci < ccount; ci ++)
@@ -343,10 +673,10 @@ static void load_enabled_from_config (void)
         char * label = aud_get_string ("ladspa", key);
 
         PluginData * plugin = find_plugin (path, label);
-        if (plugin)
-        {
-            LoadedPlugin * loaded = enable_plugin_locked (plugin);
+        LoadedPlugin * loaded = plugin ? enable_plugin_locked (plugin) : NULL;
 
+        if (loaded)
+        {
             int ccount = index_count (loaded->plugin->controls);
             for (int ci = 0; ci < ccount; ci ++)
             {
@@ -490,7 +820,7 @@ static void configure_plugin (LoadedPlugin * loaded)
     PluginData * plugin = loaded->plugin;
     char buf[200];
 
-    snprintf (buf, sizeof buf, _("%s Settings"), plugin->desc->Name);
+    snprintf (buf, sizeof buf, _("%s Settings"), plugin->name);
     loaded->settings_win = gtk_dialog_new_with_buttons (buf, (GtkWindow *)
      config_win, GTK_DIALOG_DESTROY_WITH_PARENT, GTK_STOCK_CLOSE,
      GTK_RESPONSE_CLOSE, NULL);
@@ -36,8 +36,11 @@ typedef struct {
 } ControlData;
 
 typedef struct {
-    char * path;
-    const LADSPA_Descriptor * desc;
+    char * path; /* file name of the module */
+    char * module; /* full path of the module */
+    int index; /* of the descriptor within the module */
+    char * label, * name;
+    const LADSPA_Descriptor * desc; /* NULL until the module is opened */
     Index * controls; /* (ControlData *) */
     GArray * in_ports, * out_ports; /* (int) */
     char selected;
@@ -49,7 +52,7 @@ typedef struct {
     char selected;
     char active;
     Index * instances; /* (LADSPA_Handle) */
-    float * * in_bufs, * * out_bufs; /* (float *) */
+    float * * out_bufs; /* (float *), only if LADSPA_PROPERTY_INPLACE_BROKEN */
     GtkWidget * settings_win;
 } LoadedPlugin;
 
@@ -77,7 +77,8 @@ static PSFEngine psf_probe(uint8_t *buffer)
 	return ENG_NONE;
 }
 
-/* ao_get_lib: called to load secondary files */
+/* ao_get_lib: called to load secondary files (during playback only, so
+ * the tuple reader below does not depend on dirpath) */
 static const char *dirpath;
 
 int ao_get_lib(char *filename, uint8_t **buffer, uint64_t *length)
@@ -111,7 +112,10 @@ Tuple *psf2_tuple(const char *filename, VFSFile *file)
 		return NULL;
 
 	if (corlett_decode(buf, sz, NULL, NULL, &c) != AO_SUCCESS)
+	{
+		free(buf);
 		return NULL;
+	}
 
 	t = tuple_new_from_filename(filename);
 
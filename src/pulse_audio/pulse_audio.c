@@ -30,6 +30,7 @@
 #include <audacious/drct.h>
 #include <audacious/misc.h>
 #include <audacious/plugin.h>
+#include <audacious/preferences.h>
 #include <audacious/i18n.h>
 
 #define ERROR(...) do {fprintf (stderr, "pulseaudio: " __VA_ARGS__); putchar ('\n');} while (0)
@@ -50,6 +51,13 @@ static int connected = 0;
 
 static pa_time_event *volume_time_event = NULL;
 
+/* target latency in low latency mode */
+#define LOW_LATENCY_MS 40
+
+static const char * const pulse_defaults[] = {
+ "low_latency", "FALSE",
+ NULL};
+
 #define CHECK_DEAD_GOTO(label, warn) do { \
 if (!mainloop || \
     !context || pa_context_get_state(context) != PA_CONTEXT_READY || \
@@ -315,10 +323,17 @@ static int pulse_get_output_time (void)
 
     time = written * (int64_t) 1000 / bytes_per_second;
 
+    /* with timing interpolation this is the latency right now, including the
+     * sink's own buffer, rather than as of the last timing update */
     pa_usec_t usec;
     int neg;
     if (pa_stream_get_latency (stream, & usec, & neg) == PA_OK)
-        time -= usec / 1000;
+    {
+        if (neg)
+            time += usec / 1000;
+        else
+            time -= usec / 1000;
+    }
 
     /* fix for AUDPLUG-308: pa_stream_get_latency() still returns positive even
      * immediately after a flush; fix the result so that we don't return less
@@ -393,31 +408,36 @@ fail:
 }
 
 static void pulse_write(void* ptr, int length) {
-    int writeoffs, remain, writable;
-
     CHECK_CONNECTED();
 
     pa_threaded_mainloop_lock(mainloop);
     CHECK_DEAD_GOTO(fail, 1);
 
-    /* break large fragments into smaller fragments. --nenolod */
-    for (writeoffs = 0, remain = length;
-         writeoffs < length;
-         writeoffs += writable, remain -= writable)
+    /* Copy straight into the server's shared memory rather than letting
+     * pa_stream_write() make a copy of our buffer.  PulseAudio may hand us
+     * less than we asked for, so this can take more than one pass. */
+    for (int remain = length; remain > 0; )
     {
-         void * pptr = (char *) ptr + writeoffs;
+        void * buf = NULL;
+        size_t size = remain;
 
-         writable = length - writeoffs;
-         size_t fragsize = pa_stream_writable_size(stream);
+        if (pa_stream_begin_write (stream, & buf, & size) < 0) {
+            AUDDBG("pa_stream_begin_write() failed: %s", pa_strerror(pa_context_errno(context)));
+            goto fail;
+        }
 
-         /* don't write more than what PA is willing to handle right now. */
-         if (writable > fragsize)
-             writable = fragsize;
+        if (size > (size_t) remain)
+            size = remain;
 
-         if (pa_stream_write(stream, pptr, writable, NULL, PA_SEEK_RELATIVE, 0) < 0) {
-             AUDDBG("pa_stream_write() failed: %s", pa_strerror(pa_context_errno(context)));
-             goto fail;
-         }
+        memcpy (buf, ptr, size);
+
+        if (pa_stream_write(stream, buf, size, NULL, PA_SEEK_RELATIVE, 0) < 0) {
+            AUDDBG("pa_stream_write() failed: %s", pa_strerror(pa_context_errno(context)));
+            goto fail;
+        }
+
+        ptr = (char *) ptr + size;
+        remain -= size;
     }
 
     do_trigger = 0;
@@ -555,8 +575,19 @@ static int pulse_open(int fmt, int rate, int nch) {
     int aud_buffer = aud_get_int(NULL, "output_buffer_size");
     size_t buffer_size = pa_usec_to_bytes(aud_buffer, &ss) * 1000;
     pa_buffer_attr buffer = {(uint32_t) -1, buffer_size, (uint32_t) -1, (uint32_t) -1, buffer_size};
+    pa_stream_flags_t flags = PA_STREAM_INTERPOLATE_TIMING | PA_STREAM_AUTO_TIMING_UPDATE;
+
+    /* In low latency mode, ask for a short buffer and have the server
+     * configure the sink to match, so that the whole path stays short.  The
+     * data is requested in quarters of the buffer. */
+    if (aud_get_bool ("pulse", "low_latency"))
+    {
+        buffer.tlength = pa_usec_to_bytes (LOW_LATENCY_MS * 1000, & ss);
+        buffer.minreq = buffer.tlength / 4;
+        flags |= PA_STREAM_ADJUST_LATENCY;
+    }
 
-    if (pa_stream_connect_playback(stream, NULL, &buffer, PA_STREAM_INTERPOLATE_TIMING|PA_STREAM_AUTO_TIMING_UPDATE, NULL, NULL) < 0) {
+    if (pa_stream_connect_playback(stream, NULL, &buffer, flags, NULL, NULL) < 0) {
         ERROR ("Failed to connect stream: %s", pa_strerror(pa_context_errno(context)));
         goto unlock_and_fail;
     }
@@ -633,6 +664,8 @@ fail:
 
 static bool_t pulse_init (void)
 {
+    aud_config_set_defaults ("pulse", pulse_defaults);
+
     if (! pulse_open (FMT_S16_NE, 44100, 2))
         return FALSE;
 
@@ -640,6 +673,15 @@ static bool_t pulse_init (void)
     return TRUE;
 }
 
+static const PreferencesWidget pulse_widgets[] = {
+ {WIDGET_CHK_BTN, N_("Low latency mode (takes effect on next song)"),
+  .cfg_type = VALUE_BOOLEAN, .csect = "pulse", .cname = "low_latency"}
+};
+
+static const PluginPreferences pulse_prefs = {
+ .widgets = pulse_widgets,
+ .n_widgets = N_ELEMENTS (pulse_widgets)};
+
 static const char pulse_about[] =
  N_("Audacious PulseAudio Output Plugin\n\n"
     "This program is free software; you can redistribute it and/or modify\n"
@@ -662,6 +704,7 @@ AUD_OUTPUT_PLUGIN
     .name = N_("PulseAudio Output"),
     .domain = PACKAGE,
     .about_text = pulse_about,
+    .prefs = & pulse_prefs,
     .probe_priority = 8,
     .init = pulse_init,
     .get_volume = pulse_get_volume,
@@ -89,6 +89,7 @@ extern bool_t read_authentication_test_result(char **error_code, char **error_de
 extern bool_t read_token(char **error_code, char **error_detail);
 extern bool_t read_session_key(char **error_code, char **error_detail);
 extern bool_t read_scrobble_result(char **error_code, char **error_detail, bool_t *ignored, char **ignored_code);
+extern bool_t read_scrobble_batch_result(char **error_code, char **error_detail, int n_tracks, char **ignored_codes);
 
 //scrobbler.c //TODO: refactor this
 extern gchar *remove_tabs(const char *string);
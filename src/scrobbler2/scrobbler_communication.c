@@ -2,6 +2,7 @@
 //external includes
 #include <stdarg.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <curl/curl.h>
 
@@ -77,6 +78,27 @@ static char *scrobbler_get_signature(int nparams, API_Parameter *parameters) {
 
 
 
+/*
+ * Builds the POST data for a request. The first parameter must be "method";
+ * the array gets sorted while computing the signature.
+ */
+static gchar *create_message_from_parameters (int n_params, API_Parameter *params) {
+    GString *message = g_string_new(NULL);
+
+    for (int i = 0; i < n_params; i++) {
+        char *escaped_argument = curl_easy_escape(curlHandle, params[i].argument, 0);
+        g_string_append_printf(message, "%s%s=%s", (i == 0 ? "" : "&"), params[i].paramName, escaped_argument);
+        curl_free(escaped_argument);
+    }
+
+    gchar *api_sig = scrobbler_get_signature(n_params, params);
+    g_string_append_printf(message, "&api_sig=%s", api_sig);
+    g_free(api_sig);
+
+    AUDDBG("FINAL message: %s.\n", message->str);
+    return g_string_free(message, FALSE);
+}
+
 /*
  * n_args should count with the given authentication parameters
  * At most 2: api_key, session_key.
@@ -89,50 +111,21 @@ static char *scrobbler_get_signature(int nparams, API_Parameter *parameters) {
  * Returns NULL if an error occurrs
  */
 static gchar *create_message_to_lastfm (char *method_name, int n_args, ...) {
-    //TODO: Improve this f-ugly mess.
-    gchar *result = NULL;
-
     //parameters to be sent to the get_signature() function
     API_Parameter signable_params[n_args+1];
     signable_params[0].paramName = g_strdup("method");
     signable_params[0].argument  = g_strdup(method_name);
 
-    size_t msg_size = 2; // First '=' and final '\0'
-    msg_size = msg_size + strlen("method") + strlen(method_name);
-
     va_list vl;
     va_start(vl, n_args);
     for (int i = 0; i < n_args; i++) {
-
         signable_params[i+1].paramName = g_strdup(va_arg(vl, gchar *));
         signable_params[i+1].argument  = g_strdup(va_arg(vl, gchar *));
-
-        msg_size += strlen( signable_params[i+1].paramName );
-        msg_size += strlen( signable_params[i+1].argument );
-        msg_size += 2; //Counting '&' and '='
     }
     va_end(vl);
 
-    gchar *aux;
-    result = g_strconcat("method=", method_name, NULL);
-    char *escaped_argument;
-
-    for (int i = 0; i < n_args; i++) {
-        escaped_argument = curl_easy_escape(curlHandle, signable_params[i+1].argument, 0);
-
-        aux = g_strdup_printf("%s&%s=%s", result, signable_params[i+1].paramName, escaped_argument);
-        g_free(result);
-        curl_free(escaped_argument);
-        result = aux;
-    }
-
-    gchar *api_sig = scrobbler_get_signature(n_args+1, signable_params);
-
-    aux = g_strdup_printf("%s&api_sig=%s", result, api_sig);
-    result = aux;
+    gchar *result = create_message_from_parameters(n_args+1, signable_params);
 
-    AUDDBG("FINAL message: %s.\n", result);
-    g_free(api_sig);
     for (int i = 0; i < n_args+1; i++) {
         g_free(signable_params[i].paramName);
         g_free(signable_params[i].argument);
@@ -314,7 +307,10 @@ bool_t scrobbler_communication_init() {
         return FALSE;
     }
 
-    curl_requests_result = curl_easy_setopt(curlHandle, CURLOPT_URL, SCROBBLER_URL);
+    //the endpoint can be overridden, e.g. to talk to a local stand-in for the API
+    char *url = aud_get_string("scrobbler", "api_url");
+    curl_requests_result = curl_easy_setopt(curlHandle, CURLOPT_URL, (url != NULL && url[0]) ? url : SCROBBLER_URL);
+    g_free(url);
     if (curl_requests_result != CURLE_OK) {
         AUDDBG("Could not define scrobbler destination URL: %s.\n", curl_easy_strerror(curl_requests_result));
         return FALSE;
@@ -329,213 +325,379 @@ bool_t scrobbler_communication_init() {
     return TRUE;
 }
 
-static void set_timestamp_to_current(gchar **line) {
-    //line[0] line[1] line[2] line[3] line[4] line[5] line[6]   line[7]
-    //artist  album   title   number  length  "L"     timestamp NULL
+/* The queue is an append-only journal: scrobbler.c appends one line per track
+ * and this thread never rewrites what it has sent. Instead, the byte offset up
+ * to which everything was dealt with is kept in scrobbler.log.offset, together
+ * with the inode of the log it refers to. Once most of the log is behind that
+ * offset, the remaining tail is moved into a fresh file. */
 
-    gchar **splitted_line = g_strsplit(*line, "\t", 0);
-    g_free(splitted_line[6]);
-    splitted_line[6] = g_strdup_printf("%"G_GINT64_FORMAT"", g_get_real_time() / G_USEC_PER_SEC);
-    AUDDBG("splitted line's timestamp is now: %s.\n", splitted_line[6]);
-    g_free(*line);
-    (*line) = g_strjoinv("\t", splitted_line);
-}
+#define SCROBBLE_BATCH_SIZE 50          //the most track.scrobble accepts at once
+#define COMPACT_THRESHOLD (64 * 1024)   //don't bother compacting smaller logs
 
-static void delete_lines_from_scrobble_log (GSList **lines_to_remove_ptr, GSList **lines_to_retry_ptr, gchar *queuepath) {
-    GSList *lines_to_remove = *lines_to_remove_ptr;
-    GSList *lines_to_retry = *lines_to_retry_ptr;
+typedef enum {
+    BATCH_OK,       //every track was scrobbled, ignored or requeued
+    BATCH_RETRY,    //temporary problem: leave the tracks on the queue
+    BATCH_REJECTED  //last.fm refused the request as a whole
+} BatchResult;
+
+typedef struct {
+    gchar *data;    //everything past the committed offset
+    size_t len;
+    gint64 offset;  //position of data in the log file
+} QueueTail;
+
+static gint64 read_committed_offset(const char *offsetpath, guint64 inode) {
     gchar *contents = NULL;
-    gchar **lines = NULL;
-    gchar **finallines = g_malloc_n(1, sizeof(gchar *));
-    int n_finallines;
+    gint64 offset = 0;
+
+    if (g_file_get_contents(offsetpath, &contents, NULL, NULL)) {
+        char *end;
+        //a marker left for a different (compacted or deleted) log is stale
+        if (g_ascii_strtoull(contents, &end, 10) == inode) {
+            offset = g_ascii_strtoll(end, NULL, 10);
+        }
+        g_free(contents);
+    }
+
+    return MAX(offset, 0);
+}
+
+static void write_committed_offset(const char *offsetpath, guint64 inode, gint64 offset) {
+    gchar *contents = g_strdup_printf("%"G_GUINT64_FORMAT" %"G_GINT64_FORMAT"\n", inode, offset);
+    if (!g_file_set_contents(offsetpath, contents, -1, NULL)) {
+        AUDDBG("Could not write to %s!\n", offsetpath);
+    }
+    g_free(contents);
+}
 
-    if (lines_to_remove != NULL) {
-        lines_to_remove = g_slist_reverse(lines_to_remove);
+//must be called with log_access_mutex held
+static bool_t read_queue_tail(const char *queuepath, const char *offsetpath, QueueTail *tail) {
+    struct stat st;
+    FILE *f = fopen(queuepath, "rb");
+
+    if (f == NULL) {
+        return FALSE;
     }
-    if (lines_to_retry != NULL) {
-        lines_to_retry = g_slist_reverse(lines_to_retry);
+    if (fstat(fileno(f), &st) < 0) {
+        fclose(f);
+        return FALSE;
     }
 
+    gint64 offset = read_committed_offset(offsetpath, st.st_ino);
 
-    pthread_mutex_lock(&log_access_mutex);
+    //the offset must point just past a complete line
+    if (offset > st.st_size) {
+        offset = 0;
+    } else if (offset > 0 && (fseek(f, offset - 1, SEEK_SET) < 0 || fgetc(f) != '\n')) {
+        offset = 0;
+    }
 
-    gboolean success = g_file_get_contents(queuepath, &contents, NULL, NULL);
-    if (!success) {
-        AUDDBG("Could not read scrobbler.log contents.\n");
-    } else {
-        lines = g_strsplit(contents, "\n", 0);
+    if (fseek(f, offset, SEEK_SET) < 0) {
+        fclose(f);
+        return FALSE;
+    }
 
-        n_finallines = 0;
-        for (int i = 0 ; lines[i] != NULL && strlen(lines[i]) > 0; i++) {
-            if (lines_to_remove != NULL && *((int *) (lines_to_remove->data)) == i) {
-                //this line is to remove
-                lines_to_remove = g_slist_next(lines_to_remove);
-            } else {
-                //keep this line
-                AUDDBG("Going to keep line %i\n", i);
-                if (lines_to_retry != NULL && *((int *) (lines_to_retry->data)) == i) {
-                  lines_to_retry = g_slist_next(lines_to_retry);
-                  //this line will be retried with a zero timestamp
-                  AUDDBG("Going to zero this line.\n");
-                  AUDDBG("Line before: %s.\n", lines[i]);
-                  set_timestamp_to_current(&(lines[i]));
-                  AUDDBG("Line after: %s.\n", lines[i]);
+    tail->offset = offset;
+    tail->data = g_malloc(st.st_size - offset + 1);
+    tail->len = fread(tail->data, 1, st.st_size - offset, f);
+    tail->data[tail->len] = '\0';
 
-                } else {
-                  AUDDBG("not zeroing this line\n");
-                }
-                n_finallines++;
-                finallines = g_realloc_n(finallines, n_finallines, sizeof(gchar *));
-                finallines[n_finallines-1] = g_strdup(lines[i]);
-            }
+    fclose(f);
+
+    //lines are written whole under log_access_mutex, so a missing final '\n'
+    //means a crash in the middle of a write: terminate the torn line
+    if (tail->len > 0 && tail->data[tail->len - 1] != '\n' && (f = fopen(queuepath, "ab")) != NULL) {
+        if (fputc('\n', f) != EOF) {
+            tail->data = g_realloc(tail->data, tail->len + 2);
+            tail->data[tail->len++] = '\n';
+            tail->data[tail->len] = '\0';
         }
+        fclose(f);
+    }
 
-        finallines = g_realloc_n(finallines, n_finallines+2, sizeof(gchar *));
-        finallines[n_finallines] = g_strdup("");
-        finallines[n_finallines+1] = NULL;
-        g_free(contents);
-        contents = g_strjoinv("\n", finallines);
-        success = g_file_set_contents(queuepath, contents, -1, NULL);
-        if (!success) {
+    return TRUE;
+}
+
+//must be called with log_access_mutex held
+//the log is only truncated or compacted if <compact> is set, since that moves
+//the lines that are still to be sent
+static void commit_queue_offset(const char *queuepath, const char *offsetpath, gint64 offset, bool_t compact) {
+    struct stat st;
+
+    if (stat(queuepath, &st) < 0) {
+        return;
+    }
+
+    if (compact && offset >= st.st_size) {
+        //everything was sent: start over with an empty log
+        FILE *f = fopen(queuepath, "wb");
+        if (f == NULL) {
             AUDDBG("Could not write to scrobbler.log!\n");
+            return;
         }
+        fclose(f);
+        offset = 0;
+
+    } else if (compact && offset >= COMPACT_THRESHOLD && offset >= st.st_size / 2) {
+        gchar *contents = NULL;
+        gsize length = 0;
+
+        if (!g_file_get_contents(queuepath, &contents, &length, NULL) || offset > (gint64) length) {
+            g_free(contents);
+            return;
+        }
+
+        //the new file gets a new inode, so a crash before the marker below is
+        //written leaves a stale marker rather than a wrong one
+        if (!g_file_set_contents(queuepath, contents + offset, length - offset, NULL) ||
+                stat(queuepath, &st) < 0) {
+            AUDDBG("Could not compact scrobbler.log!\n");
+            g_free(contents);
+            return;
+        }
+        g_free(contents);
+        offset = 0;
+    }
+
+    write_committed_offset(offsetpath, st.st_ino, offset);
+}
 
+//must be called with log_access_mutex held
+static void append_to_queue(const char *queuepath, const GString *lines) {
+    FILE *f = fopen(queuepath, "ab");
+
+    if (f == NULL) {
+        perror("fopen");
+        return;
+    }
+    if (fwrite(lines->str, 1, lines->len, f) != lines->len) {
+        perror("fwrite");
     }
+    fclose(f);
+}
 
+//records that everything up to <offset> was dealt with, after first saving the
+//tracks that are to be sent again
+static void commit_queue(const char *queuepath, const char *offsetpath, GString *requeue, gint64 offset, bool_t compact) {
+    pthread_mutex_lock(&log_access_mutex);
+    if (requeue->len > 0) {
+        append_to_queue(queuepath, requeue);
+        g_string_truncate(requeue, 0);
+    }
+    commit_queue_offset(queuepath, offsetpath, offset, compact);
     pthread_mutex_unlock(&log_access_mutex);
+}
 
+static void requeue_with_current_timestamp(gchar **track, GString *requeue) {
+    //track[0] track[1] track[2] track[3] track[4] track[5] track[6]   track[7]
+    //artist   album    title    number   length   "L"      timestamp  NULL
 
-    g_strfreev(finallines);
-    g_strfreev(lines);
-    g_free(contents);
+    g_free(track[6]);
+    track[6] = g_strdup_printf("%"G_GINT64_FORMAT"", g_get_real_time() / G_USEC_PER_SEC);
+    AUDDBG("track's timestamp is now: %s.\n", track[6]);
+
+    gchar *line = g_strjoinv("\t", track);
+    g_string_append(requeue, line);
+    g_string_append_c(requeue, '\n');
+    g_free(line);
+}
+
+static BatchResult send_scrobble_batch(gchar ***tracks, int n_tracks, GString *requeue) {
+    static const char * const names[] = {"artist", "album", "track", "trackNumber", "duration", "timestamp"};
+    static const int columns[] = {0, 1, 2, 3, 4, 6};
+    const int n_fields = G_N_ELEMENTS(names);
+
+    int n_params = 3 + n_fields * n_tracks;
+    API_Parameter *params = g_new(API_Parameter, n_params);
+
+    params[0].paramName = g_strdup("method");
+    params[0].argument  = g_strdup("track.scrobble");
+    params[1].paramName = g_strdup("api_key");
+    params[1].argument  = g_strdup(SCROBBLER_API_KEY);
+    params[2].paramName = g_strdup("sk");
+    params[2].argument  = g_strdup(session_key);
+
+    for (int i = 0; i < n_tracks; i++) {
+        for (int j = 0; j < n_fields; j++) {
+            API_Parameter *param = &params[3 + n_fields * i + j];
+            param->paramName = g_strdup_printf("%s[%d]", names[j], i);
+            param->argument  = g_strdup(tracks[i][columns[j]]);
+        }
+    }
+
+    gchar *scrobblemsg = create_message_from_parameters(n_params, params);
+
+    for (int i = 0; i < n_params; i++) {
+        g_free(params[i].paramName);
+        g_free(params[i].argument);
+    }
+    g_free(params);
+
+    bool_t sent = send_message_to_lastfm(scrobblemsg);
+    g_free(scrobblemsg);
+
+    if (!sent) {
+        AUDDBG("Could not scrobble the tracks on the queue. Network problem?\n");
+        scrobbling_enabled = FALSE;
+        return BATCH_RETRY;
+    }
+
+    gchar *error_code = NULL;
+    gchar *error_detail = NULL;
+    gchar *ignored_codes[SCROBBLE_BATCH_SIZE] = {NULL};
+    BatchResult result;
+
+    if (read_scrobble_batch_result(&error_code, &error_detail, n_tracks, ignored_codes) == TRUE) {
+        AUDDBG("SCROBBLE OK. %i tracks.\n", n_tracks);
+
+        for (int i = 0; i < n_tracks; i++) {
+            if (g_strcmp0(ignored_codes[i], "3") == 0) { //3: Timestamp was too old
+                AUDDBG("SCROBBLE IGNORED!!! track %i, detail: %s\n", i, ignored_codes[i]);
+                requeue_with_current_timestamp(tracks[i], requeue);
+            }
+            //TODO: a track might not be scrobbled due to "daily scrobble limit exeeded" (code 5).
+            //We are not dealing with this case currently and are losing that scrobble.
+            g_free(ignored_codes[i]);
+        }
+        result = BATCH_OK;
+
+    } else {
+        AUDDBG("SCROBBLE NOT OK. Error code: %s. Error detail: %s.\n", error_code, error_detail);
+
+        if (error_code == NULL) { //net error(?) or the answer from last.fm was not well read
+            result = BATCH_RETRY;
+        }
+        else if (g_strcmp0(error_code, "11") == 0 ||
+                 g_strcmp0(error_code, "16") == 0){
+            //error code 11: Service Offline - This service is temporarily offline. Try again later.
+            //error code 16: The service is temporarily unavailable, please try again.
+            result = BATCH_RETRY;
+        }
+        else if (g_strcmp0(error_code,  "9") == 0) {
+            //Bad Session. Reauth.
+            scrobbling_enabled = FALSE;
+            g_free(session_key);
+            session_key = NULL;
+            aud_set_string("scrobbler", "session_key", "");
+            result = BATCH_RETRY;
+        }
+        else {
+            result = BATCH_REJECTED;
+        }
+    }
+
+    g_free(error_code);
+    g_free(error_detail);
+    return result;
 }
 
-static void save_line_to_remove(GSList **lines_to_remove, int linenumber) {
-    int *rem = g_malloc(sizeof(int));
-    *rem = linenumber;
-    (*lines_to_remove) = g_slist_prepend((*lines_to_remove), rem);
+//returns how many of the leading tracks are done with
+static int submit_scrobble_batch(gchar ***tracks, int n_tracks, GString *requeue) {
+    BatchResult result = send_scrobble_batch(tracks, n_tracks, requeue);
+
+    if (result == BATCH_REJECTED && n_tracks > 1) {
+        //a single bad track spoils the whole request; find it by sending them one by one
+        for (int i = 0; i < n_tracks; i++) {
+            if (send_scrobble_batch(&tracks[i], 1, requeue) == BATCH_RETRY) {
+                return i;
+            }
+        }
+    }
+
+    return (result == BATCH_RETRY) ? 0 : n_tracks;
 }
 
 static void scrobble_cached_queue() {
 
     gchar *queuepath = g_build_filename(aud_get_path(AUD_PATH_USER_DIR),"scrobbler.log", NULL);
-    gchar *contents = NULL;
-    gboolean success;
-    gchar **lines = NULL;
-    gchar **line;
-    gchar *scrobblemsg;
-    GSList *lines_to_remove = NULL; //lines to remove because they were scrobbled (or ignored, and will not be retried)
-    GSList *lines_to_retry = NULL; //lines to retry later because they were too old TODO: or "daily scrobble limit reached"
-    gchar *error_code = NULL;
-    gchar *error_detail = NULL;
-    bool_t ignored = FALSE;
-    gchar *ignored_code = NULL;
+    gchar *offsetpath = g_strconcat(queuepath, ".offset", NULL);
+    QueueTail tail;
+    bool_t success;
 
     pthread_mutex_lock(&log_access_mutex);
-    success = g_file_get_contents(queuepath, &contents, NULL, NULL);
+    success = read_queue_tail(queuepath, offsetpath, &tail);
     pthread_mutex_unlock(&log_access_mutex);
+
     if (!success) {
         AUDDBG("Couldn't access the queue file.\n");
-    } else {
+        g_free(queuepath);
+        g_free(offsetpath);
+        return;
+    }
 
-        lines = g_strsplit(contents, "\n", 0);
+    gchar **batch[SCROBBLE_BATCH_SIZE];
+    size_t batch_ends[SCROBBLE_BATCH_SIZE]; //where each line of the batch ends in tail.data
+    int n_batch = 0;
+    size_t consumed = 0; //the lines before this need not be sent again
+    GString *requeue = g_string_new(NULL);
 
-        for (int i = 0; lines[i] != NULL && strlen(lines[i]) > 0 && scrobbling_enabled; i++) {
-            line = g_strsplit(lines[i], "\t", 0);
+    char *line = tail.data;
+    char *end = tail.data + tail.len;
 
-            //line[0] line[1] line[2] line[3] line[4] line[5] line[6]   line[7]
-            //artist  album   title   number  length  "L"     timestamp NULL
+    while (scrobbling_enabled) {
+        char *newline = memchr(line, '\n', end - line);
 
-            if (line[0] && line[2] && (strcmp(line[5], "L") == 0) && line[6] && (line[7] == NULL)) {
-                scrobblemsg = create_message_to_lastfm("track.scrobble",
-                                                       8,
-                                                       "artist", line[0],
-                                                       "album", line[1],
-                                                       "track", line[2],
-                                                       "trackNumber", line[3],
-                                                       "duration", line[4],
-                                                       "timestamp", line[6],
-                                                       "api_key", SCROBBLER_API_KEY,
-                                                       "sk", session_key);
-                if (send_message_to_lastfm(scrobblemsg) == TRUE) {
-                    error_code = NULL;
-                    error_detail = NULL;
-                    if (read_scrobble_result(&error_code, &error_detail, &ignored, &ignored_code) == TRUE) {
-                        AUDDBG("SCROBBLE OK. Error code: %s. Error detail: %s\n", error_code, error_detail);
-                        AUDDBG("SCROBBLE OK. ignored: %i.\n", ignored);
-                        AUDDBG("SCROBBLE OK. ignored code: %s.\n", ignored_code);
-                        if (ignored == TRUE && g_strcmp0(ignored_code, "3") == 0) { //3: Timestamp was too old
-                            AUDDBG("SCROBBLE IGNORED!!! %i, detail: %s\n", ignored, ignored_code);
-                            save_line_to_remove(&lines_to_retry, i);
-                        } else if (ignored == TRUE && g_strcmp0(ignored_code, "") == 0) { //5: Daily scrobble limit reached
-                           //TODO: a track might not be scrobbled due to "daily scrobble limit exeeded".
-                           //This message comes on the ignoredMessage attribute, inside the XML of the response.
-                           //We are not dealing with this case currently and are losing that scrobble.
-                           //TODO
-
-                        } else {
-                            AUDDBG("Not ignored. Carrying on...\n");
-                            save_line_to_remove(&lines_to_remove, i);
-                        }
-                    } else {
-                        AUDDBG("SCROBBLE NOT OK. Error code: %s. Error detail: %s.\n", error_code, error_detail);
-
-                        if (error_code == NULL) { //net error(?) or the answer from last.fm was not well read
-                            //scrobble to be retried
-                        }
-                        else if (g_strcmp0(error_code, "11") == 0 ||
-                                 g_strcmp0(error_code, "16") == 0){
-                            //error code 11: Service Offline - This service is temporarily offline. Try again later.
-                            //error code 16: The service is temporarily unavailable, please try again.
-                            //scrobble to be retried
-                        }
-                        else if (g_strcmp0(error_code,  "9") == 0) {
-                            //Bad Session. Reauth.
-                            scrobbling_enabled = FALSE;
-                            g_free(session_key);
-                            session_key = NULL;
-                            aud_set_string("scrobbler", "session_key", "");
-                        }
-                        else {
-                            save_line_to_remove(&lines_to_remove, i);
-                        }
-                    }
-
-                    g_free(error_code);
-                    g_free(error_detail);
+        if (newline != NULL) {
+            *newline = '\0';
+            gchar **fields = g_strsplit(line, "\t", 0);
+            line = newline + 1;
 
-                } else {
-                    AUDDBG("Could not scrobble a track on the queue. Network problem?\n");
-                    //scrobble to be retried
-                    scrobbling_enabled = FALSE;
-                }
+            //line[0] line[1] line[2] line[3] line[4] line[5] line[6]   line[7]
+            //artist  album   title   number  length  "L"     timestamp NULL
 
-                g_free(scrobblemsg);
-                //TODO: Avoid spamming last.fm --- It's not as simple as just adding a wait here:
-                //If audacious is closed while we're on this loop, tracks might be re-scrobbled.
-                //This shall be doable if we only pick one track at a time from the scrobbler.log
+            if (g_strv_length(fields) == 7 && strcmp(fields[5], "L") == 0) {
+                batch[n_batch] = fields;
+                batch_ends[n_batch] = line - tail.data;
+                n_batch++;
             } else {
                 AUDDBG("Unscrobbable line.\n");
-                //leave entry on the cache file
+                g_strfreev(fields);
             }
-            g_strfreev(line);
-        }//for
+        }
 
+        if (n_batch > 0 && (n_batch == SCROBBLE_BATCH_SIZE || newline == NULL)) {
+            int done = submit_scrobble_batch(batch, n_batch, requeue);
 
-        delete_lines_from_scrobble_log(&lines_to_remove, &lines_to_retry, queuepath);
+            //commit every batch as it is done, so that after a crash at most
+            //the batch in flight is sent again
+            if (done > 0) {
+                consumed = batch_ends[done - 1];
+                commit_queue(queuepath, offsetpath, requeue, tail.offset + consumed, FALSE);
+            }
+            for (int i = 0; i < n_batch; i++) {
+                g_strfreev(batch[i]);
+            }
+            if (done < n_batch) {
+                n_batch = 0;
+                break;
+            }
+            n_batch = 0;
+        }
 
-        if (lines_to_remove != NULL) {
-            g_slist_free_full(lines_to_remove, g_free);
+        //skipped lines only count as consumed once the tracks before them are
+        if (n_batch == 0) {
+            consumed = line - tail.data;
         }
-        if (lines_to_retry != NULL) {
-            g_slist_free_full(lines_to_retry, g_free);
+        if (newline == NULL) {
+            break;
         }
+    }
 
-        g_strfreev(lines);
+    //scrobbling was disabled while a batch was being gathered
+    for (int i = 0; i < n_batch; i++) {
+        g_strfreev(batch[i]);
     }
 
-    g_free(contents);
+    //this also covers unscrobbable lines after the last batch, and is the
+    //only point where the log may be compacted
+    if (consumed > 0 || requeue->len > 0) {
+        commit_queue(queuepath, offsetpath, requeue, tail.offset + consumed, TRUE);
+    }
+
+    g_string_free(requeue, TRUE);
+    g_free(tail.data);
     g_free(queuepath);
+    g_free(offsetpath);
 }
 
 
@@ -204,6 +204,79 @@ bool_t read_scrobble_result(char **error_code_out, char **error_detail_out, bool
     return result;
 }
 
+/*
+ * The same as read_scrobble_result(), for a track.scrobble request carrying
+ * n_tracks tracks. On success, ignored_codes_out[i] is NULL if the i-th track
+ * was scrobbled OK, or holds the code it was ignored with.
+ */
+bool_t read_scrobble_batch_result(char **error_code_out, char **error_detail_out, int n_tracks, char **ignored_codes_out) {
+    xmlChar *status;
+    xmlChar *error_code = NULL;
+    xmlChar *error_detail = NULL;
+
+    bool_t result = TRUE;
+
+    for (int i = 0; i < n_tracks; i++) {
+        ignored_codes_out[i] = NULL;
+    }
+
+    if (!prepare_data()) {
+        AUDDBG("Could not read received data from last.fm. What's up?\n");
+        return FALSE;
+    }
+
+    status = check_status(&error_code, &error_detail);
+    (*error_code_out) = g_strdup((gchar *) error_code);
+    (*error_detail_out) = g_strdup((gchar *) error_detail);
+
+
+    if (status == NULL || xmlStrlen(status) == 0) {
+        AUDDBG("Status was NULL. Invalid API answer.\n");
+        clean_data();
+        return FALSE;
+    }
+
+    if (xmlStrEqual(status, (xmlChar *) "failed")) {
+        AUDDBG("Error code: %s. Detail: %s.\n", error_code, error_detail);
+        result = FALSE;
+
+    } else {
+        xmlChar *ignored_scrobbles = get_attribute_value((xmlChar *) "/lfm/scrobbles[@ignored]", (xmlChar *) "ignored");
+
+        //only look for the ignored tracks if there are any
+        if (ignored_scrobbles != NULL && ! xmlStrEqual(ignored_scrobbles, (xmlChar *) "0")) {
+            for (int i = 0; i < n_tracks; i++) {
+                gchar *expression = g_strdup_printf("/lfm/scrobbles/scrobble[%i]/ignoredMessage[@code]", i + 1);
+                xmlChar *ignored_code = get_attribute_value((xmlChar *) expression, (xmlChar *) "code");
+
+                if (ignored_code != NULL && ! xmlStrEqual(ignored_code, (xmlChar *) "0")) {
+                    ignored_codes_out[i] = g_strdup((gchar *) ignored_code);
+                    AUDDBG("track %i ignored, ignored_code: %s\n", i, ignored_code);
+                }
+                if (ignored_code != NULL) {
+                    xmlFree(ignored_code);
+                }
+                g_free(expression);
+            }
+        }
+        if (ignored_scrobbles != NULL) {
+            xmlFree(ignored_scrobbles);
+        }
+    }
+
+
+    xmlFree(status);
+    if (error_code != NULL) {
+        xmlFree(error_code);
+    }
+    if (error_detail != NULL) {
+        xmlFree(error_detail);
+    }
+
+    clean_data();
+    return result;
+}
+
 //returns
 //FALSE if there was an error with the connection
 bool_t read_authentication_test_result (char **error_code_out, char **error_detail_out) {
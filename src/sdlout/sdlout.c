@@ -32,6 +32,7 @@
 #include <audacious/misc.h>
 #include <audacious/plugin.h>
 
+#include "../common/sample_convert.h"
 #include "sdlout.h"
 
 #define VOLUME_RANGE 40 /* decibels */
@@ -50,6 +51,7 @@ static pthread_mutex_t sdlout_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t sdlout_cond = PTHREAD_COND_INITIALIZER;
 
 static volatile int vol_left, vol_right;
+static volatile int factor_left, factor_right;
 
 static int sdlout_chan, sdlout_rate;
 
@@ -62,12 +64,25 @@ static char prebuffer_flag, paused_flag;
 static int block_delay;
 static struct timeval block_time;
 
+/* Convert a volume setting to a 16.16 fixed-point gain.  This involves a
+ * powf(), so it is done when the volume changes rather than in the audio
+ * callback. */
+static int volume_factor (int vol)
+{
+    if (vol == 0)
+        return 0;
+
+    return powf (10, (float) VOLUME_RANGE * (vol - 100) / 100 / 20) * 65536;
+}
+
 int sdlout_init (void)
 {
     aud_config_set_defaults ("sdlout", sdl_defaults);
 
     vol_left = aud_get_int ("sdlout", "vol_left");
     vol_right = aud_get_int ("sdlout", "vol_right");
+    factor_left = volume_factor (vol_left);
+    factor_right = volume_factor (vol_right);
 
     if (SDL_Init (SDL_INIT_AUDIO) < 0)
     {
@@ -93,44 +108,34 @@ void sdlout_set_volume (int left, int right)
 {
     vol_left = left;
     vol_right = right;
+    factor_left = volume_factor (left);
+    factor_right = volume_factor (right);
 
     aud_set_int ("sdlout", "vol_left", left);
     aud_set_int ("sdlout", "vol_right", right);
 }
 
+/* A factor of 65536 is unity gain, for which (x * 65536) >> 16 == x; the
+ * buffer is left untouched in that case. */
+
 static void apply_mono_volume (unsigned char * data, int len)
 {
-    int vol = MAX (vol_left, vol_right);
-    int factor = (vol == 0) ? 0 : powf (10, (float) VOLUME_RANGE * (vol - 100)
-     / 100 / 20) * 65536;
+    int factor = MAX (factor_left, factor_right);
 
-    int16_t * i = (int16_t *) data;
-    int16_t * end = (int16_t *) (data + len);
+    if (factor == 65536)
+        return;
 
-    while (i < end)
-    {
-        * i = ((int) * i * factor) >> 16;
-        i ++;
-    }
+    sample_gain_s16 ((int16_t *) data, 1, len / 2, & factor);
 }
 
 static void apply_stereo_volume (unsigned char * data, int len)
 {
-    int factor_left = (vol_left == 0) ? 0 : powf (10, (float) VOLUME_RANGE *
-     (vol_left - 100) / 100 / 20) * 65536;
-    int factor_right = (vol_right == 0) ? 0 : powf (10, (float) VOLUME_RANGE *
-     (vol_right - 100) / 100 / 20) * 65536;
+    int factors[2] = {factor_left, factor_right};
 
-    int16_t * i = (int16_t *) data;
-    int16_t * end = (int16_t *) (data + len);
+    if (factors[0] == 65536 && factors[1] == 65536)
+        return;
 
-    while (i < end)
-    {
-        * i = ((int) * i * factor_left) >> 16;
-        i ++;
-        * i = ((int) * i * factor_right) >> 16;
-        i ++;
-    }
+    sample_gain_s16 ((int16_t *) data, 2, len / 4, factors);
 }
 
 static void callback (void * user, unsigned char * buf, int len)
@@ -364,50 +364,57 @@ static void xs_get_song_tuple_info(Tuple *tuple, xs_tuneinfo_t *info, int subTun
 }
 
 
-static void xs_fill_subtunes(Tuple *tuple, xs_tuneinfo_t *info)
+static void xs_fill_subtunes(Tuple *tuple, xs_tuneinfo_t *info,
+    bool_t minOnly, int minTime)
 {
     int count, found;
     int subtunes[info->nsubTunes];
 
     for (found = count = 0; count < info->nsubTunes; count++) {
-        if (count + 1 == info->startTune || !xs_cfg.subAutoMinOnly ||
+        if (count + 1 == info->startTune || !minOnly ||
             info->subTunes[count].tuneLength < 0 ||
-            info->subTunes[count].tuneLength >= xs_cfg.subAutoMinTime)
+            info->subTunes[count].tuneLength >= minTime)
             subtunes[found ++] = count + 1;
     }
 
     tuple_set_subtunes (tuple, found, subtunes);
 }
 
+/*
+ * Called from the playlist scanner, possibly from several threads at
+ * once; nothing here touches the playback state in xs_status.
+ */
 Tuple * xs_probe_for_tuple(const char *filename, VFSFile *fd)
 {
     Tuple *tuple;
     xs_tuneinfo_t *info;
     int tune = -1;
+    bool_t autoEnable, minOnly;
+    int minTime;
 
-    pthread_mutex_lock(&xs_status_mutex);
-    if (!xs_sidplayfp_probe(fd)) {
-        pthread_mutex_unlock(&xs_status_mutex);
+    if (!xs_sidplayfp_probe(fd))
         return NULL;
-    }
-    pthread_mutex_unlock(&xs_status_mutex);
 
     /* Get information from URL */
     tuple = tuple_new_from_filename (filename);
     tune = tuple_get_int (tuple, FIELD_SUBSONG_NUM, NULL);
 
     /* Get tune information from emulation engine */
-    pthread_mutex_lock(&xs_status_mutex);
     info = xs_sidplayfp_getinfo (filename);
-    pthread_mutex_unlock(&xs_status_mutex);
 
     if (info == NULL)
         return tuple;
 
     xs_get_song_tuple_info(tuple, info, tune);
 
-    if (xs_cfg.subAutoEnable && info->nsubTunes > 1 && ! tune)
-        xs_fill_subtunes(tuple, info);
+    pthread_mutex_lock(&xs_cfg_mutex);
+    autoEnable = xs_cfg.subAutoEnable;
+    minOnly = xs_cfg.subAutoMinOnly;
+    minTime = xs_cfg.subAutoMinTime;
+    pthread_mutex_unlock(&xs_cfg_mutex);
+
+    if (autoEnable && info->nsubTunes > 1 && ! tune)
+        xs_fill_subtunes(tuple, info, minOnly, minTime);
 
     xs_tuneinfo_free(info);
 
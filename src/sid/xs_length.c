@@ -197,7 +197,7 @@ sldb_node_t * xs_sldb_read_entry(char *inLine)
 
 /* Read database to memory
  */
-int xs_sldb_read(xs_sldb_t *db, const char *dbFilename)
+static int xs_sldb_read(xs_sldb_t *db, const char *dbFilename)
 {
     FILE *inFile;
     char inLine[XS_BUF_SIZE];
@@ -282,7 +282,7 @@ static int xs_sldb_cmp(const void *node1, const void *node2)
 
 /* (Re)create index
  */
-int xs_sldb_index(xs_sldb_t * db)
+static int xs_sldb_index(xs_sldb_t * db)
 {
     sldb_node_t *pCurr;
     size_t i;
@@ -325,15 +325,12 @@ int xs_sldb_index(xs_sldb_t * db)
 }
 
 
-/* Free a given song-length database
+/* Free the parsed text database
  */
-void xs_sldb_free(xs_sldb_t * db)
+static void xs_sldb_free_nodes(xs_sldb_t * db)
 {
     sldb_node_t *pCurr, *next;
 
-    if (!db)
-        return;
-
     /* Free the memory allocated for nodes */
     pCurr = db->nodes;
     while (pCurr) {
@@ -350,8 +347,180 @@ void xs_sldb_free(xs_sldb_t * db)
         db->pindex = NULL;
     }
 
-    /* Free structure */
     db->n = 0;
+}
+
+
+/* Binary index layout (native byte order), after the common header and
+ * source path:
+ *   uint32_t     buckets[XS_SLDB_BUCKETS + 1]
+ *   sldb_entry_t entries[nitems]     (sorted by hash)
+ *   int32_t      lengths[naux]
+ */
+#define XS_SLDB_MAGIC   "XSLD"
+#define XS_SLDB_VERSION 2
+#define XS_SLDB_BUCKETS 65536
+
+static unsigned xs_sldb_bucket(const xs_md5hash_t hash)
+{
+    return (hash[0] << 8) | hash[1];
+}
+
+
+static size_t xs_sldb_image_size(size_t nentries, size_t nlengths)
+{
+    return sizeof(uint32_t) * (XS_SLDB_BUCKETS + 1) +
+        sizeof(sldb_entry_t) * nentries + sizeof(int32_t) * nlengths;
+}
+
+
+/* Point the lookup tables into a binary index image, checking that every
+ * bucket and length range stays inside it. Returns -1 if the image is
+ * inconsistent, in which case it must be rebuilt.
+ */
+static int xs_sldb_attach(xs_sldb_t *db, const char *image, size_t nentries,
+    size_t nlengths)
+{
+    const uint32_t *buckets = (const uint32_t *) image;
+    const sldb_entry_t *entries =
+        (const sldb_entry_t *) (buckets + XS_SLDB_BUCKETS + 1);
+    size_t i;
+
+    if (buckets[0] != 0 || buckets[XS_SLDB_BUCKETS] != nentries)
+        return -1;
+
+    for (i = 0; i < XS_SLDB_BUCKETS; i++) {
+        if (buckets[i] > buckets[i + 1])
+            return -1;
+    }
+
+    for (i = 0; i < nentries; i++) {
+        if (entries[i].first > nlengths ||
+            entries[i].nlengths > nlengths - entries[i].first)
+            return -1;
+    }
+
+    db->buckets = buckets;
+    db->entries = entries;
+    db->lengths = (const int32_t *) (entries + nentries);
+    db->nentries = nentries;
+    return 0;
+}
+
+
+/* Serialize the sorted text database into a binary index image
+ */
+static char *xs_sldb_build_image(xs_sldb_t *db, size_t *nlengths, size_t *size)
+{
+    uint32_t *buckets;
+    sldb_entry_t *entries;
+    int32_t *lengths;
+    size_t i, nl;
+    unsigned b;
+    char *image;
+    int j;
+
+    for (i = 0, nl = 0; i < db->n; i++)
+        nl += db->pindex[i]->nlengths;
+
+    *nlengths = nl;
+    *size = xs_sldb_image_size(db->n, nl);
+    image = g_malloc0(*size);
+
+    buckets = (uint32_t *) image;
+    entries = (sldb_entry_t *) (buckets + XS_SLDB_BUCKETS + 1);
+    lengths = (int32_t *) (entries + db->n);
+
+    for (i = 0, b = 0, nl = 0; i < db->n; i++) {
+        sldb_node_t *node = db->pindex[i];
+
+        while (b <= xs_sldb_bucket(node->md5Hash))
+            buckets[b++] = i;
+
+        memcpy(entries[i].md5Hash, node->md5Hash, XS_MD5HASH_LENGTH);
+        entries[i].first = nl;
+        entries[i].nlengths = node->nlengths;
+
+        for (j = 0; j < node->nlengths; j++)
+            lengths[nl++] = node->lengths[j];
+    }
+
+    while (b <= XS_SLDB_BUCKETS)
+        buckets[b++] = db->n;
+
+    return image;
+}
+
+
+/* Open a song-length database. The text file is parsed only when its
+ * binary index is missing or out of date; otherwise the index is mapped.
+ */
+int xs_sldb_open(xs_sldb_t *db, const char *dbFilename)
+{
+    char *idxFilename, *image;
+    size_t nlengths, size;
+    assert(db);
+
+    idxFilename = xs_index_filename("sldb", dbFilename);
+
+    db->map = xs_index_map(idxFilename, dbFilename, XS_SLDB_MAGIC, XS_SLDB_VERSION);
+    if (db->map) {
+        const xs_index_header_t *hdr =
+            (const xs_index_header_t *) g_mapped_file_get_contents(db->map);
+        const char *data = xs_index_data(db->map, &size);
+
+        if (size != xs_sldb_image_size(hdr->nitems, hdr->naux) ||
+            xs_sldb_attach(db, data, hdr->nitems, hdr->naux) != 0) {
+            g_mapped_file_unref(db->map);
+            db->map = NULL;
+        }
+    }
+
+    if (!db->map) {
+        if (xs_sldb_read(db, dbFilename) != 0 || xs_sldb_index(db) != 0) {
+            g_free(idxFilename);
+            return -1;
+        }
+
+        image = xs_sldb_build_image(db, &nlengths, &size);
+
+        if (xs_index_save(idxFilename, XS_SLDB_MAGIC, XS_SLDB_VERSION,
+            dbFilename, image, size, db->n, nlengths) == 0 &&
+            (db->map = xs_index_map(idxFilename, dbFilename, XS_SLDB_MAGIC, XS_SLDB_VERSION)) != NULL) {
+            g_free(image);
+            image = (char *) xs_index_data(db->map, &size);
+        } else
+            db->image = image;
+
+        xs_sldb_attach(db, image, db->n, nlengths);
+        xs_sldb_free_nodes(db);
+    }
+
+    g_free(idxFilename);
+
+    db->hashCache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    return 0;
+}
+
+
+/* Free a given song-length database
+ */
+void xs_sldb_free(xs_sldb_t * db)
+{
+    if (!db)
+        return;
+
+    xs_sldb_free_nodes(db);
+
+    if (db->map)
+        g_mapped_file_unref(db->map);
+
+    g_free(db->image);
+
+    if (db->hashCache)
+        g_hash_table_destroy(db->hashCache);
+
+    /* Free structure */
     free(db);
 }
 
@@ -500,28 +669,38 @@ static int xs_get_sid_hash(const char *filename, xs_md5hash_t hash)
 }
 
 
-/* Get node from db index via binary search
+/* Get song lengths from db index via hash-prefix bucket probe.
+ * The returned array stays valid until the database is closed.
  */
-sldb_node_t *xs_sldb_get(xs_sldb_t *db, const char *filename)
+const int32_t *xs_sldb_get(xs_sldb_t *db, const char *filename, int *nlengths)
 {
-    sldb_node_t keyItem, *key, **item;
+    xs_md5hash_t hash, *cached;
+    const sldb_entry_t *entry, *end;
+    unsigned b;
 
     /* Check the database pointers */
-    if (!db || !db->nodes || !db->pindex)
+    if (!db || !db->entries)
         return NULL;
 
-    /* Get the hash and then look up from db */
-    if (xs_get_sid_hash(filename, keyItem.md5Hash) == 0) {
-        key = &keyItem;
-        item = bsearch(&key, db->pindex, db->n,
-            sizeof(db->pindex[0]), xs_sldb_cmp);
-
-        if (item)
-            return *item;
-        else
-            return NULL;
-    } else
+    /* Get the hash, computing it only the first time a file is seen */
+    if ((cached = g_hash_table_lookup(db->hashCache, filename)) != NULL)
+        memcpy(hash, *cached, sizeof(hash));
+    else if (xs_get_sid_hash(filename, hash) == 0)
+        g_hash_table_insert(db->hashCache, g_strdup(filename),
+            g_memdup(hash, sizeof(hash)));
+    else
         return NULL;
-}
 
+    /* Look up from db */
+    b = xs_sldb_bucket(hash);
+    end = db->entries + db->buckets[b + 1];
 
+    for (entry = db->entries + db->buckets[b]; entry < end; entry++) {
+        if (memcmp(entry->md5Hash, hash, XS_MD5HASH_LENGTH) == 0) {
+            *nlengths = entry->nlengths;
+            return db->lengths + entry->first;
+        }
+    }
+
+    return NULL;
+}
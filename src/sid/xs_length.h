@@ -1,7 +1,9 @@
 #ifndef XS_LENGTH_H
 #define XS_LENGTH_H
 
+#include <stdint.h>
 #include <sys/types.h>
+#include <glib.h>
 
 #include "xs_md5.h"
 
@@ -19,19 +21,35 @@ typedef struct _sldb_node_t {
 } sldb_node_t;
 
 
+/* Binary index record; lengths are stored in a separate array */
 typedef struct {
-    sldb_node_t     *nodes,
+    xs_md5hash_t    md5Hash;
+    uint32_t        first;      /* Index of first length */
+    uint32_t        nlengths;   /* Number of lengths */
+} sldb_entry_t;
+
+
+typedef struct {
+    sldb_node_t     *nodes,     /* Parsed text database (while indexing) */
                     **pindex;
     size_t          n;
+
+    GMappedFile     *map;       /* Binary index, mapped from disk ... */
+    char            *image;     /* ... or kept in memory if it can't be saved */
+    const uint32_t  *buckets;   /* First entry for each 16-bit hash prefix */
+    const sldb_entry_t *entries;
+    const int32_t   *lengths;
+    size_t          nentries;
+
+    GHashTable      *hashCache; /* Filename -> MD5-hash of the SID-file */
 } xs_sldb_t;
 
 
 /* Functions
  */
-int            xs_sldb_read(xs_sldb_t *, const char *);
-int            xs_sldb_index(xs_sldb_t *);
+int            xs_sldb_open(xs_sldb_t *, const char *);
 void            xs_sldb_free(xs_sldb_t *);
-sldb_node_t *   xs_sldb_get(xs_sldb_t *, const char *);
+const int32_t * xs_sldb_get(xs_sldb_t *, const char *, int *);
 
 #ifdef __cplusplus
 }
@@ -27,6 +27,7 @@
 #include "xs_sidplay2.h"
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -328,7 +329,8 @@ void xs_sidplayfp_delete(xs_status_t * status)
 
 xs_tuneinfo_t* xs_sidplayfp_getinfo(const char *sidFilename)
 {
-    /* This is safe, since xmms-sid.c always calls us with xs_status locked */
+    /* Shared by all scanner threads; the tune itself is private */
+    static pthread_mutex_t db_mutex = PTHREAD_MUTEX_INITIALIZER;
     static int got_db = -1;
     static SidDatabase database;
 
@@ -363,6 +365,8 @@ xs_tuneinfo_t* xs_sidplayfp_getinfo(const char *sidFilename)
         myInfo->loadAddr(), myInfo->initAddr(), myInfo->playAddr(),
         myInfo->dataFileLen(), myInfo->formatString(), myInfo->sidModel1());
 
+    pthread_mutex_lock(&db_mutex);
+
     for (int i = 0; i < result->nsubTunes; i++) {
         if (result->subTunes[i].tuneLength >= 0)
             continue;
@@ -376,6 +380,8 @@ xs_tuneinfo_t* xs_sidplayfp_getinfo(const char *sidFilename)
         }
     }
 
+    pthread_mutex_unlock(&db_mutex);
+
     delete myTune;
 
     return result;
@@ -62,8 +62,8 @@ int xs_stil_init(void)
         return -2;
     }
 
-    /* Read the database */
-    if (xs_stildb_read(xs_stildb_db, xs_cfg.stilDBPath) != 0) {
+    /* Map the database and its index */
+    if (xs_stildb_open(xs_stildb_db, xs_cfg.stilDBPath) != 0) {
         xs_stildb_free(xs_stildb_db);
         xs_stildb_db = NULL;
         pthread_mutex_unlock(&xs_cfg_mutex);
@@ -71,15 +71,6 @@ int xs_stil_init(void)
         return -3;
     }
 
-    /* Create index */
-    if (xs_stildb_index(xs_stildb_db) != 0) {
-        xs_stildb_free(xs_stildb_db);
-        xs_stildb_db = NULL;
-        pthread_mutex_unlock(&xs_cfg_mutex);
-        pthread_mutex_unlock(&xs_stildb_db_mutex);
-        return -4;
-    }
-
     pthread_mutex_unlock(&xs_cfg_mutex);
     pthread_mutex_unlock(&xs_stildb_db_mutex);
     return 0;
@@ -155,8 +146,8 @@ int xs_songlen_init(void)
         return -2;
     }
 
-    /* Read the database */
-    if (xs_sldb_read(xs_sldb_db, xs_cfg.songlenDBPath) != 0) {
+    /* Map the database index, (re)building it if necessary */
+    if (xs_sldb_open(xs_sldb_db, xs_cfg.songlenDBPath) != 0) {
         xs_sldb_free(xs_sldb_db);
         xs_sldb_db = NULL;
         pthread_mutex_unlock(&xs_cfg_mutex);
@@ -164,15 +155,6 @@ int xs_songlen_init(void)
         return -3;
     }
 
-    /* Create index */
-    if (xs_sldb_index(xs_sldb_db) != 0) {
-        xs_sldb_free(xs_sldb_db);
-        xs_sldb_db = NULL;
-        pthread_mutex_unlock(&xs_cfg_mutex);
-        pthread_mutex_unlock(&xs_sldb_db_mutex);
-        return -4;
-    }
-
     pthread_mutex_unlock(&xs_cfg_mutex);
     pthread_mutex_unlock(&xs_sldb_db_mutex);
     return 0;
@@ -188,20 +170,29 @@ void xs_songlen_close(void)
 }
 
 
-sldb_node_t *xs_songlen_get(const char * filename)
+/* Copy up to maxLengths sub-tune lengths for the given file into lengths.
+ * Returns the number copied, or -1 if the file is not in the database.
+ */
+int xs_songlen_get(const char * filename, int *lengths, int maxLengths)
 {
-    sldb_node_t *result;
+    const int32_t *found = NULL;
+    int i, nlengths = 0;
 
     pthread_mutex_lock(&xs_sldb_db_mutex);
 
     if (xs_cfg.songlenDBEnable && xs_sldb_db)
-        result = xs_sldb_get(xs_sldb_db, filename);
-    else
-        result = NULL;
+        found = xs_sldb_get(xs_sldb_db, filename, &nlengths);
+
+    if (found) {
+        if (nlengths > maxLengths)
+            nlengths = maxLengths;
+        for (i = 0; i < nlengths; i++)
+            lengths[i] = found[i];
+    }
 
     pthread_mutex_unlock(&xs_sldb_db_mutex);
 
-    return result;
+    return found ? nlengths : -1;
 }
 
 
@@ -214,8 +205,7 @@ xs_tuneinfo_t *xs_tuneinfo_new(const char * filename,
         int dataFileLen, const char *sidFormat, int sidModel)
 {
     xs_tuneinfo_t *result;
-    sldb_node_t *tmpLength;
-    int i;
+    int i, nlengths;
 
     /* Allocate structure */
     result = (xs_tuneinfo_t *) g_malloc0(sizeof(xs_tuneinfo_t));
@@ -260,13 +250,14 @@ xs_tuneinfo_t *xs_tuneinfo_new(const char * filename,
 
     result->sidModel = sidModel;
 
-    /* Get length information (NOTE: Do not free this!) */
-    tmpLength = xs_songlen_get(filename);
+    /* Get length information */
+    int lengths[nsubTunes + 1];
+    nlengths = xs_songlen_get(filename, lengths, nsubTunes);
 
     /* Fill in sub-tune information */
     for (i = 0; i < result->nsubTunes; i++) {
-        if (tmpLength && (i < tmpLength->nlengths))
-            result->subTunes[i].tuneLength = tmpLength->lengths[i];
+        if (i < nlengths)
+            result->subTunes[i].tuneLength = lengths[i];
         else
             result->subTunes[i].tuneLength = -1;
 
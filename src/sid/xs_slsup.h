@@ -15,7 +15,7 @@ stil_node_t *xs_stil_get(char *filename);
 
 int xs_songlen_init(void);
 void xs_songlen_close(void);
-sldb_node_t *xs_songlen_get(const char *filename);
+int xs_songlen_get(const char *filename, int *lengths, int maxLengths);
 
 xs_tuneinfo_t *xs_tuneinfo_new(const char *pcFilename, int nsubTunes,
  int startTune, const char *sidName, const char *sidComposer,
@@ -145,7 +145,8 @@ static void xs_stildb_node_insert(xs_stildb_t *db, stil_node_t *node)
 }
 
 
-/* Read database (additively) to given db-structure
+/* Parse the STIL entry starting at data (a '/'-line) and add it to the
+ * db's list of parsed nodes. Parsing stops at the end of the entry.
  */
 #define XS_STILDB_MULTI                                         \
     if (multi) {                                                \
@@ -164,32 +165,38 @@ static void XS_STILDB_ERR(int linenum, char *line, const char *fmt, ...)
     xs_error("#%d: '%s'\n", linenum, line);
 }
 
-int xs_stildb_read(xs_stildb_t *db, char *filename)
+static stil_node_t *xs_stildb_parse_entry(xs_stildb_t *db, const char *data, size_t size)
 {
-    FILE *f;
     char line[XS_BUF_SIZE + 16];    /* Since we add some chars here and there */
     stil_node_t *node;
-    bool_t error, multi;
+    bool_t error, done, multi;
     int lineNum, subEntry;
+    size_t pos, lineLen;
+    const char *eol;
     char *tmpLine = line;
     assert(db != NULL);
 
-    /* Try to open the file */
-    if ((f = fopen(filename, "r")) == NULL) {
-        xs_error("Could not open STILDB '%s'\n", filename);
-        return -1;
-    }
-
     /* Read and parse the data */
     lineNum = 0;
     error = FALSE;
+    done = FALSE;
     multi = FALSE;
     node = NULL;
     subEntry = 0;
+    pos = 0;
 
-    while (!error && fgets(line, XS_BUF_SIZE, f) != NULL) {
+    while (!error && !done && pos < size) {
         size_t linePos = 0, eolPos = 0;
-        line[XS_BUF_SIZE] = 0;
+
+        eol = memchr(data + pos, '\n', size - pos);
+        lineLen = (eol ? (size_t) (eol - data) : size) - pos;
+        if (lineLen > XS_BUF_SIZE)
+            lineLen = XS_BUF_SIZE;
+
+        memcpy(line, data + pos, lineLen);
+        line[lineLen] = 0;
+        pos = eol ? (size_t) (eol - data) + 1 : size;
+
         xs_findeol(line, &eolPos);
         line[eolPos] = 0;
         lineNum++;
@@ -198,14 +205,11 @@ int xs_stildb_read(xs_stildb_t *db, char *filename)
 
         switch (tmpLine[0]) {
         case '/':
-            /* Check if we are already parsing entry */
+            /* A following entry ends the current one */
             multi = FALSE;
             if (node != NULL) {
-                XS_STILDB_ERR(lineNum, tmpLine,
-                    "New entry found before end of current ('%s')!\n",
-                    node->filename);
-                xs_stildb_node_free(node);
-                node = NULL;
+                done = TRUE;
+                break;
             }
 
             /* A new node */
@@ -256,10 +260,8 @@ int xs_stildb_read(xs_stildb_t *db, char *filename)
         case '\r':
             /* End of entry/field */
             multi = FALSE;
-            if (node != NULL) {
-                xs_stildb_node_insert(db, node);
-                node = NULL;
-            }
+            if (node != NULL)
+                done = TRUE;
             break;
 
         default:
@@ -316,68 +318,153 @@ int xs_stildb_read(xs_stildb_t *db, char *filename)
         free(tmpLine);
     } /* while */
 
-    /* Check if there is one remaining node */
+    if (error) {
+        xs_stildb_node_free(node);
+        return NULL;
+    }
+
     if (node != NULL)
         xs_stildb_node_insert(db, node);
 
-    /* Close the file */
-    fclose(f);
+    return node;
+}
 
-    return 0;
+
+/* Binary index layout (native byte order), after the common header and
+ * source path:
+ *   uint32_t offsets[nitems]   (entry start offsets in STIL.txt,
+ *                               sorted by entry filename)
+ */
+#define XS_STILDB_MAGIC   "XSTI"
+#define XS_STILDB_VERSION 2
+
+/* Compare a filename with the '/'-line of the entry at given offset
+ */
+static int xs_stildb_cmp(const char *filename, const char *text, size_t size, uint32_t offset)
+{
+    const char *entry = text + offset;
+    size_t len = 0;
+
+    while (offset + len < size && entry[len] != '\n' && entry[len] != '\r')
+        len++;
+
+    int d = strncmp(filename, entry, len);
+    if (d == 0 && filename[len] != 0)
+        d = 1;
+
+    return d;
 }
 
 
-/* Compare two nodes
+static int xs_stildb_cmp_offsets(const void *p1, const void *p2, void *user)
+{
+    xs_stildb_t *db = user;
+    const char *text = g_mapped_file_get_contents(db->text);
+    size_t size = g_mapped_file_get_length(db->text);
+    uint32_t o1 = *(const uint32_t *) p1, o2 = *(const uint32_t *) p2;
+    size_t len = 0;
+
+    /* Terminated copy of the first entry's filename */
+    while (o1 + len < size && text[o1 + len] != '\n' && text[o1 + len] != '\r')
+        len++;
+
+    char name[len + 1];
+    memcpy(name, text + o1, len);
+    name[len] = 0;
+
+    return xs_stildb_cmp(name, text, size, o2);
+}
+
+
+/* Find all entries in the mapped STIL.txt and sort them by filename
  */
-static int xs_stildb_cmp(const void *node1, const void *node2)
+static uint32_t *xs_stildb_build_index(xs_stildb_t *db, size_t *n)
 {
-    /* We assume here that we never ever get NULL-pointers or similar */
-    return strcmp(
-        (*(stil_node_t **) node1)->filename,
-        (*(stil_node_t **) node2)->filename);
+    const char *text = g_mapped_file_get_contents(db->text);
+    size_t size = g_mapped_file_get_length(db->text);
+    GArray *offsets = g_array_new(FALSE, FALSE, sizeof(uint32_t));
+    size_t pos = 0;
+    const char *eol;
+
+    while (pos < size) {
+        if (text[pos] == '/') {
+            uint32_t offset = pos;
+            g_array_append_val(offsets, offset);
+        }
+
+        if ((eol = memchr(text + pos, '\n', size - pos)) == NULL)
+            break;
+        pos = (eol - text) + 1;
+    }
+
+    g_qsort_with_data(offsets->data, offsets->len, sizeof(uint32_t),
+        xs_stildb_cmp_offsets, db);
+
+    *n = offsets->len;
+    return (uint32_t *) g_array_free(offsets, FALSE);
 }
 
 
-/* (Re)create index
+/* Check that every offset in a mapped index points into STIL.txt
  */
-int xs_stildb_index(xs_stildb_t *db)
+static int xs_stildb_check_index(xs_stildb_t *db, const uint32_t *index, size_t n)
 {
-    stil_node_t *curr;
+    size_t size = g_mapped_file_get_length(db->text);
     size_t i;
 
-    /* Free old index */
-    if (db->pindex) {
-        free(db->pindex);
-        db->pindex = NULL;
+    for (i = 0; i < n; i++) {
+        if (index[i] >= size)
+            return FALSE;
     }
 
-    /* Get size of db */
-    curr = db->nodes;
-    db->n = 0;
-    while (curr) {
-        db->n++;
-        curr = curr->next;
+    return TRUE;
+}
+
+
+/* Open a STIL database. Entries are located through a binary index of
+ * the memory-mapped STIL.txt and parsed only when first looked up.
+ */
+int xs_stildb_open(xs_stildb_t *db, const char *filename)
+{
+    char *idxFilename;
+    assert(db != NULL);
+
+    /* Try to map the file */
+    if ((db->text = g_mapped_file_new(filename, FALSE, NULL)) == NULL) {
+        xs_error("Could not open STILDB '%s'\n", filename);
+        return -1;
     }
 
-    /* Check number of nodes */
-    if (db->n > 0) {
-        /* Allocate memory for index-table */
-        db->pindex = (stil_node_t **) malloc(sizeof(stil_node_t *) * db->n);
-        if (!db->pindex)
-            return -1;
-
-        /* Get node-pointers to table */
-        i = 0;
-        curr = db->nodes;
-        while (curr && (i < db->n)) {
-            db->pindex[i++] = curr;
-            curr = curr->next;
+    idxFilename = xs_index_filename("stil", filename);
+
+    db->map = xs_index_map(idxFilename, filename, XS_STILDB_MAGIC, XS_STILDB_VERSION);
+    if (db->map) {
+        const xs_index_header_t *hdr =
+            (const xs_index_header_t *) g_mapped_file_get_contents(db->map);
+        size_t size;
+        const uint32_t *index = xs_index_data(db->map, &size);
+
+        if (size != sizeof(uint32_t) * hdr->nitems ||
+            !xs_stildb_check_index(db, index, hdr->nitems)) {
+            g_mapped_file_unref(db->map);
+            db->map = NULL;
+        } else {
+            db->index = index;
+            db->n = hdr->nitems;
         }
+    }
+
+    if (!db->map) {
+        db->offsets = xs_stildb_build_index(db, &db->n);
+        db->index = db->offsets;
 
-        /* Sort the indexes */
-        qsort(db->pindex, db->n, sizeof(stil_node_t *), xs_stildb_cmp);
+        xs_index_save(idxFilename, XS_STILDB_MAGIC, XS_STILDB_VERSION,
+            filename, db->offsets, sizeof(uint32_t) * db->n, db->n, 0);
     }
 
+    g_free(idxFilename);
+
+    db->parsed = g_new0(stil_node_t *, db->n);
     return 0;
 }
 
@@ -401,11 +488,14 @@ void xs_stildb_free(xs_stildb_t *db)
 
     db->nodes = NULL;
 
-    /* Free memory allocated for index */
-    if (db->pindex) {
-        free(db->pindex);
-        db->pindex = NULL;
-    }
+    /* Free index and mappings */
+    g_free(db->parsed);
+    g_free(db->offsets);
+
+    if (db->map)
+        g_mapped_file_unref(db->map);
+    if (db->text)
+        g_mapped_file_unref(db->text);
 
     /* Free structure */
     db->n = 0;
@@ -417,18 +507,34 @@ void xs_stildb_free(xs_stildb_t *db)
  */
 stil_node_t *xs_stildb_get_node(xs_stildb_t *db, char *filename)
 {
-    stil_node_t keyItem, *key, **item;
+    const char *text;
+    size_t size, lo, hi, mid;
+    int d;
 
     /* Check the database pointers */
-    if (!db || !db->nodes || !db->pindex)
+    if (!db || !db->text || !db->index)
         return NULL;
 
+    text = g_mapped_file_get_contents(db->text);
+    size = g_mapped_file_get_length(db->text);
+
     /* Look-up index using binary search */
-    keyItem.filename = filename;
-    key = &keyItem;
-    item = bsearch(&key, db->pindex, db->n, sizeof(stil_node_t *), xs_stildb_cmp);
-    if (item)
-        return *item;
-    else
-        return NULL;
+    lo = 0;
+    hi = db->n;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        d = xs_stildb_cmp(filename, text, size, db->index[mid]);
+
+        if (d == 0) {
+            if (!db->parsed[mid])
+                db->parsed[mid] = xs_stildb_parse_entry(db,
+                    text + db->index[mid], size - db->index[mid]);
+            return db->parsed[mid];
+        } else if (d < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return NULL;
 }
@@ -1,7 +1,9 @@
 #ifndef XS_STIL_H
 #define XS_STIL_H
 
+#include <stdint.h>
 #include <sys/types.h>
+#include <glib.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,15 +25,19 @@ typedef struct _stil_node_t {
 
 
 typedef struct {
-    stil_node_t *nodes, **pindex;
+    stil_node_t *nodes;         /* Entries parsed so far */
+    GMappedFile *text,          /* STIL.txt */
+        *map;                   /* Binary index, if it could be mapped */
+    uint32_t *offsets;          /* Index built in memory otherwise */
+    const uint32_t *index;      /* Sorted entry offsets in STIL.txt */
+    stil_node_t **parsed;       /* Parsed node for each index position */
     size_t n;
 } xs_stildb_t;
 
 
 /* Functions
  */
-int xs_stildb_read(xs_stildb_t *, char *);
-int xs_stildb_index(xs_stildb_t *);
+int xs_stildb_open(xs_stildb_t *, const char *);
 void xs_stildb_free(xs_stildb_t *);
 stil_node_t *xs_stildb_get_node(xs_stildb_t *, char *);
 
@@ -24,8 +24,12 @@
 #include "xs_support.h"
 
 #include <ctype.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+
+#include "xmms-sid.h"
 
 uint16_t xs_fread_be16(VFSFile *f)
 {
@@ -107,3 +111,121 @@ void xs_findnum(const char *str, size_t *pos)
         (*pos)++;
 }
 
+
+
+/* Get the location of the binary index for a given text database.
+ * Indexes can always be rebuilt, so they live in the user's cache
+ * directory, one per source path.
+ */
+char *xs_index_filename(const char *prefix, const char *srcFilename)
+{
+    char *name = g_strdup_printf("%s-%08x.idx", prefix, g_str_hash(srcFilename));
+    char *path = g_build_filename(g_get_user_cache_dir(), "audacious", "sid",
+        name, NULL);
+
+    g_free(name);
+    return path;
+}
+
+
+/* Space taken by the source path after the header
+ */
+static size_t xs_index_path_size(size_t len)
+{
+    return (len + 1 + 7) & ~(size_t) 7;
+}
+
+
+/* Map a binary index and check that it is current for the source file.
+ * The index file is named after a hash of the source path, so the path
+ * stored in it is compared too, in case two databases share a hash.
+ * Returns NULL if the index is missing, stale or of another format.
+ */
+GMappedFile *xs_index_map(const char *idxFilename, const char *srcFilename,
+    const char *magic, uint32_t version)
+{
+    GMappedFile *map;
+    const xs_index_header_t *hdr;
+    size_t len = strlen(srcFilename);
+    struct stat st;
+
+    if (stat(srcFilename, &st) != 0)
+        return NULL;
+
+    if ((map = g_mapped_file_new(idxFilename, FALSE, NULL)) == NULL)
+        return NULL;
+
+    hdr = (const xs_index_header_t *) g_mapped_file_get_contents(map);
+
+    if (g_mapped_file_get_length(map) < sizeof(xs_index_header_t) +
+        xs_index_path_size(len) ||
+        memcmp(hdr->magic, magic, sizeof(hdr->magic)) ||
+        hdr->version != version ||
+        hdr->srcMtime != (int64_t) st.st_mtime ||
+        hdr->srcSize != (int64_t) st.st_size ||
+        hdr->srcPathLen != len ||
+        memcmp(hdr + 1, srcFilename, len + 1)) {
+        g_mapped_file_unref(map);
+        return NULL;
+    }
+
+    return map;
+}
+
+
+/* Get the payload of an index mapped by xs_index_map() and its size
+ */
+const void *xs_index_data(GMappedFile *map, size_t *size)
+{
+    const xs_index_header_t *hdr =
+        (const xs_index_header_t *) g_mapped_file_get_contents(map);
+    size_t skip = sizeof(xs_index_header_t) + xs_index_path_size(hdr->srcPathLen);
+
+    *size = g_mapped_file_get_length(map) - skip;
+    return (const char *) hdr + skip;
+}
+
+
+/* Write a binary index: a header describing the source file followed
+ * by the given payload. Returns 0 on success.
+ */
+int xs_index_save(const char *idxFilename, const char *magic, uint32_t version,
+    const char *srcFilename, const void *data, size_t size,
+    uint32_t nitems, uint32_t naux)
+{
+    xs_index_header_t *hdr;
+    size_t len = strlen(srcFilename), pathSize = xs_index_path_size(len);
+    struct stat st;
+    gboolean ok;
+    char *dir;
+
+    if (stat(srcFilename, &st) != 0)
+        return -1;
+
+    hdr = (xs_index_header_t *) g_malloc0(sizeof(xs_index_header_t) + pathSize + size);
+    memcpy(hdr->magic, magic, sizeof(hdr->magic));
+    hdr->version = version;
+    hdr->srcMtime = st.st_mtime;
+    hdr->srcSize = st.st_size;
+    hdr->nitems = nitems;
+    hdr->naux = naux;
+    hdr->srcPathLen = len;
+    memcpy(hdr + 1, srcFilename, len);
+    memcpy((char *) (hdr + 1) + pathSize, data, size);
+
+    dir = g_path_get_dirname(idxFilename);
+    g_mkdir_with_parents(dir, 0755);
+    g_free(dir);
+
+    ok = g_file_set_contents(idxFilename, (const char *) hdr,
+        sizeof(xs_index_header_t) + pathSize + size, NULL);
+
+    g_free(hdr);
+
+    if (!ok) {
+        xs_error("Could not write database index '%s'\n", idxFilename);
+        return -2;
+    }
+
+    return 0;
+}
@@ -5,7 +5,9 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
 #include <sys/types.h>
+#include <glib.h>
 #include <libaudcore/vfs.h>
 
 /* VFS replacement functions
@@ -22,6 +24,26 @@ void xs_findnext(const char *, size_t *);
 void xs_findeol(const char *, size_t *);
 void xs_findnum(const char *, size_t *);
 
+
+/* Binary database index files: the header, the path of the source
+ * (NUL-terminated and padded to 8 bytes), then the payload
+ */
+typedef struct {
+    char magic[4];      /* Index type identifier */
+    uint32_t version;   /* Index format version */
+    int64_t srcMtime,   /* Modification time and size of the source */
+        srcSize;        /* text database the index was built from */
+    uint32_t nitems,    /* Number of primary records */
+        naux;           /* Number of secondary records */
+    uint32_t srcPathLen, /* Length of the source path, without the NUL */
+        reserved;
+} xs_index_header_t;
+
+char *xs_index_filename(const char *, const char *);
+GMappedFile *xs_index_map(const char *, const char *, const char *, uint32_t);
+const void *xs_index_data(GMappedFile *, size_t *);
+int xs_index_save(const char *, const char *, uint32_t, const char *, const void *, size_t, uint32_t, uint32_t);
+
 #ifdef __cplusplus
 }
 #endif
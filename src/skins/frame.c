@@ -0,0 +1,242 @@
+/*
+ * frame.c
+ * Copyright 2013 Audacious development team
+ *
+ * This file is part of Audacious.
+ *
+ * Audacious is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2 or version 3 of the License.
+ *
+ * Audacious is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Audacious. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The Audacious team does not consider modular code linking to Audacious or
+ * using our public API to be a derived work.
+ */
+
+#include "frame.h"
+
+typedef struct {
+    guint id;
+    gint period;
+    gint64 due; /* milliseconds, monotonic */
+    FrameFunc func;
+    void * user;
+} FrameClient;
+
+typedef struct {
+    GtkWidget * widget;
+    cairo_region_t * region; /* NULL for the whole widget */
+} FrameDraw;
+
+static GList * clients;
+static GList * draws;
+static guint next_id = 1;
+static gint64 last_frame;
+static guint source;
+static gint64 source_due;
+static gboolean dispatching;
+
+static gboolean frame_cb (void * unused);
+
+static gint64 now_ms (void)
+{
+    return g_get_monotonic_time () / 1000;
+}
+
+/* (re)starts the timer for the earliest client, or for the next frame if
+ * there is anything to draw */
+static void schedule (void)
+{
+    gint64 due = G_MAXINT64;
+
+    for (GList * node = clients; node; node = node->next)
+        due = MIN (due, ((FrameClient *) node->data)->due);
+
+    if (draws)
+        due = MIN (due, last_frame + FRAME_PERIOD);
+
+    if (source && source_due == due)
+        return;
+
+    if (source)
+    {
+        g_source_remove (source);
+        source = 0;
+    }
+
+    if (due == G_MAXINT64)
+        return;
+
+    source = g_timeout_add (MAX (due - now_ms (), 0), frame_cb, NULL);
+    source_due = due;
+}
+
+static void flush_draws (gboolean queue)
+{
+    GList * list = draws;
+    draws = NULL;
+
+    for (GList * node = list; node; node = node->next)
+    {
+        FrameDraw * draw = node->data;
+
+        if (queue && draw->region)
+            gtk_widget_queue_draw_region (draw->widget, draw->region);
+        else if (queue)
+            gtk_widget_queue_draw (draw->widget);
+
+        if (draw->region)
+            cairo_region_destroy (draw->region);
+
+        g_object_unref (draw->widget);
+        g_slice_free (FrameDraw, draw);
+    }
+
+    g_list_free (list);
+}
+
+static gboolean frame_cb (void * unused)
+{
+    gint64 now = now_ms ();
+
+    source = 0;
+    last_frame = now;
+
+    /* clients removed meanwhile are only marked, and freed afterward */
+    dispatching = TRUE;
+
+    for (GList * node = clients; node; node = node->next)
+    {
+        FrameClient * client = node->data;
+
+        if (! client->func || client->due > now + FRAME_PERIOD / 2)
+            continue;
+
+        /* after a stall, skip the missed periods rather than catch up */
+        client->due += client->period;
+        if (client->due <= now)
+            client->due = now + client->period;
+
+        if (! client->func (client->user))
+            client->func = NULL;
+    }
+
+    dispatching = FALSE;
+
+    GList * node = clients;
+
+    while (node)
+    {
+        FrameClient * client = node->data;
+        GList * next = node->next;
+
+        if (! client->func)
+        {
+            clients = g_list_delete_link (clients, node);
+            g_slice_free (FrameClient, client);
+        }
+
+        node = next;
+    }
+
+    flush_draws (TRUE);
+    schedule ();
+
+    return FALSE;
+}
+
+guint frame_add (gint period, FrameFunc func, void * user)
+{
+    FrameClient * client = g_slice_new (FrameClient);
+
+    client->id = next_id ++;
+    client->period = MAX (period, 1);
+    client->due = now_ms () + client->period;
+    client->func = func;
+    client->user = user;
+
+    clients = g_list_append (clients, client);
+    schedule ();
+
+    return client->id;
+}
+
+void frame_remove (guint id)
+{
+    for (GList * node = clients; node; node = node->next)
+    {
+        FrameClient * client = node->data;
+
+        if (client->id == id)
+        {
+            if (dispatching)
+            {
+                client->func = NULL;
+                return;
+            }
+
+            clients = g_list_delete_link (clients, node);
+            g_slice_free (FrameClient, client);
+            break;
+        }
+    }
+
+    schedule ();
+}
+
+void frame_cleanup (void)
+{
+    flush_draws (FALSE);
+    schedule ();
+}
+
+static FrameDraw * find_draw (GtkWidget * widget)
+{
+    for (GList * node = draws; node; node = node->next)
+    {
+        FrameDraw * draw = node->data;
+        if (draw->widget == widget)
+            return draw;
+    }
+
+    FrameDraw * draw = g_slice_new (FrameDraw);
+    draw->widget = g_object_ref (widget);
+    draw->region = cairo_region_create ();
+
+    draws = g_list_prepend (draws, draw);
+    schedule ();
+
+    return draw;
+}
+
+void frame_queue_draw (GtkWidget * widget)
+{
+    FrameDraw * draw = find_draw (widget);
+
+    if (draw->region)
+    {
+        cairo_region_destroy (draw->region);
+        draw->region = NULL;
+    }
+}
+
+void frame_queue_draw_area (GtkWidget * widget, gint x, gint y, gint width,
+ gint height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    FrameDraw * draw = find_draw (widget);
+
+    if (draw->region)
+    {
+        cairo_rectangle_int_t rect = {x, y, width, height};
+        cairo_region_union_rectangle (draw->region, & rect);
+    }
+}
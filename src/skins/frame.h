@@ -0,0 +1,52 @@
+/*
+ * frame.h
+ * Copyright 2013 Audacious development team
+ *
+ * This file is part of Audacious.
+ *
+ * Audacious is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2 or version 3 of the License.
+ *
+ * Audacious is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Audacious. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The Audacious team does not consider modular code linking to Audacious or
+ * using our public API to be a derived work.
+ */
+
+/* One timer for everything in the skinned interface that updates on its own:
+ * the vis, scrolling text and the time display.  Callbacks that fall due
+ * within half a frame of each other run together, and the areas they
+ * invalidate are queued for drawing at the end of that frame, so GTK repaints
+ * the main window once per frame instead of once per timer.  The timer is
+ * stopped while nothing is scheduled. */
+
+#ifndef SKINS_FRAME_H
+#define SKINS_FRAME_H
+
+#include <gtk/gtk.h>
+
+#define FRAME_PERIOD 30 /* milliseconds */
+
+/* Returns FALSE to be removed. */
+typedef gboolean (* FrameFunc) (void * user);
+
+/* Calls <func> every <period> milliseconds; returns an ID for frame_remove. */
+guint frame_add (gint period, FrameFunc func, void * user);
+void frame_remove (guint id);
+
+/* Invalidates an area of a widget, or all of it, at the end of the next
+ * frame. */
+void frame_queue_draw (GtkWidget * widget);
+void frame_queue_draw_area (GtkWidget * widget, gint x, gint y, gint width,
+ gint height);
+
+/* Drops pending draws; the clients are removed by their owners. */
+void frame_cleanup (void);
+
+#endif
@@ -27,6 +27,7 @@
 #include <libaudgui/libaudgui.h>
 #include <libaudgui/libaudgui-gtk.h>
 
+#include "frame.h"
 #include "plugin.h"
 #include "skins_cfg.h"
 #include "ui_equalizer.h"
@@ -125,7 +126,7 @@ static gboolean skins_init (void)
     else
         mainwin_update_song_info ();
 
-    update_source = g_timeout_add (250, update_cb, NULL);
+    update_source = frame_add (250, update_cb, NULL);
 
     return TRUE;
 }
@@ -138,11 +139,12 @@ static void skins_cleanup (void)
 
         mainwin_unhook ();
         playlistwin_unhook ();
-        g_source_remove (update_source);
+        frame_remove (update_source);
 
         skins_cfg_save();
 
         cleanup_skins();
+        frame_cleanup ();
         skins_free_paths();
         skins_cfg_free();
         ui_manager_destroy();
@@ -28,17 +28,8 @@ cairo_surface_t * surface_new (int w, int h)
     return cairo_image_surface_create (CAIRO_FORMAT_RGB24, w, h);
 }
 
-cairo_surface_t * surface_new_from_file (const gchar * name)
+cairo_surface_t * surface_new_from_pixbuf (GdkPixbuf * p)
 {
-    GError * error = NULL;
-    GdkPixbuf * p = gdk_pixbuf_new_from_file (name, & error);
-    if (error) {
-        fprintf (stderr, "Error loading %s: %s.\n", name, error->message);
-        g_error_free (error);
-    }
-    if (! p)
-        return NULL;
-
     cairo_surface_t * surface = surface_new (gdk_pixbuf_get_width (p),
      gdk_pixbuf_get_height (p));
     cairo_t * cr = cairo_create (surface);
@@ -47,7 +38,6 @@ cairo_surface_t * surface_new_from_file (const gchar * name)
     cairo_paint (cr);
 
     cairo_destroy (cr);
-    g_object_unref (p);
     return surface;
 }
 
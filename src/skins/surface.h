@@ -24,9 +24,10 @@
 
 #include <glib.h>
 #include <cairo.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
 
 cairo_surface_t * surface_new (gint w, gint h);
-cairo_surface_t * surface_new_from_file (const gchar * name);
+cairo_surface_t * surface_new_from_pixbuf (GdkPixbuf * p);
 guint32 surface_get_pixel (cairo_surface_t * s, gint x, gint y);
 void surface_copy_rect (cairo_surface_t * a, gint ax, gint ay, gint w, gint h,
  cairo_surface_t * b, gint bx, gint by);
@@ -33,6 +33,8 @@
 #include "ui_vis.h"
 #include "util.h"
 
+#include "../common/vis_bands.h"
+
 static void title_change (void)
 {
     if (aud_drct_get_ready ())
@@ -196,51 +198,20 @@ static void render_multi_pcm (const gfloat * pcm, gint channels)
 static void make_log_graph (const gfloat * freq, gint bands, gint db_range, gint
  int_range, guchar * graph)
 {
-    static gint last_bands = 0;
-    static gfloat * xscale = NULL;
+    static VisBands layout;
 
-    /* conversion table for the x-axis */
-    if (bands != last_bands)
+    if (bands != layout.bands)
     {
-        xscale = g_realloc (xscale, sizeof (gfloat) * (bands + 1));
-        for (int i = 0; i <= bands; i ++)
-            xscale[i] = powf (256, (float) i / bands) - 0.5f;
-
-        last_bands = bands;
+        vis_bands_cleanup (& layout);
+        vis_bands_init (& layout, bands);
     }
 
-    for (gint i = 0; i < bands; i ++)
-    {
-        /* sum up values in freq array between xscale[i] and xscale[i + 1],
-           including fractional parts */
-        gint a = ceilf (xscale[i]);
-        gint b = floorf (xscale[i + 1]);
-        gfloat sum = 0;
-
-        if (b < a)
-            sum += freq[b] * (xscale[i + 1] - xscale[i]);
-        else
-        {
-            if (a > 0)
-                sum += freq[a - 1] * (a - xscale[i]);
-            for (; a < b; a ++)
-                sum += freq[a];
-            if (b < 256)
-                sum += freq[b] * (xscale[i + 1] - b);
-        }
-
-        /* fudge factor to make the graph have the same overall height as a
-           12-band one no matter how many bands there are */
-        sum *= (gfloat) bands / 12;
-
-        /* convert to dB */
-        gfloat val = 20 * log10f (sum);
+    gfloat levels[bands];
+    vis_bands_compute (& layout, freq, db_range, levels);
 
-        /* scale (-db_range, 0.0) to (0.0, int_range) */
-        val = (1 + val / db_range) * int_range;
-
-        graph[i] = CLAMP (val, 0, int_range);
-    }
+    /* scale (0.0, 1.0) to (0, int_range) */
+    for (gint i = 0; i < bands; i ++)
+        graph[i] = levels[i] * int_range;
 }
 
 static void render_freq (const gfloat * freq)
@@ -796,9 +796,26 @@ static void update_cb (void * unused, void * another)
         ui_skinned_playlist_set_focused (playlistwin_list,
          aud_playlist_get_position (active_playlist));
         song_changed = FALSE;
+        real_update ();
+        return;
     }
 
-    real_update ();
+    gint at = 0, count = 0;
+    gint level = aud_playlist_updated_range (active_playlist, & at, & count);
+
+    if (level == PLAYLIST_UPDATE_STRUCTURE)
+    {
+        real_update ();
+        return;
+    }
+
+    /* metadata and selection changes only touch their own rows */
+    if (! level)
+        count = 0;
+
+    ui_skinned_playlist_update_rows (playlistwin_list, at, count);
+    playlistwin_update_info ();
+    update_rollup_text ();
 }
 
 static void follow_cb (void * data, void * another)
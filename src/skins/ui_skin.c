@@ -27,8 +27,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <gtk/gtk.h>
+#include <glib/gstdio.h>
 
 #include <audacious/debug.h>
 #include <audacious/misc.h>
@@ -70,7 +72,8 @@ typedef struct _SkinPixmapIdMapping SkinPixmapIdMapping;
 typedef struct _SkinMaskInfo SkinMaskInfo;
 
 static gboolean skin_load (Skin * skin, const gchar * path);
-static void skin_parse_hints (Skin * skin, const gchar * path_p);
+static void skin_parse_hints (Skin * skin, SkinFiles * files);
+static void skin_cache_prune (void);
 
 Skin *active_skin = NULL;
 
@@ -129,9 +132,9 @@ static const guint32 default_vis_colors[24] = {
     COLOR (200, 200, 200)
 };
 
-static cairo_region_t * skin_create_transparent_mask (const gchar * path, const
- gchar * file, const gchar * section, GdkWindow * window, gint width, gint
- height);
+static cairo_region_t * skin_create_transparent_mask (SkinFiles * files,
+ const gchar * file, const gchar * section, GdkWindow * window, gint width,
+ gint height);
 
 gboolean active_skin_load (const gchar * path)
 {
@@ -222,18 +225,17 @@ skin_pixmap_id_lookup(guint id)
     return NULL;
 }
 
-static gchar * skin_pixmap_locate (const gchar * dirname, gchar * * basenames)
+static gchar * skin_pixmap_locate (SkinFiles * files, gchar * * basenames)
 {
-    gchar * filename = NULL;
     gint i;
 
     for (i = 0; basenames[i] != NULL; i ++)
     {
-        if ((filename = find_file_case_path (dirname, basenames[i])) != NULL)
-            break;
+        if (skin_files_has (files, basenames[i]))
+            return g_strdup (basenames[i]);
     }
 
-    return filename;
+    return NULL;
 }
 
 /**
@@ -283,15 +285,13 @@ skin_pixmap_free_basenames(gchar ** basenames)
  * Locates a pixmap file for skin.
  */
 static gchar *
-skin_pixmap_locate_basenames(const Skin * skin,
-                             const SkinPixmapIdMapping * pixmap_id_mapping,
-                             const gchar * path_p)
+skin_pixmap_locate_basenames(SkinFiles * files,
+                             const SkinPixmapIdMapping * pixmap_id_mapping)
 {
     gchar *filename = NULL;
-    const gchar *path = path_p ? path_p : skin->path;
     gchar **basenames = skin_pixmap_create_basenames(pixmap_id_mapping);
 
-    filename = skin_pixmap_locate(path, basenames);
+    filename = skin_pixmap_locate(files, basenames);
 
     skin_pixmap_free_basenames(basenames);
 
@@ -304,10 +304,11 @@ skin_pixmap_locate_basenames(const Skin * skin,
 
 
 static gboolean
-skin_load_pixmap_id(Skin * skin, SkinPixmapId id, const gchar * path_p)
+skin_load_pixmap_id(Skin * skin, SkinPixmapId id, SkinFiles * files)
 {
     const SkinPixmapIdMapping *pixmap_id_mapping;
     gchar *filename;
+    GdkPixbuf *pixbuf;
 
     g_return_val_if_fail(skin != NULL, FALSE);
     g_return_val_if_fail(id < SKIN_PIXMAP_COUNT, FALSE);
@@ -316,21 +317,27 @@ skin_load_pixmap_id(Skin * skin, SkinPixmapId id, const gchar * path_p)
     pixmap_id_mapping = skin_pixmap_id_lookup(id);
     g_return_val_if_fail(pixmap_id_mapping != NULL, FALSE);
 
-    filename = skin_pixmap_locate_basenames(skin, pixmap_id_mapping, path_p);
+    filename = skin_pixmap_locate_basenames(files, pixmap_id_mapping);
 
     if (filename == NULL)
         return FALSE;
 
-    skin->pixmaps[id] = surface_new_from_file (filename);
-
+    pixbuf = skin_files_load_pixbuf (files, filename);
     g_free (filename);
-    return skin->pixmaps[id] ? TRUE : FALSE;
+
+    if (! pixbuf)
+        return FALSE;
+
+    skin->pixmaps[id] = surface_new_from_pixbuf (pixbuf);
+    g_object_unref (pixbuf);
+
+    return TRUE;
 }
 
-static void skin_mask_create (Skin * skin, const gchar * path, gint id,
+static void skin_mask_create (Skin * skin, SkinFiles * files, gint id,
  GdkWindow * window)
 {
-    skin->masks[id] = skin_create_transparent_mask (path, "region.txt",
+    skin->masks[id] = skin_create_transparent_mask (files, "region.txt",
      skin_mask_info[id].inistr, window, skin_mask_info[id].width,
      skin_mask_info[id].height);
 }
@@ -379,6 +386,7 @@ init_skins(const gchar * path)
     active_skin = skin_new();
 
     skin_parse_hints(active_skin, NULL);
+    skin_cache_prune();
 
     /* create the windows if they haven't been created yet, needed for bootstrapping */
     if (mainwin == NULL)
@@ -434,13 +442,10 @@ void cleanup_skins()
  * Hints files are somewhat like "scripts" in Winamp3/5.
  * We'll probably add scripts to it next.
  */
-static void skin_parse_hints (Skin * skin, const gchar * path_p)
+static void skin_parse_hints (Skin * skin, SkinFiles * files)
 {
-    gchar *filename;
     INIFile *inifile;
 
-    path_p = path_p ? path_p : skin->path;
-
     skin->properties.mainwin_vis_x = 24;
     skin->properties.mainwin_vis_y = 43;
     skin->properties.mainwin_text_x = 112;
@@ -507,15 +512,10 @@ static void skin_parse_hints (Skin * skin, const gchar * path_p)
     skin->properties.mainwin_close_x = 264;
     skin->properties.mainwin_close_y = 3;
 
-    if (path_p == NULL)
+    if (files == NULL)
         return;
 
-    filename = find_file_case_uri (path_p, "skin.hints");
-
-    if (filename == NULL)
-        return;
-
-    inifile = open_ini_file(filename);
+    inifile = open_ini_file(files, "skin.hints");
     if (!inifile)
         return;
 
@@ -600,9 +600,6 @@ static void skin_parse_hints (Skin * skin, const gchar * path_p)
     skin_mask_info[0].height = skin->properties.mainwin_height;
     skin_mask_info[0].width = skin->properties.mainwin_width;
 
-    if (filename != NULL)
-        g_free(filename);
-
     close_ini_file(inifile);
 }
 
@@ -659,35 +656,28 @@ static guint32 skin_load_color (INIFile * inifile, const gchar * section,
     return COLOR (red, green, blue);
 }
 
-static cairo_region_t * skin_create_transparent_mask (const gchar * path, const
- gchar * file, const gchar * section, GdkWindow * window, gint width, gint
- height)
+static cairo_region_t * skin_create_transparent_mask (SkinFiles * files,
+ const gchar * file, const gchar * section, GdkWindow * window, gint width,
+ gint height)
 {
-    gchar *filename = NULL;
     INIFile *inifile = NULL;
     gboolean created_mask = FALSE;
     GArray *num, *point;
     guint i, j;
     gint k;
 
-    if (path != NULL)
-        filename = find_file_case_uri (path, file);
-
-    /* filename will be null if path wasn't set */
-    if (!filename)
+    if (files == NULL || ! skin_files_has (files, file))
         return create_default_mask(window, width, height);
 
-    inifile = open_ini_file(filename);
+    inifile = open_ini_file(files, file);
 
     if ((num = read_ini_array(inifile, section, "NumPoints")) == NULL) {
-        g_free(filename);
         close_ini_file(inifile);
         return NULL;
     }
 
     if ((point = read_ini_array(inifile, section, "PointList")) == NULL) {
         g_array_free(num, TRUE);
-        g_free(filename);
         close_ini_file(inifile);
         return NULL;
     }
@@ -731,7 +721,6 @@ static cairo_region_t * skin_create_transparent_mask (const gchar * path, const
 
     g_array_free(num, TRUE);
     g_array_free(point, TRUE);
-    g_free(filename);
 
     if (!created_mask)
     {
@@ -742,20 +731,15 @@ static cairo_region_t * skin_create_transparent_mask (const gchar * path, const
     return mask;
 }
 
-static void skin_load_viscolor (Skin * skin, const gchar * path, const gchar *
+static void skin_load_viscolor (Skin * skin, SkinFiles * files, const gchar *
  basename)
 {
-    gchar * filename, * buffer, * string, * next;
+    gchar * buffer, * string, * next;
     gint line;
 
     memcpy (skin->vis_colors, default_vis_colors, sizeof skin->vis_colors);
 
-    filename = find_file_case_uri (path, basename);
-    if (filename == NULL)
-        return;
-
-    buffer = load_text_file (filename);
-    g_free (filename);
+    buffer = skin_files_load (files, basename, NULL);
     string = buffer;
 
     for (line = 0; string != NULL && line < 24; line ++)
@@ -797,19 +781,18 @@ skin_numbers_generate_dash(Skin * skin)
 }
 
 static gboolean
-skin_load_pixmaps(Skin * skin, const gchar * path)
+skin_load_pixmaps(Skin * skin, SkinFiles * files)
 {
     guint i;
-    gchar *filename;
     INIFile *inifile;
 
     if(!skin) return FALSE;
-    if(!path) return FALSE;
+    if(!files) return FALSE;
 
-    AUDDBG("Loading pixmaps in %s\n", path);
+    AUDDBG("Loading pixmaps in %s\n", skin->path);
 
     for (i = 0; i < SKIN_PIXMAP_COUNT; i++)
-        if (! skin_load_pixmap_id (skin, i, path))
+        if (! skin_load_pixmap_id (skin, i, files))
             return FALSE;
 
     if (skin->pixmaps[SKIN_TEXT])
@@ -819,8 +802,7 @@ skin_load_pixmaps(Skin * skin, const gchar * path)
      (skin->pixmaps[SKIN_NUMBERS]) < 108)
         skin_numbers_generate_dash (skin);
 
-    filename = find_file_case_uri (path, "pledit.txt");
-    inifile = (filename != NULL) ? open_ini_file (filename) : NULL;
+    inifile = open_ini_file (files, "pledit.txt");
 
     skin->colors[SKIN_PLEDIT_NORMAL] =
         skin_load_color(inifile, "Text", "Normal", "#2499ff");
@@ -834,15 +816,12 @@ skin_load_pixmaps(Skin * skin, const gchar * path)
     if (inifile)
         close_ini_file(inifile);
 
-    if (filename)
-        g_free(filename);
-
-    skin_mask_create (skin, path, SKIN_MASK_MAIN, gtk_widget_get_window (mainwin));
-    skin_mask_create (skin, path, SKIN_MASK_MAIN_SHADE, gtk_widget_get_window (mainwin));
-    skin_mask_create (skin, path, SKIN_MASK_EQ, gtk_widget_get_window (equalizerwin));
-    skin_mask_create (skin, path, SKIN_MASK_EQ_SHADE, gtk_widget_get_window (equalizerwin));
+    skin_mask_create (skin, files, SKIN_MASK_MAIN, gtk_widget_get_window (mainwin));
+    skin_mask_create (skin, files, SKIN_MASK_MAIN_SHADE, gtk_widget_get_window (mainwin));
+    skin_mask_create (skin, files, SKIN_MASK_EQ, gtk_widget_get_window (equalizerwin));
+    skin_mask_create (skin, files, SKIN_MASK_EQ_SHADE, gtk_widget_get_window (equalizerwin));
 
-    skin_load_viscolor(skin, path, "viscolor.txt");
+    skin_load_viscolor(skin, files, "viscolor.txt");
 
     return TRUE;
 }
@@ -851,14 +830,13 @@ skin_load_pixmaps(Skin * skin, const gchar * path)
  * Checks if all pixmap files exist that skin needs.
  */
 static gboolean
-skin_check_pixmaps(const Skin * skin, const gchar * skin_path)
+skin_check_pixmaps(SkinFiles * files)
 {
     guint i;
     for (i = 0; i < SKIN_PIXMAP_COUNT; i++)
     {
-        gchar *filename = skin_pixmap_locate_basenames(skin,
-                                                       skin_pixmap_id_lookup(i),
-                                                       skin_path);
+        gchar *filename = skin_pixmap_locate_basenames(files,
+                                                       skin_pixmap_id_lookup(i));
         if (!filename)
             return FALSE;
         g_free(filename);
@@ -866,11 +844,311 @@ skin_check_pixmaps(const Skin * skin, const gchar * skin_path)
     return TRUE;
 }
 
+/*
+ * Decoded skin cache
+ *
+ * Decoding the bitmaps of an archived skin is most of the time spent loading
+ * it, so once an archive has been loaded, its pixmaps, colors, masks and
+ * hints are saved as they are in memory.  The cache is keyed by the path of
+ * the archive and checked against its size and modification time.
+ */
+
+#define SKIN_CACHE_MAGIC "AUDSKIN"
+#define SKIN_CACHE_VERSION 1
+#define SKIN_CACHE_MAX_FILES 32
+
+typedef struct {
+    gchar magic[8];
+    guint32 version;
+    guint32 properties_size;
+    gint64 mtime;
+    gint64 size;
+} SkinCacheHeader;
+
+typedef struct {
+    const guchar * data;
+    gsize len, pos;
+} SkinCacheReader;
+
+static gchar * skin_cache_dir (void)
+{
+    return g_build_filename (g_get_user_cache_dir (), "audacious", "skins", NULL);
+}
+
+static gchar * skin_cache_filename (const gchar * path)
+{
+    gchar * dir = skin_cache_dir ();
+    gchar * md5 = g_compute_checksum_for_string (G_CHECKSUM_MD5, path, -1);
+    gchar * base = g_strconcat (md5, ".cache", NULL);
+    gchar * filename = g_build_filename (dir, base, NULL);
+
+    g_free (dir);
+    g_free (md5);
+    g_free (base);
+    return filename;
+}
+
+static void skin_cache_header (SkinCacheHeader * header, const struct stat * info)
+{
+    memset (header, 0, sizeof (SkinCacheHeader));
+    strcpy (header->magic, SKIN_CACHE_MAGIC);
+    header->version = SKIN_CACHE_VERSION;
+    header->properties_size = sizeof (SkinProperties);
+    header->mtime = info->st_mtime;
+    header->size = info->st_size;
+}
+
+static const void * skin_cache_read (SkinCacheReader * reader, gsize len)
+{
+    const void * data = reader->data + reader->pos;
+
+    if (reader->len - reader->pos < len)
+        return NULL;
+
+    reader->pos += len;
+    return data;
+}
+
+static gboolean skin_cache_read_int (SkinCacheReader * reader, gint32 * value)
+{
+    const void * data = skin_cache_read (reader, sizeof (gint32));
+
+    if (! data)
+        return FALSE;
+
+    memcpy (value, data, sizeof (gint32));
+    return TRUE;
+}
+
+static gboolean skin_cache_read_skin (SkinCacheReader * reader, Skin * skin)
+{
+    const void * data;
+    gint32 count, w, h;
+
+    if (! (data = skin_cache_read (reader, sizeof skin->properties)))
+        return FALSE;
+    memcpy (& skin->properties, data, sizeof skin->properties);
+
+    if (! (data = skin_cache_read (reader, sizeof skin->colors)))
+        return FALSE;
+    memcpy (skin->colors, data, sizeof skin->colors);
+
+    if (! (data = skin_cache_read (reader, sizeof skin->vis_colors)))
+        return FALSE;
+    memcpy (skin->vis_colors, data, sizeof skin->vis_colors);
+
+    for (gint i = 0; i < SKIN_MASK_COUNT; i ++)
+    {
+        if (! skin_cache_read_int (reader, & count) || count < -1)
+            return FALSE;
+
+        /* -1 means that the skin has no mask here */
+        if (count < 0)
+            continue;
+
+        if ((gsize) count > (reader->len - reader->pos) / sizeof
+         (cairo_rectangle_int_t))
+            return FALSE;
+
+        data = skin_cache_read (reader, sizeof (cairo_rectangle_int_t) * count);
+        skin->masks[i] = cairo_region_create_rectangles (data, count);
+    }
+
+    for (gint i = 0; i < SKIN_PIXMAP_COUNT; i ++)
+    {
+        if (! skin_cache_read_int (reader, & w) || ! skin_cache_read_int
+         (reader, & h) || w <= 0 || h <= 0 || w > 16384 || h > 16384 ||
+         ! (data = skin_cache_read (reader, (gsize) w * h * 4)))
+            return FALSE;
+
+        cairo_surface_t * surface = surface_new (w, h);
+        guchar * pixels = cairo_image_surface_get_data (surface);
+        gint stride = cairo_image_surface_get_stride (surface);
+
+        cairo_surface_flush (surface);
+
+        for (gint y = 0; y < h; y ++)
+            memcpy (pixels + stride * y, (const guchar *) data + w * 4 * y, w * 4);
+
+        cairo_surface_mark_dirty (surface);
+        skin->pixmaps[i] = surface;
+    }
+
+    return reader->pos == reader->len;
+}
+
+/* Fills in a zeroed skin from the cache.  On failure, the skin may be partly
+ * filled in and must be freed. */
+static gboolean skin_cache_load (Skin * skin, const gchar * path)
+{
+    gchar * filename = skin_cache_filename (path);
+    SkinCacheHeader header;
+    SkinCacheReader reader;
+    struct stat info;
+    gchar * data;
+    gsize len;
+    gboolean success = FALSE;
+
+    if (stat (path, & info) < 0 || ! g_file_get_contents (filename, & data,
+     & len, NULL))
+    {
+        g_free (filename);
+        return FALSE;
+    }
+
+    skin_cache_header (& header, & info);
+
+    reader.data = (const guchar *) data;
+    reader.len = len;
+    reader.pos = 0;
+
+    const void * found = skin_cache_read (& reader, sizeof header);
+
+    if (found && ! memcmp (found, & header, sizeof header))
+        success = skin_cache_read_skin (& reader, skin);
+
+    /* the age of a cache file is the time it was last used */
+    if (success)
+        g_utime (filename, NULL);
+
+    g_free (data);
+    g_free (filename);
+    return success;
+}
+
+typedef struct {
+    gchar * filename;
+    time_t mtime;
+} SkinCacheFile;
+
+static gint skin_cache_compare (gconstpointer a, gconstpointer b)
+{
+    time_t ta = ((const SkinCacheFile *) a)->mtime;
+    time_t tb = ((const SkinCacheFile *) b)->mtime;
+
+    return (ta < tb) ? 1 : (ta > tb) ? -1 : 0;
+}
+
+static gboolean skin_cache_scan (const gchar * path, const gchar * basename,
+ gpointer files)
+{
+    struct stat info;
+
+    if (stat (path, & info) < 0)
+        return FALSE;
+
+    if (S_ISREG (info.st_mode) && g_str_has_suffix (basename, ".cache"))
+    {
+        SkinCacheFile file = {g_strdup (path), info.st_mtime};
+        g_array_append_val (files, file);
+    }
+
+    return FALSE;
+}
+
+/* Keeps only the most recently used cache files. */
+static void skin_cache_prune (void)
+{
+    GArray * files = g_array_new (FALSE, FALSE, sizeof (SkinCacheFile));
+    gchar * dir = skin_cache_dir ();
+
+    dir_foreach (dir, skin_cache_scan, files, NULL);
+    g_array_sort (files, skin_cache_compare);
+
+    for (guint i = 0; i < files->len; i ++)
+    {
+        SkinCacheFile * file = & g_array_index (files, SkinCacheFile, i);
+
+        if (i >= SKIN_CACHE_MAX_FILES)
+            unlink (file->filename);
+
+        g_free (file->filename);
+    }
+
+    g_array_free (files, TRUE);
+    g_free (dir);
+}
+
+static void skin_cache_write_int (GByteArray * out, gint32 value)
+{
+    g_byte_array_append (out, (const guint8 *) & value, sizeof value);
+}
+
+static void skin_cache_save (Skin * skin, const gchar * path)
+{
+    SkinCacheHeader header;
+    struct stat info;
+
+    if (stat (path, & info) < 0)
+        return;
+
+    skin_cache_header (& header, & info);
+
+    GByteArray * out = g_byte_array_new ();
+
+    g_byte_array_append (out, (const guint8 *) & header, sizeof header);
+    g_byte_array_append (out, (const guint8 *) & skin->properties,
+     sizeof skin->properties);
+    g_byte_array_append (out, (const guint8 *) skin->colors, sizeof skin->colors);
+    g_byte_array_append (out, (const guint8 *) skin->vis_colors,
+     sizeof skin->vis_colors);
+
+    for (gint i = 0; i < SKIN_MASK_COUNT; i ++)
+    {
+        if (! skin->masks[i])
+        {
+            skin_cache_write_int (out, -1);
+            continue;
+        }
+
+        gint count = cairo_region_num_rectangles (skin->masks[i]);
+        skin_cache_write_int (out, count);
+
+        for (gint j = 0; j < count; j ++)
+        {
+            cairo_rectangle_int_t rect;
+            cairo_region_get_rectangle (skin->masks[i], j, & rect);
+            g_byte_array_append (out, (const guint8 *) & rect, sizeof rect);
+        }
+    }
+
+    for (gint i = 0; i < SKIN_PIXMAP_COUNT; i ++)
+    {
+        cairo_surface_t * surface = skin->pixmaps[i];
+        gint w = cairo_image_surface_get_width (surface);
+        gint h = cairo_image_surface_get_height (surface);
+        gint stride = cairo_image_surface_get_stride (surface);
+
+        cairo_surface_flush (surface);
+
+        skin_cache_write_int (out, w);
+        skin_cache_write_int (out, h);
+
+        for (gint y = 0; y < h; y ++)
+            g_byte_array_append (out, cairo_image_surface_get_data (surface) +
+             stride * y, w * 4);
+    }
+
+    gchar * dir = skin_cache_dir ();
+    gchar * filename = skin_cache_filename (path);
+
+    if (g_mkdir_with_parents (dir, S_IRWXU) < 0 || ! g_file_set_contents
+     (filename, (const gchar *) out->data, out->len, NULL))
+        AUDDBG ("Unable to write skin cache %s\n", filename);
+
+    g_free (dir);
+    g_free (filename);
+    g_byte_array_free (out, TRUE);
+
+    skin_cache_prune ();
+}
+
 static gboolean
 skin_load_nolock(Skin * skin, const gchar * path, gboolean force)
 {
-    gchar *newpath, *skin_path;
-    int archive = 0;
+    SkinFiles *files;
+    Skin cached;
+    gchar *newpath;
 
     AUDDBG("Attempt to load skin \"%s\"\n", path);
 
@@ -886,22 +1164,38 @@ skin_load_nolock(Skin * skin, const gchar * path, gboolean force)
         return FALSE;
     }
 
-    if (file_is_archive(path)) {
-        AUDDBG("Attempt to load archive\n");
-        if (!(skin_path = archive_decompress(path))) {
-            AUDDBG("Unable to extract skin archive (%s)\n", path);
-            return FALSE;
-        }
-        archive = 1;
-    } else {
-        skin_path = g_strdup(path);
+    memset (& cached, 0, sizeof cached);
+
+    if (file_is_archive (path) && skin_cache_load (& cached, path))
+    {
+        AUDDBG ("Loaded skin from cache\n");
+
+        cached.path = g_strdup (path);
+        skin_free (skin);
+        * skin = cached;
+
+        skin_current_num ++;
+
+        skin_mask_info[0].width = skin->properties.mainwin_width;
+        skin_mask_info[0].height = skin->properties.mainwin_height;
+
+        mainwin_set_shape ();
+        equalizerwin_set_shape ();
+
+        return TRUE;
+    }
+
+    skin_free (& cached);
+
+    if (!(files = skin_files_open(path))) {
+        AUDDBG("Unable to read skin (%s)\n", path);
+        return FALSE;
     }
 
     // Check if skin path has all necessary files.
-    if (!skin_check_pixmaps(skin, skin_path)) {
-        if(archive) del_directory(skin_path);
-        AUDDBG("Skin path (%s) doesn't have all wanted pixmaps\n", skin_path);
-        g_free(skin_path);
+    if (!skin_check_pixmaps(files)) {
+        AUDDBG("Skin path (%s) doesn't have all wanted pixmaps\n", path);
+        skin_files_close(files);
         return FALSE;
     }
 
@@ -916,17 +1210,18 @@ skin_load_nolock(Skin * skin, const gchar * path, gboolean force)
     skin_current_num++;
 
     /* Parse the hints for this skin. */
-    skin_parse_hints(skin, skin_path);
+    skin_parse_hints(skin, files);
 
-    if (!skin_load_pixmaps(skin, skin_path)) {
-        if(archive) del_directory(skin_path);
-        g_free(skin_path);
+    if (!skin_load_pixmaps(skin, files)) {
+        skin_files_close(files);
         AUDDBG("Skin loading failed\n");
         return FALSE;
     }
 
-    if(archive) del_directory(skin_path);
-    g_free(skin_path);
+    skin_files_close(files);
+
+    if (file_is_archive (skin->path))
+        skin_cache_save (skin, skin->path);
 
     mainwin_set_shape ();
     equalizerwin_set_shape ();
@@ -51,6 +51,15 @@ typedef struct {
      hover, drag;
     gint popup_pos, popup_source;
     gboolean popup_shown;
+    PangoLayout * layout;
+
+    /* state of the last draw, used to tell when a partial redraw will do */
+    struct {
+        gint left, right, length, position, focus;
+        gint * queue; /* queue position of each visible row, or -1 */
+        gint queue_rows;
+        gchar * title;
+    } drawn;
 } PlaylistData;
 
 static gboolean playlist_button_press (GtkWidget * list, GdkEventButton * event);
@@ -135,6 +144,27 @@ static void cancel_all (GtkWidget * list, PlaylistData * data)
     popup_hide (list, data);
 }
 
+/* One layout is kept per widget and refilled for every cell; creating a fresh
+ * PangoLayout for each number, length and title was most of the draw cost. */
+static PangoLayout * get_layout (GtkWidget * wid, PlaylistData * data,
+ const gchar * text, gint width, PangoAlignment align)
+{
+    if (! data->layout)
+    {
+        data->layout = gtk_widget_create_pango_layout (wid, NULL);
+        pango_layout_set_font_description (data->layout, data->font);
+    }
+
+    pango_layout_set_text (data->layout, text, -1);
+    pango_layout_set_width (data->layout, (width > 0) ? PANGO_SCALE * width : -1);
+    pango_layout_set_alignment (data->layout, align);
+    pango_layout_set_ellipsize (data->layout, (align == PANGO_ALIGN_CENTER) ?
+     PANGO_ELLIPSIZE_MIDDLE : (width > 0) ? PANGO_ELLIPSIZE_END :
+     PANGO_ELLIPSIZE_NONE);
+
+    return data->layout;
+}
+
 DRAW_FUNC_BEGIN (playlist_draw)
     PlaylistData * data = g_object_get_data ((GObject *) wid, "playlistdata");
     g_return_val_if_fail (data, FALSE);
@@ -142,8 +172,27 @@ DRAW_FUNC_BEGIN (playlist_draw)
     gint active_entry = aud_playlist_get_position (active_playlist);
     gint left = 3, right = 3;
     PangoLayout * layout;
+    PangoRectangle rect;
     gint width;
 
+    /* only rows inside the clip area are painted; the others are still
+     * measured since they decide the width of the number and length columns */
+
+    gdouble clip_top, clip_bottom;
+    cairo_clip_extents (cr, NULL, & clip_top, NULL, & clip_bottom);
+
+    gint last = MIN (data->first + data->rows, active_length);
+    gint paint_first = MAX (data->first, data->first + ((gint) clip_top -
+     data->offset) / data->row_height);
+    gint paint_last = MIN (last, data->first + ((gint) clip_bottom -
+     data->offset + data->row_height - 1) / data->row_height);
+    gboolean partial = (paint_first > data->first || paint_last < last);
+
+#define PAINTED(i) ((i) >= paint_first && (i) < paint_last)
+
+    if (data->layout)
+        pango_layout_context_changed (data->layout);
+
     /* background */
 
     set_cairo_color (cr, active_skin->colors[SKIN_PLEDIT_NORMALBG]);
@@ -151,25 +200,19 @@ DRAW_FUNC_BEGIN (playlist_draw)
 
     /* playlist title */
 
-    if (data->offset)
+    if (data->offset && clip_top < data->offset)
     {
-        layout = gtk_widget_create_pango_layout (wid, active_title);
-        pango_layout_set_font_description (layout, data->font);
-        pango_layout_set_width (layout, PANGO_SCALE * (data->width - left -
-         right));
-        pango_layout_set_alignment (layout, PANGO_ALIGN_CENTER);
-        pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_MIDDLE);
+        layout = get_layout (wid, data, active_title, data->width - left -
+         right, PANGO_ALIGN_CENTER);
 
         cairo_move_to (cr, left, 0);
         set_cairo_color (cr, active_skin->colors[SKIN_PLEDIT_NORMAL]);
         pango_cairo_show_layout (cr, layout);
-        g_object_unref (layout);
     }
 
     /* selection highlight */
 
-    for (gint i = data->first; i < data->first + data->rows && i <
-     active_length; i ++)
+    for (gint i = paint_first; i < paint_last; i ++)
     {
         if (! aud_playlist_entry_get_selected (active_playlist, i))
             continue;
@@ -186,25 +229,23 @@ DRAW_FUNC_BEGIN (playlist_draw)
     {
         width = 0;
 
-        for (gint i = data->first; i < data->first + data->rows && i <
-         active_length; i ++)
+        for (gint i = data->first; i < last; i ++)
         {
             gchar buf[16];
             snprintf (buf, sizeof buf, "%d.", 1 + i);
 
-            layout = gtk_widget_create_pango_layout (wid, buf);
-            pango_layout_set_font_description (layout, data->font);
-
-            PangoRectangle rect;
+            layout = get_layout (wid, data, buf, -1, PANGO_ALIGN_LEFT);
             pango_layout_get_pixel_extents (layout, NULL, & rect);
             width = MAX (width, rect.width);
 
+            if (! PAINTED (i))
+                continue;
+
             cairo_move_to (cr, left, data->offset + data->row_height * (i -
              data->first));
             set_cairo_color (cr, active_skin->colors[(i == active_entry) ?
              SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
             pango_cairo_show_layout (cr, layout);
-            g_object_unref (layout);
         }
 
         left += width + 4;
@@ -214,8 +255,7 @@ DRAW_FUNC_BEGIN (playlist_draw)
 
     width = 0;
 
-    for (gint i = data->first; i < data->first + data->rows && i <
-     active_length; i ++)
+    for (gint i = data->first; i < last; i ++)
     {
         gint len = aud_playlist_entry_get_length (active_playlist, i, TRUE);
         gchar buf[16];
@@ -225,52 +265,57 @@ DRAW_FUNC_BEGIN (playlist_draw)
         else
             buf[0] = 0;
 
-        layout = gtk_widget_create_pango_layout (wid, buf);
-        pango_layout_set_font_description (layout, data->font);
-
-        PangoRectangle rect;
+        layout = get_layout (wid, data, buf, -1, PANGO_ALIGN_LEFT);
         pango_layout_get_pixel_extents (layout, NULL, & rect);
         width = MAX (width, rect.width);
 
+        if (! PAINTED (i))
+            continue;
+
         cairo_move_to (cr, data->width - right - rect.width, data->offset +
          data->row_height * (i - data->first));
         set_cairo_color (cr, active_skin->colors[(i == active_entry) ?
          SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
         pango_cairo_show_layout (cr, layout);
-        g_object_unref (layout);
     }
 
     right += width + 6;
 
     /* queue positions */
 
+    gint queue_rows = last - data->first;
+    gint * queue = g_new (gint, MAX (queue_rows, 1));
+
+    for (gint i = 0; i < queue_rows; i ++)
+        queue[i] = -1;
+
     if (aud_playlist_queue_count (active_playlist))
     {
         width = 0;
 
-        for (gint i = data->first; i < data->first + data->rows && i <
-         active_length; i ++)
+        for (gint i = data->first; i < last; i ++)
         {
             gint pos = aud_playlist_queue_find_entry (active_playlist, i);
+            queue[i - data->first] = pos;
+
             if (pos < 0)
                 continue;
 
             gchar buf[16];
             snprintf (buf, sizeof buf, "(#%d)", 1 + pos);
 
-            layout = gtk_widget_create_pango_layout (wid, buf);
-            pango_layout_set_font_description (layout, data->font);
-
-            PangoRectangle rect;
+            layout = get_layout (wid, data, buf, -1, PANGO_ALIGN_LEFT);
             pango_layout_get_pixel_extents (layout, NULL, & rect);
             width = MAX (width, rect.width);
 
+            if (! PAINTED (i))
+                continue;
+
             cairo_move_to (cr, data->width - right - rect.width, data->offset +
              data->row_height * (i - data->first));
             set_cairo_color (cr, active_skin->colors[(i == active_entry) ?
              SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
             pango_cairo_show_layout (cr, layout);
-            g_object_unref (layout);
         }
 
         right += width + 6;
@@ -278,17 +323,11 @@ DRAW_FUNC_BEGIN (playlist_draw)
 
     /* titles */
 
-    for (gint i = data->first; i < data->first + data->rows && i <
-     active_length; i ++)
+    for (gint i = paint_first; i < paint_last; i ++)
     {
         gchar * title = aud_playlist_entry_get_title (active_playlist, i, TRUE);
-
-        layout = gtk_widget_create_pango_layout (wid, title);
-        pango_layout_set_font_description (layout, data->font);
-        pango_layout_set_width (layout, PANGO_SCALE * (data->width - left -
-         right));
-        pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_END);
-
+        layout = get_layout (wid, data, title, data->width - left - right,
+         PANGO_ALIGN_LEFT);
         str_unref (title);
 
         cairo_move_to (cr, left, data->offset + data->row_height * (i -
@@ -296,9 +335,10 @@ DRAW_FUNC_BEGIN (playlist_draw)
         set_cairo_color (cr, active_skin->colors[(i == active_entry) ?
          SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
         pango_cairo_show_layout (cr, layout);
-        g_object_unref (layout);
     }
 
+#undef PAINTED
+
     /* focus rectangle */
 
     gint focus = aud_playlist_get_focus (active_playlist);
@@ -324,6 +364,27 @@ DRAW_FUNC_BEGIN (playlist_draw)
         set_cairo_color (cr, active_skin->colors[SKIN_PLEDIT_NORMAL]);
         cairo_stroke (cr);
     }
+
+    /* if the columns moved, the rows outside the clip area are stale */
+
+    if (partial && (left != data->drawn.left || right != data->drawn.right))
+        gtk_widget_queue_draw (wid);
+
+    data->drawn.left = left;
+    data->drawn.right = right;
+    data->drawn.length = active_length;
+    data->drawn.position = active_entry;
+    data->drawn.focus = focus;
+
+    g_free (data->drawn.queue);
+    data->drawn.queue = queue;
+    data->drawn.queue_rows = queue_rows;
+
+    if (! partial)
+    {
+        g_free (data->drawn.title);
+        data->drawn.title = g_strdup (active_title);
+    }
 DRAW_FUNC_END
 
 static void playlist_destroy (GtkWidget * list)
@@ -333,7 +394,12 @@ static void playlist_destroy (GtkWidget * list)
 
     cancel_all (list, data);
 
+    if (data->layout)
+        g_object_unref (data->layout);
+
     pango_font_description_free (data->font);
+    g_free (data->drawn.queue);
+    g_free (data->drawn.title);
     g_free (data);
 }
 
@@ -400,6 +466,12 @@ void ui_skinned_playlist_set_font (GtkWidget * list, const gchar * font)
     pango_font_description_free (data->font);
     data->font = pango_font_description_from_string (font);
 
+    if (data->layout)
+    {
+        g_object_unref (data->layout);
+        data->layout = NULL;
+    }
+
     PangoLayout * layout = gtk_widget_create_pango_layout (list, "A");
     pango_layout_set_font_description (layout, data->font);
 
@@ -431,6 +503,59 @@ void ui_skinned_playlist_update (GtkWidget * list)
         ui_skinned_playlist_slider_update (data->slider);
 }
 
+/* Whether the queue position shown on any visible row changed since the last
+ * draw.  Comparing only the length of the queue misses entries that were
+ * reordered, or dequeued and queued again elsewhere. */
+static gboolean queue_changed (PlaylistData * data)
+{
+    gint rows = MIN (data->first + data->rows, active_length) - data->first;
+
+    if (rows != data->drawn.queue_rows)
+        return TRUE;
+
+    gboolean queued = (aud_playlist_queue_count (active_playlist) > 0);
+
+    for (gint i = 0; i < rows; i ++)
+    {
+        gint pos = queued ? aud_playlist_queue_find_entry (active_playlist,
+         data->first + i) : -1;
+
+        if (pos != data->drawn.queue[i])
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* Redraws only the visible part of rows <at> to <at + count - 1>, falling back
+ * to a full update when scrolling, the playing entry, the focus, the queue or
+ * the title bar changed since the last draw. */
+void ui_skinned_playlist_update_rows (GtkWidget * list, gint at, gint count)
+{
+    PlaylistData * data = g_object_get_data ((GObject *) list, "playlistdata");
+    g_return_if_fail (data);
+
+    gint first = data->first, rows = data->rows, offset = data->offset;
+    calc_layout (data);
+
+    if (data->first != first || data->rows != rows || data->offset != offset ||
+     data->drawn.length != active_length || data->drawn.position !=
+     aud_playlist_get_position (active_playlist) || data->drawn.focus !=
+     aud_playlist_get_focus (active_playlist) || g_strcmp0
+     (data->drawn.title, active_title) || queue_changed (data))
+    {
+        ui_skinned_playlist_update (list);
+        return;
+    }
+
+    gint top = MAX (at, data->first);
+    gint bottom = MIN (at + count, data->first + data->rows);
+
+    if (top < bottom)
+        gtk_widget_queue_draw_area (list, 0, data->offset + data->row_height *
+         (top - data->first), data->width, data->row_height * (bottom - top));
+}
+
 static void scroll_to (PlaylistData * data, gint position)
 {
     if (position < data->first || position >= data->first + data->rows)
@@ -28,6 +28,7 @@
 #include <string.h>
 
 #include "draw-compat.h"
+#include "frame.h"
 #include "skins_cfg.h"
 #include "ui_skin.h"
 #include "ui_skinned_textbox.h"
@@ -97,7 +98,7 @@ static gboolean textbox_scroll (GtkWidget * textbox)
     if (! config.twoway_scroll && data->offset >= data->buf_width)
         data->offset = 0;
 
-    gtk_widget_queue_draw (textbox);
+    frame_queue_draw (textbox);
     return TRUE;
 }
 
@@ -269,14 +270,14 @@ static void textbox_render (GtkWidget * textbox, TextboxData * data)
     if (data->scrolling)
     {
         if (! data->scroll_source)
-            data->scroll_source = g_timeout_add (TIMEOUT, (GSourceFunc)
+            data->scroll_source = frame_add (TIMEOUT, (FrameFunc)
              textbox_scroll, textbox);
     }
     else
     {
         if (data->scroll_source)
         {
-            g_source_remove (data->scroll_source);
+            frame_remove (data->scroll_source);
             data->scroll_source = 0;
         }
     }
@@ -357,7 +358,7 @@ static void textbox_destroy (GtkWidget * textbox)
     if (data->buf)
         cairo_surface_destroy (data->buf);
     if (data->scroll_source)
-        g_source_remove (data->scroll_source);
+        frame_remove (data->scroll_source);
 
     g_free (data->text);
     g_free (data);
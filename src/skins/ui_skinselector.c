@@ -81,41 +81,26 @@ static GdkPixbuf *
 skin_get_preview(const gchar * path)
 {
     GdkPixbuf *preview = NULL;
-    gchar *dec_path, *preview_path;
-    gboolean is_archive = FALSE;
+    SkinFiles *files;
     gint i = 0;
     gchar buf[60];			/* gives us lots of room */
 
-    if (file_is_archive(path))
-    {
-        if (!(dec_path = archive_decompress(path)))
-            return NULL;
-
-        is_archive = TRUE;
-    }
-    else
-    {
-        dec_path = g_strdup(path);
-    }
+    /* archives are read into memory; nothing is extracted to disk */
+    if (!(files = skin_files_open(path)))
+        return NULL;
 
     for (i = 0; i < EXTENSION_TARGETS; i++)
     {
         sprintf(buf, "main.%s", ext_targets[i]);
 
-        if ((preview_path = find_file_case_path (dec_path, buf)) != NULL)
+        if (skin_files_has(files, buf))
+        {
+            preview = skin_files_load_pixbuf(files, buf);
             break;
+        }
     }
 
-    if (preview_path)
-    {
-        preview = gdk_pixbuf_new_from_file(preview_path, NULL);
-        g_free(preview_path);
-    }
-
-    if (is_archive)
-        del_directory(dec_path);
-
-    g_free(dec_path);
+    skin_files_close(files);
 
     return preview;
 }
@@ -27,6 +27,7 @@
 #include <string.h>
 
 #include "draw-compat.h"
+#include "frame.h"
 #include "skins_cfg.h"
 #include "surface.h"
 #include "ui_skin.h"
@@ -190,17 +191,20 @@ void ui_svis_clear_data (GtkWidget * widget)
 
 void ui_svis_timeout_func (GtkWidget * widget, guchar * data)
 {
-    if (config.vis_type == VIS_VOICEPRINT)
-    {
-        for (gint i = 0; i < 2; i ++)
-            svis.data[i] = data[i];
-    }
-    else
+    gint values = (config.vis_type == VIS_VOICEPRINT) ? 2 : 75;
+    gboolean changed = ! svis.active;
+
+    for (gint i = 0; i < values; i ++)
     {
-        for (gint i = 0; i < 75; i ++)
+        if (svis.data[i] != data[i])
+        {
             svis.data[i] = data[i];
+            changed = TRUE;
+        }
     }
 
     svis.active = TRUE;
-    gtk_widget_queue_draw (widget);
+
+    if (changed)
+        frame_queue_draw (widget);
 }
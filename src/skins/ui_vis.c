@@ -27,6 +27,7 @@
 #include <string.h>
 
 #include "draw-compat.h"
+#include "frame.h"
 #include "skins_cfg.h"
 #include "surface.h"
 #include "ui_skin.h"
@@ -248,8 +249,31 @@ void ui_vis_clear_data (GtkWidget * wid)
     gtk_widget_queue_draw (wid);
 }
 
+/* what ui_vis_draw shows for value <i> of the analyzer or scope */
+static gint vis_column (gint i)
+{
+    if (config.vis_type == VIS_ANALYZER)
+    {
+        gint h = vis.data[i], p = config.analyzer_peaks ? vis.peak[i] : 0;
+        return CLAMP (h, 0, 16) << 5 | CLAMP (p, 0, 16);
+    }
+
+    gint h = vis.data[i];
+    return CLAMP (h, 0, 15);
+}
+
 void ui_vis_timeout_func (GtkWidget * widget, guchar * data)
 {
+    gboolean bars = (config.vis_type == VIS_ANALYZER && config.analyzer_type ==
+     ANALYZER_BARS);
+    gint values = bars ? 19 : 75;
+    gint before[75];
+
+    for (gint i = 0; i < values; i ++)
+        before[i] = vis_column (i);
+
+    gboolean was_active = vis.active;
+
     if (config.vis_type == VIS_ANALYZER)
     {
         const gint n = (config.analyzer_type == ANALYZER_BARS) ? 19 : 75;
@@ -312,5 +336,37 @@ void ui_vis_timeout_func (GtkWidget * widget, guchar * data)
     }
 
     vis.active = TRUE;
-    gtk_widget_queue_draw (widget);
+
+    /* the voiceprint scrolls every time; otherwise only the columns whose
+     * values changed are redrawn, if any */
+    if (config.vis_type == VIS_VOICEPRINT || ! was_active)
+    {
+        frame_queue_draw (widget);
+        return;
+    }
+
+    gint first = values, last = -1;
+
+    for (gint i = 0; i < values; i ++)
+    {
+        if (vis_column (i) != before[i])
+        {
+            first = MIN (first, i);
+            last = i;
+        }
+    }
+
+    if (last < 0)
+        return;
+
+    if (bars)
+        frame_queue_draw_area (widget, 4 * first, 0, 4 * (last - first) + 3, 16);
+    else
+    {
+        /* a line segment of the scope also depends on the value to its left */
+        if (config.vis_type == VIS_SCOPE && config.scope_mode == SCOPE_LINE)
+            first = MAX (first - 1, 0);
+
+        frame_queue_draw_area (widget, first, 0, last + 1 - first, 16);
+    }
 }
@@ -28,7 +28,6 @@
 #include <dirent.h>
 #include <stdlib.h>
 #include <string.h>
-#include <strings.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -38,34 +37,22 @@
 #include <audacious/i18n.h>
 #include <libaudcore/audstrings.h>
 #include <libaudcore/hook.h>
-#include <libaudcore/vfs.h>
 
 #include "ui_main.h"
 #include "util.h"
 
-typedef struct
-{
-    const gchar *to_match;
-    gchar *match;
-    gboolean found;
-} FindFileContext;
-
-#ifndef HAVE_MKDTEMP
-static void make_directory(const gchar *path, mode_t mode);
-#endif
+/* folder -> hash table of (lower-cased name -> actual name) */
+static GHashTable * file_case_cache = NULL;
 
 gchar * find_file_case (const gchar * folder, const gchar * basename)
 {
-    static GHashTable * cache = NULL;
-    GList * list = NULL;
-    void * vlist;
+    GHashTable * names;
 
-    if (cache == NULL)
-        cache = g_hash_table_new (g_str_hash, g_str_equal);
+    if (file_case_cache == NULL)
+        file_case_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+         g_free, (GDestroyNotify) g_hash_table_destroy);
 
-    if (g_hash_table_lookup_extended (cache, folder, NULL, & vlist))
-        list = vlist;
-    else
+    if ((names = g_hash_table_lookup (file_case_cache, folder)) == NULL)
     {
         DIR * handle;
         struct dirent * entry;
@@ -73,20 +60,21 @@ gchar * find_file_case (const gchar * folder, const gchar * basename)
         if ((handle = opendir (folder)) == NULL)
             return NULL;
 
+        names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
         while ((entry = readdir (handle)) != NULL)
-            list = g_list_prepend (list, g_strdup (entry->d_name));
+            g_hash_table_insert (names, g_ascii_strdown (entry->d_name, -1),
+             g_strdup (entry->d_name));
 
-        g_hash_table_insert (cache, g_strdup (folder), list);
+        g_hash_table_insert (file_case_cache, g_strdup (folder), names);
         closedir (handle);
     }
 
-    for (; list != NULL; list = list->next)
-    {
-        if (! strcasecmp (list->data, basename))
-            return g_strdup (list->data);
-    }
+    gchar * lower = g_ascii_strdown (basename, -1);
+    gchar * found = g_strdup (g_hash_table_lookup (names, lower));
+    g_free (lower);
 
-    return NULL;
+    return found;
 }
 
 gchar * find_file_case_path (const gchar * folder, const gchar * basename)
@@ -101,42 +89,6 @@ gchar * find_file_case_path (const gchar * folder, const gchar * basename)
     return path;
 }
 
-gchar * find_file_case_uri (const gchar * folder, const gchar * basename)
-{
-    gchar * found, * uri;
-
-    if ((found = find_file_case_path (folder, basename)) == NULL)
-        return NULL;
-
-    uri = g_filename_to_uri (found, NULL, NULL);
-    g_free (found);
-    return uri;
-}
-
-gchar * load_text_file (const gchar * filename)
-{
-    VFSFile * file;
-    gint size;
-    gchar * buffer;
-
-    file = vfs_fopen (filename, "r");
-
-    if (file == NULL)
-        return NULL;
-
-    size = vfs_fsize (file);
-    size = MAX (0, size);
-    buffer = g_malloc (size + 1);
-
-    size = vfs_fread (buffer, 1, size, file);
-    size = MAX (0, size);
-    buffer[size] = 0;
-
-    vfs_fclose (file);
-
-    return buffer;
-}
-
 gchar * text_parse_line (gchar * text)
 {
     gchar * newline = strchr (text, '\n');
@@ -154,12 +106,9 @@ typedef enum
     ARCHIVE_DIR,
     ARCHIVE_TAR,
     ARCHIVE_TGZ,
-    ARCHIVE_ZIP,
-    ARCHIVE_TBZ2
+    ARCHIVE_ZIP
 } ArchiveType;
 
-typedef gchar *(*ArchiveExtractFunc) (const gchar *, const gchar *);
-
 typedef struct
 {
     ArchiveType type;
@@ -172,81 +121,9 @@ static ArchiveExtensionType archive_extensions[] = {
     {ARCHIVE_ZIP, ".zip"},
     {ARCHIVE_TGZ, ".tar.gz"},
     {ARCHIVE_TGZ, ".tgz"},
-    {ARCHIVE_TBZ2, ".tar.bz2"},
-    {ARCHIVE_TBZ2, ".bz2"},
     {ARCHIVE_UNKNOWN, NULL}
 };
 
-static gchar *archive_extract_tar(const gchar *archive, const gchar *dest);
-static gchar *archive_extract_zip(const gchar *archive, const gchar *dest);
-static gchar *archive_extract_tgz(const gchar *archive, const gchar *dest);
-static gchar *archive_extract_tbz2(const gchar *archive, const gchar *dest);
-
-static ArchiveExtractFunc archive_extract_funcs[] = {
-    NULL,
-    NULL,
-    archive_extract_tar,
-    archive_extract_tgz,
-    archive_extract_zip,
-    archive_extract_tbz2
-};
-
-
-/* FIXME: these functions can be generalised into a function using a
- * command lookup table */
-
-static const gchar *get_tar_command(void)
-{
-    static const gchar *command = NULL;
-
-    if (!command)
-    {
-        if (!(command = getenv("TARCMD")))
-            command = "tar";
-    }
-
-    return command;
-}
-
-static const gchar *get_unzip_command(void)
-{
-    static const gchar *command = NULL;
-
-    if (!command)
-    {
-        if (!(command = getenv("UNZIPCMD")))
-            command = "unzip";
-    }
-
-    return command;
-}
-
-
-static gchar *archive_extract_tar(const gchar *archive, const gchar *dest)
-{
-    return g_strdup_printf("%s >/dev/null xf \"%s\" -C %s", get_tar_command(),
-                           archive, dest);
-}
-
-static gchar *archive_extract_zip(const gchar *archive, const gchar *dest)
-{
-    return g_strdup_printf("%s >/dev/null -o -j \"%s\" -d %s",
-                           get_unzip_command(), archive, dest);
-}
-
-static gchar *archive_extract_tgz(const gchar *archive, const gchar *dest)
-{
-    return g_strdup_printf("%s >/dev/null xzf \"%s\" -C %s", get_tar_command(),
-                           archive, dest);
-}
-
-static gchar *archive_extract_tbz2(const gchar *archive, const gchar *dest)
-{
-    return g_strdup_printf("bzip2 -dc \"%s\" | %s >/dev/null xf - -C %s",
-                           archive, get_tar_command(), dest);
-}
-
-
 static ArchiveType archive_get_type(const gchar *filename)
 {
     gint i = 0;
@@ -292,122 +169,401 @@ gchar *archive_basename(const gchar *str)
     return NULL;
 }
 
-/**
- * Escapes characters that are special to the shell inside double quotes.
- *
- * @param string String to be escaped.
- * @return Given string with special characters escaped. Must be freed with g_free().
- */
-static gchar *
-escape_shell_chars(const gchar * string)
+/* A file inside an archive that has been read into memory */
+typedef struct
+{
+    const guchar *data;
+    gsize stored, size;
+    gboolean deflated;
+} ArchiveEntry;
+
+struct _SkinFiles
 {
-    const gchar *special = "$`\"\\";    /* Characters to escape */
-    const gchar *in = string;
-    gchar *out, *escaped;
-    gint num = 0;
+    gchar *folder;        /* a skin that is not packed, or ... */
+    guchar *data;         /* ... an archive (for tar.gz, the decompressed
+                           * tar stream) */
+    gsize len;
+    GHashTable *entries;  /* lower-cased base name -> ArchiveEntry */
+};
+
+#define ARCHIVE_MAX_SIZE (64 << 20)
+
+static guint archive_get_le16(const guchar *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static guint32 archive_get_le32(const guchar *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((guint32) p[3] << 24);
+}
+
+/* Decompresses a zlib stream, either raw deflate (zip) or gzip (tar.gz) */
+static guchar *archive_inflate(const guchar *in, gsize in_len,
+                               GZlibCompressorFormat format, gsize *out_len)
+{
+    GConverter *conv = (GConverter *) g_zlib_decompressor_new(format);
+    GByteArray *out = g_byte_array_new();
+    GConverterResult result;
+    GError *error = NULL;
+    guchar buf[16384];
+    gsize used, written;
+
+    do
+    {
+        result = g_converter_convert(conv, in, in_len, buf, sizeof buf,
+                                     G_CONVERTER_INPUT_AT_END, &used, &written,
+                                     &error);
 
-    while (*in != '\0')
-        if (strchr(special, *in++))
-            num++;
+        if (result == G_CONVERTER_ERROR || out->len + written > ARCHIVE_MAX_SIZE)
+        {
+            if (error)
+            {
+                AUDDBG("Decompression failed: %s\n", error->message);
+                g_error_free(error);
+            }
 
-    escaped = g_malloc(strlen(string) + num + 1);
+            g_byte_array_free(out, TRUE);
+            g_object_unref(conv);
+            return NULL;
+        }
+
+        g_byte_array_append(out, buf, written);
+        in += used;
+        in_len -= used;
+    }
+    while (result != G_CONVERTER_FINISHED);
 
-    in = string;
-    out = escaped;
+    g_object_unref(conv);
 
-    while (*in != '\0') {
-        if (strchr(special, *in))
-            *out++ = '\\';
-        *out++ = *in++;
+    *out_len = out->len;
+    return g_byte_array_free(out, FALSE);
+}
+
+static void archive_add_entry(SkinFiles *files, const gchar *name,
+                              gsize name_len, const guchar *data, gsize stored,
+                              gsize size, gboolean deflated)
+{
+    ArchiveEntry *entry;
+    const gchar *base = name;
+    gsize i;
+
+    /* skins are flat, so directories inside the archive are ignored */
+    for (i = 0; i < name_len && name[i]; i++)
+    {
+        if (name[i] == '/' || name[i] == '\\')
+            base = name + i + 1;
     }
-    *out = '\0';
 
-    return escaped;
+    if (base == name + i)
+        return;
+
+    entry = g_new(ArchiveEntry, 1);
+    entry->data = data;
+    entry->stored = stored;
+    entry->size = size;
+    entry->deflated = deflated;
+
+    g_hash_table_insert(files->entries,
+                        g_ascii_strdown(base, name + i - base), entry);
+}
+
+static gboolean archive_read_zip(SkinFiles *files)
+{
+    const guchar *d = files->data;
+    gsize len = files->len, pos, i;
+    guint count, n;
+
+    if (len < 22)
+        return FALSE;
+
+    /* the end of central directory record, followed by up to 64 KB of
+     * comment */
+    for (i = len - 22; ; i--)
+    {
+        if (archive_get_le32(d + i) == 0x06054b50)
+            break;
+
+        if (i == 0 || len - i > 22 + 65535)
+            return FALSE;
+    }
+
+    count = archive_get_le16(d + i + 10);
+    pos = archive_get_le32(d + i + 16);
+
+    for (n = 0; n < count; n++)
+    {
+        guint method, name_len;
+        gsize stored, size, local, start;
+
+        if (pos > len || len - pos < 46 ||
+            archive_get_le32(d + pos) != 0x02014b50)
+            return FALSE;
+
+        method = archive_get_le16(d + pos + 10);
+        stored = archive_get_le32(d + pos + 20);
+        size = archive_get_le32(d + pos + 24);
+        name_len = archive_get_le16(d + pos + 28);
+        local = archive_get_le32(d + pos + 42);
+
+        if (len - pos - 46 < name_len || local > len || len - local < 30 ||
+            archive_get_le32(d + local) != 0x04034b50)
+            return FALSE;
+
+        start = local + 30 + archive_get_le16(d + local + 26) +
+            archive_get_le16(d + local + 28);
+
+        if (start > len || len - start < stored)
+            return FALSE;
+
+        if (method == 0 || method == 8)
+            archive_add_entry(files, (const gchar *) d + pos + 46, name_len,
+                              d + start, stored, size, method == 8);
+
+        pos += 46 + name_len + archive_get_le16(d + pos + 30) +
+            archive_get_le16(d + pos + 32);
+    }
+
+    return TRUE;
+}
+
+static gboolean archive_read_tar(SkinFiles *files)
+{
+    const guchar *d = files->data;
+    gsize len = files->len, pos = 0;
+    const gchar *long_name = NULL;
+    gsize long_name_len = 0;
+
+    while (len - pos >= 512 && d[pos])
+    {
+        const guchar *header = d + pos;
+        gsize size = 0;
+        gint i;
+
+        /* octal, padded with spaces or NULs */
+        for (i = 124; i < 136; i++)
+        {
+            if (header[i] >= '0' && header[i] <= '7')
+                size = (size << 3) | (header[i] - '0');
+            else if (header[i] != ' ')
+                break;
+        }
+
+        pos += 512;
+
+        if (len - pos < size)
+            return FALSE;
+
+        if (header[156] == 'L')
+        {
+            /* GNU long name, applying to the next entry */
+            long_name = (const gchar *) d + pos;
+            long_name_len = size;
+        }
+        else
+        {
+            if (header[156] == '0' || header[156] == 0)
+            {
+                if (long_name)
+                    archive_add_entry(files, long_name, long_name_len,
+                                      d + pos, size, size, FALSE);
+                else
+                    archive_add_entry(files, (const gchar *) header, 100,
+                                      d + pos, size, size, FALSE);
+            }
+
+            long_name = NULL;
+        }
+
+        if (len - pos < ((size + 511) & ~(gsize) 511))
+            break;
+
+        pos += (size + 511) & ~(gsize) 511;
+    }
+
+    return TRUE;
 }
 
 /*
-   decompress_archive
+   skin_files_open
 
-   Decompresses the archive "filename" to a temporary directory,
-   returns the path to the temp dir, or NULL if failed,
-   watch out tho, doesn't actually check if the system command succeeds :-|
+   Opens a skin folder, or reads a skin archive into memory.  Archived files
+   are decompressed only when they are loaded.  Returns NULL if the path is
+   neither a folder nor a readable archive.
 */
-
-gchar *archive_decompress(const gchar *filename)
+SkinFiles *skin_files_open(const gchar *path)
 {
-    gchar *tmpdir, *cmd, *escaped_filename;
-    ArchiveType type;
-#ifndef HAVE_MKDTEMP
-#ifdef S_IRGRP
-    mode_t mode755 = S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
-#else
-    mode_t mode755 = S_IRWXU;
-#endif
-#endif
-
-    if ((type = archive_get_type(filename)) <= ARCHIVE_DIR)
+    ArchiveType type = archive_get_type(path);
+    SkinFiles *files;
+    gchar *raw;
+    gsize raw_len;
+    gboolean ok;
+
+    if (type == ARCHIVE_UNKNOWN)
         return NULL;
 
-#ifdef HAVE_MKDTEMP
-    tmpdir = g_build_filename(g_get_tmp_dir(), "audacious.XXXXXXXX", NULL);
-    if (!mkdtemp(tmpdir))
+    files = g_new0(SkinFiles, 1);
+
+    if (type == ARCHIVE_DIR)
     {
-        g_free(tmpdir);
-        AUDDBG("Unable to load skin: Failed to create temporary "
-               "directory: %s\n", g_strerror(errno));
-        return NULL;
+        files->folder = g_strdup(path);
+        return files;
     }
-#else
-    tmpdir = g_strdup_printf("%s/audacious.%ld", g_get_tmp_dir(), (long)rand());
-    make_directory(tmpdir, mode755);
-#endif
 
-    escaped_filename = escape_shell_chars(filename);
-    cmd = archive_extract_funcs[type] (escaped_filename, tmpdir);
-    g_free(escaped_filename);
+    files->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                           g_free);
 
-    if (!cmd)
+    if (g_file_get_contents(path, &raw, &raw_len, NULL))
     {
-        AUDDBG("extraction function is NULL!\n");
-        g_free(tmpdir);
-        return NULL;
+        if (type == ARCHIVE_TGZ)
+        {
+            files->data = archive_inflate((const guchar *) raw, raw_len,
+                                          G_ZLIB_COMPRESSOR_FORMAT_GZIP,
+                                          &files->len);
+            g_free(raw);
+        }
+        else
+        {
+            files->data = (guchar *) raw;
+            files->len = raw_len;
+        }
     }
 
-    AUDDBG("Attempt to execute \"%s\"\n", cmd);
+    if (!files->data)
+        ok = FALSE;
+    else if (type == ARCHIVE_ZIP)
+        ok = archive_read_zip(files);
+    else
+        ok = archive_read_tar(files);
 
-    if (system(cmd) != 0)
+    if (!ok || !g_hash_table_size(files->entries))
     {
-        AUDDBG("could not execute cmd %s\n", cmd);
-        g_free(cmd);
+        AUDDBG("Unable to read skin archive %s\n", path);
+        skin_files_close(files);
         return NULL;
     }
-    g_free(cmd);
 
-    return tmpdir;
+    return files;
 }
 
-static gboolean del_directory_func(const gchar *path, const gchar *basename,
-                                   void *params)
+void skin_files_close(SkinFiles *files)
 {
-    if (!strcmp(basename, ".") || !strcmp(path, ".."))
-        return FALSE;
+    if (files->entries)
+        g_hash_table_destroy(files->entries);
+
+    g_free(files->folder);
+    g_free(files->data);
+    g_free(files);
+}
 
-    if (g_file_test(path, G_FILE_TEST_IS_DIR))
+gboolean skin_files_has(SkinFiles *files, const gchar *name)
+{
+    gchar *lower, *found;
+    gboolean has;
+
+    if (files->folder)
     {
-        dir_foreach(path, del_directory_func, NULL, NULL);
-        rmdir(path);
-        return FALSE;
+        if ((found = find_file_case(files->folder, name)) == NULL)
+            return FALSE;
+
+        g_free(found);
+        return TRUE;
+    }
+
+    lower = g_ascii_strdown(name, -1);
+    has = (g_hash_table_lookup(files->entries, lower) != NULL);
+    g_free(lower);
+
+    return has;
+}
+
+/*
+   skin_files_load
+
+   Loads the file "name" (matched without regard to case) from a skin.  The
+   contents are terminated with a NUL byte, which is not counted in *len, and
+   must be freed with g_free().  Returns NULL if the file was not found.
+*/
+gchar *skin_files_load(SkinFiles *files, const gchar *name, gsize *len)
+{
+    ArchiveEntry *entry;
+    gchar *lower, *path, *data = NULL;
+    gsize size = 0;
+
+    if (files->folder)
+    {
+        if ((path = find_file_case_path(files->folder, name)) == NULL)
+            return NULL;
+
+        if (!g_file_get_contents(path, &data, &size, NULL))
+            data = NULL;
+
+        g_free(path);
+    }
+    else
+    {
+        lower = g_ascii_strdown(name, -1);
+        entry = g_hash_table_lookup(files->entries, lower);
+        g_free(lower);
+
+        if (entry == NULL)
+            return NULL;
+
+        if (entry->deflated)
+        {
+            guchar *inflated = archive_inflate(entry->data, entry->stored,
+                                               G_ZLIB_COMPRESSOR_FORMAT_RAW,
+                                               &size);
+
+            if (inflated)
+            {
+                data = g_realloc(inflated, size + 1);
+                data[size] = 0;
+            }
+        }
+        else
+        {
+            size = entry->stored;
+            data = g_malloc(size + 1);
+            memcpy(data, entry->data, size);
+            data[size] = 0;
+        }
     }
 
-    unlink(path);
+    if (len)
+        *len = size;
 
-    return FALSE;
+    return data;
 }
 
-void del_directory(const gchar *path)
+GdkPixbuf *skin_files_load_pixbuf(SkinFiles *files, const gchar *name)
 {
-    dir_foreach(path, del_directory_func, NULL, NULL);
-    rmdir(path);
+    GdkPixbufLoader *loader;
+    GdkPixbuf *pixbuf = NULL;
+    GError *error = NULL;
+    gchar *data;
+    gsize len;
+
+    if ((data = skin_files_load(files, name, &len)) == NULL)
+        return NULL;
+
+    loader = gdk_pixbuf_loader_new();
+
+    if (!gdk_pixbuf_loader_write(loader, (const guchar *) data, len, &error))
+        gdk_pixbuf_loader_close(loader, NULL);
+    else if (gdk_pixbuf_loader_close(loader, &error))
+        pixbuf = g_object_ref(gdk_pixbuf_loader_get_pixbuf(loader));
+
+    if (error)
+    {
+        fprintf(stderr, "Error loading %s: %s.\n", name, error->message);
+        g_error_free(error);
+    }
+
+    g_object_unref(loader);
+    g_free(data);
+
+    return pixbuf;
 }
 
 static void strip_string(GString *string)
@@ -439,7 +595,7 @@ static void close_ini_file_free_section(gpointer section)
     g_hash_table_destroy((GHashTable *)section);
 }
 
-INIFile *open_ini_file(const gchar *filename)
+INIFile *open_ini_file(SkinFiles *files, const gchar *name)
 {
     GHashTable *ini_file = NULL;
     GHashTable *section = NULL;
@@ -451,13 +607,12 @@ INIFile *open_ini_file(const gchar *filename)
 
     unsigned char x[] = { 0xff, 0xfe, 0x00 };
 
-    g_return_val_if_fail(filename, NULL);
+    g_return_val_if_fail(name, NULL);
 
-    void * vbuf = NULL;
-    vfs_file_get_contents (filename, & vbuf, & filesize);
-    if (! vbuf)
+    gsize len;
+    if (! (buffer = (guchar *) skin_files_load (files, name, & len)))
         return NULL;
-    buffer = vbuf;
+    filesize = len;
 
     /*
      * Convert UTF-16 into something useful. Original implementation
@@ -764,17 +919,6 @@ GtkWidget *make_filebrowser(const gchar *title, gboolean save)
     return dialog;
 }
 
-#ifndef HAVE_MKDTEMP
-static void make_directory(const gchar *path, mode_t mode)
-{
-    if (g_mkdir_with_parents(path, mode) == 0)
-        return;
-
-    g_printerr(_("Could not create directory (%s): %s\n"), path,
-               g_strerror(errno));
-}
-#endif
-
 void check_set (GtkActionGroup * action_group, const gchar * action_name,
  gboolean is_on)
 {
@@ -33,18 +33,24 @@ typedef gboolean(*DirForeachFunc) (const gchar *path, const gchar *basename,
 
 gchar * find_file_case (const gchar * folder, const gchar * basename);
 gchar * find_file_case_path (const gchar * folder, const gchar * basename);
-gchar * find_file_case_uri (const gchar * folder, const gchar * basename);
 
-gchar * load_text_file (const gchar * filename);
 gchar * text_parse_line (gchar * text);
 
-void del_directory(const gchar *dirname);
 gboolean dir_foreach(const gchar *path, DirForeachFunc function,
                      gpointer user_data, GError **error);
 
+/* the files of a skin, either in a folder or read from an archive */
+typedef struct _SkinFiles SkinFiles;
+
+SkinFiles *skin_files_open(const gchar *path);
+void skin_files_close(SkinFiles *files);
+gboolean skin_files_has(SkinFiles *files, const gchar *name);
+gchar *skin_files_load(SkinFiles *files, const gchar *name, gsize *len);
+GdkPixbuf *skin_files_load_pixbuf(SkinFiles *files, const gchar *name);
+
 typedef GHashTable INIFile;
 
-INIFile *open_ini_file(const gchar *filename);
+INIFile *open_ini_file(SkinFiles *files, const gchar *name);
 void close_ini_file(INIFile *key_file);
 gchar *read_ini_string(INIFile *key_file, const gchar *section,
                        const gchar *key);
@@ -54,7 +60,6 @@ GArray *read_ini_array(INIFile *key_file, const gchar *section,
 GArray *string_to_garray(const gchar *str);
 
 gboolean file_is_archive(const gchar *filename);
-gchar *archive_decompress(const gchar *path);
 gchar *archive_basename(const gchar *path);
 
 GtkWidget *make_filebrowser(const gchar *title, gboolean save);
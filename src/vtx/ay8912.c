@@ -392,16 +392,158 @@ static void prepare_generation(ayemu_ay_t *ay)
 }
 
 
+/* Number of chip tacts until a counter with the given period next flips
+   its generator (the counter is incremented before it is compared). */
+static inline int tacts_to_edge(int cnt, int period)
+{
+  return (cnt < period - 1) ? period - cnt : 1;
+}
+
+#define ENVVOL Envelope [ay->regs.env_style][ay->env_pos]
+
+/* Mixer output for the current generator state. */
+static inline void mix_tact(ayemu_ay_t *ay, int *mix_l, int *mix_r)
+{
+  int tmpvol;
+  int l = 0, r = 0;
+
+  if ((ay->bit_a | !ay->regs.R7_tone_a) & (ay->bit_n | !ay->regs.R7_noise_a)) {
+    tmpvol = (ay->regs.env_a)? ENVVOL : ay->regs.vol_a * 2 + 1;
+    l += ay->vols[0][tmpvol];
+    r += ay->vols[1][tmpvol];
+  }
+
+  if ((ay->bit_b | !ay->regs.R7_tone_b) & (ay->bit_n | !ay->regs.R7_noise_b)) {
+    tmpvol =(ay->regs.env_b)? ENVVOL :  ay->regs.vol_b * 2 + 1;
+    l += ay->vols[2][tmpvol];
+    r += ay->vols[3][tmpvol];
+  }
+
+  if ((ay->bit_c | !ay->regs.R7_tone_c) & (ay->bit_n | !ay->regs.R7_noise_c)) {
+    tmpvol = (ay->regs.env_c)? ENVVOL : ay->regs.vol_c * 2 + 1;
+    l += ay->vols[4][tmpvol];
+    r += ay->vols[5][tmpvol];
+  }
+
+  *mix_l = l;
+  *mix_r = r;
+}
+
+/* Advance all generators by one chip tact. */
+static inline void step_tact(ayemu_ay_t *ay)
+{
+  if (++ay->cnt_a >= ay->regs.tone_a) {
+    ay->cnt_a = 0;
+    ay->bit_a = ! ay->bit_a;
+  }
+  if (++ay->cnt_b >= ay->regs.tone_b) {
+    ay->cnt_b = 0;
+    ay->bit_b = ! ay->bit_b;
+  }
+  if (++ay->cnt_c >= ay->regs.tone_c) {
+    ay->cnt_c = 0;
+    ay->bit_c = ! ay->bit_c;
+  }
+
+  /* GenNoise (c) Hacker KAY & Sergey Bulba */
+  if (++ay->cnt_n >= (ay->regs.noise * 2)) {
+    ay->cnt_n = 0;
+    ay->Cur_Seed = (ay->Cur_Seed * 2 + 1) ^ \
+      (((ay->Cur_Seed >> 16) ^ (ay->Cur_Seed >> 13)) & 1);
+    ay->bit_n = ((ay->Cur_Seed >> 16) & 1);
+  }
+
+  if (++ay->cnt_e >= ay->regs.env_freq) {
+    ay->cnt_e = 0;
+    if (++ay->env_pos > 127)
+      ay->env_pos = 64;
+  }
+}
+
+/* Advance a counter with the given period by n tacts.
+   Returns the number of times its generator flipped. */
+static inline int advance_counter(int *cnt, int period, int n)
+{
+  int first = tacts_to_edge(*cnt, period);
+  int step = (period > 1) ? period : 1;
+
+  if (n < first) {
+    *cnt += n;
+    return 0;
+  }
+
+  n -= first;
+  *cnt = n % step;
+  return 1 + n / step;
+}
+
+/* Advance all generators by n tacts during which the mixer output does
+   not change. Generators that are not audible may still flip. */
+static void skip_tacts(ayemu_ay_t *ay, int n)
+{
+  int flips;
+
+  if (advance_counter(&ay->cnt_a, ay->regs.tone_a, n) & 1)
+    ay->bit_a = ! ay->bit_a;
+  if (advance_counter(&ay->cnt_b, ay->regs.tone_b, n) & 1)
+    ay->bit_b = ! ay->bit_b;
+  if (advance_counter(&ay->cnt_c, ay->regs.tone_c, n) & 1)
+    ay->bit_c = ! ay->bit_c;
+
+  flips = advance_counter(&ay->cnt_n, ay->regs.noise * 2, n);
+  if (flips) {
+    while (flips--)
+      ay->Cur_Seed = (ay->Cur_Seed * 2 + 1) ^ \
+	(((ay->Cur_Seed >> 16) ^ (ay->Cur_Seed >> 13)) & 1);
+    ay->bit_n = ((ay->Cur_Seed >> 16) & 1);
+  }
+
+  flips = advance_counter(&ay->cnt_e, ay->regs.env_freq, n);
+  if (ay->env_pos + flips > 127)
+    ay->env_pos = 64 + (ay->env_pos + flips - 64) % 64;
+  else
+    ay->env_pos += flips;
+}
+
+/* Scale one accumulated output count and store it in the sound buffer. */
+static inline unsigned char *put_sample(ayemu_ay_t *ay, unsigned char *sound_buf, int mix_l, int mix_r)
+{
+  mix_l /= ay->Amp_Global;
+  mix_r /= ay->Amp_Global;
+
+  if (ay->sndfmt.bpc == 8) {
+    mix_l = (mix_l >> 8) | 128; /* 8 bit sound */
+    mix_r = (mix_r >> 8) | 128;
+    *sound_buf++ = mix_l;
+    if (ay->sndfmt.channels != 1)
+      *sound_buf++ = mix_r;
+  } else {
+    *sound_buf++ = mix_l & 0x00FF; /* 16 bit sound */
+    *sound_buf++ = (mix_l >> 8);
+    if (ay->sndfmt.channels != 1) {
+      *sound_buf++ = mix_r & 0x00FF;
+      *sound_buf++ = (mix_r >> 8);
+    }
+  }
+
+  return sound_buf;
+}
+
 /*! Generate sound.
  * Fill sound buffer with current register data
  * Return value: pointer to next data in output sound buffer
  * \retval \b 1 if OK, \b 0 if error occures.
+ *
+ * Rather than stepping every generator on every chip tact, the distance
+ * to the next edge of an audible tone, noise or envelope generator is
+ * computed first; the mixer output cannot change before that edge, so the
+ * whole run (which may span several output counts) is accumulated at once.
  */
 void *ayemu_gen_sound(ayemu_ay_t *ay, void *buff, size_t sound_bufsize)
 {
   int mix_l, mix_r;
-  int tmpvol;
-  int m;
+  int tact_l, tact_r;
+  int tacts, quiet, n, edge;
   int snd_numcount;
   unsigned char *sound_buf = buff;
 
@@ -411,74 +553,76 @@ void *ayemu_gen_sound(ayemu_ay_t *ay, void *buff, size_t sound_bufsize)
   prepare_generation(ay);
 
   snd_numcount = sound_bufsize / (ay->sndfmt.channels * (ay->sndfmt.bpc >> 3));
-  while (snd_numcount-- > 0) {
-    mix_l = mix_r = 0;
-
-    for (m = 0 ; m < ay->ChipTacts_per_outcount ; m++) {
-      if (++ay->cnt_a >= ay->regs.tone_a) {
-	ay->cnt_a = 0;
-	ay->bit_a = ! ay->bit_a;
-      }
-      if (++ay->cnt_b >= ay->regs.tone_b) {
-	ay->cnt_b = 0;
-	ay->bit_b = ! ay->bit_b;
-      }
-      if (++ay->cnt_c >= ay->regs.tone_c) {
-	ay->cnt_c = 0;
-	ay->bit_c = ! ay->bit_c;
+  tacts = ay->ChipTacts_per_outcount;
+  mix_l = mix_r = 0;
+
+  while (snd_numcount > 0) {
+    /* quiet tacts before the next edge of an audible generator */
+    quiet = INT32_MAX;
+    if (ay->regs.R7_tone_a && (edge = tacts_to_edge(ay->cnt_a, ay->regs.tone_a)) < quiet)
+      quiet = edge;
+    if (ay->regs.R7_tone_b && (edge = tacts_to_edge(ay->cnt_b, ay->regs.tone_b)) < quiet)
+      quiet = edge;
+    if (ay->regs.R7_tone_c && (edge = tacts_to_edge(ay->cnt_c, ay->regs.tone_c)) < quiet)
+      quiet = edge;
+    if ((ay->regs.R7_noise_a || ay->regs.R7_noise_b || ay->regs.R7_noise_c) &&
+     (edge = tacts_to_edge(ay->cnt_n, ay->regs.noise * 2)) < quiet)
+      quiet = edge;
+    if ((ay->regs.env_a || ay->regs.env_b || ay->regs.env_c) &&
+     (edge = tacts_to_edge(ay->cnt_e, ay->regs.env_freq)) < quiet)
+      quiet = edge;
+    quiet--;
+
+    /* with the edge inside this output count, as with fast noise or
+       envelopes, stepping the rest of the count tact by tact is cheaper
+       than working out each short run */
+    if (quiet < tacts) {
+      while (tacts > 0) {
+	step_tact(ay);
+	mix_tact(ay, &tact_l, &tact_r);
+	mix_l += tact_l;
+	mix_r += tact_r;
+	tacts--;
       }
 
-      /* GenNoise (c) Hacker KAY & Sergey Bulba */
-      if (++ay->cnt_n >= (ay->regs.noise * 2)) {
-	ay->cnt_n = 0;
-	ay->Cur_Seed = (ay->Cur_Seed * 2 + 1) ^ \
-	  (((ay->Cur_Seed >> 16) ^ (ay->Cur_Seed >> 13)) & 1);
-	ay->bit_n = ((ay->Cur_Seed >> 16) & 1);
-      }
+      sound_buf = put_sample(ay, sound_buf, mix_l, mix_r);
+      snd_numcount--;
+      tacts = ay->ChipTacts_per_outcount;
+      mix_l = mix_r = 0;
+      continue;
+    }
 
-      if (++ay->cnt_e >= ay->regs.env_freq) {
-	ay->cnt_e = 0;
-	if (++ay->env_pos > 127)
-	  ay->env_pos = 64;
-      }
+    mix_tact(ay, &tact_l, &tact_r);
 
-#define ENVVOL Envelope [ay->regs.env_style][ay->env_pos]
+    while (quiet > 0 && snd_numcount > 0) {
+      n = (quiet < tacts) ? quiet : tacts;
+      mix_l += tact_l * n;
+      mix_r += tact_r * n;
+      skip_tacts(ay, n);
+      quiet -= n;
 
-      if ((ay->bit_a | !ay->regs.R7_tone_a) & (ay->bit_n | !ay->regs.R7_noise_a)) {
-	tmpvol = (ay->regs.env_a)? ENVVOL : ay->regs.vol_a * 2 + 1;
-	mix_l += ay->vols[0][tmpvol];
-	mix_r += ay->vols[1][tmpvol];
+      if ((tacts -= n) == 0) {
+	sound_buf = put_sample(ay, sound_buf, mix_l, mix_r);
+	snd_numcount--;
+	tacts = ay->ChipTacts_per_outcount;
+	mix_l = mix_r = 0;
       }
+    }
 
-      if ((ay->bit_b | !ay->regs.R7_tone_b) & (ay->bit_n | !ay->regs.R7_noise_b)) {
-	tmpvol =(ay->regs.env_b)? ENVVOL :  ay->regs.vol_b * 2 + 1;
-	mix_l += ay->vols[2][tmpvol];
-	mix_r += ay->vols[3][tmpvol];
-      }
+    if (snd_numcount <= 0)
+      break;
 
-      if ((ay->bit_c | !ay->regs.R7_tone_c) & (ay->bit_n | !ay->regs.R7_noise_c)) {
-	tmpvol = (ay->regs.env_c)? ENVVOL : ay->regs.vol_c * 2 + 1;
-	mix_l += ay->vols[4][tmpvol];
-	mix_r += ay->vols[5][tmpvol];
-      }
-    } /* end for (m=0; ...) */
-
-    mix_l /= ay->Amp_Global;
-    mix_r /= ay->Amp_Global;
-
-    if (ay->sndfmt.bpc == 8) {
-      mix_l = (mix_l >> 8) | 128; /* 8 bit sound */
-      mix_r = (mix_r >> 8) | 128;
-      *sound_buf++ = mix_l;
-      if (ay->sndfmt.channels != 1)
-	*sound_buf++ = mix_r;
-    } else {
-      *sound_buf++ = mix_l & 0x00FF; /* 16 bit sound */
-      *sound_buf++ = (mix_l >> 8);
-      if (ay->sndfmt.channels != 1) {
-	*sound_buf++ = mix_r & 0x00FF;
-	*sound_buf++ = (mix_r >> 8);
-      }
+    /* the edge tact itself */
+    step_tact(ay);
+    mix_tact(ay, &tact_l, &tact_r);
+    mix_l += tact_l;
+    mix_r += tact_r;
+
+    if (--tacts == 0) {
+      sound_buf = put_sample(ay, sound_buf, mix_l, mix_r);
+      snd_numcount--;
+      tacts = ay->ChipTacts_per_outcount;
+      mix_l = mix_r = 0;
     }
   }
   return sound_buf;
@@ -42,7 +42,8 @@ static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 static int seek_value = -1;
 static bool_t stop_flag = FALSE;
 
-/* xsf_get_lib: called to load secondary files */
+/* xsf_get_lib: called to load secondary files (during playback only, so
+ * the tuple reader below does not depend on dirpath) */
 static const char *dirpath;
 
 int xsf_get_lib(char *filename, void **buffer, unsigned int *length)
@@ -72,7 +73,10 @@ Tuple *xsf_tuple(const char *filename, VFSFile *fd)
 		return NULL;
 
 	if (corlett_decode(buf, sz, NULL, NULL, &c) != AO_SUCCESS)
+	{
+		free(buf);
 		return NULL;
+	}
 
 	t = tuple_new_from_filename(filename);
 
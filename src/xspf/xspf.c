@@ -26,9 +26,7 @@
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 #include <libxml/xmlreader.h>
-#include <libxml/xmlsave.h>
-#include <libxml/xpath.h>
-#include <libxml/xpathInternals.h>
+#include <libxml/xmlwriter.h>
 #include <libxml/uri.h>
 
 #include <audacious/i18n.h>
@@ -171,18 +169,6 @@ static void xspf_add_file (xmlNode * track, const gchar * filename, const gchar
 }
 
 
-static void xspf_find_track (xmlNode * tracklist, const gchar * filename, const
- gchar * base, Index * filenames, Index * tuples)
-{
-    xmlNode *nptr;
-
-    for (nptr = tracklist->children; nptr != NULL; nptr = nptr->next) {
-        if (nptr->type == XML_ELEMENT_NODE &&
-         ! xmlStrcmp (nptr->name, (xmlChar *) "track"))
-            xspf_add_file (nptr, filename, base, filenames, tuples);
-    }
-}
-
 static gint read_cb (void * file, gchar * buf, gint len)
 {
     return vfs_fread (buf, 1, len, file);
@@ -198,51 +184,70 @@ static gint close_cb (void * file)
     return 0;
 }
 
+/* The playlist is read with an xmlTextReader rather than parsed into a full
+ * document; only the subtree of the current <track> is expanded, so memory
+ * use no longer grows with the length of the playlist. */
 static gboolean xspf_playlist_load (const gchar * filename, VFSFile * file,
  gchar * * title, Index * filenames, Index * tuples)
 {
-    xmlDoc * doc = xmlReadIO (read_cb, close_cb, file, filename, NULL,
-     XML_PARSE_RECOVER);
-    if (! doc)
+    xmlTextReader * reader = xmlReaderForIO (read_cb, close_cb, file, filename,
+     NULL, XML_PARSE_RECOVER);
+    if (! reader)
         return FALSE;
 
     * title = NULL;
 
-    xmlNode *nptr, *nptr2;
+    gchar * base = NULL;
+    gboolean in_playlist = FALSE, in_tracklist = FALSE;
+    gint ret;
+
+    while ((ret = xmlTextReaderRead (reader)) == 1)
+    {
+        if (xmlTextReaderNodeType (reader) != XML_READER_TYPE_ELEMENT)
+            continue;
 
-    // find trackList
-    for (nptr = doc->children; nptr != NULL; nptr = nptr->next) {
-        if (nptr->type == XML_ELEMENT_NODE &&
-            !xmlStrcmp(nptr->name, (xmlChar *)"playlist")) {
-            gchar * base;
+        const xmlChar * name = xmlTextReaderConstLocalName (reader);
+        gint depth = xmlTextReaderDepth (reader);
 
-            base = (gchar *)xmlNodeGetBase(doc, nptr);
+        if (depth == 0)
+        {
+            in_playlist = ! xmlStrcmp (name, (xmlChar *) "playlist");
+            in_tracklist = FALSE;
 
-            for (nptr2 = nptr->children; nptr2; nptr2 = nptr2->next)
+            if (in_playlist)
             {
-                if (nptr2->type != XML_ELEMENT_NODE)
-                    continue;
+                xmlFree (base);
+                base = (gchar *) xmlTextReaderBaseUri (reader);
+            }
+        }
+        else if (depth == 1 && in_playlist)
+        {
+            in_tracklist = ! xmlStrcmp (name, (xmlChar *) "trackList");
 
-                if (! xmlStrcmp (nptr2->name, (xmlChar *) "title"))
+            if (! xmlStrcmp (name, (xmlChar *) "title"))
+            {
+                xmlChar * xml_title = xmlTextReaderReadString (reader);
+                if (xml_title && xml_title[0])
                 {
-                    xmlChar * xml_title = xmlNodeGetContent (nptr2);
-                    if (xml_title && xml_title[0])
-                    {
-                        str_unref (* title);
-                        * title = str_get ((gchar *) xml_title);
-                    }
-                    xmlFree (xml_title);
+                    str_unref (* title);
+                    * title = str_get ((gchar *) xml_title);
                 }
-                else if (! xmlStrcmp (nptr2->name, (xmlChar *) "trackList"))
-                    xspf_find_track (nptr2, filename, base, filenames, tuples);
+                xmlFree (xml_title);
             }
-
-            xmlFree (base);
+        }
+        else if (depth == 2 && in_tracklist && ! xmlStrcmp (name, (xmlChar *)
+         "track"))
+        {
+            xmlNode * track = xmlTextReaderExpand (reader);
+            if (track)
+                xspf_add_file (track, filename, base, filenames, tuples);
         }
     }
 
-    xmlFreeDoc(doc);
-    return TRUE;
+    xmlFree (base);
+    xmlFreeTextReader (reader);
+
+    return (ret == 0 || index_count (filenames) > 0);
 }
 
 
@@ -256,6 +261,14 @@ static gboolean xspf_playlist_load (const gchar * filename, VFSFile * file,
 /* check for characters that are invalid in XML */
 static gboolean is_valid_string (const gchar * s, gchar * * subst)
 {
+    /* plain ASCII is by far the common case and needs no decoding */
+    const guchar * a = (const guchar *) s;
+    while ((* a >= 0x20 && * a < 0x80) || * a == 0x9 || * a == 0xa || * a == 0xd)
+        a ++;
+
+    if (! * a)
+        return TRUE;
+
     if (! g_utf8_validate (s, -1, NULL))
         goto NOT_VALID;
 
@@ -311,125 +324,142 @@ NOT_VALID:;
 }
 
 
-static void xspf_add_node(xmlNodePtr node, TupleValueType type,
-        gboolean isMeta, const gchar *xspfName, const gchar *strVal,
-        const gint intVal)
+static gboolean xspf_write_node (xmlTextWriter * writer, TupleValueType type,
+ gboolean isMeta, const gchar * xspfName, const gchar * strVal, gint intVal)
 {
     gchar tmps[64];
-    xmlNodePtr tmp;
-
-    if (isMeta) {
-        tmp = xmlNewNode(NULL, (xmlChar *) "meta");
-        xmlSetProp(tmp, (xmlChar *) "rel", (xmlChar *) xspfName);
-    } else
-        tmp = xmlNewNode(NULL, (xmlChar *) xspfName);
+    const gchar * text = tmps;
+    gchar * subst = NULL;
 
     switch (type) {
-        case TUPLE_STRING:;
-            gchar * subst;
+        case TUPLE_STRING:
             if (is_valid_string (strVal, & subst))
-                xmlAddChild (tmp, xmlNewText ((xmlChar *) strVal));
+                text = strVal;
             else
-            {
-                xmlAddChild (tmp, xmlNewText ((xmlChar *) subst));
-                g_free (subst);
-            }
+                text = subst;
             break;
 
         case TUPLE_INT:
-            g_snprintf(tmps, sizeof(tmps), "%d", intVal);
-            xmlAddChild(tmp, xmlNewText((xmlChar *) tmps));
+            g_snprintf (tmps, sizeof tmps, "%d", intVal);
             break;
 
         default:
-            break;
+            return TRUE;
     }
 
-    xmlAddChild(node, tmp);
-}
+    gboolean success;
 
+    if (isMeta)
+        success = (xmlTextWriterStartElement (writer, (xmlChar *) "meta") >= 0 &&
+         xmlTextWriterWriteAttribute (writer, (xmlChar *) "rel", (xmlChar *)
+         xspfName) >= 0 && xmlTextWriterWriteString (writer, (xmlChar *) text)
+         >= 0 && xmlTextWriterEndElement (writer) >= 0);
+    else
+        success = (xmlTextWriterWriteElement (writer, (xmlChar *) xspfName,
+         (xmlChar *) text) >= 0);
 
-static gboolean xspf_playlist_save (const gchar * filename, VFSFile * file,
- const gchar * title, Index * filenames, Index * tuples)
+    g_free (subst);
+    return success;
+}
+
+static gboolean xspf_write_track (xmlTextWriter * writer, const gchar *
+ filename, const Tuple * tuple)
 {
-    gint entries = index_count (filenames);
-    xmlDocPtr doc;
-    xmlNodePtr rootnode, tracklist;
-    gint count;
+    if (xmlTextWriterStartElement (writer, (xmlChar *) "track") < 0 ||
+     xmlTextWriterWriteElement (writer, (xmlChar *) "location", (xmlChar *)
+     filename) < 0)
+        return FALSE;
 
-    doc = xmlNewDoc((xmlChar *)"1.0");
-    doc->charset = XML_CHAR_ENCODING_UTF8;
-    doc->encoding = xmlStrdup((xmlChar *)"UTF-8");
+    if (tuple != NULL)
+    {
+        for (gint i = 0; i < xspf_nentries; i ++)
+        {
+            const xspf_entry_t * xs = & xspf_entries[i];
 
-    rootnode = xmlNewNode(NULL, (xmlChar *)XSPF_ROOT_NODE_NAME);
-    xmlSetProp(rootnode, (xmlChar *)"version", (xmlChar *)"1");
-    xmlSetProp(rootnode, (xmlChar *)"xmlns", (xmlChar *)XSPF_XMLNS);
+            if (tuple_get_value_type (tuple, xs->tupleField, NULL) != xs->type)
+                continue;
 
-    /* common */
-    xmlDocSetRootElement(doc, rootnode);
+            gboolean success = TRUE;
 
-    if (title)
-        xspf_add_node (rootnode, TUPLE_STRING, FALSE, "title", title, 0);
+            switch (xs->type) {
+                case TUPLE_STRING:;
+                    gchar * scratch = tuple_get_str (tuple, xs->tupleField, NULL);
+                    if (scratch)
+                        success = xspf_write_node (writer, xs->type, xs->isMeta,
+                         xs->xspfName, scratch, 0);
+                    str_unref (scratch);
+                    break;
 
-    tracklist = xmlNewNode(NULL, (xmlChar *)"trackList");
-    xmlAddChild(rootnode, tracklist);
+                case TUPLE_INT:
+                    success = xspf_write_node (writer, xs->type, xs->isMeta,
+                     xs->xspfName, NULL, tuple_get_int (tuple, xs->tupleField,
+                     NULL));
+                    break;
 
-    for (count = 0; count < entries; count ++)
-    {
-        const gchar * filename = index_get (filenames, count);
-        const Tuple * tuple = index_get (tuples, count);
-        xmlNodePtr track, location;
-        gchar *scratch = NULL;
-        gint scratchi = 0;
+                default:
+                    break;
+            }
 
-        track = xmlNewNode(NULL, (xmlChar *)"track");
-        location = xmlNewNode(NULL, (xmlChar *)"location");
+            if (! success)
+                return FALSE;
+        }
+    }
 
-        xmlAddChild(location, xmlNewText((xmlChar *)filename));
-        xmlAddChild(track, location);
-        xmlAddChild(tracklist, track);
+    return (xmlTextWriterEndElement (writer) >= 0);
+}
 
-        if (tuple != NULL)
-        {
-            gint i;
-            for (i = 0; i < xspf_nentries; i++) {
-                const xspf_entry_t *xs = &xspf_entries[i];
-                gboolean isOK = (tuple_get_value_type (tuple, xs->tupleField,
-                 NULL) == xs->type);
-
-                switch (xs->type) {
-                    case TUPLE_STRING:
-                        scratch = tuple_get_str (tuple, xs->tupleField, NULL);
-                        if (! scratch)
-                            isOK = FALSE;
-                        str_unref(scratch);
-                        break;
-                    case TUPLE_INT:
-                        scratchi = tuple_get_int (tuple, xs->tupleField, NULL);
-                        break;
-                    default:
-                        break;
-                }
+/* Tracks are written to the file as they are formatted, without building a
+ * document in memory first. */
+static gboolean xspf_playlist_save (const gchar * filename, VFSFile * file,
+ const gchar * title, Index * filenames, Index * tuples)
+{
+    gint entries = index_count (filenames);
 
-                if (isOK)
-                    xspf_add_node(track, xs->type, xs->isMeta, xs->xspfName, scratch, scratchi);
-            }
-        }
+    xmlOutputBuffer * buffer = xmlOutputBufferCreateIO (write_cb, close_cb,
+     file, NULL);
+    if (! buffer)
+        return FALSE;
+
+    /* the writer takes ownership of the buffer */
+    xmlTextWriter * writer = xmlNewTextWriter (buffer);
+    if (! writer)
+    {
+        xmlOutputBufferClose (buffer);
+        return FALSE;
     }
 
-    xmlSaveCtxt * save = xmlSaveToIO (write_cb, close_cb, file, NULL,
-     XML_SAVE_FORMAT);
-    if (! save)
+    xmlTextWriterSetIndent (writer, 1);
+
+    if (xmlTextWriterStartDocument (writer, "1.0", "UTF-8", NULL) < 0 ||
+     xmlTextWriterStartElement (writer, (xmlChar *) XSPF_ROOT_NODE_NAME) < 0 ||
+     xmlTextWriterWriteAttribute (writer, (xmlChar *) "version", (xmlChar *)
+     "1") < 0 || xmlTextWriterWriteAttribute (writer, (xmlChar *) "xmlns",
+     (xmlChar *) XSPF_XMLNS) < 0)
         goto ERR;
 
-    if (xmlSaveDoc (save, doc) < 0 || xmlSaveClose (save) < 0)
+    if (title && ! xspf_write_node (writer, TUPLE_STRING, FALSE, "title",
+     title, 0))
+        goto ERR;
+
+    if (xmlTextWriterStartElement (writer, (xmlChar *) "trackList") < 0)
+        goto ERR;
+
+    for (gint count = 0; count < entries; count ++)
+    {
+        if (! xspf_write_track (writer, index_get (filenames, count),
+         index_get (tuples, count)))
+            goto ERR;
+    }
+
+    /* closes trackList and playlist, then flushes */
+    if (xmlTextWriterEndDocument (writer) < 0)
         goto ERR;
 
-    xmlFreeDoc(doc);
+    xmlFreeTextWriter (writer);
     return TRUE;
 
 ERR:
-    xmlFreeDoc (doc);
+    xmlFreeTextWriter (writer);
     return FALSE;
 }
 